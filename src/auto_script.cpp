@@ -12,12 +12,18 @@
 #ifndef HAS_PRECOMPILED_STD_HEADERS
 #  include <ctime>
 #  include <csignal>
+#  include <set>
 #  include <map>
+#  include <deque>
 #  include <vector>
 #  include <string>
 #  include <fstream>
 #  include <iostream>
 #  include <stdexcept>
+#  ifndef _WIN32
+#     include <unistd.h>
+#     include <sys/wait.h>
+#  endif
 #endif
 
 #include "auto_script.h"
@@ -50,6 +56,7 @@ const char* const c_attribute_time = "time";
 const char* const c_attribute_cycle = "cycle";
 const char* const c_attribute_start = "start";
 const char* const c_attribute_finish = "finish";
+const char* const c_attribute_limit = "limit";
 const char* const c_attribute_exclude = "exclude";
 const char* const c_attribute_filename = "filename";
 const char* const c_attribute_arguments = "arguments";
@@ -57,6 +64,21 @@ const char* const c_attribute_timestamp = "timestamp";
 
 const int c_min_cycle_seconds_for_logging = 3600;
 
+// NOTE: This is the maximum number of scripts that will be run concurrently (any further
+// scripts that become due will be queued until a worker is free).
+const size_t c_num_autoscript_workers = 4;
+
+// NOTE: If script reconfiguration is permitted then the schedule is not waited on for any
+// longer than this (so that a change to the autoscript file will be noticed).
+const int c_reconfig_check_msecs = 1000;
+
+const int c_max_schedule_wait_msecs = 60000;
+const int c_min_schedule_wait_msecs = 10;
+
+const int c_worker_wait_msecs = 1000;
+const int c_job_check_msecs = 100;
+const int c_job_kill_grace_msecs = 2000;
+
 // NOTE: This figure will allow an event that recurs every minute to be able to be skipped for max. 10 days.
 // FUTURE: This value should probably be allowed to be overidden by a configuration option.
 const size_t c_max_reschedule_attempts = 15000;
@@ -77,7 +99,7 @@ enum exclude_type
 
 struct script_info
 {
-   script_info( ) : last_mod( 0 ), exclude( e_exclude_type_none ), allow_late_exec( false ) { }
+   script_info( ) : limit_seconds( 0 ), last_mod( 0 ), exclude( e_exclude_type_none ), allow_late_exec( false ) { }
 
    string name;
 
@@ -85,6 +107,8 @@ struct script_info
    mtime finish_time;
    int cycle_seconds;
 
+   int limit_seconds;
+
    udate start_date;
    udate finish_date;
 
@@ -113,6 +137,28 @@ typedef script_schedule_container::const_iterator script_schedule_const_iterator
 
 script_schedule_container g_script_schedule;
 
+struct autoscript_job
+{
+   autoscript_job( ) : limit_seconds( 0 ) { }
+
+   string name;
+   string command;
+   string args_file;
+
+   int limit_seconds;
+};
+
+mutex g_job_mutex;
+
+deque< autoscript_job > g_jobs;
+set< string > g_queued_or_running;
+
+bool g_stop_workers = false;
+size_t g_active_workers = 0;
+
+wait_notifier g_job_notifier;
+wait_notifier g_schedule_notifier;
+
 void read_script_info( )
 {
    guard g( g_mutex );
@@ -162,6 +208,10 @@ void read_script_info( )
 
          info.cycle_seconds = unformat_duration( cycle );
 
+         string limit( reader.read_opt_attribute( c_attribute_limit ) );
+         if( !limit.empty( ) )
+            info.limit_seconds = unformat_duration( limit );
+
          info.start_date = udate::local( );
          string s( reader.read_opt_attribute( c_attribute_start ) );
          if( !s.empty( ) )
@@ -306,6 +356,207 @@ bool scripts_file_has_changed( )
    return changed;
 }
 
+bool queue_job( const autoscript_job& job )
+{
+   {
+      guard g( g_job_mutex );
+
+      // NOTE: A script that is still queued or running is not queued again.
+      if( g_queued_or_running.count( job.name ) )
+         return false;
+
+      g_queued_or_running.insert( job.name );
+      g_jobs.push_back( job );
+   }
+
+   g_job_notifier.notify( );
+
+   return true;
+}
+
+void run_job( const autoscript_job& job )
+{
+   TRACE_LOG( TRACE_SESSIONS, job.command );
+
+#ifndef _WIN32
+   // NOTE: The command is run directly (rather than via "exec_system" which uses a background
+   // shell) so that the number of scripts running is bounded by the number of workers and so
+   // that a script (along with anything it has started) can be killed if exceeding its limit.
+   const char* p_command = job.command.c_str( );
+
+   pid_t pid = fork( );
+
+   if( pid == 0 )
+   {
+      setpgid( 0, 0 );
+      execl( "/bin/sh", "sh", "-c", p_command, ( char* )0 );
+      _exit( 127 );
+   }
+
+   if( pid < 0 )
+      throw runtime_error( "unable to fork for autoscript '" + job.name + "'" );
+
+   int status = 0;
+
+   bool killed = false;
+   milliseconds waited = 0;
+
+   while( waitpid( pid, &status, WNOHANG ) == 0 )
+   {
+      // NOTE: If the server is being shut down then stop waiting (leaving the script to finish
+      // by itself as it would have if it had been started in the background).
+      if( g_server_shutdown )
+         break;
+
+      if( job.limit_seconds )
+      {
+         if( !killed && waited >= job.limit_seconds * 1000 )
+         {
+            killed = true;
+            kill( -pid, SIGTERM );
+
+            TRACE_LOG( TRACE_ANYTHING, "autoscript '" + job.name
+             + "' exceeded its limit of " + to_string( job.limit_seconds ) + " seconds and has been terminated" );
+         }
+         else if( killed && waited >= job.limit_seconds * 1000 + c_job_kill_grace_msecs )
+         {
+            kill( -pid, SIGKILL );
+            waitpid( pid, &status, 0 );
+
+            break;
+         }
+      }
+
+      msleep( c_job_check_msecs );
+      waited += c_job_check_msecs;
+   }
+#else
+   // KLUDGE: For some reason under Windows if multiple scripts need to be run in
+   // quick succession then subsequent execs can fail to work without this delay.
+   msleep( 250 );
+   exec_system( job.command, true );
+#endif
+}
+
+class autoscript_worker : public thread
+{
+   public:
+   void on_start( );
+};
+
+void autoscript_worker::on_start( )
+{
+   while( true )
+   {
+      autoscript_job job;
+      bool has_job = false;
+
+      unsigned long generation = g_job_notifier.get_generation( );
+
+      {
+         guard g( g_job_mutex );
+
+         if( g_stop_workers )
+            break;
+
+         if( !g_jobs.empty( ) )
+         {
+            has_job = true;
+
+            job = g_jobs.front( );
+            g_jobs.pop_front( );
+         }
+      }
+
+      if( !has_job )
+      {
+         g_job_notifier.wait( generation, c_worker_wait_msecs );
+         continue;
+      }
+
+      try
+      {
+         run_job( job );
+      }
+      catch( exception& x )
+      {
+         TRACE_LOG( TRACE_ANYTHING, string( "autoscript error: " ) + x.what( ) );
+      }
+      catch( ... )
+      {
+         TRACE_LOG( TRACE_ANYTHING, "autoscript error: unexpected unknown exception caught" );
+      }
+
+      guard g( g_job_mutex );
+      g_queued_or_running.erase( job.name );
+   }
+
+   {
+      guard g( g_job_mutex );
+      --g_active_workers;
+   }
+
+   g_schedule_notifier.notify( );
+
+   delete this;
+}
+
+void start_workers( )
+{
+   guard g( g_job_mutex );
+
+   g_stop_workers = false;
+
+   for( size_t i = 0; i < c_num_autoscript_workers; i++ )
+   {
+      ++g_active_workers;
+
+      autoscript_worker* p_worker = new autoscript_worker;
+      p_worker->start( );
+   }
+}
+
+void stop_workers( )
+{
+   {
+      guard g( g_job_mutex );
+
+      g_stop_workers = true;
+
+      // NOTE: Any queued jobs are discarded (along with their script args files).
+      while( !g_jobs.empty( ) )
+      {
+         if( !g_jobs.front( ).args_file.empty( ) )
+            file_remove( g_jobs.front( ).args_file );
+
+         g_queued_or_running.erase( g_jobs.front( ).name );
+         g_jobs.pop_front( );
+      }
+   }
+
+   g_job_notifier.notify( );
+
+   // NOTE: Wait for any jobs that are still running to complete (or to be killed).
+   while( true )
+   {
+      unsigned long generation = g_schedule_notifier.get_generation( );
+
+      {
+         guard g( g_job_mutex );
+
+         if( !g_active_workers )
+            break;
+      }
+
+      g_schedule_notifier.wait( generation, c_worker_wait_msecs );
+   }
+}
+
+}
+
+void wake_autoscript_session( )
+{
+   g_schedule_notifier.notify( );
 }
 
 void output_schedule( ostream& os )
@@ -349,9 +600,33 @@ void autoscript_session::on_start( )
       TRACE_LOG( TRACE_SESSIONS,
        "started autoscript session (tid = " + to_string( current_thread_id( ) ) + ")" );
 
+      start_workers( );
+
       while( true )
       {
-         msleep( 1000 );
+         int wait_msecs = c_max_schedule_wait_msecs;
+
+         if( changed || script_reconfig )
+            wait_msecs = c_reconfig_check_msecs;
+
+         {
+            guard g( g_mutex );
+
+            // NOTE: Rather than polling the schedule wait until the earliest script is due (an
+            // extra few milliseconds are added to ensure that the due time will have passed).
+            if( !g_script_schedule.empty( ) )
+            {
+               seconds until_due = g_script_schedule.begin( )->first - date_time::local( );
+
+               if( until_due * 1000.0 < wait_msecs )
+                  wait_msecs = max( c_min_schedule_wait_msecs, ( int )( until_due * 1000.0 ) + c_min_schedule_wait_msecs );
+            }
+         }
+
+         unsigned long generation = g_schedule_notifier.get_generation( );
+
+         if( !g_server_shutdown )
+            g_schedule_notifier.wait( generation, wait_msecs );
 
          if( g_server_shutdown )
             break;
@@ -433,14 +708,22 @@ void autoscript_session::on_start( )
                      if( cycle_seconds >= c_min_cycle_seconds_for_logging )
                         script_args += " " + g_scripts[ j->second ].name;
 
+                     autoscript_job job;
+
+                     job.name = g_scripts[ j->second ].name;
+                     job.args_file = script_args.substr( 0, script_args.find( ' ' ) );
+                     job.limit_seconds = g_scripts[ j->second ].limit_seconds;
 #ifdef _WIN32
-                     // KLUDGE: For some reason under Windows if multiple scripts need to be run in
-                     // one pass then subsequent execs can fail to work if this delay is not included.
-                     msleep( 250 );
-                     exec_system( "script " + script_args, true );
+                     job.command = "script " + script_args;
 #else
-                     exec_system( "./script " + script_args, true );
+                     job.command = "./script " + script_args;
 #endif
+                     if( !queue_job( job ) )
+                     {
+                        file_remove( job.args_file );
+
+                        TRACE_LOG( TRACE_SESSIONS, "skipping autoscript '" + job.name + "' (still queued or running)" );
+                     }
                   }
                   else
                   {
@@ -454,7 +737,14 @@ void autoscript_session::on_start( )
                      if( !arguments.empty( ) )
                         cmd_and_args += " " + arguments;
 
-                     exec_system( cmd_and_args, true );
+                     autoscript_job job;
+
+                     job.name = g_scripts[ j->second ].name;
+                     job.command = cmd_and_args;
+                     job.limit_seconds = g_scripts[ j->second ].limit_seconds;
+
+                     if( !queue_job( job ) )
+                        TRACE_LOG( TRACE_SESSIONS, "skipping autoscript '" + job.name + "' (still queued or running)" );
                   }
                }
 
@@ -503,6 +793,8 @@ void autoscript_session::on_start( )
 #endif
       TRACE_LOG( TRACE_ANYTHING, "autoscript error: unexpected unknown exception caught" );
    }
+
+   stop_workers( );
 #ifdef DEBUG
    cout << "finished autoscript session..." << endl;
 #endif
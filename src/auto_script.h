@@ -13,6 +13,8 @@
 
 #  include "threads.h"
 
+void wake_autoscript_session( );
+
 void output_schedule( std::ostream& os );
 
 class autoscript_session : public thread
@@ -10,10 +10,14 @@
 #pragma hdrstop
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <cstdio>
+#  include <cstring>
 #  include <map>
+#  include <deque>
 #  include <memory>
 #  include <fstream>
 #  include <sstream>
+#  include <iomanip>
 #  include <iostream>
 #  include <stdexcept>
 #  ifdef __BORLANDC__
@@ -43,6 +47,8 @@
 #include "base64.h"
 #include "config.h"
 #include "format.h"
+#include "threads.h"
+#include "date_time.h"
 #include "utilities.h"
 #include "fs_iterator.h"
 
@@ -71,6 +77,15 @@ const int c_progress_lines = 250;
 // const int c_max_bytes_per_line = 57; // (for 76 characters)
 const int c_max_bytes_per_line = 96; // (for 128 characters)
 
+const int c_zlib_read_buffer_size = 131072;
+
+const int c_zlib_block_size = 1048576;
+const int c_zlib_max_threads = 64;
+
+const double c_bytes_per_megabyte = 1048576.0;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
 const char* const c_zlib_extension = ".gz";
 const char* const c_default_extension = ".bun";
 
@@ -118,14 +133,24 @@ string escaped_line( const string& line )
 #ifdef ZLIB_SUPPORT
 bool read_zlib_line( gzFile& gzf, string& s, bool unescape = true )
 {
-   char c;
    s.erase( );
 
+   // NOTE: Uses "gzgetc" (which reads directly from the zlib buffer unless it needs refilling)
+   // rather than calling "gzread" for every character.
    bool is_escape = false;
-   while( !gzeof( gzf ) )
+   while( true )
    {
-      if( !gzread( gzf, &c, sizeof( char ) ) )
-         throw runtime_error( "reading zlib char" );
+      int ch = gzgetc( gzf );
+
+      if( ch == -1 )
+      {
+         if( gzeof( gzf ) )
+            break;
+         else
+            throw runtime_error( "reading zlib char" );
+      }
+
+      char c = ( char )ch;
 
       if( is_escape )
       {
@@ -146,15 +171,233 @@ bool read_zlib_line( gzFile& gzf, string& s, bool unescape = true )
    return !s.empty( );
 }
 
-void write_zlib_line( gzFile& gzf, const string& str )
+struct zlib_block
 {
-   if( str.size( ) )
+   string input;
+   string output;
+   string error;
+};
+
+class zlib_block_thread : public joinable_thread
+{
+   public:
+   zlib_block_thread( zlib_block& block, int level )
+    :
+    block( block ),
+    level( level )
+   {
+   }
+
+   void on_start( );
+
+   private:
+   zlib_block& block;
+
+   int level;
+};
+
+// NOTE: If more than one thread is to be used then the output is split into blocks which are each
+// compressed as a separate gzip member (by worker threads) with the members being written in order
+// (gzip readers treat consecutive members as a single stream so unbundle needs no changes for this).
+class zlib_output
+{
+   public:
+   zlib_output( )
+    :
+    gzf( 0 ),
+    p_file( 0 ),
+    level( Z_DEFAULT_COMPRESSION ),
+    num_threads( 1 ),
+    total_bytes( 0 )
+   {
+   }
+
+   ~zlib_output( )
+   {
+      wait_for_blocks( 0, false );
+
+      while( !blocks.empty( ) )
+      {
+         delete blocks.front( );
+         blocks.pop_front( );
+      }
+
+      if( gzf )
+         gzclose( gzf );
+
+      if( p_file )
+         fclose( p_file );
+   }
+
+   bool open( const string& file_name, const string& open_mode, int threads )
+   {
+      num_threads = threads;
+
+      if( !open_mode.empty( ) && isdigit( open_mode[ open_mode.size( ) - 1 ] ) )
+         level = open_mode[ open_mode.size( ) - 1 ] - '0';
+
+      if( num_threads <= 1 )
+         gzf = gzopen( file_name.c_str( ), open_mode.c_str( ) );
+      else
+      {
+         p_file = fopen( file_name.c_str( ), "wb" );
+         ap_block.reset( new zlib_block );
+         ap_block->input.reserve( c_zlib_block_size );
+      }
+
+      return gzf || p_file;
+   }
+
+   void write( const char* p_data, size_t length )
+   {
+      total_bytes += length;
+
+      if( gzf )
+      {
+         if( !gzwrite( gzf, p_data, length ) )
+            throw runtime_error( "writing zlib block" );
+      }
+      else
+      {
+         while( length )
+         {
+            size_t chunk = min( length, c_zlib_block_size - ap_block->input.size( ) );
+
+            ap_block->input.append( p_data, chunk );
+
+            p_data += chunk;
+            length -= chunk;
+
+            if( ap_block->input.size( ) == c_zlib_block_size )
+               start_block( );
+         }
+      }
+   }
+
+   void close( )
+   {
+      if( gzf )
+      {
+         gzFile tmp_gzf = gzf;
+         gzf = 0;
+
+         if( gzclose( tmp_gzf ) != Z_OK )
+            throw runtime_error( "closing zlib output" );
+      }
+      else if( p_file )
+      {
+         if( !ap_block->input.empty( ) )
+            start_block( );
+
+         wait_for_blocks( 0, true );
+
+         FILE* p_tmp_file = p_file;
+         p_file = 0;
+
+         if( fclose( p_tmp_file ) != 0 )
+            throw runtime_error( "closing zlib output" );
+      }
+   }
+
+   int64_t get_total_bytes( ) const { return total_bytes; }
+
+   private:
+   void start_block( )
    {
-      if( !gzwrite( gzf, str.c_str( ), str.size( ) ) )
-         throw runtime_error( "writing zlib string" );
+      // NOTE: Limit the number of blocks being compressed to the number of threads in use.
+      wait_for_blocks( num_threads - 1, true );
 
-      if( !gzwrite( gzf, "\n", 1 ) )
-         throw runtime_error( "writing zlib linefeed" );
+      zlib_block* p_block = ap_block.release( );
+      blocks.push_back( p_block );
+
+      ap_block.reset( new zlib_block );
+      ap_block->input.reserve( c_zlib_block_size );
+
+      zlib_block_thread* p_thread = new zlib_block_thread( *p_block, level );
+      block_threads.push_back( p_thread );
+
+      p_thread->start( );
+   }
+
+   // NOTE: Each block's thread is joined before its output is used (or it is deleted) so the
+   // block (and this object) cannot be destroyed whilst the thread is still running.
+   void wait_for_blocks( size_t max_pending, bool write_output )
+   {
+      while( blocks.size( ) > max_pending )
+      {
+         auto_ptr< zlib_block_thread > ap_thread( block_threads.front( ) );
+         block_threads.pop_front( );
+
+         ap_thread->join( );
+
+         auto_ptr< zlib_block > ap_done( blocks.front( ) );
+         blocks.pop_front( );
+
+         if( write_output )
+         {
+            if( !ap_done->error.empty( ) )
+               throw runtime_error( ap_done->error );
+
+            if( fwrite( ap_done->output.data( ), 1, ap_done->output.size( ), p_file ) != ap_done->output.size( ) )
+               throw runtime_error( "writing zlib block" );
+         }
+      }
+   }
+
+   gzFile gzf;
+   FILE* p_file;
+
+   int level;
+   int num_threads;
+
+   int64_t total_bytes;
+
+   auto_ptr< zlib_block > ap_block;
+
+   deque< zlib_block* > blocks;
+   deque< zlib_block_thread* > block_threads;
+};
+
+void zlib_block_thread::on_start( )
+{
+   string error;
+   string compressed;
+
+   z_stream zs;
+   memset( &zs, 0, sizeof( zs ) );
+
+   // NOTE: Adding 16 to the window bits results in a gzip (rather than a zlib) header and trailer.
+   if( deflateInit2( &zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+      error = "unable to initialise zlib deflate";
+   else
+   {
+      compressed.resize( deflateBound( &zs, block.input.size( ) ) + 32 );
+
+      zs.next_in = ( Bytef* )block.input.data( );
+      zs.avail_in = block.input.size( );
+
+      zs.next_out = ( Bytef* )&compressed[ 0 ];
+      zs.avail_out = compressed.size( );
+
+      if( deflate( &zs, Z_FINISH ) != Z_STREAM_END )
+         error = "unexpected zlib deflate failure";
+      else
+         compressed.resize( zs.total_out );
+
+      deflateEnd( &zs );
+   }
+
+   block.error = error;
+   block.output.swap( compressed );
+   block.input.erase( );
+}
+
+void write_zlib_line( zlib_output& gzf, const string& str )
+{
+   if( str.size( ) )
+   {
+      gzf.write( str.c_str( ), str.size( ) );
+      gzf.write( "\n", 1 );
    }
 }
 #endif
@@ -204,7 +447,7 @@ void check_file_header( ifstream& inpf, const string& filename, encoding_type& e
 void output_directory( set< string >& file_names, const string& path_name, int level, ofstream& outf )
 #else
 void output_directory( set< string >& file_names,
- const string& path_name, int level, ofstream& outf, bool use_zlib, gzFile& gzf )
+ const string& path_name, int level, ofstream& outf, bool use_zlib, zlib_output& gzf )
 #endif
 {
    string::size_type pos = path_name.find_last_of( '/' );
@@ -262,7 +505,7 @@ void process_directory( const string& directory, const string& filespec_path,
 void process_directory( const string& directory, const string& filespec_path,
  const vector< string >& filename_filters, const vector< string >* p_filename_exclusions,
  set< string >& matched_filters, set< string >& file_names, bool recurse, bool prune,
- bool is_quieter, bool is_append, encoding_type encoding, ofstream& outf, bool use_zlib, gzFile& gzf )
+ bool is_quieter, bool is_append, encoding_type encoding, ofstream& outf, bool use_zlib, zlib_output& gzf )
 #endif
 {
    directory_filter df;
@@ -511,8 +754,8 @@ void process_directory( const string& directory, const string& filespec_path,
             {
                if( encoding != e_encoding_type_raw )
                   write_zlib_line( gzf, encoded );
-               else if( !gzwrite( gzf, buffer, count ) )
-                  throw runtime_error( "writing zlib block" );
+               else
+                  gzf.write( buffer, count );
             }
 #endif
 
@@ -536,6 +779,7 @@ int main( int argc, char* argv[ ] )
    bool is_delete = false;
    bool is_quieter = false;
 
+   int num_threads = 1;
    string open_mode( "wb" );
 
 #ifndef ZLIB_SUPPORT
@@ -563,6 +807,23 @@ int main( int argc, char* argv[ ] )
       }
    }
 
+#ifdef ZLIB_SUPPORT
+   if( argc > first_arg + 1 )
+   {
+      string next( argv[ first_arg + 1 ] );
+
+      if( next.size( ) > 2 && next.substr( 0, 2 ) == "-t"
+       && next.find_first_not_of( "0123456789", 2 ) == string::npos )
+      {
+         ++first_arg;
+         num_threads = atoi( next.substr( 2 ).c_str( ) );
+
+         if( num_threads < 1 || num_threads > c_zlib_max_threads )
+            invalid = true;
+      }
+   }
+#endif
+
    if( argc > first_arg + 1 )
    {
       if( string( argv[ first_arg + 1 ] ) == "-d" )
@@ -648,7 +909,7 @@ int main( int argc, char* argv[ ] )
 #endif
 
    if( !is_quiet )
-      cout << "bundle v0.1f\n";
+      cout << "bundle v0.1g\n";
 
    if( invalid || ( argc - first_arg < 2 )
     || string( argv[ 1 ] ) == "?" || string( argv[ 1 ] ) == "/?" || string( argv[ 1 ] ) == "-?" )
@@ -656,10 +917,13 @@ int main( int argc, char* argv[ ] )
 #ifndef ZLIB_SUPPORT
       cout << "usage: bundle [-0|-1|-9] [-d]|[-r [-p]] [-q[q]] [-b64|-esc] <fname> [<fspec1> [<fspec2> [...]]] [-x <fspec1> [...]]" << endl;
 #else
-      cout << "usage: bundle [-0|-1|-9] [-d]|[-r [-p]] [-q[q]] [-b64|-esc] [-ngz] <fname> [<fspec1> [<fspec2> [...]]] [-x <fspec1> [...]]" << endl;
+      cout << "usage: bundle [-0|-1|-9] [-t<n>] [-d]|[-r [-p]] [-q[q]] [-b64|-esc] [-ngz] <fname> [<fspec1> [<fspec2> [...]]] [-x <fspec1> [...]]" << endl;
 #endif
 
       cout << "\nwhere: -0/-1/-9 is used for setting zero/fastest/best compression level" << endl;
+#ifdef ZLIB_SUPPORT
+      cout << "  and: -t<n> is to compress using <n> threads (with a max. of " << c_zlib_max_threads << ")" << endl;
+#endif
       cout << "  and: -d is to delete matching files which exist in an existing bundle" << endl;
       cout << "  and: -r is to recurse sub-directories (-p to prune empty directories)" << endl;
       cout << "  and: -q for quiet mode (-qq to suppress all output apart from errors)" << endl;
@@ -673,6 +937,9 @@ int main( int argc, char* argv[ ] )
 
    try
    {
+      int64_t total_bytes = 0;
+      mtime start( mtime::standard( ) );
+
       g_cwd = get_cwd( );
 
       string::size_type pos;
@@ -811,15 +1078,19 @@ int main( int argc, char* argv[ ] )
          if( !outf )
             throw runtime_error( "unable to open file '" + output_filename + "' for output" );
 #else
-         gzFile gzf;
+         zlib_output gzf;
          ofstream outf;
 
+         bool okay;
          if( !use_zlib )
+         {
             outf.open( output_filename.c_str( ) );
+            okay = outf.good( );
+         }
          else
-            gzf = gzopen( output_filename.c_str( ), open_mode.c_str( ) );
+            okay = gzf.open( output_filename, open_mode, num_threads );
 
-         if( ( use_zlib && !gzf ) || ( !use_zlib && !outf ) )
+         if( !okay )
             throw runtime_error( "unable to open file '" + output_filename + "' for output" );
 #endif
 
@@ -899,8 +1170,13 @@ int main( int argc, char* argv[ ] )
             if( !use_zlib )
                inpf.open( filename.c_str( ) );
             else
+            {
                igzf = gzopen( filename.c_str( ), "rb" );
 
+               if( igzf )
+                  gzbuffer( igzf, c_zlib_read_buffer_size );
+            }
+
             if( ( use_zlib && !igzf ) || ( !use_zlib && !inpf ) )
                throw runtime_error( "unable to open file '" + filename + "' for input" );
 #else
@@ -992,8 +1268,8 @@ int main( int argc, char* argv[ ] )
                            if( !outf.good( ) )
                               throw runtime_error( "unexpected bad output file stream" );
                         }
-                        else if( !gzwrite( gzf, buffer, count ) )
-                           throw runtime_error( "writing zlib block" );
+                        else
+                           gzf.write( buffer, count );
 #endif
 
                         raw_file_size -= count;
@@ -1247,7 +1523,10 @@ int main( int argc, char* argv[ ] )
 
 #ifdef ZLIB_SUPPORT
          if( use_zlib )
-            gzclose( gzf );
+         {
+            gzf.close( );
+            total_bytes = gzf.get_total_bytes( );
+         }
 #endif
 
          if( !use_zlib )
@@ -1255,6 +1534,8 @@ int main( int argc, char* argv[ ] )
             outf.flush( );
             if( !outf.good( ) )
                throw runtime_error( "unexpected write failure for output file '" + filename + "'" );
+
+            total_bytes = outf.tellp( );
          }
       }
 
@@ -1273,7 +1554,19 @@ int main( int argc, char* argv[ ] )
       }
 
       if( !is_quiet )
-         cout << "==> finished bundling '" << filename << "'" << endl;
+      {
+         cout << "==> finished bundling '" << filename << "'";
+
+         milliseconds elapsed = mtime::standard( ) - start;
+         if( elapsed < 0 )
+            elapsed += c_milliseconds_per_day;
+
+         if( elapsed > 0 )
+            cout << " (" << fixed << setprecision( 2 )
+             << ( ( total_bytes / c_bytes_per_megabyte ) / ( elapsed / 1000.0 ) ) << " MB/s)";
+
+         cout << endl;
+      }
    }
    catch( exception& x )
    {
@@ -154,6 +154,7 @@ const char* const c_attribute_max_attached_data = "max_attached_data";
 const char* const c_attribute_max_storage_handlers = "max_storage_handlers";
 const char* const c_attribute_files_area_item_max_num = "files_area_item_max_num";
 const char* const c_attribute_files_area_item_max_size = "files_area_item_max_size";
+const char* const c_attribute_fetch_cache_max_items = "fetch_cache_max_items";
 
 const char* const c_section_client = "client";
 const char* const c_section_extern = "extern";
@@ -1204,6 +1205,13 @@ const size_t c_max_storage_handlers_default = 10;
 const size_t c_files_area_item_max_num_default = 1000;
 const size_t c_files_area_item_max_size_default = 100000; // i.e. 100kB
 
+// NOTE: The fetch cache is only used if configured (as derived field values can depend upon
+// session variables or the current time that are not part of the fetch itself).
+const size_t c_fetch_cache_max_items_default = 0;
+
+const int64_t c_ods_compact_max_entries = 250;
+const int c_ods_compact_interval_seconds = 3600;
+
 string g_empty_string;
 
 size_t g_max_sessions = c_max_sessions_default;
@@ -1212,6 +1220,12 @@ size_t g_max_storage_handlers = c_max_storage_handlers_default + 1; // i.e. extr
 size_t g_files_area_item_max_num = c_files_area_item_max_num_default;
 size_t g_files_area_item_max_size = c_files_area_item_max_size_default;
 
+size_t g_fetch_cache_max_items = c_fetch_cache_max_items_default;
+
+// NOTE: This is incremented whenever a transaction is committed or a storage is initialised
+// so that any cached fetch responses will no longer be used.
+uint64_t g_data_revision = 0;
+
 const char* const c_default_storage_name = "<none>";
 const char* const c_default_storage_identity = "<default>";
 
@@ -1220,6 +1234,9 @@ map< string, map< string, string > > g_crypt_keys;
 auto_ptr< ods > gap_ods;
 auto_ptr< ods_file_system > gap_ofs;
 
+time_t g_ods_last_compacted = 0;
+bool g_ods_compact_underway = false;
+
 void init_ciyam_ods( )
 {
    gap_ods.reset( new ods( c_ciyam_server,
@@ -1334,6 +1351,10 @@ void perform_storage_op( storage_op op,
 {
    guard g( g_mutex );
 
+   // NOTE: As storage administration (such as a restore) can change data outside of any transaction
+   // the data revision is also incremented whenever a storage is linked to.
+   ++g_data_revision;
+
    storage_handler* p_new_handler = 0;
 
    if( name == c_default_storage_name )
@@ -1994,200 +2015,214 @@ void remove_tx_info_from_cache( )
    }
 }
 
-bool is_child_constrained( class_base& instance,
- class_base& root_instance, string& constraining_class, map< string, set< string > >& instance_keys )
+struct cascade_restriction
 {
-   class_base_accessor instance_accessor( instance );
-
-   class_base* p_class_base;
-   string sql, next_child_field;
-
-   size_t num_children = instance_accessor.get_num_foreign_key_children( );
-   if( num_children && !instance_keys[ instance.get_class_id( ) ].count( instance.get_key( ) ) )
+   cascade_restriction( const string& lock_class_id, const string& key, const string& display_name )
+    :
+    lock_class_id( lock_class_id ),
+    key( key ),
+    display_name( display_name )
    {
-      for( int pass = 0; pass < 2; ++pass )
-      {
-         cascade_op next_op;
-         if( pass == 0 )
-            next_op = e_cascade_op_restrict;
-         else
-            next_op = e_cascade_op_destroy;
-
-         for( size_t i = 0; i < num_children; i++ )
-         {
-            p_class_base = instance_accessor.get_next_foreign_key_child( i, next_child_field, next_op );
+   }
 
-            auto_ptr< class_cascade > ap_tmp_cascading;
-            if( p_class_base )
-               ap_tmp_cascading.reset( new class_cascade( *p_class_base ) );
+   string lock_class_id;
+   string key;
 
-            // FUTURE: The handling of cascades needs to be revisited at some stage to improve performance
-            // as currently iteration occurs three times (firstly to lock, secondly to test if constrained
-            // and thirdly for the actual deletions).
-            if( p_class_base
-             && p_class_base->iterate_forwards( "", c_key_field, true, 0, e_sql_optimisation_unordered ) )
-            {
-               class_base_accessor child_instance_accessor( *p_class_base );
+   string display_name;
+};
 
-               if( next_op == e_cascade_op_restrict )
-               {
-                  storage_handler& handler( *gtp_session->p_storage_handler );
+// NOTE: A cascade plan is constructed by a single walk of the foreign key child tree that obtains the
+// cascade locks whilst collecting restricting children. As the restricting children can only be tested
+// once all the locks have been obtained only the first restricting child (that is not already locked
+// for destroy) of each restricting relationship is collected with any further ones being left to be
+// checked by a second (check only) walk if all those that were collected end up being locked (separate
+// "visited" sets are maintained for locking and restriction checking so that what is locked and what
+// is checked is identical to performing the locking and checking as separate walks).
+struct cascade_plan
+{
+   cascade_plan( class_base& root_instance, bool check_restrictions, bool locks_obtained = false )
+    :
+    root_instance( root_instance ),
+    locks_obtained( locks_obtained ),
+    check_restrictions( check_restrictions ),
+    has_unchecked_restrictions( false )
+   {
+   }
 
-                  do
-                  {
-                     // NOTE: If the instance that would restrict has already been locked for destroy then
-                     // it can be safely ignored (i.e. continue iteration to find the next instance). Once
-                     // an actual restricting instance is found then no further iteration is required.
-                     op_lock lock = handler.get_lock_info_for_owner(
-                      p_class_base->get_lock_class_id( ), p_class_base->get_key( ), root_instance );
+   class_base& root_instance;
 
-                     if( lock.type != op_lock::e_lock_type_destroy )
-                     {
-                        constraining_class = p_class_base->get_display_name( );
-                        p_class_base->iterate_stop( );
-                        return true;
-                     }
-                  } while( p_class_base->iterate_next( ) );
-               }
-               else
-               {
-                  do
-                  {
-                     // NOTE: If the child instance is actually a derived class then get the derived object.
-                     sql.erase( );
-                     class_base* p_dyn_class_base( child_instance_accessor.fetch_dynamic_instance( sql, false ) );
+   bool locks_obtained;
+   bool check_restrictions;
+   bool has_unchecked_restrictions;
 
-                     // FUTURE: This fetch should not actually be necessary as long as the key has been set.
-                     if( !sql.empty( ) )
-                        fetch_instance_from_db( *p_dyn_class_base, sql );
+   map< string, set< string > > locked_keys;
+   map< string, set< string > > checked_keys;
 
-                     if( next_op == e_cascade_op_destroy )
-                        instance_keys[ p_class_base->get_class_id( ) ].insert( p_class_base->get_key( ) );
+   vector< cascade_restriction > restrictions;
+};
 
-                     if( is_child_constrained( *p_dyn_class_base, root_instance, constraining_class, instance_keys ) )
-                     {
-                        p_class_base->iterate_stop( );
-                        return true;
-                     }
+bool plan_cascade_for_destroy( class_base& instance, cascade_plan& plan, bool obtain_locks, bool check_restrictions )
+{
+   class_base_accessor instance_accessor( instance );
 
-                     child_instance_accessor.destroy_dynamic_instance( );
+   size_t num_children = instance_accessor.get_num_foreign_key_children( );
 
-                  } while( p_class_base->iterate_next( ) );
-               }
-            }
-         }
-      }
-   }
+   if( !num_children )
+      return true;
 
-   return false;
-}
+   bool perform_locks = obtain_locks && !plan.locked_keys[ instance.get_class_id( ) ].count( instance.get_key( ) );
+   bool perform_checks = check_restrictions && !plan.checked_keys[ instance.get_class_id( ) ].count( instance.get_key( ) );
 
-bool obtain_cascade_locks_for_destroy( class_base& instance,
- class_base& root_instance, map< string, set< string > >& instance_keys )
-{
-   class_base_accessor instance_accessor( instance );
+   if( !perform_locks && !perform_checks )
+      return true;
 
    size_t lock_handle;
    class_base* p_class_base;
    string sql, next_child_field;
 
+   class_base& root_instance( plan.root_instance );
    storage_handler& handler( *gtp_session->p_storage_handler );
 
-   size_t num_children = instance_accessor.get_num_foreign_key_children( );
-   if( num_children && !instance_keys[ instance.get_class_id( ) ].count( instance.get_key( ) ) )
+   for( int pass = 0; pass < 3; ++pass )
    {
-      for( int pass = 0; pass < 2; ++pass )
+      cascade_op next_op;
+      if( pass == 0 )
       {
-         cascade_op next_op;
-         if( pass == 0 )
-            next_op = e_cascade_op_destroy;
-         else
-            next_op = e_cascade_op_unlink;
+         if( !perform_checks )
+            continue;
 
-         for( size_t i = 0; i < num_children; i++ )
-         {
-            p_class_base = instance_accessor.get_next_foreign_key_child( i, next_child_field, next_op );
+         next_op = e_cascade_op_restrict;
+      }
+      else if( pass == 1 )
+         next_op = e_cascade_op_destroy;
+      else
+      {
+         if( !perform_locks )
+            break;
+
+         next_op = e_cascade_op_unlink;
+      }
+
+      for( size_t i = 0; i < num_children; i++ )
+      {
+         p_class_base = instance_accessor.get_next_foreign_key_child( i, next_child_field, next_op );
+
+         auto_ptr< class_cascade > ap_tmp_cascading;
+         if( p_class_base )
+            ap_tmp_cascading.reset( new class_cascade( *p_class_base ) );
 
-            auto_ptr< class_cascade > ap_tmp_cascading;
-            if( p_class_base )
-               ap_tmp_cascading.reset( new class_cascade( *p_class_base ) );
+         if( p_class_base
+          && p_class_base->iterate_forwards( "", c_key_field, true, 0, e_sql_optimisation_unordered ) )
+         {
+            class_base_accessor child_instance_accessor( *p_class_base );
 
-            // FUTURE: The handling of cascades needs to be revisited at some stage to improve performance
-            // as currently iteration occurs three times (firstly to lock, secondly to test if constrained
-            // and thirdly for the actual deletions).
-            if( p_class_base
-             && p_class_base->iterate_forwards( "", c_key_field, true, 0, e_sql_optimisation_unordered ) )
+            if( next_op == e_cascade_op_restrict )
             {
-               class_base_accessor child_instance_accessor( *p_class_base );
+               string display_name( p_class_base->get_display_name( ) );
+               string lock_class_id( p_class_base->get_lock_class_id( ) );
 
                do
                {
-                  // NOTE: A lock may have already been obtained during the recursion due to multiple
-                  // relationship paths leading to the same instance - if found then simply continue.
-                  op_lock lock = handler.get_lock_info_for_owner(
-                   p_class_base->get_lock_class_id( ), p_class_base->get_key( ), root_instance );
+                  op_lock lock = handler.get_lock_info_for_owner( lock_class_id, p_class_base->get_key( ), root_instance );
 
-                  if( lock.type != op_lock::e_lock_type_none )
+                  if( lock.type == op_lock::e_lock_type_destroy )
                      continue;
 
-                  // NOTE: It is possible that the original instance being destroyed (for which the lock
-                  // is not marked class "owned") may also be subject to unlinking (due to the existence
-                  // of a relationship to a child instance) so it's being assumed here that if a destroy
-                  // lock belonging to the same session is found for this instance then this is the case.
-                  if( pass == 1 )
+                  plan.restrictions.push_back( cascade_restriction( lock_class_id, p_class_base->get_key( ), display_name ) );
+
+                  // NOTE: If all the locks have already been obtained then the first restricting child
+                  // found means the destroy is constrained so the walk can simply be stopped here.
+                  if( plan.locks_obtained )
                   {
-                     // FUTURE: Although extremely unlinkely it's possible for the destroy lock to not be
-                     // that of the original operation (i.e. instead part of a completely separate op for
-                     // the same session). As the key protocol commands only deal with a single operation
-                     // the assumption that the lock is part of the same operation is fine, however, were
-                     // it to become desirable for multiple operations (belonging to the same session) to
-                     // be supported then this assumption could be incorrect and lead to potential issues.
-                     lock = handler.get_lock_info( p_class_base->get_lock_class_id( ), p_class_base->get_key( ) );
-                     if( lock.p_session == gtp_session && lock.type == op_lock::e_lock_type_destroy )
-                        continue;
+                     p_class_base->iterate_stop( );
+                     return false;
                   }
 
-                  if( next_op == e_cascade_op_unlink )
+                  if( p_class_base->iterate_next( ) )
                   {
-                     if( !handler.obtain_lock( lock_handle, p_class_base->get_lock_class_id( ),
-                      p_class_base->get_key( ), op_lock::e_lock_type_update, gtp_session, &instance, &root_instance ) )
-                     {
-                        p_class_base->iterate_stop( );
-                        return false;
-                     }
+                     plan.has_unchecked_restrictions = true;
+                     p_class_base->iterate_stop( );
                   }
-                  else
-                  {
-                     if( handler.obtain_lock( lock_handle, p_class_base->get_lock_class_id( ),
-                      p_class_base->get_key( ), op_lock::e_lock_type_destroy, gtp_session, &instance, &root_instance ) )
-                     {
-                        // NOTE: If the child instance is actually a derived class then get the derived object.
-                        sql.erase( );
-                        class_base* p_dyn_class_base( child_instance_accessor.fetch_dynamic_instance( sql, false ) );
 
-                        // FUTURE: This fetch should not actually be necessary as long as the key has been set.
-                        if( !sql.empty( ) )
-                           fetch_instance_from_db( *p_dyn_class_base, sql );
+                  break;
+               } while( p_class_base->iterate_next( ) );
 
-                        if( next_op == e_cascade_op_destroy )
-                           instance_keys[ p_class_base->get_class_id( ) ].insert( p_class_base->get_key( ) );
+               continue;
+            }
+
+            do
+            {
+               bool lock_child = false;
+
+               if( perform_locks )
+               {
+                  // NOTE: A lock may have already been obtained during the walk due to multiple
+                  // relationship paths leading to the same instance - if found then simply continue.
+                  op_lock lock = handler.get_lock_info_for_owner(
+                   p_class_base->get_lock_class_id( ), p_class_base->get_key( ), root_instance );
 
-                        if( !obtain_cascade_locks_for_destroy( *p_dyn_class_base, root_instance, instance_keys ) )
+                  if( lock.type == op_lock::e_lock_type_none )
+                  {
+                     // NOTE: It is possible that the original instance being destroyed (for which the lock
+                     // is not marked class "owned") may also be subject to unlinking (due to the existence
+                     // of a relationship to a child instance) so it's being assumed here that if a destroy
+                     // lock belonging to the same session is found for this instance then this is the case.
+                     if( next_op == e_cascade_op_unlink )
+                     {
+                        // FUTURE: Although extremely unlinkely it's possible for the destroy lock to not be
+                        // that of the original operation (i.e. instead part of a completely separate op for
+                        // the same session). As the key protocol commands only deal with a single operation
+                        // the assumption that the lock is part of the same operation is fine, however, were
+                        // it to become desirable for multiple operations (belonging to the same session) to
+                        // be supported then this assumption could be incorrect and lead to potential issues.
+                        lock = handler.get_lock_info( p_class_base->get_lock_class_id( ), p_class_base->get_key( ) );
+
+                        if( lock.p_session != gtp_session || lock.type != op_lock::e_lock_type_destroy )
                         {
-                           p_class_base->iterate_stop( );
-                           return false;
+                           if( !handler.obtain_lock( lock_handle, p_class_base->get_lock_class_id( ),
+                            p_class_base->get_key( ), op_lock::e_lock_type_update, gtp_session, &instance, &root_instance ) )
+                           {
+                              p_class_base->iterate_stop( );
+                              return false;
+                           }
                         }
-
-                        child_instance_accessor.destroy_dynamic_instance( );
                      }
+                     else if( handler.obtain_lock( lock_handle, p_class_base->get_lock_class_id( ),
+                      p_class_base->get_key( ), op_lock::e_lock_type_destroy, gtp_session, &instance, &root_instance ) )
+                        lock_child = true;
                      else
                      {
                         p_class_base->iterate_stop( );
                         return false;
                      }
                   }
-               } while( p_class_base->iterate_next( ) );
-            }
+               }
+
+               if( next_op == e_cascade_op_destroy && ( lock_child || perform_checks ) )
+               {
+                  // NOTE: If the child instance is actually a derived class then get the derived object.
+                  sql.erase( );
+                  class_base* p_dyn_class_base( child_instance_accessor.fetch_dynamic_instance( sql, false ) );
+
+                  // FUTURE: This fetch should not actually be necessary as long as the key has been set.
+                  if( !sql.empty( ) )
+                     fetch_instance_from_db( *p_dyn_class_base, sql );
+
+                  if( lock_child )
+                     plan.locked_keys[ p_class_base->get_class_id( ) ].insert( p_class_base->get_key( ) );
+
+                  if( perform_checks )
+                     plan.checked_keys[ p_class_base->get_class_id( ) ].insert( p_class_base->get_key( ) );
+
+                  if( !plan_cascade_for_destroy( *p_dyn_class_base, plan, lock_child, perform_checks ) )
+                  {
+                     p_class_base->iterate_stop( );
+                     return false;
+                  }
+
+                  child_instance_accessor.destroy_dynamic_instance( );
+               }
+            } while( p_class_base->iterate_next( ) );
          }
       }
    }
@@ -2195,6 +2230,41 @@ bool obtain_cascade_locks_for_destroy( class_base& instance,
    return true;
 }
 
+bool is_cascade_constrained( cascade_plan& plan, string& constraining_class )
+{
+   storage_handler& handler( *gtp_session->p_storage_handler );
+
+   // NOTE: If the instance that would restrict has already been locked for destroy then it can
+   // be safely ignored. Once an actual restricting instance is found no further checks are made.
+   for( size_t i = 0; i < plan.restrictions.size( ); i++ )
+   {
+      const cascade_restriction& restriction( plan.restrictions[ i ] );
+
+      op_lock lock = handler.get_lock_info_for_owner( restriction.lock_class_id, restriction.key, plan.root_instance );
+
+      if( lock.type != op_lock::e_lock_type_destroy )
+      {
+         constraining_class = restriction.display_name;
+         return true;
+      }
+   }
+
+   // NOTE: If every collected restriction is being destroyed but some restricting children had
+   // not been collected then these are now checked (stopping at the first one that restricts).
+   if( plan.has_unchecked_restrictions )
+   {
+      cascade_plan check_plan( plan.root_instance, true, true );
+
+      if( !plan_cascade_for_destroy( plan.root_instance, check_plan, false, true ) )
+      {
+         constraining_class = check_plan.restrictions.back( ).display_name;
+         return true;
+      }
+   }
+
+   return false;
+}
+
 size_t obtain_keyed_lock( const string& lock_class, const string& key, op_lock::lock_type lock_type )
 {
    if( !gtp_session->p_storage_handler->get_ods( ) )
@@ -2584,6 +2654,81 @@ string formatted_value( const string& value, const string& field_type )
    return formatted_value;
 }
 
+void check_aggregate_field( class_base& instance,
+ string& field, bool* p_is_sql_numeric = 0, string* p_field_type = 0 )
+{
+   get_field_name( instance, field, p_is_sql_numeric, p_field_type );
+
+   if( field[ field.length( ) - 1 ] != '_' && instance.is_field_transient( instance.get_field_num( field ) ) )
+      throw runtime_error( "transient field '" + field + "' cannot be aggregated" );
+}
+
+string construct_sql_aggregate_columns( class_base& instance, const sql_aggregate_info& aggregate_info )
+{
+   string columns;
+
+   for( size_t i = 0; i < aggregate_info.group_fields.size( ); i++ )
+   {
+      string next_field( aggregate_info.group_fields[ i ] );
+      check_aggregate_field( instance, next_field );
+
+      if( !columns.empty( ) )
+         columns += ',';
+      columns += "C_" + next_field;
+   }
+
+   if( aggregate_info.aggregates.empty( ) )
+      throw runtime_error( "unexpected missing aggregates in sql select preparation" );
+
+   for( size_t i = 0; i < aggregate_info.aggregates.size( ); i++ )
+   {
+      string next( aggregate_info.aggregates[ i ] );
+
+      // NOTE: Each aggregate is expected to be in the form <function>:<field> (with the
+      // special case "count:*" being permitted for counting all the rows found).
+      string::size_type pos = next.find( ':' );
+      if( pos == string::npos )
+         throw runtime_error( "unexpected aggregate format '" + next + "'" );
+
+      string function( upper( next.substr( 0, pos ) ) );
+      string field( next.substr( pos + 1 ) );
+
+      if( function != "SUM" && function != "COUNT" && function != "MIN" && function != "MAX" )
+         throw runtime_error( "unknown aggregate function '" + next.substr( 0, pos ) + "'" );
+
+      if( !columns.empty( ) )
+         columns += ',';
+
+      if( field == "*" )
+      {
+         if( function != "COUNT" )
+            throw runtime_error( "only count can be used with '*' for aggregate '" + next + "'" );
+
+         columns += "COUNT(*)";
+      }
+      else
+      {
+         bool is_sql_numeric;
+         string field_type;
+
+         check_aggregate_field( instance, field, &is_sql_numeric, &field_type );
+
+         if( function == "SUM" && !is_sql_numeric && field_type != "numeric" )
+            throw runtime_error( "non-numeric field '" + field + "' cannot be summed" );
+
+         // NOTE: As numeric fields are stored as text they are cast in order to be summed
+         // or compared with the trailing zero decimals of the result then being removed.
+         if( function != "COUNT" && !is_sql_numeric && field_type == "numeric" )
+            columns += "TRIM(TRAILING '.' FROM TRIM(TRAILING '0' FROM "
+             + function + "(CAST(C_" + field + " AS DECIMAL(65,30)))))";
+         else
+            columns += function + "(C_" + field + ")";
+      }
+   }
+
+   return columns;
+}
+
 string construct_sql_select(
  class_base& instance,
  const vector< string >& field_info,
@@ -2591,7 +2736,8 @@ string construct_sql_select(
  const vector< pair< string, string > >& query_info,
  const vector< pair< string, string > >& fixed_info,
  const vector< pair< string, string > >& paging_info, const string& security_info,
- bool is_reverse, bool is_inclusive, int row_limit, bool only_sys_fields, const string& text_search )
+ bool is_reverse, bool is_inclusive, int row_limit, bool only_sys_fields,
+ const string& text_search, const sql_aggregate_info* p_aggregate_info = 0 )
 {
    string sql, sql_fields_and_table( "SELECT " );
 
@@ -2599,7 +2745,9 @@ string construct_sql_select(
 
    vector< string > use_index_fields;
 
-   if( field_info.empty( ) )
+   if( p_aggregate_info )
+      sql_fields_and_table += construct_sql_aggregate_columns( instance, *p_aggregate_info );
+   else if( field_info.empty( ) )
    {
       if( !only_sys_fields )
          sql_fields_and_table += "*";
@@ -3017,6 +3165,25 @@ string construct_sql_select(
       sql += "C_" + security_field + " LIKE '" + security_level + "%'";
    }
 
+   // NOTE: Grouped aggregates are ordered by the group fields (so any
+   // "order_info" is expected to be empty when aggregating).
+   if( p_aggregate_info && !p_aggregate_info->group_fields.empty( ) )
+   {
+      string group_columns;
+
+      for( size_t i = 0; i < p_aggregate_info->group_fields.size( ); i++ )
+      {
+         string next_field( p_aggregate_info->group_fields[ i ] );
+         get_field_name( instance, next_field );
+
+         if( i > 0 )
+            group_columns += ',';
+         group_columns += "C_" + next_field;
+      }
+
+      sql += " GROUP BY " + group_columns + " ORDER BY " + group_columns;
+   }
+
    if( !order_info.empty( ) )
    {
       sql += " ORDER BY ";
@@ -3510,6 +3677,9 @@ void read_server_configuration( )
       g_files_area_item_max_size = ( size_t )unformat_bytes( reader.read_opt_attribute(
        c_attribute_files_area_item_max_size, to_string( c_files_area_item_max_size_default ) ).c_str( ) );
 
+      g_fetch_cache_max_items = atoi( reader.read_opt_attribute(
+       c_attribute_fetch_cache_max_items, to_string( c_fetch_cache_max_items_default ) ).c_str( ) );
+
       reader.start_section( c_section_email );
 
       if( reader.has_started_section( c_section_mbox ) )
@@ -3995,6 +4165,36 @@ void check_timezone_info( )
       setup_timezones( );
 }
 
+void check_ods_compaction( )
+{
+   if( !gap_ods.get( ) )
+      return;
+
+   time_t now( time( 0 ) );
+
+   // NOTE: Compaction of the system ODS is performed a small number of entries at a time (with
+   // further steps occurring on later calls) so that it will never delay new sessions for long.
+   if( g_ods_compact_underway || now - g_ods_last_compacted >= c_ods_compact_interval_seconds )
+   {
+      try
+      {
+         scoped_ods_instance ods_instance( *gap_ods );
+
+         g_ods_compact_underway = gap_ods->move_some_free_data_to_end( c_ods_compact_max_entries );
+
+         if( !g_ods_compact_underway )
+            g_ods_last_compacted = now;
+      }
+      catch( exception& x )
+      {
+         g_ods_compact_underway = false;
+         g_ods_last_compacted = now;
+
+         TRACE_LOG( TRACE_ANYTHING, string( "ods compaction error: " ) + x.what( ) );
+      }
+   }
+}
+
 string get_string( const string& key )
 {
    string str( key );
@@ -4283,6 +4483,11 @@ size_t get_files_area_item_max_size( )
    return g_files_area_item_max_size;
 }
 
+size_t get_fetch_cache_max_items( )
+{
+   return g_fetch_cache_max_items;
+}
+
 string get_mbox_path( )
 {
    return g_mbox_path;
@@ -5729,6 +5934,23 @@ void set_session_variable( const string& name,
                if( p_set_special_temporary )
                   *p_set_special_temporary = true;
             }
+            else if( val.substr( 0, pos ) == "bench" )
+            {
+               p_command_handler->output_progress( "benchmarking..." );
+
+               size_t num_moves = 0;
+
+               if( pos != string::npos )
+                  num_moves = from_string< size_t >( val.substr( pos + 1 ) );
+
+               ostringstream osstr;
+               tmp_cube.benchmark( osstr, num_moves );
+
+               val = osstr.str( );
+
+               if( p_set_special_temporary )
+                  *p_set_special_temporary = true;
+            }
             else if( val.substr( 0, pos ) == "suggest" )
             {
                ostringstream osstr;
@@ -9529,6 +9751,16 @@ bool instance_iterate( size_t handle, const string& context,
     key_info, fields, text, query, security_info, direction, inclusive, row_limit, optimisation, p_filters );
 }
 
+bool instance_aggregate( size_t handle,
+ const string& context, const string& key_info, const string& text,
+ const string& query, const string& security_info, sql_aggregate_info& aggregate_info )
+{
+   return perform_instance_iterate(
+    get_class_base_from_handle_for_op( handle, context, e_permit_op_type_value_none, false ),
+    key_info, c_key_field, text, query, security_info, e_iter_direction_forwards,
+    true, 0, e_sql_optimisation_none, 0, &aggregate_info );
+}
+
 bool instance_iterate_next( size_t handle, const string& context )
 {
    return perform_instance_iterate_next(
@@ -9629,6 +9861,13 @@ void transaction_start( )
    gtp_session->transactions.push( new ods::transaction( *ods::instance( ) ) );
 }
 
+uint64_t get_data_revision( )
+{
+   guard g( g_mutex );
+
+   return g_data_revision;
+}
+
 void transaction_commit( )
 {
    if( gtp_session->transactions.empty( ) )
@@ -9671,6 +9910,8 @@ void transaction_commit( )
 
          remove_tx_info_from_cache( );
 
+         ++g_data_revision;
+
          gtp_session->tx_key_info.clear( );
          gtp_session->sql_undo_statements.clear( );
 
@@ -10285,8 +10526,9 @@ void begin_instance_op( instance_op op, class_base& instance,
          // each child's graph parent) and then check for the existence of restricting children.
          if( !is_cascade_op )
          {
-            map< string, set< string > > instance_keys;
-            if( !obtain_cascade_locks_for_destroy( instance, instance, instance_keys ) )
+            cascade_plan plan( instance, !session_skip_is_constained( ) );
+
+            if( !plan_cascade_for_destroy( instance, plan, true, plan.check_restrictions ) )
             {
                handler.release_locks_for_owner( instance, true );
 
@@ -10304,10 +10546,7 @@ void begin_instance_op( instance_op op, class_base& instance,
                    + "' cannot be destroyed as a lock to a dependent child could not be obtained" );
             }
 
-            instance_keys.clear( );
-
-            if( !session_skip_is_constained( ) )
-               is_constrained = is_child_constrained( instance, instance, constraining_class, instance_keys );
+            is_constrained = is_cascade_constrained( plan, constraining_class );
          }
 
          if( is_constrained )
@@ -10784,8 +11023,8 @@ void perform_instance_fetch( class_base& instance,
 
 bool perform_instance_iterate( class_base& instance,
  const string& key_info, const string& fields, const string& text,
- const string& query, const string& security_info, iter_direction direction,
- bool inclusive, int row_limit, sql_optimisation optimisation, const set< string >* p_filters )
+ const string& query, const string& security_info, iter_direction direction, bool inclusive,
+ int row_limit, sql_optimisation optimisation, const set< string >* p_filters, sql_aggregate_info* p_aggregate_info )
 {
    bool found = false;
 
@@ -11073,6 +11312,43 @@ bool perform_instance_iterate( class_base& instance,
             }
          }
 
+         if( p_aggregate_info )
+         {
+            if( instance.get_persistence_type( ) != 0 ) // i.e. SQL persistence
+               throw runtime_error( "aggregates are only supported for SQL persistence" );
+
+            // NOTE: As filtering is performed after records have been fetched from the DB any
+            // filters (including transient field ones) will prevent aggregates from being used.
+            if( p_filters || !instance_accessor.transient_filter_field_values( ).empty( ) )
+               throw runtime_error( "aggregates cannot be used with filters or transient field queries" );
+
+            sql = construct_sql_select( instance,
+             field_info, vector< string >( ), query_info, fixed_info, paging_info, security_info,
+             ( direction == e_iter_direction_backwards ), inclusive, 0, true, text, p_aggregate_info );
+
+            TRACE_LOG( TRACE_SQLSTMTS, sql );
+
+            p_aggregate_info->results.clear( );
+
+            sql_dataset ds( *gtp_session->ap_db.get( ), sql );
+
+            while( ds.next( ) )
+            {
+               string next;
+
+               for( int i = 0; i < ds.get_fieldcount( ); i++ )
+               {
+                  if( i > 0 )
+                     next += ',';
+                  next += escaped( ds.as_string( i ), "," );
+               }
+
+               p_aggregate_info->results.push_back( next );
+            }
+
+            return !p_aggregate_info->results.empty( );
+         }
+
          if( instance.get_persistence_type( ) == 0 ) // i.e. SQL persistence
          {
             sql = construct_sql_select( instance,
@@ -93,6 +93,7 @@ void CIYAM_BASE_DECL_SPEC init_globals( );
 void CIYAM_BASE_DECL_SPEC term_globals( );
 
 void CIYAM_BASE_DECL_SPEC check_timezone_info( );
+void CIYAM_BASE_DECL_SPEC check_ods_compaction( );
 
 std::string CIYAM_BASE_DECL_SPEC get_string( const std::string& key );
 
@@ -152,6 +153,8 @@ bool CIYAM_BASE_DECL_SPEC get_using_ssl( );
 size_t CIYAM_BASE_DECL_SPEC get_files_area_item_max_num( );
 size_t CIYAM_BASE_DECL_SPEC get_files_area_item_max_size( );
 
+size_t CIYAM_BASE_DECL_SPEC get_fetch_cache_max_items( );
+
 std::string CIYAM_BASE_DECL_SPEC get_mbox_path( );
 std::string CIYAM_BASE_DECL_SPEC get_mbox_username( );
 
@@ -698,6 +701,18 @@ bool CIYAM_BASE_DECL_SPEC instance_iterate( size_t handle,
 bool CIYAM_BASE_DECL_SPEC instance_iterate_next( size_t handle, const std::string& context );
 void CIYAM_BASE_DECL_SPEC instance_iterate_stop( size_t handle, const std::string& context );
 
+struct sql_aggregate_info
+{
+   std::vector< std::string > aggregates;
+   std::vector< std::string > group_fields;
+
+   std::vector< std::string > results;
+};
+
+bool CIYAM_BASE_DECL_SPEC instance_aggregate( size_t handle,
+ const std::string& context, const std::string& key_info, const std::string& text,
+ const std::string& query, const std::string& security_info, sql_aggregate_info& aggregate_info );
+
 bool CIYAM_BASE_DECL_SPEC instance_filtered( size_t handle, const std::string& context );
 bool CIYAM_BASE_DECL_SPEC instance_has_transient_filter_fields( size_t handle, const std::string& context );
 
@@ -720,6 +735,8 @@ void CIYAM_BASE_DECL_SPEC op_instance_cancel( size_t handle, const std::string&
 
 void CIYAM_BASE_DECL_SPEC output_progress_message( const std::string& message );
 
+uint64_t CIYAM_BASE_DECL_SPEC get_data_revision( );
+
 void CIYAM_BASE_DECL_SPEC transaction_start( );
 void CIYAM_BASE_DECL_SPEC transaction_commit( );
 void CIYAM_BASE_DECL_SPEC transaction_rollback( );
@@ -805,7 +822,8 @@ bool CIYAM_BASE_DECL_SPEC perform_instance_iterate(
  const std::string& fields, const std::string& text,
  const std::string& query, const std::string& security_info,
  iter_direction direction, bool inclusive = true, int row_limit = 0,
- sql_optimisation optimisation = e_sql_optimisation_none, const std::set< std::string >* p_filters = 0 );
+ sql_optimisation optimisation = e_sql_optimisation_none,
+ const std::set< std::string >* p_filters = 0, sql_aggregate_info* p_aggregate_info = 0 );
 
 bool CIYAM_BASE_DECL_SPEC perform_instance_iterate_next( class_base& instance );
 
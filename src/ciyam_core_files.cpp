@@ -546,6 +546,84 @@ string::size_type insert_account_into_transaction_log_line( const string& accoun
    return pos;
 }
 
+// NOTE: As checking the signature is the most expensive part of verifying a block or transaction
+// it is checked before the core files mutex is acquired (so that other sessions are not held up
+// waiting for it). The result is only used if the same public key, signature and signed content
+// are later found when the file is being verified (otherwise it will be checked as before).
+struct signature_check
+{
+   signature_check( ) : is_valid( false ) { }
+
+   bool matches( const string& verify, const string& signature, const string& public_key_base64 ) const
+   {
+      return !this->signature.empty( ) && this->signature == signature
+       && this->public_key_base64 == public_key_base64 && this->verify == verify;
+   }
+
+   string verify;
+   string address;
+   string signature;
+   string public_key_base64;
+
+   bool is_valid;
+};
+
+void check_signature( signature_check& check, const vector< string >& lines,
+ const char* p_object_type, const char* p_public_key_prefix, const char* p_signature_prefix )
+{
+   if( lines.empty( ) )
+      return;
+
+   vector< string > attributes;
+   split( lines[ 0 ], attributes );
+
+   for( size_t i = 0; i < attributes.size( ); i++ )
+   {
+      string::size_type pos = attributes[ i ].find( p_public_key_prefix );
+
+      if( pos != string::npos )
+      {
+         check.public_key_base64 = attributes[ i ].substr( pos + strlen( p_public_key_prefix ) );
+         break;
+      }
+   }
+
+   if( check.public_key_base64.empty( ) )
+      return;
+
+   string verify( string( p_object_type ) + ':' + lines[ 0 ] );
+
+   for( size_t i = 1; i < lines.size( ); i++ )
+   {
+      if( lines[ i ].find( p_signature_prefix ) == 0 )
+      {
+         check.verify = verify;
+         check.signature = lines[ i ].substr( strlen( p_signature_prefix ) );
+         break;
+      }
+
+      verify += "\n" + lines[ i ];
+   }
+
+   if( check.signature.empty( ) )
+      return;
+
+#ifdef SSL_SUPPORT
+   try
+   {
+      public_key pkey( check.public_key_base64, true );
+
+      check.address = pkey.get_address( true, true );
+      check.is_valid = pkey.verify_signature( check.verify, check.signature );
+   }
+   catch( ... )
+   {
+      // NOTE: Any error will instead be reported when the file is being verified.
+      check.signature.erase( );
+   }
+#endif
+}
+
 pair< uint64_t, uint64_t > verify_block( const string& content,
  bool check_sigs, vector< pair< string, string > >* p_extras, block_info* p_block_info = 0 );
 
@@ -728,11 +806,17 @@ string get_block_hash_for_account_and_height( const string& chain_id,
 pair< uint64_t, uint64_t > verify_block( const string& content,
  bool check_sigs, vector< pair< string, string > >* p_extras, block_info* p_block_info )
 {
-   guard g( g_mutex, "verify_block" );
-
    vector< string > lines;
    split( content, lines, '\n', c_esc, false );
 
+   signature_check block_signature_check;
+
+   if( check_sigs )
+      check_signature( block_signature_check, lines, c_file_type_core_block_object,
+       c_file_type_core_block_header_public_key_prefix, c_file_type_core_block_detail_signature_prefix );
+
+   guard g( g_mutex, "verify_block" );
+
    if( lines.empty( ) )
       throw runtime_error( "unexpected empty block content" );
 
@@ -1287,13 +1371,24 @@ pair< uint64_t, uint64_t > verify_block( const string& content,
          had_signature = true;
          block_signature = next_line;
 #ifdef SSL_SUPPORT
-         public_key pkey( public_key_base64, true );
+         if( block_signature_check.matches( verify, block_signature, public_key_base64 ) )
+         {
+            if( block_height )
+               mint_address = block_signature_check.address;
+
+            if( !block_signature_check.is_valid )
+               throw runtime_error( "invalid block signature" );
+         }
+         else
+         {
+            public_key pkey( public_key_base64, true );
 
-         if( block_height )
-            mint_address = pkey.get_address( true, true );
+            if( block_height )
+               mint_address = pkey.get_address( true, true );
 
-         if( check_sigs && !pkey.verify_signature( verify, block_signature ) )
-            throw runtime_error( "invalid block signature" );
+            if( check_sigs && !pkey.verify_signature( verify, block_signature ) )
+               throw runtime_error( "invalid block signature" );
+         }
 #endif
       }
       else
@@ -2433,11 +2528,17 @@ void verify_rewind( const string& content, vector< pair< string, string > >* p_e
 void verify_transaction( const string& content, bool check_sigs,
  vector< pair< string, string > >* p_extras, transaction_info* p_transaction_info )
 {
-   guard g( g_mutex, "verify_transaction" );
-
    vector< string > lines;
    split( content, lines, '\n', c_esc, false );
 
+   signature_check transaction_signature_check;
+
+   if( check_sigs )
+      check_signature( transaction_signature_check, lines, c_file_type_core_transaction_object,
+       c_file_type_core_transaction_header_public_key_prefix, c_file_type_core_transaction_detail_signature_prefix );
+
+   guard g( g_mutex, "verify_transaction" );
+
    if( lines.empty( ) )
       throw runtime_error( "unexpected empty transaction content" );
 
@@ -2664,12 +2765,22 @@ void verify_transaction( const string& content, bool check_sigs,
          transaction_signature = next_line;
 
 #ifdef SSL_SUPPORT
-         public_key pkey( public_key_base64, true );
+         if( transaction_signature_check.matches( verify, transaction_signature, public_key_base64 ) )
+         {
+            transaction_address = transaction_signature_check.address;
+
+            if( !transaction_signature_check.is_valid )
+               throw runtime_error( "invalid transaction signature" );
+         }
+         else
+         {
+            public_key pkey( public_key_base64, true );
 
-         transaction_address = pkey.get_address( true, true );
+            transaction_address = pkey.get_address( true, true );
 
-         if( check_sigs && !pkey.verify_signature( verify, transaction_signature ) )
-            throw runtime_error( "invalid transaction signature" );
+            if( check_sigs && !pkey.verify_signature( verify, transaction_signature ) )
+               throw runtime_error( "invalid transaction signature" );
+         }
 #endif
       }
       else
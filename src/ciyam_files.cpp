@@ -12,6 +12,8 @@
 #  include <cstring>
 #  include <map>
 #  include <set>
+#  include <vector>
+#  include <algorithm>
 #  include <memory>
 #  include <fstream>
 #  include <stdexcept>
@@ -120,6 +122,489 @@ string construct_file_name_from_hash( const string& hash,
    return filename;
 }
 
+const char* const c_files_area_index_file = "files.idx";
+const char* const c_files_area_index_version = "ciyam_files_idx 2";
+
+const size_t c_files_area_scan_threads = 8;
+
+const size_t c_files_area_index_checkpoint_changes = 1000;
+
+struct files_dir_info
+{
+   files_dir_info( ) : mtime( 0 ), num_files( 0 ), num_bytes( 0 ) { }
+
+   time_t mtime;
+
+   size_t num_files;
+   int64_t num_bytes;
+};
+
+// NOTE: Per sub-directory totals (along with the mtime that was observed after the last change that
+// was made to the directory) are kept so that these can be written to the files area index and then
+// trusted at startup for any sub-directory whose mtime has not since changed.
+map< string, files_dir_info > g_files_dir_info;
+
+time_t g_files_root_mtime = 0;
+
+size_t g_files_area_changes = 0;
+
+void checkpoint_files_area_index( );
+
+void update_files_dir_info( const string& filename, int files_change, int64_t bytes_change )
+{
+   string::size_type pos = filename.find_last_of( "/\\" );
+
+   if( pos != string::npos && pos >= 2 )
+   {
+      files_dir_info& info( g_files_dir_info[ filename.substr( pos - 2, 2 ) ] );
+
+      info.num_files += files_change;
+      info.num_bytes += bytes_change;
+
+      info.mtime = last_modification_time( filename.substr( 0, pos ) );
+   }
+
+   if( ++g_files_area_changes >= c_files_area_index_checkpoint_changes )
+      checkpoint_files_area_index( );
+}
+
+void update_files_root_mtime( )
+{
+   g_files_root_mtime = last_modification_time( c_files_directory );
+
+   if( ++g_files_area_changes >= c_files_area_index_checkpoint_changes )
+      checkpoint_files_area_index( );
+}
+
+struct files_dir_scan
+{
+   files_dir_scan( const string& name, bool stat_files )
+    :
+    name( name ),
+    stat_files( stat_files ),
+    mtime( 0 )
+   {
+   }
+
+   string name;
+   bool stat_files;
+
+   time_t mtime;
+
+   vector< pair< string, int64_t > > files;
+};
+
+void scan_files_dir( const string& path, files_dir_scan& scan )
+{
+   string dir_path( path + '/' + scan.name );
+
+   scan.mtime = last_modification_time( dir_path );
+
+   file_filter ff;
+   fs_iterator fs( dir_path, &ff );
+
+   while( fs.has_next( ) )
+      scan.files.push_back( make_pair( fs.get_name( ),
+       scan.stat_files ? file_size( fs.get_full_name( ) ) : ( int64_t )0 ) );
+}
+
+class files_dir_scanner
+{
+   public:
+   files_dir_scanner( const string& path, vector< files_dir_scan >& scans )
+    :
+    path( path ),
+    scans( scans ),
+    next_scan( 0 )
+   {
+   }
+
+   void scan( size_t num_threads );
+
+   bool scan_next( );
+
+   private:
+   string path;
+   vector< files_dir_scan >& scans;
+
+   size_t next_scan;
+
+   string error;
+
+   mutex lock;
+};
+
+void files_dir_scanner::scan( size_t num_threads )
+{
+   if( num_threads > scans.size( ) )
+      num_threads = scans.size( );
+
+   run_in_threads( *this, &files_dir_scanner::scan_next, num_threads );
+
+   if( !error.empty( ) )
+      throw runtime_error( error );
+}
+
+bool files_dir_scanner::scan_next( )
+{
+   size_t next;
+
+   {
+      guard g( lock );
+
+      if( next_scan >= scans.size( ) || !error.empty( ) )
+         return false;
+
+      next = next_scan++;
+   }
+
+   try
+   {
+      scan_files_dir( path, scans[ next ] );
+   }
+   catch( exception& x )
+   {
+      guard g( lock );
+      error = x.what( );
+   }
+   catch( ... )
+   {
+      guard g( lock );
+      error = "unexpected exception scanning files area directory";
+   }
+
+   return true;
+}
+
+struct files_area_index
+{
+   files_area_index( ) : written( 0 ), max_num( 0 ), max_size( 0 ), root_mtime( 0 ) { }
+
+   time_t written;
+
+   size_t max_num;
+   size_t max_size;
+
+   time_t root_mtime;
+
+   vector< pair< string, string > > tags;
+
+   map< string, files_dir_info > dirs;
+};
+
+bool read_files_area_index( const string& index_file_name, files_area_index& index )
+{
+   ifstream inpf( index_file_name.c_str( ) );
+
+   if( !inpf )
+      return false;
+
+   string next;
+   if( !getline( inpf, next ) || next != string( c_files_area_index_version ) )
+      return false;
+
+   size_t num_tags = 0;
+
+   if( !( inpf >> index.written >> index.max_num >> index.max_size >> index.root_mtime >> num_tags ) )
+      return false;
+
+   // NOTE: A directory could have been changed again within the same second that it had last
+   // been changed in (without its mtime changing) so any mtime that is not prior to the second
+   // in which the index was written is not trusted.
+   if( index.root_mtime >= index.written )
+      index.root_mtime = 0;
+
+   for( size_t i = 0; i < num_tags; i++ )
+   {
+      string hash, tag;
+
+      if( !( inpf >> hash ) || !getline( inpf, tag ) || tag.size( ) < 2 )
+         return false;
+
+      index.tags.push_back( make_pair( hash, tag.substr( 1 ) ) );
+   }
+
+   size_t num_dirs = 0;
+
+   if( !( inpf >> num_dirs ) )
+      return false;
+
+   for( size_t i = 0; i < num_dirs; i++ )
+   {
+      string name;
+      files_dir_info info;
+
+      if( !( inpf >> name >> info.mtime >> info.num_files >> info.num_bytes ) )
+         return false;
+
+      if( info.mtime >= index.written )
+         info.mtime = 0;
+
+      index.dirs.insert( make_pair( name, info ) );
+   }
+
+   if( !getline( inpf, next ) || !getline( inpf, next ) || next != "." )
+      return false;
+
+   return true;
+}
+
+void write_files_area_index( const string& index_file_name )
+{
+   string tmp_file_name( index_file_name + ".tmp" );
+
+   // NOTE: A directory whose mtime is the current second could still be changed again without its
+   // mtime changing so a zero mtime is written instead (which will cause the directory to be re-scanned).
+   time_t now = time( 0 );
+
+   time_t root_mtime = last_modification_time( c_files_directory );
+
+   if( root_mtime != g_files_root_mtime || root_mtime >= now )
+      root_mtime = 0;
+
+   {
+      ofstream outf( tmp_file_name.c_str( ) );
+
+      if( !outf )
+         throw runtime_error( "unable to open file '" + tmp_file_name + "' for output" );
+
+      outf << c_files_area_index_version << '\n';
+
+      outf << now << ' ' << get_files_area_item_max_num( ) << ' ' << get_files_area_item_max_size( )
+       << ' ' << root_mtime << ' ' << g_tag_hashes.size( ) << '\n';
+
+      for( map< string, string >::iterator i = g_tag_hashes.begin( ); i != g_tag_hashes.end( ); ++i )
+         outf << i->second << ' ' << i->first << '\n';
+
+      outf << g_files_dir_info.size( ) << '\n';
+
+      for( map< string, files_dir_info >::iterator i = g_files_dir_info.begin( ); i != g_files_dir_info.end( ); ++i )
+      {
+         string dir_path( string( c_files_directory ) + '/' + i->first );
+
+         time_t mtime = 0;
+
+         if( file_exists( dir_path ) )
+            mtime = last_modification_time( dir_path );
+
+         if( mtime != i->second.mtime || mtime >= now )
+            mtime = 0;
+
+         outf << i->first << ' ' << mtime << ' ' << i->second.num_files << ' ' << i->second.num_bytes << '\n';
+      }
+
+      outf << ".\n";
+
+      outf.flush( );
+      if( !outf.good( ) )
+         throw runtime_error( "unexpected bad output stream" );
+   }
+
+   if( !file_rename( tmp_file_name, index_file_name ) )
+      throw runtime_error( "unable to rename '" + tmp_file_name + "' to '" + index_file_name + "'" );
+}
+
+// NOTE: As every change made to the files area changes the mtime of the directory that was changed
+// an index that was written before later changes is still safe to use at startup (as any directory
+// that was changed will be rescanned) so the index is rewritten after loading and then after every
+// "c_files_area_index_checkpoint_changes" changes in order to limit what needs to be rescanned if
+// the server is not shutdown cleanly. Failing to write the index is not treated as an error as it
+// will just result in more directories needing to be scanned at the next startup.
+void checkpoint_files_area_index( )
+{
+   g_files_area_changes = 0;
+
+   try
+   {
+      write_files_area_index( c_files_area_index_file );
+   }
+   catch( ... )
+   {
+      file_remove( c_files_area_index_file );
+   }
+}
+
+void load_files_area( files_area_index* p_index, vector< string >* p_untagged )
+{
+   size_t max_num = get_files_area_item_max_num( );
+   size_t max_size = get_files_area_item_max_size( );
+
+   // NOTE: If either limit has been reduced then every file needs to be checked again.
+   if( p_index && ( max_num < p_index->max_num || max_size < p_index->max_size ) )
+      p_index = 0;
+
+   string files_path( c_files_directory );
+
+   g_files_dir_info.clear( );
+
+   time_t root_mtime = last_modification_time( files_path );
+
+   bool use_index_tags = ( p_index && p_index->root_mtime && p_index->root_mtime == root_mtime );
+
+   if( !use_index_tags )
+   {
+      bool had_removal = false;
+
+      file_filter ff;
+      fs_iterator fs( files_path, &ff );
+
+      while( fs.has_next( ) )
+      {
+         string data( buffer_file( fs.get_full_name( ) ) );
+         string filename( construct_file_name_from_hash( data, false, false ) );
+
+         if( !file_exists( filename ) )
+         {
+            had_removal = true;
+            file_remove( fs.get_full_name( ) );
+         }
+
+         g_hash_tags.insert( make_pair( data, fs.get_name( ) ) );
+         g_tag_hashes.insert( make_pair( fs.get_name( ), data ) );
+      }
+
+      if( had_removal )
+         root_mtime = last_modification_time( files_path );
+   }
+
+   g_files_root_mtime = root_mtime;
+
+   vector< string > dir_names;
+
+   {
+      directory_filter df;
+      fs_iterator dfsi( files_path, &df );
+
+      while( dfsi.has_next( ) )
+         dir_names.push_back( dfsi.get_name( ) );
+   }
+
+   sort( dir_names.begin( ), dir_names.end( ) );
+
+   // NOTE: Any sub-directory that is not in the index (or whose mtime differs from the one found
+   // in the index) is scanned (with "stat" calls being skipped for unchanged sub-directories that
+   // only need scanning in order to identify untagged files).
+   vector< files_dir_scan > scans;
+   set< string > rescanned_dirs;
+
+   for( size_t i = 0; i < dir_names.size( ); i++ )
+   {
+      const string& name( dir_names[ i ] );
+
+      bool is_unchanged = false;
+
+      if( p_index )
+      {
+         map< string, files_dir_info >::iterator di = p_index->dirs.find( name );
+
+         if( di != p_index->dirs.end( ) && di->second.mtime
+          && di->second.mtime == last_modification_time( files_path + '/' + name ) )
+            is_unchanged = true;
+      }
+
+      if( !is_unchanged )
+         rescanned_dirs.insert( name );
+
+      if( !is_unchanged || p_untagged )
+         scans.push_back( files_dir_scan( name, !is_unchanged ) );
+   }
+
+   if( use_index_tags )
+   {
+      bool had_removal = false;
+
+      for( size_t i = 0; i < p_index->tags.size( ); i++ )
+      {
+         const string& hash( p_index->tags[ i ].first );
+         const string& tag( p_index->tags[ i ].second );
+
+         // NOTE: Only tags for files in sub-directories that have changed need to be checked.
+         if( rescanned_dirs.count( lower( hash.substr( 0, 2 ) ) )
+          && !file_exists( construct_file_name_from_hash( hash, false, false ) ) )
+         {
+            had_removal = true;
+            file_remove( files_path + '/' + tag );
+         }
+
+         g_hash_tags.insert( make_pair( hash, tag ) );
+         g_tag_hashes.insert( make_pair( tag, hash ) );
+      }
+
+      if( had_removal )
+         g_files_root_mtime = last_modification_time( files_path );
+   }
+
+   files_dir_scanner scanner( files_path, scans );
+   scanner.scan( c_files_area_scan_threads );
+
+   size_t next_scan = 0;
+
+   for( size_t i = 0; i < dir_names.size( ); i++ )
+   {
+      const string& name( dir_names[ i ] );
+      string dir_path( files_path + '/' + name );
+
+      files_dir_scan* p_scan = 0;
+
+      if( next_scan < scans.size( ) && scans[ next_scan ].name == name )
+         p_scan = &scans[ next_scan++ ];
+
+      files_dir_info info;
+
+      if( !rescanned_dirs.count( name ) )
+      {
+         info = p_index->dirs[ name ];
+
+         g_total_files += info.num_files;
+         g_total_bytes += info.num_bytes;
+      }
+      else
+      {
+         info.mtime = p_scan->mtime;
+
+         bool had_removal = false;
+
+         for( size_t j = 0; j < p_scan->files.size( ); j++ )
+         {
+            string file_path( dir_path + '/' + p_scan->files[ j ].first );
+            int64_t size = p_scan->files[ j ].second;
+
+            if( size > ( int64_t )max_size || g_total_files >= max_num )
+            {
+               had_removal = true;
+               file_remove( file_path );
+
+               p_scan->files[ j ].second = -1;
+            }
+            else
+            {
+               ++info.num_files;
+               info.num_bytes += size;
+
+               ++g_total_files;
+               g_total_bytes += size;
+            }
+         }
+
+         if( had_removal )
+            info.mtime = last_modification_time( dir_path );
+      }
+
+      if( p_untagged && p_scan )
+      {
+         for( size_t j = 0; j < p_scan->files.size( ); j++ )
+         {
+            string hash( name + p_scan->files[ j ].first );
+
+            if( p_scan->files[ j ].second >= 0 && !g_hash_tags.count( hash ) )
+               p_untagged->push_back( hash );
+         }
+      }
+
+      g_files_dir_info.insert( make_pair( name, info ) );
+   }
+}
+
 void validate_list( const string& data, bool* p_rc = 0 )
 {
    vector< string > list_items;
@@ -325,87 +810,30 @@ string get_file_stats( )
 
 void init_files_area( vector< string >* p_untagged )
 {
-   string cwd( get_cwd( ) );
-
-   try
-   {
-      bool rc;
-      set_cwd( c_files_directory, &rc );
-
-      if( !rc )
-         create_dir( c_files_directory, &rc, ( dir_perms )c_directory_perm_val );
-      else
-      {
-         directory_filter df;
-         fs_iterator dfsi( ".", &df );
-
-         bool is_first = true;
-         do
-         {
-            size_t max_num = get_files_area_item_max_num( );
-            size_t max_size = get_files_area_item_max_size( );
-
-            file_filter ff;
-            fs_iterator fs( dfsi.get_path_name( ), &ff );
-
-            vector< string > files_to_delete;
-
-            while( fs.has_next( ) )
-            {
-               if( is_first )
-               {
-                  string data( buffer_file( fs.get_full_name( ) ) );
-                  string filename( construct_file_name_from_hash( data, false, false ) );
-
-                  if( !file_exists( "../" + filename ) )
-                     file_remove( fs.get_full_name( ) );
-
-                  g_hash_tags.insert( make_pair( data, fs.get_name( ) ) );
-                  g_tag_hashes.insert( make_pair( fs.get_name( ), data ) );
-               }
-               else
-               {
-                  string file_path( fs.get_full_name( ) );
-
-                  if( file_size( file_path ) > max_size )
-                     files_to_delete.push_back( file_path );
-                  else if( g_total_files >= max_num )
-                     files_to_delete.push_back( file_path );
-                  else
-                  {
-                     ++g_total_files;
-                     g_total_bytes += file_size( file_path );
-
-                     if( p_untagged )
-                     {
-                        string::size_type pos = file_path.find_last_of( "/\\" );
-                        if( pos != string::npos && pos >= 2 )
-                        {
-                           string hash( file_path.substr( pos - 2, 2 ) );
-                           hash += file_path.substr( pos + 1 );
-
-                           if( !g_hash_tags.count( hash ) )
-                              p_untagged->push_back( hash );
-                        }
-                     }
-                  }
-               }
-            }
+   guard g( g_mutex );
 
-            is_first = false;
+   bool rc;
+   string cwd( get_cwd( ) );
 
-            for( size_t i = 0; i < files_to_delete.size( ); i++ )
-               file_remove( files_to_delete[ i ] );
+   set_cwd( c_files_directory, &rc );
 
-         } while( dfsi.has_next( ) );
-      }
+   if( !rc )
+   {
+      create_dir( c_files_directory, &rc, ( dir_perms )c_directory_perm_val );
 
-      set_cwd( cwd );
+      if( file_exists( c_files_area_index_file ) )
+         file_remove( c_files_area_index_file );
    }
-   catch( ... )
+   else
    {
       set_cwd( cwd );
-      throw;
+
+      files_area_index index;
+      bool has_index = read_files_area_index( c_files_area_index_file, index );
+
+      load_files_area( has_index ? &index : 0, p_untagged );
+
+      checkpoint_files_area_index( );
    }
 }
 
@@ -413,17 +841,36 @@ void resync_files_area( vector< string >* p_untagged )
 {
    guard g( g_mutex );
 
+   // NOTE: The in-memory information is used as though it had been read from the index
+   // so that only sub-directories whose mtime has changed will need to be re-scanned.
+   files_area_index index;
+
+   index.max_num = get_files_area_item_max_num( );
+   index.max_size = get_files_area_item_max_size( );
+
+   index.root_mtime = g_files_root_mtime;
+
+   for( map< string, string >::iterator i = g_tag_hashes.begin( ); i != g_tag_hashes.end( ); ++i )
+      index.tags.push_back( make_pair( i->second, i->first ) );
+
+   index.dirs = g_files_dir_info;
+
    g_hash_tags.clear( );
    g_tag_hashes.clear( );
 
    g_total_bytes = g_total_files = 0;
 
-   init_files_area( p_untagged );
+   load_files_area( &index, p_untagged );
+
+   checkpoint_files_area_index( );
 }
 
 void term_files_area( )
 {
-   // FUTURE: Implementation to be added.
+   guard g( g_mutex );
+
+   if( file_exists( c_files_directory ) )
+      write_files_area_index( c_files_area_index_file );
 }
 
 string current_timestamp_tag( bool truncated, size_t days_ahead )
@@ -783,9 +1230,12 @@ string create_raw_file( const string& data, bool compress, const char* p_tag, bo
          throw runtime_error( "unable to create output file '" + filename + "'" );
 
       outf << final_data;
+      outf.close( );
 
       ++g_total_files;
       g_total_bytes += final_data.size( );
+
+      update_files_dir_info( filename, 1, final_data.size( ) );
    }
    else if( p_is_existing )
       *p_is_existing = true;
@@ -914,7 +1364,11 @@ void tag_del( const string& name, bool unlink )
 
       tag_filename += "/" + name;
 
-      file_remove( tag_filename );
+      if( file_exists( tag_filename ) )
+      {
+         file_remove( tag_filename );
+         update_files_root_mtime( );
+      }
 
       if( g_tag_hashes.count( name ) )
       {
@@ -1023,6 +1477,9 @@ void tag_file( const string& name, const string& hash )
          if( !outf.good( ) )
             throw runtime_error( "unexpected bad output stream" );
 
+         outf.close( );
+         update_files_root_mtime( );
+
          g_hash_tags.insert( make_pair( hash, tag_name ) );
          g_tag_hashes.insert( make_pair( tag_name, hash ) );
       }
@@ -1218,12 +1675,32 @@ string hash_with_nonce( const string& hash, const string& nonce )
 
 void fetch_file( const string& hash, tcp_socket& socket, progress* p_progress )
 {
-   string tmp_filename( "~" + uuid( ).as_string( ) );
    string filename( construct_file_name_from_hash( hash, false, false ) );
 
 #ifndef _WIN32
-   int um = umask( 077 );
-#endif
+   ifstream inpf;
+
+   // NOTE: Rather than copying the file to a temporary file (in case it is deleted or replaced
+   // whilst being transferred) it is opened whilst holding the lock. As files are only ever
+   // removed or replaced by renaming over them the open descriptor will continue to refer to
+   // the original content until the transfer has completed.
+   {
+      guard g( g_mutex );
+
+      if( !file_exists( filename ) )
+         throw runtime_error( "file '" + hash + "' was not found" );
+
+      inpf.open( filename.c_str( ), ios::in | ios::binary );
+
+      if( !inpf )
+         throw runtime_error( "unable to open file '" + hash + "' for input" );
+   }
+
+   file_transfer( inpf, socket, c_response_okay_more,
+    c_file_transfer_initial_timeout, c_file_transfer_line_timeout, c_file_transfer_max_line_size, 0, p_progress );
+#else
+   string tmp_filename( "~" + uuid( ).as_string( ) );
+
    try
    {
       // NOTE: As the file may end up being deleted whilst it is being
@@ -1244,20 +1721,15 @@ void fetch_file( const string& hash, tcp_socket& socket, progress* p_progress )
        c_response_okay_more, c_file_transfer_initial_timeout,
        c_file_transfer_line_timeout, c_file_transfer_max_line_size, 0, 0, 0, p_progress );
 
-#ifndef _WIN32
-      umask( um );
-#endif
       file_remove( tmp_filename );
    }
    catch( ... )
    {
-#ifndef _WIN32
-      umask( um );
-#endif
       file_remove( tmp_filename );
 
       throw;
    }
+#endif
 }
 
 void store_file( const string& hash, tcp_socket& socket,
@@ -1373,7 +1845,27 @@ void store_file( const string& hash, tcp_socket& socket,
          }
 
          if( !is_in_blacklist )
+         {
+#ifndef _WIN32
+            // NOTE: An existing file is replaced by renaming over it rather than being rewritten
+            // in place so that a "fetch_file" still reading the original (via its already opened
+            // descriptor) is unaffected.
+            if( !file_rename( tmp_filename, filename ) )
+            {
+               string new_filename( filename + "~" );
+
+               file_copy( tmp_filename, new_filename );
+
+               if( !file_rename( new_filename, filename ) )
+               {
+                  file_remove( new_filename );
+                  throw runtime_error( "unable to replace file '" + hash + "'" );
+               }
+            }
+#else
             file_copy( tmp_filename, filename );
+#endif
+         }
 
          file_remove( tmp_filename );
 
@@ -1382,8 +1874,12 @@ void store_file( const string& hash, tcp_socket& socket,
 
          if( !is_in_blacklist )
          {
+            int64_t new_bytes = file_size( filename );
+
             g_total_bytes -= existing_bytes;
-            g_total_bytes += file_size( filename );
+            g_total_bytes += new_bytes;
+
+            update_files_dir_info( filename, !existing, new_bytes - existing_bytes );
          }
       }
    }
@@ -1438,6 +1934,8 @@ void delete_file( const string& hash, bool even_if_tagged )
 
       --g_total_files;
       g_total_bytes -= existing_bytes;
+
+      update_files_dir_info( filename, -1, -existing_bytes );
    }   
 }
 
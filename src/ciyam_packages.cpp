@@ -13,9 +13,11 @@
 #  include <map>
 #  include <set>
 #  include <deque>
+#  include <memory>
 #  include <vector>
 #  include <fstream>
 #  include <iostream>
+#  include <algorithm>
 #  include <stdexcept>
 #endif
 
@@ -24,6 +26,7 @@
 #include "ciyam_packages.h"
 
 #include "sio.h"
+#include "threads.h"
 #include "utilities.h"
 #include "ciyam_base.h"
 #include "class_base.h"
@@ -51,7 +54,8 @@ void export_data( ostream& outs,
  map< string, set< string > >& exported_records, map< string, set< string > >& exported_children,
  deque< pair< string, string > >& next_pass, map< string, set< string > >& will_be_exported,
  map< string, set< string > >& partial_export, const map< string, int >& rounds,
- int current_round, map< int, deque< pair< string, string > > >& future_rounds, time_t& ts, size_t& total )
+ int current_round, map< int, deque< pair< string, string > > >& future_rounds,
+ time_t start_time, time_t& ts, size_t& total )
 {
    size_t handle = create_object_instance( module, class_id );
    class_base& cb( get_class_base_from_handle_for_op( handle, "" ) );
@@ -188,7 +192,7 @@ void export_data( ostream& outs,
                export_data( outs, module, all_field_data[ i ].class_id,
                 all_field_data[ i ].value, last_class_id, output_fk_children, handler,
                 all_class_ids, excludes, tests, includes, exported_records, exported_children,
-                next_pass, will_be_exported, partial_export, rounds, current_round, future_rounds, ts, total );
+                next_pass, will_be_exported, partial_export, rounds, current_round, future_rounds, start_time, ts, total );
             else if( !all_field_data[ i ].mandatory )
             {
                // NOTE: If a foreign key cannot be processed first but is not mandatory (as is often
@@ -269,7 +273,8 @@ void export_data( ostream& outs,
          {
             ts = time( 0 );
             // FUTURE: This message should be handled as a server string message.
-            handler.output_progress( "Processed " + to_string( total ) + " records..." );
+            handler.output_progress( "Processed " + to_string( total )
+             + " records (" + to_string( total / ( ts - start_time ) ) + " per second)..." );
          }
       }
 
@@ -324,7 +329,7 @@ void export_data( ostream& outs,
                         export_data( outs, module, p_class_base->get_class_id( ),
                          p_class_base->get_key( ), last_class_id, true, handler, all_class_ids,
                          excludes, tests, includes, exported_records, exported_children, next_pass,
-                         will_be_exported, partial_export, rounds, current_round, future_rounds, ts, total );
+                         will_be_exported, partial_export, rounds, current_round, future_rounds, start_time, ts, total );
                      } while( p_class_base->iterate_next( ) );
                   }
                }
@@ -340,6 +345,278 @@ void export_data( ostream& outs,
    destroy_object_instance( handle );
 }
 
+const size_t c_package_batch_records = 500;
+const size_t c_package_max_queued_batches = 4;
+
+const int c_package_batch_wait_msecs = 250;
+
+struct package_record
+{
+   package_record( ) : line_num( 0 ) { }
+
+   size_t line_num;
+
+   vector< string > field_values;
+   map< string, string > search_replaces_used;
+};
+
+struct package_batch
+{
+   package_batch( ) : line_num( 0 ), is_class_start( false ), is_class_finish( false ) { }
+
+   string mclass;
+   string field_list;
+
+   size_t line_num;
+
+   bool is_class_start;
+   bool is_class_finish;
+
+   vector< package_record > records;
+};
+
+// NOTE: Reads the package records (performing search/replaces and splitting them into field
+// values) in its own thread so that this can occur whilst the session is still applying the
+// previous batch of records (instance operations can only be performed by the session). The
+// reader owns the input file and its destructor stops and joins the thread (so it is always
+// safe for the session to simply delete it).
+class package_reader : public joinable_thread
+{
+   public:
+   package_reader( const string& filename );
+
+   ~package_reader( );
+
+   void start( const vector< pair< string, string > >& replaces );
+
+   void on_start( );
+
+   bool next_batch( auto_ptr< package_batch >& ap_batch, size_t& line_num );
+
+   void stop( );
+
+   private:
+   bool add_batch( package_batch* p_batch );
+
+   ifstream inpf;
+   auto_ptr< sio_reader > ap_sio_reader;
+
+   vector< pair< string, string > > search_replaces;
+
+   mutex lock;
+   wait_notifier notifier;
+
+   bool is_stopping;
+   bool is_finished;
+
+   string error;
+   size_t error_line_num;
+
+   deque< package_batch* > batches;
+};
+
+package_reader::package_reader( const string& filename )
+ :
+ inpf( filename.c_str( ) ),
+ is_stopping( false ),
+ is_finished( false ),
+ error_line_num( 0 )
+{
+   if( !inpf )
+      throw runtime_error( "unable to open file '" + filename + "' for input in import_package" );
+
+   ap_sio_reader.reset( new sio_reader( inpf ) );
+}
+
+package_reader::~package_reader( )
+{
+   stop( );
+
+   for( size_t i = 0; i < batches.size( ); i++ )
+      delete batches[ i ];
+}
+
+void package_reader::start( const vector< pair< string, string > >& replaces )
+{
+   search_replaces = replaces;
+
+   joinable_thread::start( );
+}
+
+void package_reader::on_start( )
+{
+   try
+   {
+      bool was_stopped = false;
+
+      while( !was_stopped && ap_sio_reader->has_started_section( c_section_class ) )
+      {
+         auto_ptr< package_batch > ap_batch( new package_batch );
+
+         ap_batch->is_class_start = true;
+
+         ap_batch->mclass = ap_sio_reader->read_attribute( c_attribute_name );
+         ap_batch->field_list = ap_sio_reader->read_attribute( c_attribute_fields );
+
+         ap_batch->line_num = ap_sio_reader->get_last_line_num( );
+
+         string next_record;
+         while( ap_sio_reader->has_read_attribute( c_attribute_record, next_record ) )
+         {
+            ap_batch->records.push_back( package_record( ) );
+            package_record& record( ap_batch->records.back( ) );
+
+            record.line_num = ap_sio_reader->get_last_line_num( );
+
+            for( size_t i = 0; i < search_replaces.size( ); i++ )
+            {
+               string original_next_record( next_record );
+
+               next_record = search_replace( next_record,
+                search_replaces[ i ].first, search_replaces[ i ].second );
+
+               // NOTE: Remember any search replaces that were used in order to be able to append
+               // entries to the map file (if required) for @<prefix>_<key> usage entries.
+               if( next_record != original_next_record )
+                  record.search_replaces_used[ search_replaces[ i ].second ] = search_replaces[ i ].first;
+            }
+
+            split( next_record, record.field_values, ',', '\\', false );
+
+            if( ap_batch->records.size( ) >= c_package_batch_records )
+            {
+               if( !add_batch( ap_batch.release( ) ) )
+               {
+                  was_stopped = true;
+                  break;
+               }
+
+               ap_batch.reset( new package_batch );
+            }
+         }
+
+         if( was_stopped )
+            break;
+
+         ap_sio_reader->finish_section( c_section_class );
+
+         ap_batch->is_class_finish = true;
+         ap_batch->line_num = ap_sio_reader->get_last_line_num( );
+
+         if( !add_batch( ap_batch.release( ) ) )
+            was_stopped = true;
+      }
+
+      if( !was_stopped )
+         ap_sio_reader->verify_finished_sections( );
+   }
+   catch( exception& x )
+   {
+      guard g( lock );
+
+      error = x.what( );
+      error_line_num = ap_sio_reader->get_last_line_num( );
+   }
+   catch( ... )
+   {
+      guard g( lock );
+
+      error = "unexpected unknown exception";
+      error_line_num = ap_sio_reader->get_last_line_num( );
+   }
+
+   // NOTE: Scope for guard object.
+   {
+      guard g( lock );
+      is_finished = true;
+   }
+
+   notifier.notify( );
+}
+
+bool package_reader::next_batch( auto_ptr< package_batch >& ap_batch, size_t& line_num )
+{
+   ap_batch.reset( );
+
+   while( true )
+   {
+      unsigned long generation = notifier.get_generation( );
+
+      // NOTE: Scope for guard object.
+      {
+         guard g( lock );
+
+         if( !batches.empty( ) )
+         {
+            ap_batch.reset( batches.front( ) );
+            batches.pop_front( );
+
+            break;
+         }
+
+         if( is_finished )
+         {
+            if( !error.empty( ) )
+            {
+               line_num = error_line_num;
+               throw runtime_error( error );
+            }
+
+            return false;
+         }
+      }
+
+      notifier.wait( generation, c_package_batch_wait_msecs );
+   }
+
+   notifier.notify( );
+
+   return true;
+}
+
+void package_reader::stop( )
+{
+   // NOTE: Scope for guard object.
+   {
+      guard g( lock );
+      is_stopping = true;
+   }
+
+   notifier.notify( );
+
+   join( );
+}
+
+bool package_reader::add_batch( package_batch* p_batch )
+{
+   auto_ptr< package_batch > ap_batch( p_batch );
+
+   while( true )
+   {
+      unsigned long generation = notifier.get_generation( );
+
+      // NOTE: Scope for guard object.
+      {
+         guard g( lock );
+
+         if( is_stopping )
+            return false;
+
+         if( batches.size( ) < c_package_max_queued_batches )
+         {
+            batches.push_back( ap_batch.release( ) );
+            break;
+         }
+      }
+
+      notifier.wait( generation, c_package_batch_wait_msecs );
+   }
+
+   notifier.notify( );
+
+   return true;
+}
+
 }
 
 void export_package( const string& module,
@@ -551,12 +828,13 @@ void export_package( const string& module,
    // links set to blank).
    size_t total = 0;
    time_t ts( time( 0 ) );
+   time_t start_time( ts );
    while( true )
    {
       export_data( outf, module_name, next_class_id,
        next_key, last_class_id, is_first, get_session_command_handler( ),
        all_class_ids, excludes, tests, includes, exported_records, exported_children,
-       next_pass, will_be_exported, partial_export, rounds, current_round, future_rounds, ts, total );
+       next_pass, will_be_exported, partial_export, rounds, current_round, future_rounds, start_time, ts, total );
 
       if( current_round == 0 )
          is_first = false;
@@ -639,15 +917,11 @@ void import_package( const string& module,
       }
    }
 
-   ifstream inpf( filename.c_str( ) );
-   if( !inpf )
-      throw runtime_error( "unable to open file '" + filename + "' for input in import_package" );
+   auto_ptr< package_reader > ap_reader( new package_reader( filename ) );
 
    set_uid( uid );
    set_dtm( dtm );
 
-   sio_reader reader( inpf );
-
    string log_lines;
 
    string map_file_name;
@@ -764,9 +1038,12 @@ void import_package( const string& module,
    }
 
    time_t ts( time( 0 ) );
+   time_t start_time( ts );
 
-   transaction_start( );
-   size_t transaction_id = next_transaction_id( ) + 1;
+   ap_reader->start( search_replaces );
+
+   size_t transaction_id = 0;
+   bool has_transaction = false;
 
    set< string > keys_updating;
    map< string, string > keys_created;
@@ -774,25 +1051,43 @@ void import_package( const string& module,
 
    vector< string > map_appends;
 
+   size_t handle = 0;
+   size_t line_num = 1;
+   size_t num_records = 0;
+
    try
    {
-      size_t line_num = 1;
-      while( reader.has_started_section( c_section_class ) )
-      {
-         ++line_num;
+      transaction_start( );
+      has_transaction = true;
+
+      transaction_id = next_transaction_id( ) + 1;
+
+      string mclass;
+      string class_id_to_log;
+
+      vector< string > fields;
 
-         string mclass( reader.read_attribute( c_attribute_name ) );
-         string field_list( reader.read_attribute( c_attribute_fields ) );
+      vector< bool > skip_field_flags;
+      vector< string > field_ids_to_log;
+      vector< string > foreign_class_ids;
+      vector< vector< string > > skip_record_values;
 
-         line_num += 2;
+      vector< pair< string, string > > base_class_info;
 
-         mclass = get_class_id_for_id_or_name( module_id, mclass );
+      auto_ptr< package_batch > ap_batch;
 
-         size_t handle = create_object_instance( module_id, mclass, 0, false );
-         try
+      while( ap_reader->next_batch( ap_batch, line_num ) )
+      {
+         if( ap_batch->is_class_start )
          {
-            vector< string > fields;
-            split( field_list, fields );
+            line_num = ap_batch->line_num;
+
+            mclass = get_class_id_for_id_or_name( module_id, ap_batch->mclass );
+
+            handle = create_object_instance( module_id, mclass, 0, false );
+
+            fields.clear( );
+            split( ap_batch->field_list, fields );
 
             // NOTE: Check that field names have not been repeated (apart from "ignore").
             vector< string > sorted_fields( fields.begin( ), fields.end( ) );
@@ -813,300 +1108,307 @@ void import_package( const string& module,
             if( !key_prefix.empty( ) )
                get_foreign_field_and_class_ids( handle, "", foreign_field_and_class_ids );
 
-            vector< pair< string, string > > base_class_info;
+            base_class_info.clear( );
             get_base_class_info( handle, "", base_class_info );
 
             if( base_class_info.empty( ) )
                base_class_info.push_back( make_pair( mclass, mclass ) );
 
-            string next_record;
-            while( reader.has_read_attribute( c_attribute_record, next_record ) )
-            {
-               ++line_num;
+            class_id_to_log = mclass;
 
-               if( time( 0 ) - ts >= 10 )
-               {
-                  ts = time( 0 );
-                  // FUTURE: This message should be handled as a server string message.
-                  get_session_command_handler( ).output_progress( "Processed " + to_string( line_num ) + " lines..." );
-               }
+            if( is_using_blockchain && class_id_to_log.find( module_id ) == 0 )
+               class_id_to_log.erase( 0, module_id.length( ) );
 
-               map< string, string > search_replaces_used;
+            // NOTE: Determine the skip, foreign key and log details for each field once per class
+            // rather than for every record.
+            skip_field_flags.assign( fields.size( ), false );
+            field_ids_to_log.assign( fields.size( ), string( ) );
+            foreign_class_ids.assign( fields.size( ), string( ) );
+            skip_record_values.assign( fields.size( ), vector< string >( ) );
 
-               if( !search_replaces.empty( ) )
-               {
-                  for( size_t i = 0; i < search_replaces.size( ); i++ )
-                  {
-                     string original_next_record( next_record );
+            for( size_t i = 1; i < fields.size( ); i++ )
+            {
+               if( fields[ i ] == c_ignore_field )
+                  skip_field_flags[ i ] = true;
 
-                     next_record = search_replace( next_record,
-                      search_replaces[ i ].first, search_replaces[ i ].second );
+               for( size_t j = 0; j < base_class_info.size( ); j++ )
+               {
+                  string next_cid = base_class_info[ j ].first;
 
-                     // NOTE: Remember any search replaces that were used in order to be able to append
-                     // entries to the map file (if required) for @<prefix>_<key> usage entries.
-                     if( next_record != original_next_record )
-                        search_replaces_used[ search_replaces[ i ].second ] = search_replaces[ i ].first;
+                  if( skip_fields.count( next_cid ) && skip_fields[ next_cid ].count( fields[ i ] ) )
+                  {
+                     if( skip_fields[ next_cid ][ fields[ i ] ].empty( ) )
+                        skip_field_flags[ i ] = true;
+                     else
+                        skip_record_values[ i ].push_back( skip_fields[ next_cid ][ fields[ i ] ].substr( 1 ) );
                   }
                }
 
-               vector< string > field_values;
-               split( next_record, field_values, ',', '\\', false );
+               if( foreign_field_and_class_ids.count( fields[ i ] ) )
+                  foreign_class_ids[ i ] = foreign_field_and_class_ids[ fields[ i ] ];
 
-               if( field_values.size( ) != fields.size( ) )
-                  throw runtime_error( "found " + to_string( field_values.size( ) )
-                   + " field values but was expecting " + to_string( fields.size( ) ) );
+               string field_id_to_log( fields[ i ] );
 
-               if( fields.size( ) )
+               if( is_using_blockchain && field_id_to_log.find( module_id ) == 0 )
                {
-                  if( fields[ 0 ] != c_key_field )
-                     throw runtime_error( "unexpected missing key field processing line #" + to_string( line_num ) );
+                  field_id_to_log.erase( 0, module_id.length( ) );
+                  if( field_id_to_log.find( class_id_to_log ) == 0 )
+                     field_id_to_log.erase( 0, class_id_to_log.length( ) );
+               }
 
-                  bool skip_op = false;
+               field_ids_to_log[ i ] = field_id_to_log;
+            }
+         }
 
-                  if( field_values[ 0 ].empty( ) || field_values[ 0 ] == "!" )
-                     skip_op = true;
-                  else
-                  {
-                     for( size_t i = 1; i < fields.size( ); i++ )
-                     {
-                        for( size_t j = 0; j < base_class_info.size( ); j++ )
-                        {
-                           string next_cid = base_class_info[ j ].first;
-
-                           if( skip_fields.count( next_cid ) && skip_fields[ next_cid ].count( fields[ i ] ) )
-                           {
-                              if( !skip_fields[ next_cid ][ fields[ i ] ].empty( )
-                               && field_values[ i ] == skip_fields[ next_cid ][ fields[ i ] ].substr( 1 ) )
-                                 skip_op = true;
-                           }
-                        }
-                     }
-                  }
+         for( size_t r = 0; r < ap_batch->records.size( ); r++ )
+         {
+            package_record& record( ap_batch->records[ r ] );
 
-                  string next_key( field_values[ 0 ] );
+            line_num = record.line_num;
 
-                  // NOTE: Allow packages being imported with the "new_only" option to
-                  // still update specific records by prefixing their keys with a '!'.
-                  if( !next_key.empty( ) && next_key[ 0 ] == '!' )
-                  {
-                     next_key.erase( 0, 1 );
-                     keys_updating.insert( next_key );
-                  }
+            ++num_records;
 
-                  bool is_remove_op = false;
-                  if( !next_key.empty( ) && next_key[ 0 ] == '~' )
-                  {
-                     next_key.erase( 0, 1 );
-
-                     if( !for_remove )
-                        skip_op = true;
-                     else
-                        is_remove_op = true;
-                  }
+            if( time( 0 ) - ts >= 10 )
+            {
+               ts = time( 0 );
+               // FUTURE: This message should be handled as a server string message.
+               get_session_command_handler( ).output_progress( "Processed " + to_string( line_num )
+                + " lines (" + to_string( num_records / ( ts - start_time ) ) + " records per second)..." );
+            }
 
-                  string original_key( next_key );
+            vector< string >& field_values( record.field_values );
+            map< string, string >& search_replaces_used( record.search_replaces_used );
 
-                  // NOTE: Allow a key field to be specified in the following manner: @3_20101010101010101010
-                  // where the text between the @ and _ (in the case "3") is used to replace the equal number
-                  // of leading characters in the key (so the final key will become 30101010101010101010).
-                  if( !next_key.empty( ) && next_key[ 0 ] == '@' )
-                  {
-                     string::size_type pos = next_key.find( '_' );
-                     if( pos == string::npos )
-                        throw runtime_error( "unexpected key format '" + next_key + "' processing line #" + to_string( line_num ) );
+            if( field_values.size( ) != fields.size( ) )
+               throw runtime_error( "found " + to_string( field_values.size( ) )
+                + " field values but was expecting " + to_string( fields.size( ) ) );
 
-                     original_key.erase( 0, pos + 1 );
+            if( fields.size( ) )
+            {
+               if( fields[ 0 ] != c_key_field )
+                  throw runtime_error( "unexpected missing key field processing line #" + to_string( line_num ) );
 
-                     string prefix_replace;
-                     if( pos > 1 )
-                        prefix_replace = next_key.substr( 1, pos - 1 );
+               bool skip_op = false;
 
-                     if( prefix_replace.length( ) )
+               if( field_values[ 0 ].empty( ) || field_values[ 0 ] == "!" )
+                  skip_op = true;
+               else
+               {
+                  for( size_t i = 1; i < fields.size( ); i++ )
+                  {
+                     for( size_t j = 0; j < skip_record_values[ i ].size( ); j++ )
                      {
-                        if( next_key.length( ) > pos * 2 )
-                        {
-                           next_key.erase( 0, pos + 1 + prefix_replace.length( ) );
-                           next_key = prefix_replace + next_key;
-                        }
-                        else if( pos == next_key.length( ) - 1 )
+                        if( field_values[ i ] == skip_record_values[ i ][ j ] )
                            skip_op = true;
-                        else
-                           throw runtime_error( "unexpected key prefix '" + next_key + "' processing line #" + to_string( line_num ) );
                      }
                   }
+               }
 
-                  if( is_remove_op && !for_remove )
-                     skip_op = true;
-                  else if( for_remove && !is_remove_op )
+               string next_key( field_values[ 0 ] );
+
+               // NOTE: Allow packages being imported with the "new_only" option to
+               // still update specific records by prefixing their keys with a '!'.
+               if( !next_key.empty( ) && next_key[ 0 ] == '!' )
+               {
+                  next_key.erase( 0, 1 );
+                  keys_updating.insert( next_key );
+               }
+
+               bool is_remove_op = false;
+               if( !next_key.empty( ) && next_key[ 0 ] == '~' )
+               {
+                  next_key.erase( 0, 1 );
+
+                  if( !for_remove )
                      skip_op = true;
+                  else
+                     is_remove_op = true;
+               }
 
-                  if( !skip_op )
-                  {
-                     string next_log_line;
+               string original_key( next_key );
 
-                     string key_value( key_prefix + next_key );
+               // NOTE: Allow a key field to be specified in the following manner: @3_20101010101010101010
+               // where the text between the @ and _ (in the case "3") is used to replace the equal number
+               // of leading characters in the key (so the final key will become 30101010101010101010).
+               if( !next_key.empty( ) && next_key[ 0 ] == '@' )
+               {
+                  string::size_type pos = next_key.find( '_' );
+                  if( pos == string::npos )
+                     throw runtime_error( "unexpected key format '" + next_key + "' processing line #" + to_string( line_num ) );
 
-                     instance_fetch_rc rc;
+                  original_key.erase( 0, pos + 1 );
 
-                     // NOTE: As a performance optimisation the instance fetch is skipped if the
-                     // "new_only" option is being used (assumes the record was not found unless
-                     // previously created or specifically flagged as an update).
-                     if( new_only )
-                     {
-                        if( keys_created.count( key_value ) || keys_updating.count( key_value ) )
-                           rc = e_instance_fetch_rc_okay;
-                        else
-                           rc = e_instance_fetch_rc_not_found;
-                     }
-                     else
-                        instance_fetch( handle, "", key_value, &rc );
+                  string prefix_replace;
+                  if( pos > 1 )
+                     prefix_replace = next_key.substr( 1, pos - 1 );
 
-                     bool is_update = false;
-                     if( rc != e_instance_fetch_rc_okay )
+                  if( prefix_replace.length( ) )
+                  {
+                     if( next_key.length( ) > pos * 2 )
                      {
-                        next_log_line = "pc";
-                        op_instance_create( handle, "", key_value, false );
+                        next_key.erase( 0, pos + 1 + prefix_replace.length( ) );
+                        next_key = prefix_replace + next_key;
                      }
-                     else if( new_only && !keys_created.count( key_value ) && !keys_updating.count( key_value ) )
-                        // FUTURE: This message should be handled as a server string message.
-                        throw runtime_error( "Package key '" + key_value + "' is already in use." );
+                     else if( pos == next_key.length( ) - 1 )
+                        skip_op = true;
                      else
-                     {
-                        is_update = true;
-                        next_log_line = "pu";
-                        op_instance_update( handle, "", key_value, "", false );
-                     }
+                        throw runtime_error( "unexpected key prefix '" + next_key + "' processing line #" + to_string( line_num ) );
+                  }
+               }
 
-                     string class_id_to_log( mclass );
+               if( is_remove_op && !for_remove )
+                  skip_op = true;
+               else if( for_remove && !is_remove_op )
+                  skip_op = true;
 
-                     if( is_using_blockchain && class_id_to_log.find( module_id ) == 0 )
-                        class_id_to_log.erase( 0, module_id.length( ) );
+               if( !skip_op )
+               {
+                  string next_log_line;
 
-                     next_log_line += " " + uid + " " + dtm + " "
-                      + module_id + " " + class_id_to_log + " " + key_value + " \"";
+                  string key_value( key_prefix + next_key );
 
-                     string log_field_value_pairs;
+                  instance_fetch_rc rc;
 
-                     for( size_t i = 1; i < fields.size( ); i++ )
-                     {
-                        bool skip_field = false;
-                        for( size_t j = 0; j < base_class_info.size( ); j++ )
-                        {
-                           string next_cid = base_class_info[ j ].first;
-
-                           if( skip_fields.count( next_cid ) && skip_fields[ next_cid ].count( fields[ i ] ) )
-                           {
-                              if( skip_fields[ next_cid ][ fields[ i ] ].empty( ) )
-                              {
-                                 skip_field = true;
-                                 break;
-                              }
-                           }
-                        }
+                  // NOTE: As a performance optimisation the instance fetch is skipped if the
+                  // "new_only" option is being used (assumes the record was not found unless
+                  // previously created or specifically flagged as an update).
+                  if( new_only )
+                  {
+                     if( keys_created.count( key_value ) || keys_updating.count( key_value ) )
+                        rc = e_instance_fetch_rc_okay;
+                     else
+                        rc = e_instance_fetch_rc_not_found;
+                  }
+                  else
+                     instance_fetch( handle, "", key_value, &rc );
 
-                        if( skip_field || fields[ i ] == c_ignore_field )
-                           continue;
+                  bool is_update = false;
+                  if( rc != e_instance_fetch_rc_okay )
+                  {
+                     next_log_line = "pc";
+                     op_instance_create( handle, "", key_value, false );
+                  }
+                  else if( new_only && !keys_created.count( key_value ) && !keys_updating.count( key_value ) )
+                     // FUTURE: This message should be handled as a server string message.
+                     throw runtime_error( "Package key '" + key_value + "' is already in use." );
+                  else
+                  {
+                     is_update = true;
+                     next_log_line = "pu";
+                     op_instance_update( handle, "", key_value, "", false );
+                  }
 
-                        if( foreign_field_and_class_ids.count( fields[ i ] )
-                         && prefixed_class_keys[ foreign_field_and_class_ids[ fields[ i ] ] ].count( field_values[ i ] ) )
-                           field_values[ i ] = key_prefix + field_values[ i ];
+                  next_log_line += " " + uid + " " + dtm + " "
+                   + module_id + " " + class_id_to_log + " " + key_value + " \"";
 
-                        string value;
+                  string log_field_value_pairs;
 
-                        if( is_using_blockchain )
-                        {
-                           string method_name_and_args( "get " );
-                           method_name_and_args += fields[ i ];
+                  for( size_t i = 1; i < fields.size( ); i++ )
+                  {
+                     if( skip_field_flags[ i ] )
+                        continue;
 
-                           value = execute_object_command( handle, "", method_name_and_args );
-                        }
+                     if( !foreign_class_ids[ i ].empty( )
+                      && prefixed_class_keys[ foreign_class_ids[ i ] ].count( field_values[ i ] ) )
+                        field_values[ i ] = key_prefix + field_values[ i ];
 
-                        if( !is_using_blockchain || value != field_values[ i ] )
-                        {
-                           string method_name_and_args( "set " );
-                           method_name_and_args += fields[ i ] + " ";
-                           method_name_and_args += "\"" + escaped( unescaped( field_values[ i ], "rn\r\n" ), "\"" ) + "\"";
+                     string value;
+
+                     if( is_using_blockchain )
+                     {
+                        string method_name_and_args( "get " );
+                        method_name_and_args += fields[ i ];
 
-                           if( !log_field_value_pairs.empty( ) )
-                              log_field_value_pairs += ",";
+                        value = execute_object_command( handle, "", method_name_and_args );
+                     }
 
-                           string field_id_to_log( fields[ i ] );
+                     if( !is_using_blockchain || value != field_values[ i ] )
+                     {
+                        string method_name_and_args( "set " );
+                        method_name_and_args += fields[ i ] + " ";
+                        method_name_and_args += "\"" + escaped( unescaped( field_values[ i ], "rn\r\n" ), "\"" ) + "\"";
 
-                           if( is_using_blockchain && field_id_to_log.find( module_id ) == 0 )
-                           {
-                              field_id_to_log.erase( 0, module_id.length( ) );
-                              if( field_id_to_log.find( class_id_to_log ) == 0 )
-                                 field_id_to_log.erase( 0, class_id_to_log.length( ) );
-                           }
+                        if( !log_field_value_pairs.empty( ) )
+                           log_field_value_pairs += ",";
 
-                           log_field_value_pairs += field_id_to_log
-                            + "=" + search_replace( field_values[ i ], "\\\\", "\\\\\\\\", ",", "\\\\," );
+                        log_field_value_pairs += field_ids_to_log[ i ]
+                         + "=" + search_replace( field_values[ i ], "\\\\", "\\\\\\\\", ",", "\\\\," );
 
-                           execute_object_command( handle, "", method_name_and_args );
-                        }
+                        execute_object_command( handle, "", method_name_and_args );
                      }
+                  }
 
-                     next_log_line += log_field_value_pairs + "\"";
+                  next_log_line += log_field_value_pairs + "\"";
 
-                     if( !log_lines.empty( ) )
-                        log_lines += "\n";
-                     log_lines += next_log_line;
+                  if( !log_lines.empty( ) )
+                     log_lines += "\n";
+                  log_lines += next_log_line;
 
-                     op_instance_apply( handle, "", false );
+                  op_instance_apply( handle, "", false );
 
-                     if( !is_update && !for_remove )
-                     {
-                        keys_created.insert( make_pair( key_value, mclass ) );
+                  if( !is_update && !for_remove )
+                  {
+                     keys_created.insert( make_pair( key_value, mclass ) );
 
-                        if( original_key != key_value && search_replaces_used.count( original_key ) )
-                           map_appends.push_back( search_replaces_used[ original_key ] + "=" + key_value );
-                     }
+                     if( original_key != key_value && search_replaces_used.count( original_key ) )
+                        map_appends.push_back( search_replaces_used[ original_key ] + "=" + key_value );
                   }
+               }
 
-                  if( !for_remove && !key_prefix.empty( ) )
-                  {
-                     prefixed_class_keys[ mclass ].insert( next_key );
-
-                     vector< pair< string, string > > base_class_info;
-                     get_base_class_info( handle, "", base_class_info );
+               if( !for_remove && !key_prefix.empty( ) )
+               {
+                  prefixed_class_keys[ mclass ].insert( next_key );
 
-                     for( size_t i = 0; i < base_class_info.size( ); i++ )
-                        prefixed_class_keys[ base_class_info[ i ].first ].insert( next_key );
-                  }
+                  for( size_t i = 0; i < base_class_info.size( ); i++ )
+                     prefixed_class_keys[ base_class_info[ i ].first ].insert( next_key );
                }
             }
-
-            reader.finish_section( c_section_class );
-            destroy_object_instance( handle );
-            ++line_num;
          }
-         catch( ... )
+
+         if( ap_batch->is_class_finish )
          {
-            destroy_object_instance( handle );
-            throw;
+            line_num = ap_batch->line_num;
+
+            size_t old_handle = handle;
+
+            handle = 0;
+            destroy_object_instance( old_handle );
          }
       }
-
-      reader.verify_finished_sections( );
    }
    catch( exception& x )
    {
-      transaction_rollback( );
+      if( handle )
+         destroy_object_instance( handle );
+
+      ap_reader->stop( );
+
+      if( has_transaction )
+         transaction_rollback( );
 
       string s( x.what( ) );
 
       // FUTURE: This message should be handled as a server string message.
       s += " This occurred while processing line #"
-       + to_string( reader.get_last_line_num( ) ) + " of '" + filename + "'.";
+       + to_string( line_num ) + " of '" + filename + "'.";
 
       throw runtime_error( s );
    }
    catch( ... )
    {
-      transaction_rollback( );
+      if( handle )
+         destroy_object_instance( handle );
+
+      ap_reader->stop( );
+
+      if( has_transaction )
+         transaction_rollback( );
+
       throw;
    }
 
+   ap_reader->stop( );
+
    transaction_log_command( log_lines );
    transaction_commit( );
 
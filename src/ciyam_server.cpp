@@ -51,6 +51,7 @@
 #include "utilities.h"
 #include "ciyam_base.h"
 #include "auto_script.h"
+#include "email_queue.h"
 #ifdef SSL_SUPPORT
 #  include "ssl_socket.h"
 #endif
@@ -533,12 +534,21 @@ int main( int argc, char* argv[ ] )
 
             file_remove( c_shutdown_signal_file );
 
+            size_t num_background_sessions = 0;
+
             if( g_start_autoscript )
             {
                autoscript_session* p_autoscript_session = new autoscript_session;
                p_autoscript_session->start( );
+
+               ++num_background_sessions;
             }
 
+            // NOTE: If an SMTP server has been configured then outgoing email messages
+            // are queued and sent by email queue sessions (using pooled connections).
+            if( !get_smtp_server( ).empty( ) )
+               num_background_sessions += start_email_queue_sessions( );
+
             if( g_start_peer_listeners )
             {
                map< int, string > blockchains;
@@ -562,15 +572,23 @@ int main( int argc, char* argv[ ] )
                if( g_server_shutdown && !reported_shutdown )
                {
                   reported_shutdown = true;
+
+                  // NOTE: The autoscript session waits until the next script is due so is
+                  // woken up here in order to not unnecessarily delay the shutdown.
+                  wake_autoscript_session( );
+
                   if( !g_is_quiet )
                      cout << "server shutdown (due to interrupt) now underway..." << endl;
                }
 
-               // NOTE: If there are no active sessions (apart from the autoscript session) and is not
-               // shutting down then check and update the timezone information if it has been changed.
-               if( !g_server_shutdown
-                && ( !g_active_sessions || ( g_start_autoscript && g_active_sessions == 1 ) ) )
+               // NOTE: If there are no active sessions (apart from the background sessions) and is not
+               // shutting down then check and update the timezone information if it has been changed
+               // and perform the next step of the system ODS compaction (if one is now due).
+               if( !g_server_shutdown && g_active_sessions <= num_background_sessions )
+               {
                   check_timezone_info( );
+                  check_ods_compaction( );
+               }
 
                // NOTE: Check for accepts and create new sessions.
 #ifdef SSL_SUPPORT
@@ -1186,6 +1186,112 @@ void read_log_transformation_info( const string& file_name, map< string, string
    }
 }
 
+const int c_fetch_cache_max_age_seconds = 60;
+
+const size_t c_fetch_cache_max_entry_lines = 1000;
+
+struct fetch_cache_entry
+{
+   fetch_cache_entry( ) : revision( 0 ), created( 0 ), last_used( 0 ) { }
+
+   uint64_t revision;
+
+   time_t created;
+   uint64_t last_used;
+
+   vector< string > lines;
+};
+
+mutex g_fetch_cache_mutex;
+
+uint64_t g_fetch_cache_uses = 0;
+
+map< string, fetch_cache_entry > g_fetch_cache;
+
+// NOTE: A cached fetch response is only used if no transaction has been committed since it
+// was created (as fetched values can be derived from records of other classes). It will also
+// expire after a short time as some fetched values can depend upon the current date and time.
+bool get_cached_fetch_lines( const string& key, uint64_t revision, vector< string >& lines )
+{
+   guard g( g_fetch_cache_mutex );
+
+   map< string, fetch_cache_entry >::iterator i = g_fetch_cache.find( key );
+
+   if( i == g_fetch_cache.end( ) )
+      return false;
+
+   if( i->second.revision != revision
+    || time( 0 ) - i->second.created >= c_fetch_cache_max_age_seconds )
+   {
+      g_fetch_cache.erase( i );
+      return false;
+   }
+
+   i->second.last_used = ++g_fetch_cache_uses;
+
+   lines = i->second.lines;
+
+   return true;
+}
+
+void add_cached_fetch_lines( const string& key, uint64_t revision, const vector< string >& lines )
+{
+   size_t max_items = get_fetch_cache_max_items( );
+
+   if( !max_items )
+      return;
+
+   guard g( g_fetch_cache_mutex );
+
+   if( g_fetch_cache.size( ) >= max_items && !g_fetch_cache.count( key ) )
+   {
+      map< string, fetch_cache_entry >::iterator oldest = g_fetch_cache.end( );
+
+      for( map< string, fetch_cache_entry >::iterator
+       i = g_fetch_cache.begin( ); i != g_fetch_cache.end( ); ++i )
+      {
+         if( i->second.revision != revision )
+         {
+            oldest = i;
+            break;
+         }
+
+         if( oldest == g_fetch_cache.end( ) || i->second.last_used < oldest->second.last_used )
+            oldest = i;
+      }
+
+      if( oldest != g_fetch_cache.end( ) )
+         g_fetch_cache.erase( oldest );
+   }
+
+   fetch_cache_entry& entry( g_fetch_cache[ key ] );
+
+   entry.revision = revision;
+   entry.created = time( 0 );
+   entry.last_used = ++g_fetch_cache_uses;
+
+   entry.lines = lines;
+}
+
+// NOTE: If too many lines are being fetched then the cache lines pointer will be cleared so
+// that the response will not end up being cached.
+void write_fetch_line( tcp_socket& socket, const string& line,
+ vector< string >*& p_cache_lines, progress* p_progress )
+{
+   if( p_cache_lines )
+   {
+      if( p_cache_lines->size( ) < c_fetch_cache_max_entry_lines )
+         p_cache_lines->push_back( line );
+      else
+      {
+         p_cache_lines->clear( );
+         p_cache_lines = 0;
+      }
+   }
+
+   socket.write_line( line, c_request_timeout, p_progress );
+}
+
 class socket_command_handler : public command_handler
 {
    public:
@@ -2334,6 +2440,31 @@ void ciyam_session_command_functor::operator ( )( const string& command, const p
             }
          }
 
+         // NOTE: Only a plain fetch (i.e. not one that involves setting values or PDF generation) that
+         // is not occurring within a transaction is able to make use of the fetch cache.
+         bool use_fetch_cache = !create_pdf && map_file.empty( ) && set_values.empty( ) && blockchain.empty( )
+          && ( key_info.empty( ) || key_info[ 0 ] != ' ' ) && !transaction_level( ) && get_fetch_cache_max_items( );
+
+         string fetch_cache_key;
+         uint64_t fetch_cache_revision = 0;
+
+         vector< string > cache_lines;
+         vector< string >* p_cache_lines = 0;
+
+         if( use_fetch_cache )
+         {
+            fetch_cache_revision = get_data_revision( );
+
+            fetch_cache_key = storage_name( ) + '\n' + module + '\n' + mclass + '\n' + context
+             + '\n' + parent_key + '\n' + key_info + '\n' + ( is_reverse ? "1" : "0" ) + '\n' + uid
+             + '\n' + dtm + '\n' + grp + '\n' + tz_name + '\n' + tmp_dir + '\n' + filters + '\n' + perms
+             + '\n' + security_info + '\n' + search_text + '\n' + search_query + '\n' + extra_vars
+             + '\n' + limit + '\n' + fields + '\n' + ( minimal ? "1" : "0" ) + ( no_default_values ? "1" : "0" );
+
+            if( !get_cached_fetch_lines( fetch_cache_key, fetch_cache_revision, cache_lines ) )
+               p_cache_lines = &cache_lines;
+         }
+
          // KLUDGE: Assume a dynamic instance is needed if a context has been supplied
          // as there is no simple way to otherwise determine this (maybe it's not even
          // worth worrying about trying to optimise this behaviour).
@@ -2407,9 +2538,15 @@ void ciyam_session_command_functor::operator ( )( const string& command, const p
                ap_blockchain_lock.reset( new system_variable_lock( blockchain ) );
             }
 
+            // NOTE: If the response was found in the fetch cache then just output its lines.
+            if( use_fetch_cache && !p_cache_lines )
+            {
+               for( size_t i = 0; i < cache_lines.size( ); i++ )
+                  socket.write_line( cache_lines[ i ], c_request_timeout, p_progress );
+            }
             // NOTE: If a space is provided as the key then fetch the default record values or if the
             // first character of the key is a space then clone a default record from another.
-            if( !key_info.empty( ) && key_info[ 0 ] == ' ' )
+            else if( !key_info.empty( ) && key_info[ 0 ] == ' ' )
             {
                if( create_pdf )
                   throw runtime_error( "pdf generation is not permitted for default values usage" );
@@ -2554,7 +2691,7 @@ void ciyam_session_command_functor::operator ( )( const string& command, const p
                         }
 
                         if( summaries.empty( ) )
-                           socket.write_line( output, c_request_timeout, p_progress );
+                           write_fetch_line( socket, output, p_cache_lines, p_progress );
                         else
                         {
                            string prefix;
@@ -2601,10 +2738,127 @@ void ciyam_session_command_functor::operator ( )( const string& command, const p
                {
                   for( multimap< string, string >::iterator
                    i = summary_sorted_values.begin( ); i != summary_sorted_values.end( ); ++i )
-                     socket.write_line( i->second, c_request_timeout, p_progress );
+                     write_fetch_line( socket, i->second, p_cache_lines, p_progress );
+               }
+
+               if( p_cache_lines && !g_server_shutdown )
+                  add_cached_fetch_lines( fetch_cache_key, fetch_cache_revision, *p_cache_lines );
+            }
+
+            destroy_object_instance( handle );
+         }
+         catch( exception& )
+         {
+            possibly_expected_error = true;
+            destroy_object_instance( handle );
+            throw;
+         }
+         catch( ... )
+         {
+            destroy_object_instance( handle );
+            throw;
+         }
+      }
+      else if( command == c_cmd_ciyam_session_perform_aggregate )
+      {
+         string module( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_module ) );
+         string mclass( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_mclass ) );
+         string uid( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_uid ) );
+         string dtm( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_dtm ) );
+         string grp( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_grp ) );
+         string tz_name( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_tz_name ) );
+         string perms( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_perms ) );
+         string security_info( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_security_info ) );
+         string search_text( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_search_text ) );
+         string search_query( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_search_query ) );
+         string extra_vars( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_extra_vars ) );
+         string group_fields( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_group_fields ) );
+         string key_info( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_key_info ) );
+         string aggregates( get_parm_val( parameters, c_cmd_parm_ciyam_session_perform_aggregate_aggregates ) );
+
+         if( tz_name.empty( ) )
+            tz_name = get_timezone( );
+
+         string context;
+         string::size_type pos = mclass.find( ':' );
+         if( pos != string::npos )
+         {
+            context = mclass.substr( pos + 1 );
+            mclass.erase( pos );
+         }
+
+         mclass = get_class_id_for_id_or_name( module, mclass );
+
+         string parent_key;
+         bool found_parent_key = false;
+
+         if( !context.empty( ) && !key_info.empty( ) )
+         {
+            pos = key_info.find( ':' );
+            if( pos != string::npos )
+            {
+               parent_key = key_info.substr( 0, pos );
+               key_info.erase( 0, pos + 1 );
+               found_parent_key = true;
+            }
+         }
+
+         if( !context.empty( ) != found_parent_key )
+            throw runtime_error( "must provide both child context and parent key or neither" );
+
+         sql_aggregate_info aggregate_info;
+
+         split( aggregates, aggregate_info.aggregates );
+
+         if( !group_fields.empty( ) )
+            split( group_fields, aggregate_info.group_fields );
+
+         size_t handle = create_object_instance( module, mclass, 0,
+          !context.empty( ) || get_module_class_has_derivations( module, mclass ) );
+
+         try
+         {
+            if( !extra_vars.empty( ) )
+            {
+               vector< string > extras;
+               split( extra_vars, extras );
+
+               for( size_t i = 0; i < extras.size( ); i++ )
+               {
+                  string next( extras[ i ] );
+                  string::size_type pos = next.find( '=' );
+
+                  if( pos == string::npos )
+                     throw runtime_error( "unexpected format for extras: " + extra_vars );
+
+                  instance_set_variable( handle, context, next.substr( 0, pos ), next.substr( pos + 1 ) );
                }
             }
 
+            set_dtm( dtm );
+            set_grp( grp );
+            set_uid( uid );
+            set_tz_name( tz_name );
+
+            set< string > perm_set;
+            if( !perms.empty( ) )
+               split( perms, perm_set );
+            set_perms( perm_set );
+
+            // NOTE: If a parent was provided then set it so that the child context
+            // will restrict the aggregates to those records belonging to it.
+            if( !parent_key.empty( ) )
+               instance_set_parent( handle, "", parent_key );
+
+            // NOTE: One line is output per group (or just the one line if no group fields
+            // were provided) consisting of the group field values followed by aggregates.
+            if( instance_aggregate( handle, context,
+             key_info, search_text, search_query, security_info, aggregate_info ) )
+            {
+               for( size_t i = 0; i < aggregate_info.results.size( ); i++ )
+                  socket.write_line( aggregate_info.results[ i ], c_request_timeout, p_progress );
+            }
+
             destroy_object_instance( handle );
          }
          catch( exception& )
@@ -5275,6 +5529,11 @@ void ciyam_session_command_functor::operator ( )( const string& command, const p
          output_schedule( osstr );
          output_response_lines( socket, osstr.str( ) );
       }
+      else if( command == c_cmd_ciyam_session_emailqueue )
+      {
+         output_email_queue( osstr );
+         output_response_lines( socket, osstr.str( ) );
+      }
       else if( command == c_cmd_ciyam_session_smtpinfo )
          response = get_smtp_username( ) + "@" + get_smtp_suffix( );
       else if( command == c_cmd_ciyam_session_starttls )
@@ -5321,12 +5580,31 @@ void ciyam_session_command_functor::operator ( )( const string& command, const p
       }
       else if( command == c_cmd_ciyam_session_timezones )
       {
-         string own_tz( get_timezone( ) );
+         bool benchmark( has_parm_val( parameters, c_cmd_parm_ciyam_session_timezones_benchmark ) );
+         string tz_name( get_parm_val( parameters, c_cmd_parm_ciyam_session_timezones_tz_name ) );
+         string num_conversions( get_parm_val( parameters, c_cmd_parm_ciyam_session_timezones_num_conversions ) );
 
-         response = list_timezones( );
+         if( benchmark )
+         {
+            ostringstream osstr;
 
-         if( response.find( own_tz + ' ' ) != string::npos )
-            replace( response, own_tz + ' ', "*" + own_tz + ' ' );
+            benchmark_timezone_conversions( osstr, tz_name,
+             num_conversions.empty( ) ? 0 : from_string< size_t >( num_conversions ) );
+
+            response = osstr.str( );
+
+            if( !response.empty( ) && response[ response.length( ) - 1 ] == '\n' )
+               response.erase( response.length( ) - 1 );
+         }
+         else
+         {
+            string own_tz( get_timezone( ) );
+
+            response = list_timezones( );
+
+            if( response.find( own_tz + ' ' ) != string::npos )
+               replace( response, own_tz + ' ', "*" + own_tz + ' ' );
+         }
       }
       else if( command == c_cmd_ciyam_session_utc_now )
          response = date_time::standard( ).as_string( true, false );
@@ -9,6 +9,9 @@
 #pragma hdrstop
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <map>
+#  include <string>
+#  include <vector>
 #  include <iostream>
 #endif
 
@@ -136,401 +139,484 @@ const char* const c_special_variable_total_child_field_in_parent = "@total_child
 
 mutex g_mutex;
 
-map< string, string > g_variables;
+typedef map< string, string > variable_container;
+typedef variable_container::const_iterator variable_const_iterator;
 
-}
+// NOTE: The "g_variables" container is only accessed whilst holding "g_mutex" and after
+// each change a copy of it is published to "g_snapshot" (which is used for all reads so
+// that readers never need to acquire the mutex).
+variable_container g_variables;
+
+read_snapshot< variable_container > g_snapshot;
 
-string get_special_var_name( special_var var )
+const char* special_var_name( special_var var )
 {
-   string s;
+   const char* p = 0;
 
    switch( var )
    {
       case e_special_var_bh:
-      s = string( c_special_variable_bh );
+      p = c_special_variable_bh;
       break;
 
       case e_special_var_id:
-      s = string( c_special_variable_id );
+      p = c_special_variable_id;
       break;
 
       case  e_special_var_os:
-      s = string( c_special_variable_os );
+      p = c_special_variable_os;
       break;
 
       case e_special_var_dtm:
-      s = string( c_special_variable_dtm );
+      p = c_special_variable_dtm;
       break;
 
       case e_special_var_grp:
-      s = string( c_special_variable_grp );
+      p = c_special_variable_grp;
       break;
 
       case e_special_var_key:
-      s = string( c_special_variable_key );
+      p = c_special_variable_key;
       break;
 
       case e_special_var_sec:
-      s = string( c_special_variable_sec );
+      p = c_special_variable_sec;
       break;
 
       case e_special_var_uid:
-      s = string( c_special_variable_uid );
+      p = c_special_variable_uid;
       break;
 
       case e_special_var_arg1:
-      s = string( c_special_variable_arg1 );
+      p = c_special_variable_arg1;
       break;
 
       case e_special_var_arg2:
-      s = string( c_special_variable_arg2 );
+      p = c_special_variable_arg2;
       break;
 
       case e_special_var_cube:
-      s = string( c_special_variable_cube );
+      p = c_special_variable_cube;
       break;
 
       case e_special_var_hash:
-      s = string( c_special_variable_hash );
+      p = c_special_variable_hash;
       break;
 
       case e_special_var_val1:
-      s = string( c_special_variable_val1 );
+      p = c_special_variable_val1;
       break;
 
       case e_special_var_val2:
-      s = string( c_special_variable_val2 );
+      p = c_special_variable_val2;
       break;
 
       case e_special_var_file:
-      s = string( c_special_variable_file );
+      p = c_special_variable_file;
       break;
 
       case e_special_var_loop:
-      s = string( c_special_variable_loop );
+      p = c_special_variable_loop;
       break;
 
       case e_special_var_name:
-      s = string( c_special_variable_name );
+      p = c_special_variable_name;
       break;
 
       case e_special_var_none:
-      s = string( c_special_variable_none );
+      p = c_special_variable_none;
       break;
 
       case e_special_var_path:
-      s = string( c_special_variable_path );
+      p = c_special_variable_path;
       break;
 
       case e_special_var_peer:
-      s = string( c_special_variable_peer );
+      p = c_special_variable_peer;
       break;
 
       case e_special_var_port:
-      s = string( c_special_variable_port );
+      p = c_special_variable_port;
       break;
 
       case e_special_var_size:
-      s = string( c_special_variable_size );
+      p = c_special_variable_size;
       break;
 
       case e_special_var_uuid:
-      s = string( c_special_variable_uuid );
+      p = c_special_variable_uuid;
       break;
 
       case e_special_var_algos:
-      s = string( c_special_variable_algos );
+      p = c_special_variable_algos;
       break;
 
       case e_special_var_array:
-      s = string( c_special_variable_array );
+      p = c_special_variable_array;
       break;
 
       case e_special_var_async:
-      s = string( c_special_variable_async );
+      p = c_special_variable_async;
       break;
 
       case e_special_var_bytes:
-      s = string( c_special_variable_bytes );
+      p = c_special_variable_bytes;
       break;
 
       case e_special_var_class:
-      s = string( c_special_variable_class );
+      p = c_special_variable_class;
       break;
 
       case e_special_var_embed:
-      s = string( c_special_variable_embed );
+      p = c_special_variable_embed;
       break;
 
       case e_special_var_print:
-      s = string( c_special_variable_print );
+      p = c_special_variable_print;
       break;
 
       case e_special_var_quiet:
-      s = string( c_special_variable_quiet );
+      p = c_special_variable_quiet;
       break;
 
       case e_special_var_title:
-      s = string( c_special_variable_title );
+      p = c_special_variable_title;
       break;
 
       case e_special_var_cloned:
-      s = string( c_special_variable_cloned );
+      p = c_special_variable_cloned;
       break;
 
       case e_special_var_images:
-      s = string( c_special_variable_images );
+      p = c_special_variable_images;
       break;
 
       case e_special_var_module:
-      s = string( c_special_variable_module );
+      p = c_special_variable_module;
       break;
 
       case e_special_var_pubkey:
-      s = string( c_special_variable_pubkey );
+      p = c_special_variable_pubkey;
       break;
 
       case e_special_var_return:
-      s = string( c_special_variable_return );
+      p = c_special_variable_return;
       break;
 
       case e_special_var_script:
-      s = string( c_special_variable_script );
+      p = c_special_variable_script;
       break;
 
       case e_special_var_do_exec:
-      s = string( c_special_variable_do_exec );
+      p = c_special_variable_do_exec;
       break;
 
       case e_special_var_is_last:
-      s = string( c_special_variable_is_last );
+      p = c_special_variable_is_last;
       break;
 
       case e_special_var_message:
-      s = string( c_special_variable_message );
+      p = c_special_variable_message;
       break;
 
       case e_special_var_package:
-      s = string( c_special_variable_package );
+      p = c_special_variable_package;
       break;
 
       case e_special_var_restore:
-      s = string( c_special_variable_restore );
+      p = c_special_variable_restore;
       break;
 
       case e_special_var_slowest:
-      s = string( c_special_variable_slowest );
+      p = c_special_variable_slowest;
       break;
 
       case e_special_var_storage:
-      s = string( c_special_variable_storage );
+      p = c_special_variable_storage;
       break;
 
       case e_special_var_tz_name:
-      s = string( c_special_variable_tz_name );
+      p = c_special_variable_tz_name;
       break;
 
       case e_special_var_trigger:
-      s = string( c_special_variable_trigger );
+      p = c_special_variable_trigger;
       break;
 
       case e_special_var_cmd_hash:
-      s = string( c_special_variable_cmd_hash );
+      p = c_special_variable_cmd_hash;
       break;
 
       case e_special_var_key_info:
-      s = string( c_special_variable_key_info );
+      p = c_special_variable_key_info;
       break;
 
       case e_special_var_executed:
-      s = string( c_special_variable_executed );
+      p = c_special_variable_executed;
       break;
 
       case e_special_var_identity:
-      s = string( c_special_variable_identity );
+      p = c_special_variable_identity;
       break;
 
       case e_special_var_progress:
-      s = string( c_special_variable_progress );
+      p = c_special_variable_progress;
       break;
 
       case e_special_var_args_file:
-      s = string( c_special_variable_args_file );
+      p = c_special_variable_args_file;
       break;
 
       case e_special_var_crypt_key:
-      s = string( c_special_variable_crypt_key );
+      p = c_special_variable_crypt_key;
       break;
 
       case e_special_var_decrement:
-      s = string( c_special_variable_decrement );
+      p = c_special_variable_decrement;
       break;
 
       case e_special_var_image_dir:
-      s = string( c_special_variable_image_dir );
+      p = c_special_variable_image_dir;
       break;
 
       case e_special_var_increment:
-      s = string( c_special_variable_increment );
+      p = c_special_variable_increment;
       break;
 
       case e_special_var_val_error:
-      s = string( c_special_variable_val_error );
+      p = c_special_variable_val_error;
       break;
 
       case e_special_var_blockchain:
-      s = string( c_special_variable_blockchain );
+      p = c_special_variable_blockchain;
       break;
 
       case e_special_var_extra_info:
-      s = string( c_special_variable_extra_info );
+      p = c_special_variable_extra_info;
       break;
 
       case e_special_var_file_names:
-      s = string( c_special_variable_file_names );
+      p = c_special_variable_file_names;
       break;
 
       case e_special_var_permission:
-      s = string( c_special_variable_permission );
+      p = c_special_variable_permission;
       break;
 
       case e_special_var_allow_async:
-      s = string( c_special_variable_allow_async );
+      p = c_special_variable_allow_async;
       break;
 
       case e_special_var_application:
-      s = string( c_special_variable_application );
+      p = c_special_variable_application;
       break;
 
       case e_special_var_errors_only:
-      s = string( c_special_variable_errors_only );
+      p = c_special_variable_errors_only;
       break;
 
       case e_special_var_file_hashes:
-      s = string( c_special_variable_file_hashes );
+      p = c_special_variable_file_hashes;
       break;
 
       case e_special_var_init_log_id:
-      s = string( c_special_variable_init_log_id );
+      p = c_special_variable_init_log_id;
       break;
 
       case e_special_var_output_file:
-      s = string( c_special_variable_output_file );
+      p = c_special_variable_output_file;
       break;
 
       case e_special_var_path_prefix:
-      s = string( c_special_variable_path_prefix );
+      p = c_special_variable_path_prefix;
       break;
 
       case e_special_var_permissions:
-      s = string( c_special_variable_permissions );
+      p = c_special_variable_permissions;
       break;
 
       case e_special_var_skip_update:
-      s = string( c_special_variable_skip_update );
+      p = c_special_variable_skip_update;
       break;
 
       case e_special_var_state_names:
-      s = string( c_special_variable_state_names );
+      p = c_special_variable_state_names;
       break;
 
       case e_special_var_transaction:
-      s = string( c_special_variable_transaction );
+      p = c_special_variable_transaction;
       break;
 
       case e_special_var_block_height:
-      s = string( c_special_variable_block_height );
+      p = c_special_variable_block_height;
       break;
 
       case e_special_var_rewind_height:
-      s = string( c_special_variable_rewind_height );
+      p = c_special_variable_rewind_height;
       break;
 
       case e_special_var_update_fields:
-      s = string( c_special_variable_update_fields );
+      p = c_special_variable_update_fields;
       break;
 
       case e_special_var_peer_initiator:
-      s = string( c_special_variable_peer_initiator );
+      p = c_special_variable_peer_initiator;
       break;
 
       case e_special_var_peer_responder:
-      s = string( c_special_variable_peer_responder );
+      p = c_special_variable_peer_responder;
       break;
 
       case e_special_var_unix_timestamp:
-      s = string( c_special_variable_unix_timestamp );
+      p = c_special_variable_unix_timestamp;
       break;
 
       case e_special_var_dummy_timestamp:
-      s = string( c_special_variable_dummy_timestamp );
+      p = c_special_variable_dummy_timestamp;
       break;
 
       case e_special_var_row_cache_limit:
-      s = string( c_special_variable_row_cache_limit );
+      p = c_special_variable_row_cache_limit;
       break;
 
       case e_special_var_check_if_changed:
-      s = string( c_special_variable_check_if_changed );
+      p = c_special_variable_check_if_changed;
       break;
 
       case e_special_var_skip_after_fetch:
-      s = string( c_special_variable_skip_after_fetch );
+      p = c_special_variable_skip_after_fetch;
       break;
 
       case e_special_var_skip_persistance:
-      s = string( c_special_variable_skip_persistance );
+      p = c_special_variable_skip_persistance;
       break;
 
       case e_special_var_fields_and_values:
-      s = string( c_special_variable_fields_and_values );
+      p = c_special_variable_fields_and_values;
       break;
 
       case e_special_var_package_type_path:
-      s = string( c_special_variable_package_type_path );
+      p = c_special_variable_package_type_path;
       break;
 
       case e_special_var_attached_file_path:
-      s = string( c_special_variable_attached_file_path );
+      p = c_special_variable_attached_file_path;
       break;
 
       case e_special_var_check_script_error:
-      s = string( c_special_variable_check_script_error );
+      p = c_special_variable_check_script_error;
       break;
 
       case e_special_var_blockchain_head_hash:
-      s = string( c_special_variable_blockchain_head_hash );
+      p = c_special_variable_blockchain_head_hash;
       break;
 
       case e_special_var_blockchain_info_hash:
-      s = string( c_special_variable_blockchain_info_hash );
+      p = c_special_variable_blockchain_info_hash;
       break;
 
       case e_special_var_locally_minted_block:
-      s = string( c_special_variable_locally_minted_block );
+      p = c_special_variable_locally_minted_block;
       break;
 
       case e_special_var_secondary_validation:
-      s = string( c_special_variable_secondary_validation );
+      p = c_special_variable_secondary_validation;
       break;
 
       case e_special_var_skip_blockchain_lock:
-      s = string( c_special_variable_skip_blockchain_lock );
+      p = c_special_variable_skip_blockchain_lock;
       break;
 
       case e_special_var_peer_is_synchronising:
-      s = string( c_special_variable_peer_is_synchronising );
+      p = c_special_variable_peer_is_synchronising;
       break;
 
       case e_special_var_total_child_field_in_parent:
-      s = string( c_special_variable_total_child_field_in_parent );
+      p = c_special_variable_total_child_field_in_parent;
       break;
 
       default:
       throw runtime_error( "unexpected special var value #" + to_string( var ) );
    }
 
-   return s;
+   return p;
+}
+
+const size_t c_num_special_vars = e_special_var_total_child_field_in_parent + 1;
+
+class special_var_names
+{
+   public:
+   special_var_names( )
+   {
+      for( size_t i = 0; i < c_num_special_vars; i++ )
+         names.push_back( string( special_var_name( ( special_var )i ) ) );
+   }
+
+   const string& operator [ ]( size_t i ) const { return names[ i ]; }
+
+   private:
+   vector< string > names;
+};
+
+// NOTE: Special variable names are used very frequently so are only constructed once.
+special_var_names g_special_var_names;
+
+// NOTE: Publishes a copy of the variables (if they were changed) when it goes out of scope
+// and so must be declared after the guard for "g_mutex".
+struct variables_publisher
+{
+   variables_publisher( ) : changed( false ) { }
+
+   ~variables_publisher( )
+   {
+      if( changed )
+         g_snapshot.publish( new variable_container( g_variables ) );
+   }
+
+   bool changed;
+};
+
+string get_variable_value( const variable_container& variables, const string& name, const string& sys_var_prefix )
+{
+   string retval;
+   string var_name( name );
+
+   if( var_name.find_first_of( "?*" ) != string::npos )
+   {
+      if( var_name == "*" )
+         var_name = sys_var_prefix + var_name;
+
+      variable_const_iterator ci;
+      for( ci = variables.begin( ); ci != variables.end( ); ++ci )
+      {
+         if( wildcard_match( var_name, ci->first ) )
+         {
+            if( !retval.empty( ) )
+               retval += "\n";
+            retval += ci->first + ' ' + ci->second;
+         }
+      }
+   }
+   else
+   {
+      variable_const_iterator ci = variables.find( var_name );
+
+      if( ci != variables.end( ) )
+         retval = ci->second;
+   }
+
+   return retval;
+}
+
+}
+
+const string& get_special_var_name( special_var var )
+{
+   if( ( size_t )var >= c_num_special_vars )
+      throw runtime_error( "unexpected special var value #" + to_string( var ) );
+
+   return g_special_var_names[ var ];
 }
 
 system_variable_lock::system_variable_lock( const string& name )
@@ -566,7 +652,29 @@ system_variable_lock::~system_variable_lock( )
 
 string get_raw_system_variable( const string& name )
 {
+   bool has_prefix = ( !name.empty( )
+    && ( name[ 0 ] == c_persist_variable_prefix || name[ 0 ] == c_restore_variable_prefix ) );
+
+   // NOTE: Unless persisting or restoring (or the unix timestamp has not yet been set) the
+   // current snapshot is read without acquiring the mutex.
+   if( !has_prefix )
+   {
+      read_snapshot< variable_container >::reader variables( g_snapshot );
+
+      if( variables->count( c_special_variable_unix_timestamp ) )
+      {
+         string sys_var_prefix;
+
+         variable_const_iterator ci = variables->find( c_special_variable_sys_var_prefix );
+         if( ci != variables->end( ) )
+            sys_var_prefix = ci->second;
+
+         return get_variable_value( *variables, name, sys_var_prefix );
+      }
+   }
+
    guard g( g_mutex );
+   variables_publisher publisher;
 
    string retval;
    string var_name( name );
@@ -592,8 +700,13 @@ string get_raw_system_variable( const string& name )
    if( g_variables.count( c_special_variable_sys_var_prefix ) )
       sys_var_prefix = g_variables[ c_special_variable_sys_var_prefix ];
 
-   g_variables.insert(
-    make_pair( to_string( c_special_variable_unix_timestamp ), to_string( unix_timestamp( ) ) ) );
+   if( !g_variables.count( c_special_variable_unix_timestamp ) )
+   {
+      publisher.changed = true;
+
+      g_variables.insert(
+       make_pair( to_string( c_special_variable_unix_timestamp ), to_string( unix_timestamp( ) ) ) );
+   }
 
    // NOTE: One or more persistent variables can have their values
    // either stored or restored depending upon the prefix used and
@@ -653,7 +766,10 @@ string get_raw_system_variable( const string& name )
                ciyam_ods_file_system( ).fetch_from_text_file( next, value );
 
                if( !var_name.empty( ) )
+               {
+                  publisher.changed = true;
                   g_variables[ next ] = value;
+               }
                else
                {
                   string next_value;
@@ -682,27 +798,8 @@ string get_raw_system_variable( const string& name )
          }
       }
    }
-   else if( var_name.find_first_of( "?*" ) != string::npos )
-   {
-      if( var_name == "*" )
-         var_name = sys_var_prefix + var_name;
-
-      map< string, string >::const_iterator ci;
-      for( ci = g_variables.begin( ); ci != g_variables.end( ); ++ci )
-      {
-         if( wildcard_match( var_name, ci->first ) )
-         {
-            if( !retval.empty( ) )
-               retval += "\n";
-            retval += ci->first + ' ' + ci->second;
-         }
-      }
-   }
    else
-   {
-      if( g_variables.count( var_name ) )
-         retval = g_variables[ var_name ];
-   }
+      retval = get_variable_value( g_variables, var_name, sys_var_prefix );
 
    return retval;
 }
@@ -723,6 +820,7 @@ string get_system_variable( const string& name_or_expr )
 void set_system_variable( const string& name, const string& value )
 {
    guard g( g_mutex );
+   variables_publisher publisher;
 
    string val( value );
 
@@ -751,11 +849,17 @@ void set_system_variable( const string& name, const string& value )
    }
 
    if( !val.empty( ) )
+   {
+      publisher.changed = true;
       g_variables[ var_name ] = val;
+   }
    else
    {
       if( g_variables.count( var_name ) )
+      {
+         publisher.changed = true;
          g_variables.erase( var_name );
+      }
    }
 
    if( persist )
@@ -775,6 +879,7 @@ void set_system_variable( const string& name, const string& value )
 bool set_system_variable( const string& name, const string& value, const string& current )
 {
    guard g( g_mutex );
+   variables_publisher publisher;
 
    bool retval = false;
 
@@ -791,6 +896,8 @@ bool set_system_variable( const string& name, const string& value, const string&
 
    if( retval )
    {
+      publisher.changed = true;
+
       if( !value.empty( ) )
          g_variables[ name ] = value;
       else
@@ -21,7 +21,7 @@
 #     define CIYAM_BASE_DECL_SPEC DYNAMIC_IMPORT
 #  endif
 
-std::string CIYAM_BASE_DECL_SPEC get_special_var_name( special_var var );
+const std::string& CIYAM_BASE_DECL_SPEC get_special_var_name( special_var var );
 
 struct CIYAM_BASE_DECL_SPEC system_variable_lock
 {
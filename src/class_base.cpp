@@ -50,6 +50,7 @@
 #include "hashcash.h"
 #include "date_time.h"
 #include "tx_create.h"
+#include "fs_iterator.h"
 #include "file_utils.h"
 #include "ciyam_base.h"
 #include "ciyam_files.h"
@@ -136,6 +137,26 @@ const char* const c_attribute_finish_time = "finish_time";
 
 const char* const c_gpg_key_fingerprint_prefix = "Key fingerprint = ";
 
+const char* const c_email_queue_directory = "email_queue";
+const char* const c_email_queue_file_ext = ".msg";
+const char* const c_email_queue_failed_ext = ".failed";
+
+const char* const c_section_email = "email";
+
+const char* const c_attribute_dt = "dt";
+const char* const c_attribute_html = "html";
+const char* const c_attribute_error = "error";
+const char* const c_attribute_message = "message";
+const char* const c_attribute_subject = "subject";
+const char* const c_attribute_attempts = "attempts";
+const char* const c_attribute_recipients = "recipients";
+const char* const c_attribute_retry_after = "retry_after";
+const char* const c_attribute_extra_headers = "extra_headers";
+
+const int c_email_queue_retry_seconds = 60;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
 typedef map< string, size_t > foreign_key_lock_container;
 typedef foreign_key_lock_container::iterator foreign_key_lock_iterator;
 typedef foreign_key_lock_container::const_iterator foreign_key_lock_const_iterator;
@@ -147,6 +168,15 @@ map< string, string > g_daylight_names;
 
 mutex g_mutex;
 
+mutex g_email_queue_mutex;
+
+bool g_email_queue_active = false;
+
+size_t g_email_queue_sequence = 0;
+
+set< string > g_email_queue_claimed;
+map< string, time_t > g_email_queue_retry_after;
+
 map< string, pair< int, map< string, string > > > g_class_maps;
 
 const string& attached_file_path_var_name( )
@@ -234,54 +264,75 @@ string get_mask( int numeric_digits,
    return mask;
 }
 
+inline int64_t instant_value( const date_time& dt )
+{
+   return ( ( int64_t )( daynum )dt * c_milliseconds_per_day ) + ( milliseconds )dt.get_time( );
+}
+
+void build_daylight_transitions( daylight_savings_info& daylight_savings )
+{
+   daylight_savings.transitions.clear( );
+
+   for( years_info_const_iterator yici = daylight_savings.years_info.begin( );
+    yici != daylight_savings.years_info.end( ); ++yici )
+   {
+      daylight_savings.transitions.push_back( daylight_transition( yici->first, yici->second.bias,
+       instant_value( date_time( yici->second.begin ) ), instant_value( date_time( yici->second.finish ) ) ) );
+   }
+}
+
 date_time local_utc_conv( const date_time& dt, int utc_offset,
- daylight_savings_info* p_daylight_savings_info, bool to_local, int* p_offset = 0, bool is_daylight = false )
+ const daylight_savings_info* p_daylight_savings_info, bool to_local, int* p_offset = 0, bool is_daylight = false )
 {
    int bias = 0;
    date_time retval( dt );
 
-   if( p_daylight_savings_info && !p_daylight_savings_info->years_info.empty( ) )
+   if( p_daylight_savings_info && !p_daylight_savings_info->transitions.empty( ) )
    {
-      years_info_const_iterator yici;
-      yici = p_daylight_savings_info->years_info.lower_bound( dt.get_year( ) );
+      const vector< daylight_transition >& transitions( p_daylight_savings_info->transitions );
+
+      int dt_year = dt.get_year( );
 
-      // NOTE: If no entry found then it is assumed that DST is no longer applicable.
-      if( yici != p_daylight_savings_info->years_info.end( ) )
+      size_t low = 0;
+      size_t high = transitions.size( );
+
+      while( low < high )
       {
-         // NOTE: If the entry found was greater than the current year then look for a previous entry.
-         if( yici != p_daylight_savings_info->years_info.begin( ) && yici->first > dt.get_year( ) )
-            --yici;
+         size_t mid = low + ( ( high - low ) / 2 );
 
-         // NOTE: If the year being checked is not equal to the DST entry found then it is assumed
-         // that DST was not being used for that year.
-         if( dt.get_year( ) == yici->first )
-         {
-            string begin( yici->second.begin );
-            string finish( yici->second.finish );
+         if( transitions[ mid ].year < dt_year )
+            low = mid + 1;
+         else
+            high = mid;
+      }
 
-            date_time dt_check( dt );
+      // NOTE: If the year being checked does not have a DST entry then it is assumed that DST
+      // was not being used for that year (or is no longer applicable if beyond the last one).
+      if( low < transitions.size( ) && transitions[ low ].year == dt_year )
+      {
+         const daylight_transition& transition( transitions[ low ] );
 
-            // NOTE: If converting from UTC then need to add the standard offset before testing (as
-            // the daylight savings date pairs are expected to be passed as "standard local times").
-            if( to_local )
-               dt_check += ( seconds )utc_offset;
+         int64_t check = instant_value( dt );
 
-            date_time dt_begin( begin );
-            date_time dt_finish( finish );
+         // NOTE: If converting from UTC then need to add the standard offset before testing (as
+         // the daylight savings date pairs are expected to be passed as "standard local times").
+         if( to_local )
+            check += ( int64_t )utc_offset * 1000;
 
-            if( !to_local && is_daylight )
-               dt_finish += ( seconds )yici->second.bias;
+         int64_t finish = transition.finish;
 
-            if( dt_begin < dt_finish )
-            {
-               if( dt_check >= dt_begin && dt_check < dt_finish )
-                  bias = yici->second.bias;
-            }
-            else
-            {
-               if( dt_check < dt_finish || dt_check >= dt_begin )
-                  bias = yici->second.bias;
-            }
+         if( !to_local && is_daylight )
+            finish += ( int64_t )transition.bias * 1000;
+
+         if( transition.begin < finish )
+         {
+            if( check >= transition.begin && check < finish )
+               bias = transition.bias;
+         }
+         else
+         {
+            if( check < finish || check >= transition.begin )
+               bias = transition.bias;
          }
       }
    }
@@ -835,6 +886,7 @@ void class_base::op_destroy( const string& key, op_destroy_rc* p_rc, bool is_int
             break;
 
             case e_instance_op_rc_locked:
+            case e_instance_op_rc_child_locked:
             *p_rc = e_op_destroy_rc_locked;
             break;
 
@@ -1627,9 +1679,8 @@ void class_base::destroy( )
             if( p_class_base )
                ap_tmp_cascading.reset( new class_cascade( *p_class_base ) );
 
-            // FUTURE: The handling of cascades needs to be revisited at some stage to improve performance
-            // as currently iteration occurs three times (firstly to lock, secondly to test if constrained
-            // and thirdly for the actual deletions).
+            // NOTE: The cascade locks and restriction checks have already been made by the single walk
+            // of the cascade plan (when the destroy op began) so this is the only other iteration needed.
             if( p_class_base
              && p_class_base->iterate_forwards( "", c_key_field, true, 0, e_sql_optimisation_unordered ) )
             {
@@ -1643,6 +1694,9 @@ void class_base::destroy( )
                      output_progress_message( "Cascaded " + to_string( i ) + " children..." );
                   }
 
+                  // NOTE: Children are destroyed one at a time (rather than by a single DELETE for each
+                  // child class) as every child destroy needs to run its own triggers and cascades and
+                  // also needs to be individually included in the transaction log.
                   if( next_op == e_cascade_op_destroy )
                   {
                      op_destroy_rc rc;
@@ -3871,11 +3925,7 @@ void generate_timezones_sio( const vector< timezone_info >& timezones )
 
 void setup_timezones( )
 {
-   ifstream inpf( "timezones.sio" );
-   if( !inpf )
-      throw runtime_error( "unable to open file 'timezones.sio' for input" );
-
-   sio_reader reader( inpf );
+   sio_reader reader( string( "timezones.sio" ) );
    reader.start_section( c_section_timezones );
 
    g_timezones.clear( );
@@ -3988,6 +4038,8 @@ void setup_timezones( )
          reader.finish_section( c_section_daylight_saving_changes );
       }
 
+      build_daylight_transitions( tz_data.daylight_savings );
+
       g_timezones.insert( make_pair( name.empty( ) ? abbr : name, tz_data ) );
 
       g_timezone_abbrs[ name.empty( ) ? abbr : name ] = abbr;
@@ -4040,17 +4092,21 @@ string get_tz_desc( const string& tz_name )
    return g_timezones[ name ].description;
 }
 
-void get_tz_info( const date_time& dt, string& tz_name, float& offset )
+timezone_const_iterator find_timezone( const string& tz_name, bool& use_daylight, bool* p_is_daylight = 0 )
 {
    string tz( tz_name );
-   bool is_daylight = false;
-   bool use_daylight = false;
 
-   if( g_daylight_names.count( tz ) )
+   use_daylight = false;
+
+   map< string, string >::const_iterator dni = g_daylight_names.find( tz );
+
+   if( dni != g_daylight_names.end( ) )
    {
-      is_daylight = true;
       use_daylight = true;
-      tz = g_daylight_names[ tz ];
+      tz = dni->second;
+
+      if( p_is_daylight )
+         *p_is_daylight = true;
    }
 
    if( !tz.empty( ) && tz[ tz.length( ) - 1 ] == '+' )
@@ -4059,20 +4115,32 @@ void get_tz_info( const date_time& dt, string& tz_name, float& offset )
       tz.erase( tz.length( ) - 1 );
    }
 
-   if( !g_timezones.count( tz ) )
+   timezone_const_iterator tci = g_timezones.find( tz );
+
+   if( tci == g_timezones.end( ) )
       throw runtime_error( "unable to find timezone information for '" + tz + "'" );
 
+   return tci;
+}
+
+void get_tz_info( const date_time& dt, string& tz_name, float& offset )
+{
+   bool is_daylight = false;
+   bool use_daylight = false;
+
+   timezone_const_iterator tci = find_timezone( tz_name, use_daylight, &is_daylight );
+
    int utc_offset;
 
-   local_utc_conv( dt, g_timezones[ tz ].utc_offset,
-    ( use_daylight ? &g_timezones[ tz ].daylight_savings : 0 ), false, &utc_offset, is_daylight );
+   local_utc_conv( dt, tci->second.utc_offset,
+    ( use_daylight ? &tci->second.daylight_savings : 0 ), false, &utc_offset, is_daylight );
 
    offset = ( float )utc_offset / 3600.0;
 
-   if( utc_offset == g_timezones[ tz ].utc_offset )
-      tz_name = g_timezone_abbrs[ tz ];
+   if( utc_offset == tci->second.utc_offset )
+      tz_name = g_timezone_abbrs[ tci->first ];
    else
-      tz_name = g_timezones[ tz ].daylight_abbr;
+      tz_name = tci->second.daylight_abbr;
 }
 
 date_time utc_to_local( const date_time& dt )
@@ -4082,85 +4150,124 @@ date_time utc_to_local( const date_time& dt )
 
 date_time utc_to_local( const date_time& dt, string& tz_name )
 {
-   string tz( tz_name );
    bool use_daylight = false;
 
-   if( g_daylight_names.count( tz ) )
-   {
-      use_daylight = true;
-      tz = g_daylight_names[ tz ];
-   }
-
-   if( !tz.empty( ) && tz[ tz.length( ) - 1 ] == '+' )
-   {
-      use_daylight = true;
-      tz.erase( tz.length( ) - 1 );
-   }
-
-   if( !g_timezones.count( tz ) )
-      throw runtime_error( "unable to find timezone information for '" + tz + "'" );
+   timezone_const_iterator tci = find_timezone( tz_name, use_daylight );
 
    int utc_offset;
 
-   date_time rc = local_utc_conv( dt, g_timezones[ tz ].utc_offset,
-    ( use_daylight ? &g_timezones[ tz ].daylight_savings : 0 ), true, &utc_offset );
+   date_time rc = local_utc_conv( dt, tci->second.utc_offset,
+    ( use_daylight ? &tci->second.daylight_savings : 0 ), true, &utc_offset );
 
-   if( utc_offset == g_timezones[ tz ].utc_offset )
-      tz_name = g_timezone_abbrs[ tz ];
+   if( utc_offset == tci->second.utc_offset )
+      tz_name = g_timezone_abbrs[ tci->first ];
    else
-      tz_name = g_timezones[ tz ].daylight_abbr;
+      tz_name = tci->second.daylight_abbr;
 
    return rc;
 }
 
 date_time utc_to_local( const date_time& dt, const string& tz_name )
 {
-   string tz( tz_name );
    bool use_daylight = false;
 
-   if( g_daylight_names.count( tz ) )
-   {
-      use_daylight = true;
-      tz = g_daylight_names[ tz ];
-   }
+   timezone_const_iterator tci = find_timezone( tz_name, use_daylight );
 
-   if( !tz.empty( ) && tz[ tz.length( ) - 1 ] == '+' )
-   {
-      use_daylight = true;
-      tz.erase( tz.length( ) - 1 );
-   }
+   return local_utc_conv( dt, tci->second.utc_offset,
+    ( use_daylight ? &tci->second.daylight_savings : 0 ), true );
+}
 
-   if( !g_timezones.count( tz ) )
-      throw runtime_error( "unable to find timezone information for '" + tz + "'" );
+date_time local_to_utc( const date_time& dt, const string& tz_name )
+{
+   bool is_daylight = false;
+   bool use_daylight = false;
+
+   timezone_const_iterator tci = find_timezone( tz_name, use_daylight, &is_daylight );
 
-   return local_utc_conv( dt, g_timezones[ tz ].utc_offset,
-    ( use_daylight ? &g_timezones[ tz ].daylight_savings : 0 ), true );
+   return local_utc_conv( dt, tci->second.utc_offset,
+    ( use_daylight ? &tci->second.daylight_savings : 0 ), false, 0, is_daylight );
 }
 
-date_time local_to_utc( const date_time& dt, const string& tz_name )
+void utc_to_local( vector< date_time >& values, const string& tz_name )
+{
+   bool use_daylight = false;
+
+   timezone_const_iterator tci = find_timezone( tz_name, use_daylight );
+
+   const daylight_savings_info* p_daylight_savings_info = use_daylight ? &tci->second.daylight_savings : 0;
+
+   for( size_t i = 0; i < values.size( ); i++ )
+      values[ i ] = local_utc_conv( values[ i ], tci->second.utc_offset, p_daylight_savings_info, true );
+}
+
+void local_to_utc( vector< date_time >& values, const string& tz_name )
 {
-   string tz( tz_name );
    bool is_daylight = false;
    bool use_daylight = false;
 
-   if( g_daylight_names.count( tz ) )
-   {
-      is_daylight = true;
-      use_daylight = true;
-      tz = g_daylight_names[ tz ];
-   }
+   timezone_const_iterator tci = find_timezone( tz_name, use_daylight, &is_daylight );
 
-   if( !tz.empty( ) && tz[ tz.length( ) - 1 ] == '+' )
+   const daylight_savings_info* p_daylight_savings_info = use_daylight ? &tci->second.daylight_savings : 0;
+
+   for( size_t i = 0; i < values.size( ); i++ )
+      values[ i ] = local_utc_conv( values[ i ],
+       tci->second.utc_offset, p_daylight_savings_info, false, 0, is_daylight );
+}
+
+void benchmark_timezone_conversions( ostream& os, const string& tz_name, size_t num_conversions )
+{
+   if( !num_conversions )
+      num_conversions = 1000000;
+
+   // NOTE: The values are spread (one hour apart) so that both standard
+   // and daylight savings periods will be included in the conversions.
+   vector< date_time > values;
+   values.reserve( num_conversions );
+
+   date_time dt( date_time::standard( ) );
+
+   for( size_t i = 0; i < num_conversions; i++ )
    {
-      use_daylight = true;
-      tz.erase( tz.length( ) - 1 );
+      values.push_back( dt );
+      dt += ( hours )1;
    }
 
-   if( !g_timezones.count( tz ) )
-      throw runtime_error( "unable to find timezone information for '" + tz + "'" );
+   vector< date_time > local_values( values );
+
+   mtime start( mtime::standard( ) );
+
+   for( size_t i = 0; i < num_conversions; i++ )
+      local_values[ i ] = utc_to_local( values[ i ], tz_name );
+
+   milliseconds elapsed = mtime::standard( ) - start;
+
+   if( elapsed < 0 )
+      elapsed += c_milliseconds_per_day;
+
+   os << num_conversions << " single conversions in " << elapsed << " ms";
+
+   if( elapsed > 0 )
+      os << " (" << ( uint64_t )( num_conversions * 1000.0 / elapsed ) << " conversions/sec)";
+
+   os << '\n';
+
+   local_values = values;
+
+   start = mtime::standard( );
+
+   utc_to_local( local_values, tz_name );
+
+   elapsed = mtime::standard( ) - start;
+
+   if( elapsed < 0 )
+      elapsed += c_milliseconds_per_day;
 
-   return local_utc_conv( dt, g_timezones[ tz ].utc_offset,
-    ( use_daylight ? &g_timezones[ tz ].daylight_savings : 0 ), false, 0, is_daylight );
+   os << num_conversions << " batch conversions in " << elapsed << " ms";
+
+   if( elapsed > 0 )
+      os << " (" << ( uint64_t )( num_conversions * 1000.0 / elapsed ) << " conversions/sec)";
+
+   os << '\n';
 }
 
 bool schedulable_month_and_day( int month, int day )
@@ -4263,42 +4370,8 @@ string get_class_map_value( const string& class_id, const string& map_id, const
    return retval;
 }
 
-void send_email_message(
- const string& recipient, const string& subject,
- const string& message, const string& html_source, const vector< string >* p_extra_headers,
- const vector< string >* p_file_names, const string* p_tz_name, const vector< string >* p_image_names,
- const string* p_image_path_prefix )
-{
-   user_account account;
-
-   account.sender = get_smtp_sender( );
-   account.username = get_smtp_username( );
-   account.password = get_smtp_password( );
-
-   string suffix( get_smtp_suffix( ) );
-   if( !suffix.empty( ) && account.username.find( '@' ) == string::npos )
-      account.username += "@" + suffix;
-
-   vector< string > recipients;
-
-   string to( recipient );
-   if( !to.empty( ) && to[ 0 ] == '@' )
-      to = get_raw_session_variable( to );
-
-   recipients.push_back( to );
-
-   send_email_message( account, recipients, subject, message,
-    html_source, p_extra_headers, p_file_names, p_tz_name, p_image_names, p_image_path_prefix );
-}
-
-void send_email_message(
- const vector< string >& recipients, const string& subject,
- const string& message, const string& html_source, const vector< string >* p_extra_headers,
- const vector< string >* p_file_names, const string* p_tz_name, const vector< string >* p_image_names,
- const string* p_image_path_prefix )
+void get_default_email_account( user_account& account )
 {
-   user_account account;
-
    account.sender = get_smtp_sender( );
    account.username = get_smtp_username( );
    account.password = get_smtp_password( );
@@ -4306,40 +4379,10 @@ void send_email_message(
    string suffix( get_smtp_suffix( ) );
    if( !suffix.empty( ) && account.username.find( '@' ) == string::npos )
       account.username += "@" + suffix;
-
-   send_email_message( account, recipients, subject, message,
-    html_source, p_extra_headers, p_file_names, p_tz_name, p_image_names, p_image_path_prefix );
 }
 
-void send_email_message( const user_account& account,
- const vector< string >& recipients, const string& subject,
- const string& message, const string& html_source, const vector< string >* p_extra_headers,
- const vector< string >* p_file_names, const string* p_tz_name, const vector< string >* p_image_names,
- const string* p_image_path_prefix )
+void setup_smtp_user_info( smtp_user_info& user_info )
 {
-   if( account.username.empty( ) )
-      throw runtime_error( "missing SMTP account information" );
-
-   string tz_name;
-   float utc_offset = 0.0;
-
-   date_time dt( date_time::standard( ) );
-
-   if( p_tz_name && !p_tz_name->empty( ) )
-   {
-      tz_name = *p_tz_name;
-      get_tz_info( dt, tz_name, utc_offset );
-
-      dt += minutes( ( int32_t )( utc_offset * 60.0 ) );
-   }
-
-   string charset( "utf-8" );
-
-   string password( account.password );
-
-   smtp_user_info user_info( account.sender,
-    account.username, password, &dt, utc_offset, &tz_name, &charset );
-
    string security( get_smtp_security( ) );
    if( !security.empty( ) )
    {
@@ -4386,6 +4429,202 @@ void send_email_message( const user_account& account,
    }
 
    user_info.max_attachment_bytes = get_smtp_max_attached_data( );
+}
+
+void get_email_date_info( const string* p_tz_name, date_time& dt, string& tz_name, float& utc_offset )
+{
+   dt = date_time::standard( );
+
+   if( p_tz_name && !p_tz_name->empty( ) )
+   {
+      tz_name = *p_tz_name;
+      get_tz_info( dt, tz_name, utc_offset );
+
+      dt += minutes( ( int32_t )( utc_offset * 60.0 ) );
+   }
+}
+
+struct queued_email
+{
+   queued_email( ) : attempts( 0 ), retry_after( 0 ), utc_offset( 0.0 ) { }
+
+   void read( const string& file_name );
+   void write( const string& file_name ) const;
+
+   int attempts;
+   time_t retry_after;
+
+   string error;
+
+   date_time dt;
+   string tz_name;
+   float utc_offset;
+
+   smtp_message message;
+};
+
+void queued_email::read( const string& file_name )
+{
+   ifstream inpf( file_name.c_str( ) );
+   if( !inpf )
+      throw runtime_error( "unable to open '" + file_name + "' for input" );
+
+   sio_reader reader( inpf );
+
+   reader.start_section( c_section_email );
+
+   attempts = from_string< int >( reader.read_attribute( c_attribute_attempts ) );
+   retry_after = from_string< time_t >( reader.read_opt_attribute( c_attribute_retry_after, "0" ) );
+
+   error = base64::decode( reader.read_opt_attribute( c_attribute_error ) );
+
+   dt = date_time( reader.read_attribute( c_attribute_dt ) );
+   tz_name = reader.read_opt_attribute( c_attribute_name );
+   utc_offset = from_string< float >( reader.read_attribute( c_attribute_utc_offset ) );
+
+   split( base64::decode( reader.read_attribute( c_attribute_recipients ) ), message.recipients );
+
+   message.subject = base64::decode( reader.read_opt_attribute( c_attribute_subject ) );
+   message.message = base64::decode( reader.read_opt_attribute( c_attribute_message ) );
+   message.html = base64::decode( reader.read_opt_attribute( c_attribute_html ) );
+
+   string extra_headers( reader.read_opt_attribute( c_attribute_extra_headers ) );
+   if( !extra_headers.empty( ) )
+      split( base64::decode( extra_headers ), message.extra_headers, '\n' );
+
+   reader.finish_section( c_section_email );
+}
+
+void queued_email::write( const string& file_name ) const
+{
+   string tmp_file_name( file_name + ".tmp" );
+
+   {
+      ofstream outf( tmp_file_name.c_str( ) );
+      if( !outf )
+         throw runtime_error( "unable to open '" + tmp_file_name + "' for output" );
+
+      sio_writer writer( outf );
+
+      writer.start_section( c_section_email );
+
+      writer.write_attribute( c_attribute_attempts, to_string( attempts ) );
+      writer.write_opt_attribute( c_attribute_retry_after, to_string( retry_after ), "0" );
+
+      writer.write_opt_attribute( c_attribute_error, base64::encode( error ) );
+
+      writer.write_attribute( c_attribute_dt, dt.as_string( ) );
+      writer.write_opt_attribute( c_attribute_name, tz_name );
+      writer.write_attribute( c_attribute_utc_offset, to_string( utc_offset ) );
+
+      writer.write_attribute( c_attribute_recipients, base64::encode( join( message.recipients ) ) );
+
+      writer.write_opt_attribute( c_attribute_subject, base64::encode( message.subject ) );
+      writer.write_opt_attribute( c_attribute_message, base64::encode( message.message ) );
+      writer.write_opt_attribute( c_attribute_html, base64::encode( message.html ) );
+
+      if( !message.extra_headers.empty( ) )
+         writer.write_attribute( c_attribute_extra_headers, base64::encode( join( message.extra_headers, '\n' ) ) );
+
+      writer.finish_section( c_section_email );
+      writer.finish_sections( );
+
+      outf.flush( );
+      if( !outf.good( ) )
+         throw runtime_error( "unexpected error writing '" + tmp_file_name + "'" );
+   }
+
+   if( !file_rename( tmp_file_name, file_name ) )
+      throw runtime_error( "unable to rename '" + tmp_file_name + "' to '" + file_name + "'" );
+}
+
+bool is_queued_email_name( string& name )
+{
+   if( name.length( ) <= strlen( c_email_queue_file_ext )
+    || name.substr( name.length( ) - strlen( c_email_queue_file_ext ) ) != c_email_queue_file_ext )
+      return false;
+
+   name.erase( name.length( ) - strlen( c_email_queue_file_ext ) );
+
+   return true;
+}
+
+struct email_queue_claims
+{
+   ~email_queue_claims( )
+   {
+      guard g( g_email_queue_mutex );
+
+      for( size_t i = 0; i < names.size( ); i++ )
+         g_email_queue_claimed.erase( names[ i ] );
+   }
+
+   vector< string > names;
+};
+
+void send_email_message(
+ const string& recipient, const string& subject,
+ const string& message, const string& html_source, const vector< string >* p_extra_headers,
+ const vector< string >* p_file_names, const string* p_tz_name, const vector< string >* p_image_names,
+ const string* p_image_path_prefix )
+{
+   vector< string > recipients;
+
+   string to( recipient );
+   if( !to.empty( ) && to[ 0 ] == '@' )
+      to = get_raw_session_variable( to );
+
+   recipients.push_back( to );
+
+   send_email_message( recipients, subject, message,
+    html_source, p_extra_headers, p_file_names, p_tz_name, p_image_names, p_image_path_prefix );
+}
+
+void send_email_message(
+ const vector< string >& recipients, const string& subject,
+ const string& message, const string& html_source, const vector< string >* p_extra_headers,
+ const vector< string >* p_file_names, const string* p_tz_name, const vector< string >* p_image_names,
+ const string* p_image_path_prefix )
+{
+   // NOTE: Messages with attached files or images are not queued as the files might no longer
+   // exist by the time that the message would be sent.
+   if( email_queue_is_active( )
+    && ( !p_file_names || p_file_names->empty( ) ) && ( !p_image_names || p_image_names->empty( ) ) )
+   {
+      queue_email_message( recipients, subject, message, html_source, p_extra_headers, p_tz_name );
+      return;
+   }
+
+   user_account account;
+   get_default_email_account( account );
+
+   send_email_message( account, recipients, subject, message,
+    html_source, p_extra_headers, p_file_names, p_tz_name, p_image_names, p_image_path_prefix );
+}
+
+void send_email_message( const user_account& account,
+ const vector< string >& recipients, const string& subject,
+ const string& message, const string& html_source, const vector< string >* p_extra_headers,
+ const vector< string >* p_file_names, const string* p_tz_name, const vector< string >* p_image_names,
+ const string* p_image_path_prefix )
+{
+   if( account.username.empty( ) )
+      throw runtime_error( "missing SMTP account information" );
+
+   string tz_name;
+   float utc_offset = 0.0;
+
+   date_time dt;
+   get_email_date_info( p_tz_name, dt, tz_name, utc_offset );
+
+   string charset( "utf-8" );
+
+   string password( account.password );
+
+   smtp_user_info user_info( account.sender,
+    account.username, password, &dt, utc_offset, &tz_name, &charset );
+
+   setup_smtp_user_info( user_info );
 
    string html;
    if( !html_source.empty( ) )
@@ -4419,6 +4658,285 @@ void send_email_message( const user_account& account,
    }
 }
 
+void activate_email_queue( )
+{
+   guard g( g_email_queue_mutex );
+
+   if( !file_exists( c_email_queue_directory ) )
+   {
+      bool rc;
+      create_dir( c_email_queue_directory, &rc );
+
+      if( !rc )
+         throw runtime_error( "unable to create directory '" + string( c_email_queue_directory ) + "'" );
+   }
+
+   // NOTE: As the retry time for a message that had failed to be sent is stored in its queue file
+   // these are read here so that the backoff of any such messages is retained across a restart.
+   time_t now( time( 0 ) );
+
+   file_filter ff;
+   fs_iterator fs( c_email_queue_directory, &ff );
+
+   while( fs.has_next( ) )
+   {
+      string name( fs.get_name( ) );
+
+      if( !is_queued_email_name( name ) )
+         continue;
+
+      queued_email email;
+
+      try
+      {
+         email.read( fs.get_full_name( ) );
+      }
+      catch( ... )
+      {
+         continue;
+      }
+
+      if( email.retry_after > now )
+         g_email_queue_retry_after[ name ] = email.retry_after;
+   }
+
+   g_email_queue_active = true;
+}
+
+bool email_queue_is_active( )
+{
+   guard g( g_email_queue_mutex );
+
+   return g_email_queue_active;
+}
+
+string queue_email_message( const vector< string >& recipients,
+ const string& subject, const string& message, const string& html_source,
+ const vector< string >* p_extra_headers, const string* p_tz_name )
+{
+   if( get_smtp_username( ).empty( ) )
+      throw runtime_error( "missing SMTP account information" );
+
+   queued_email email;
+
+   get_email_date_info( p_tz_name, email.dt, email.tz_name, email.utc_offset );
+
+   email.message.recipients = recipients;
+   email.message.subject = subject;
+   email.message.message = message;
+
+   if( !html_source.empty( ) )
+      email.message.html = buffer_file( html_source );
+
+   if( p_extra_headers )
+      email.message.extra_headers = *p_extra_headers;
+
+   string name;
+   {
+      guard g( g_email_queue_mutex );
+
+      // NOTE: The name is prefixed with the current time so that messages will be sent in the
+      // order they were queued (with the sequence making names unique within the same tenth).
+      name = date_time::standard( ).as_string( e_time_format_hhmmsst, false ) + to_comparable_string( ++g_email_queue_sequence, false, 8 );
+   }
+
+   email.write( string( c_email_queue_directory ) + "/" + name + c_email_queue_file_ext );
+
+   return name;
+}
+
+size_t send_queued_email_messages( size_t max_messages )
+{
+   email_queue_claims claims;
+
+   {
+      guard g( g_email_queue_mutex );
+
+      if( !g_email_queue_active )
+         return 0;
+
+      time_t now( time( 0 ) );
+
+      vector< string > names;
+
+      file_filter ff;
+      fs_iterator fs( c_email_queue_directory, &ff );
+
+      while( fs.has_next( ) )
+      {
+         string name( fs.get_name( ) );
+
+         if( !is_queued_email_name( name ) )
+            continue;
+
+         if( g_email_queue_claimed.count( name ) )
+            continue;
+
+         if( g_email_queue_retry_after.count( name ) && g_email_queue_retry_after[ name ] > now )
+            continue;
+
+         names.push_back( name );
+      }
+
+      sort( names.begin( ), names.end( ) );
+
+      for( size_t i = 0; i < names.size( ) && i < max_messages; i++ )
+      {
+         claims.names.push_back( names[ i ] );
+         g_email_queue_claimed.insert( names[ i ] );
+      }
+   }
+
+   if( claims.names.empty( ) )
+      return 0;
+
+   user_account account;
+   get_default_email_account( account );
+
+   string charset( "utf-8" );
+
+   smtp_user_info user_info( account.sender, account.username, account.password, 0, 0.0, 0, &charset );
+
+   setup_smtp_user_info( user_info );
+
+   progress* p_progress = 0;
+   trace_progress progress( TRACE_MAIL_OPS );
+
+   if( get_trace_flags( ) & TRACE_MAIL_OPS )
+      p_progress = &progress;
+
+   auto_ptr< smtp_connection > ap_connection;
+
+   for( size_t i = 0; i < claims.names.size( ); i++ )
+   {
+      string name( claims.names[ i ] );
+      string file_name( string( c_email_queue_directory ) + "/" + name + c_email_queue_file_ext );
+
+      queued_email email;
+      bool is_sending = false;
+
+      try
+      {
+         email.read( file_name );
+      }
+      catch( exception& x )
+      {
+         TRACE_LOG( TRACE_ANYTHING, "unable to read queued email '" + name + "' (" + x.what( ) + ")" );
+
+         file_rename( file_name, string( c_email_queue_directory ) + "/" + name + c_email_queue_failed_ext );
+         continue;
+      }
+
+      try
+      {
+         if( !ap_connection.get( ) || !ap_connection->is_okay( ) )
+            ap_connection.reset( new smtp_connection( get_smtp_server( ), user_info, p_progress ) );
+
+         smtp_user_info header_info( user_info );
+
+         header_info.p_dt = &email.dt;
+         header_info.utc_offset = email.utc_offset;
+         header_info.p_tz_abbr = &email.tz_name;
+
+         is_sending = true;
+         ap_connection->send( email.message, &header_info );
+
+         file_remove( file_name );
+
+         guard g( g_email_queue_mutex );
+         g_email_queue_retry_after.erase( name );
+      }
+      catch( exception& x )
+      {
+         if( ap_connection.get( ) && !ap_connection->is_okay( ) )
+            ap_connection.reset( );
+
+         email.error = x.what( );
+
+         // NOTE: A permanent rejection of the message by the server will not be retried.
+         if( ( is_sending && is_permanent_smtp_failure( email.error ) )
+          || ++email.attempts >= get_smtp_max_send_attempts( ) )
+         {
+            TRACE_LOG( TRACE_ANYTHING, "unable to send queued email '" + name + "' (" + x.what( ) + ")" );
+
+            email.retry_after = 0;
+            email.write( file_name );
+
+            file_rename( file_name, string( c_email_queue_directory ) + "/" + name + c_email_queue_failed_ext );
+
+            guard g( g_email_queue_mutex );
+            g_email_queue_retry_after.erase( name );
+         }
+         else
+         {
+            email.retry_after = time( 0 ) + ( c_email_queue_retry_seconds * email.attempts );
+            email.write( file_name );
+
+            guard g( g_email_queue_mutex );
+            g_email_queue_retry_after[ name ] = email.retry_after;
+         }
+
+         // NOTE: If the connection could not be established then there is no point continuing.
+         if( !ap_connection.get( ) )
+            break;
+      }
+   }
+
+   return claims.names.size( );
+}
+
+void output_email_queue( ostream& os )
+{
+   vector< string > names;
+
+   {
+      guard g( g_email_queue_mutex );
+
+      if( file_exists( c_email_queue_directory ) )
+      {
+         file_filter ff;
+         fs_iterator fs( c_email_queue_directory, &ff );
+
+         while( fs.has_next( ) )
+         {
+            string name( fs.get_name( ) );
+
+            if( wildcard_match( string( "*" ) + c_email_queue_file_ext, name )
+             || wildcard_match( string( "*" ) + c_email_queue_failed_ext, name ) )
+               names.push_back( name );
+         }
+      }
+   }
+
+   sort( names.begin( ), names.end( ) );
+
+   for( size_t i = 0; i < names.size( ); i++ )
+   {
+      os << names[ i ];
+
+      // NOTE: For messages that could not be sent the reason for the last failure is also output.
+      if( wildcard_match( string( "*" ) + c_email_queue_failed_ext, names[ i ] ) )
+      {
+         queued_email email;
+
+         try
+         {
+            email.read( string( c_email_queue_directory ) + "/" + names[ i ] );
+         }
+         catch( ... )
+         {
+         }
+
+         string::size_type pos = email.error.find( '\n' );
+
+         if( !email.error.empty( ) )
+            os << " (" << email.error.substr( 0, pos ) << ")";
+      }
+
+      os << '\n';
+   }
+}
+
 string generate_hashcash( const string& recipient )
 {
    string::size_type pos = recipient.find_last_of( "<" );
@@ -4514,6 +5032,17 @@ string check_email_headers( const vector< string >& headers, bool create_script_
    return osstr.str( );
 }
 
+bool has_script_subject( mail_source& source, int num )
+{
+   vector< string > email_headers;
+   email_headers.push_back( "Subject:" );
+
+   source.get_message_headers( num, email_headers );
+
+   return lower( email_headers[ 0 ] ).find( "subject: " ) == 0
+    && email_headers[ 0 ].find( c_email_subject_script_marker ) != string::npos;
+}
+
 void fetch_email_messages( const user_account& account,
  const string* p_file_name_prefix, vector< pair< bool, string > >* p_messages, bool skip_scripts )
 {
@@ -4554,17 +5083,8 @@ void fetch_email_messages( const user_account& account,
 
          bool is_mime = false;
 
-         if( skip_scripts )
-         {
-            vector< string > email_headers;
-            email_headers.push_back( "Subject:" );
-
-            ap_mail_source->get_message_headers( i + 1, email_headers );
-
-            if( lower( email_headers[ 0 ] ).find( "subject: " ) == 0
-             && email_headers[ 0 ].find( c_email_subject_script_marker ) != string::npos )
-               continue;
-         }
+         if( skip_scripts && has_script_subject( *ap_mail_source, i + 1 ) )
+            continue;
 
          ap_mail_source->get_message( i + 1, osstr, &is_mime );
          p_messages->push_back( make_pair( is_mime, osstr.str( ) ) );
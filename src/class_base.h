@@ -14,6 +14,7 @@
 #     include <vector>
 #     include <memory>
 #     include <string>
+#     include <iosfwd>
 #     include <utility>
 #  endif
 
@@ -1387,9 +1388,32 @@ typedef years_info_container::iterator years_info_iterator;
 typedef years_info_container::const_iterator years_info_const_iterator;
 typedef years_info_container::value_type years_info_value_type;
 
+struct daylight_transition
+{
+   daylight_transition( int year, int bias, int64_t begin, int64_t finish )
+    :
+    year( year ),
+    bias( bias ),
+    begin( begin ),
+    finish( finish )
+   {
+   }
+
+   int year;
+   int bias;
+
+   int64_t begin;
+   int64_t finish;
+};
+
 struct daylight_savings_info
 {
    years_info_container years_info;
+
+   // NOTE: The "transitions" (ordered by year with the begin and finish
+   // times as millisecond instants) are built from "years_info" after a
+   // timezone has been read so conversions don't need to parse strings.
+   std::vector< daylight_transition > transitions;
 };
 
 struct timezone_data
@@ -1420,6 +1444,12 @@ date_time CIYAM_BASE_DECL_SPEC utc_to_local( const date_time& dt, const std::str
 
 date_time CIYAM_BASE_DECL_SPEC local_to_utc( const date_time& dt, const std::string& tz_name );
 
+void CIYAM_BASE_DECL_SPEC utc_to_local( std::vector< date_time >& values, const std::string& tz_name );
+void CIYAM_BASE_DECL_SPEC local_to_utc( std::vector< date_time >& values, const std::string& tz_name );
+
+void CIYAM_BASE_DECL_SPEC benchmark_timezone_conversions(
+ std::ostream& os, const std::string& tz_name, size_t num_conversions = 0 );
+
 bool CIYAM_BASE_DECL_SPEC schedulable_month_and_day( int month, int day );
 
 void CIYAM_BASE_DECL_SPEC add_class_map( const std::string& class_id,
@@ -1455,6 +1485,22 @@ void CIYAM_BASE_DECL_SPEC send_email_message( const user_account& account,
  const std::vector< std::string >* p_file_names = 0, const std::string* p_tz_name = 0,
  const std::vector< std::string >* p_image_names = 0, const std::string* p_image_path_prefix = 0 );
 
+// NOTE: Once the email queue has been activated messages that would be sent using the default SMTP account
+// (unless having attached files or images) are instead queued to be sent by "send_queued_email_messages".
+// In this case "send_email_message" returns once the message has been queued so a failure to send it will
+// not be reported to its caller (instead after the last attempt or a permanent rejection the message file
+// is renamed with a ".failed" extension, the failure is logged and its reason is output by "emailqueue").
+void CIYAM_BASE_DECL_SPEC activate_email_queue( );
+bool CIYAM_BASE_DECL_SPEC email_queue_is_active( );
+
+std::string CIYAM_BASE_DECL_SPEC queue_email_message( const std::vector< std::string >& recipients,
+ const std::string& subject, const std::string& message, const std::string& html_source,
+ const std::vector< std::string >* p_extra_headers = 0, const std::string* p_tz_name = 0 );
+
+size_t CIYAM_BASE_DECL_SPEC send_queued_email_messages( size_t max_messages );
+
+void CIYAM_BASE_DECL_SPEC output_email_queue( std::ostream& os );
+
 std::string CIYAM_BASE_DECL_SPEC generate_hashcash( const std::string& recipient );
 bool CIYAM_BASE_DECL_SPEC has_valid_hashcash( const std::string& value );
 
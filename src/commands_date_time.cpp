@@ -11,6 +11,7 @@
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
 #  include <string>
+#  include <sstream>
 #endif
 
 #define CIYAM_BASE_IMPL
@@ -95,7 +96,7 @@ date_time_command_functor::date_time_command_functor( date_time_command_handler&
 {
 }
 
-void date_time_command_functor::operator ( )( const string& command, const parameter_info& /*parameters*/ )
+void date_time_command_functor::operator ( )( const string& command, const parameter_info& parameters )
 {
    cmd_handler.retval.erase( );
 
@@ -109,6 +110,17 @@ void date_time_command_functor::operator ( )( const string& command, const param
       cmd_handler.retval = to_string( ( julian )*cmd_handler.p_date_time );
    else if( command == c_cmd_date_time_weekday )
       cmd_handler.retval = to_string( cmd_handler.p_date_time->weekday_name( ) );
+   else if( command == c_cmd_date_time_bench )
+   {
+      string num_conversions( get_parm_val( parameters, c_cmd_parm_date_time_bench_num_conversions ) );
+
+      ostringstream osstr;
+
+      benchmark_date_time_conversions( osstr,
+       num_conversions.empty( ) ? 0 : from_string< size_t >( num_conversions ) );
+
+      cmd_handler.retval = osstr.str( );
+   }
 }
 
 command_functor* date_time_command_functor_factory( const string& /*name*/, command_handler& handler )
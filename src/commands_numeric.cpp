@@ -11,6 +11,8 @@
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
 #  include <string>
+#  include <vector>
+#  include <stdexcept>
 #endif
 
 #define CIYAM_BASE_IMPL
@@ -126,6 +128,30 @@ void numeric_command_functor::operator ( )( const string& command, const paramet
 
       cmd_handler.retval = to_string( *cmd_handler.p_numeric /= n );
    }
+   else if( command == c_cmd_numeric_sum )
+   {
+      vector< numeric > values;
+      split_numerics( get_parm_val( parameters, c_cmd_parm_numeric_sum_values ), values );
+
+      if( !values.empty( ) )
+         *cmd_handler.p_numeric += sum( &values[ 0 ], values.size( ) );
+
+      cmd_handler.retval = to_string( *cmd_handler.p_numeric );
+   }
+   else if( command == c_cmd_numeric_sum_product )
+   {
+      vector< numeric > lhs_values, rhs_values;
+      split_numerics( get_parm_val( parameters, c_cmd_parm_numeric_sum_product_lhs_values ), lhs_values );
+      split_numerics( get_parm_val( parameters, c_cmd_parm_numeric_sum_product_rhs_values ), rhs_values );
+
+      if( lhs_values.size( ) != rhs_values.size( ) )
+         throw runtime_error( "lhs and rhs values must have the same number of items" );
+
+      if( !lhs_values.empty( ) )
+         *cmd_handler.p_numeric += sum_product( &lhs_values[ 0 ], &rhs_values[ 0 ], lhs_values.size( ) );
+
+      cmd_handler.retval = to_string( *cmd_handler.p_numeric );
+   }
    else if( command == c_cmd_numeric_round )
    {
       numeric::round_method m( numeric::e_round_method_normal );
@@ -9,6 +9,7 @@
 #pragma hdrstop
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <map>
 #  include <deque>
 #  include <vector>
 #  include <iostream>
@@ -18,6 +19,8 @@
 
 #include "cube.h"
 
+#include "threads.h"
+#include "date_time.h"
 #include "utilities.h"
 
 using namespace std;
@@ -55,6 +58,101 @@ string get_init_state_for_type( const string& type )
    return y + g + o + b + r + w;
 }
 
+const char* const c_flip_op = "^";
+
+const size_t c_face_top = 0;
+const size_t c_face_lft = 1;
+const size_t c_face_fnt = 2;
+const size_t c_face_rgt = 3;
+const size_t c_face_bck = 4;
+const size_t c_face_bot = 5;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
+// NOTE: This class holds each face as a separate string and performs moves by manipulating rows
+// and columns. It is only used to construct the permutation tables that "cube" uses for its moves
+// (by applying a move to a state whose facelets are each labelled with their own offset).
+class cube_faces
+{
+   public:
+   void init( const string& state );
+
+   string get_state( ) const { return top + lft + fnt + rgt + bck + bot; }
+
+   void flip( );
+
+   void move( const string& op );
+
+   void move_top( const string& op );
+   void move_back( const string& op );
+   void move_left( const string& op );
+   void move_front( const string& op );
+   void move_right( const string& op );
+   void move_bottom( const string& op );
+
+   private:
+   string top;
+   string bot;
+   string lft;
+   string rgt;
+   string fnt;
+   string bck;
+
+   void swap_row( string& lhs, string& rhs, int num );
+   void swap_column( string& lhs, string& rhs, int lnum, int rnum = -1 );
+   void swap_row_with_column( string& lhs, string& rhs, int rnum, int cnum = - 1 );
+
+   void reverse_row( string& data, int num );
+   void reverse_column( string& data, int num );
+
+   void rotate_face( string& data, bool clockwise );
+};
+
+mutex g_mutex;
+
+map< string, string > g_move_tables;
+
+const string& get_move_table( const string& type, size_t num_facelets, const string& op )
+{
+   guard g( g_mutex );
+
+   string key( type + ':' + op );
+
+   map< string, string >::iterator i = g_move_tables.find( key );
+
+   if( i == g_move_tables.end( ) )
+   {
+      if( num_facelets > 256 )
+         throw runtime_error( "unexpected num_facelets > 256" );
+
+      string labels( num_facelets, '\0' );
+
+      for( size_t j = 0; j < num_facelets; j++ )
+         labels[ j ] = ( char )j;
+
+      cube_faces faces;
+      faces.init( labels );
+
+      if( op == c_flip_op )
+         faces.flip( );
+      else
+         faces.move( op );
+
+      i = g_move_tables.insert( make_pair( key, faces.get_state( ) ) ).first;
+   }
+
+   return i->second;
+}
+
+void check_face_op( const string& op, const char* p_name, char face )
+{
+   if( op.empty( ) )
+      throw runtime_error( "unexpected empty op for " + string( p_name ) );
+
+   if( op[ 0 ] != face && op[ 0 ] != tolower( face ) )
+      throw runtime_error( "unsupported cube op " + op );
+}
+
 }
 
 cube::cube( const string& type_and_or_state )
@@ -105,8 +203,9 @@ void cube::init( const string& state )
       throw runtime_error( "invalid state length % 6 != 0" );
    else
    {
-      size_t offset = 0;
-      size_t num_per_side = state.length( ) / 6;
+      string old_type( type );
+
+      num_per_side = state.length( ) / 6;
 
       if( num_per_side == 4 )
          type = c_type_2_2_2;
@@ -119,31 +218,16 @@ void cube::init( const string& state )
       else
          throw runtime_error( "unsupported num_per_side = " + to_string( num_per_side ) );
 
+      if( type != old_type )
+         move_perms.clear( );
+
       if( initial.empty( ) )
          initial = state;
 
-      top.clear( );
-      top = state.substr( offset, num_per_side );
-
-      lft.clear( );
-      offset += num_per_side;
-      lft = state.substr( offset, num_per_side );
-
-      fnt.clear( );
-      offset += num_per_side;
-      fnt = state.substr( offset, num_per_side );
+      facelets = state;
 
-      rgt.clear( );
-      offset += num_per_side;
-      rgt = state.substr( offset, num_per_side );
-
-      bck.clear( );
-      offset += num_per_side;
-      bck = state.substr( offset, num_per_side );
-
-      bot.clear( );
-      offset += num_per_side;
-      bot = state.substr( offset, num_per_side );
+      last_moves.erase( );
+      last_moves_perm.erase( );
    }
 }
 
@@ -231,11 +315,11 @@ string cube::scramble_moves( size_t num_moves, bool for_actual_scramble ) const
 
    for( size_t i = 0; i < scramble_moves; i++ )
    {
-      string move( available_moves[ rand( ) % range ] );
+      string move( available_moves[ next_random( ) % range ] );
 
-      if( rand( ) % 3 == 0 )
+      if( next_random( ) % 3 == 0 )
          move += '\'';
-      else if( rand( ) % 5 == 0 )
+      else if( next_random( ) % 5 == 0 )
          move += '2';
 
       moves.push_back( move );
@@ -257,17 +341,17 @@ string cube::scramble_moves( size_t num_moves, bool for_actual_scramble ) const
 
 void cube::output_sides( ostream& os ) const
 {
-   output_side_info( os, "top", top );
-   output_side_info( os, "lft", lft );
-   output_side_info( os, "fnt", fnt );
-   output_side_info( os, "rgt", rgt );
-   output_side_info( os, "bck", bck );
-   output_side_info( os, "bot", bot );
+   output_side_info( os, "top", face( c_face_top ) );
+   output_side_info( os, "lft", face( c_face_lft ) );
+   output_side_info( os, "fnt", face( c_face_fnt ) );
+   output_side_info( os, "rgt", face( c_face_rgt ) );
+   output_side_info( os, "bck", face( c_face_bck ) );
+   output_side_info( os, "bot", face( c_face_bot ) );
 }
 
 string cube::get_state( bool include_initial ) const
 {
-   string retval( top + lft + fnt + rgt + bck + bot );
+   string retval( facelets );
 
    if( include_initial )
       retval += ':' + initial;
@@ -277,59 +361,66 @@ string cube::get_state( bool include_initial ) const
 
 bool cube::solved( ) const
 {
-   return ( get_state( false ) == initial );
+   return ( facelets == initial );
 }
 
 void cube::output_top_side( ostream& os ) const
 {
-   output_side_info( os, "", top );
+   output_side_info( os, "", face( c_face_top ) );
 }
 
 void cube::output_back_side( ostream& os ) const
 {
-   output_side_info( os, "", bck );
+   output_side_info( os, "", face( c_face_bck ) );
 }
 
 void cube::output_left_side( ostream& os ) const
 {
-   output_side_info( os, "", lft );
+   output_side_info( os, "", face( c_face_lft ) );
 }
 
 void cube::output_front_side( ostream& os ) const
 {
-   output_side_info( os, "", fnt );
+   output_side_info( os, "", face( c_face_fnt ) );
 }
 
 void cube::output_right_side( ostream& os ) const
 {
-   output_side_info( os, "", rgt );
+   output_side_info( os, "", face( c_face_rgt ) );
 }
 
 void cube::output_bottom_side( ostream& os ) const
 {
-   output_side_info( os, "", bot );
+   output_side_info( os, "", face( c_face_bot ) );
 }
 
 void cube::output_side( ostream& os, const string& name ) const
 {
    if( name == "top" )
-      output_side_info( os, "", top );
+      output_side_info( os, "", face( c_face_top ) );
    else if( name == "bck" || name == "back" )
-      output_side_info( os, "", bck );
+      output_side_info( os, "", face( c_face_bck ) );
    else if( name == "lft" || name == "left" )
-      output_side_info( os, "", lft );
+      output_side_info( os, "", face( c_face_lft ) );
    else if( name == "fnt" || name == "front" )
-      output_side_info( os, "", fnt );
+      output_side_info( os, "", face( c_face_fnt ) );
    else if( name == "rgt" || name == "right" )
-      output_side_info( os, "", rgt );
+      output_side_info( os, "", face( c_face_rgt ) );
    else if( name == "bot" || name == "bottom" )
-      output_side_info( os, "", bot );
+      output_side_info( os, "", face( c_face_bot ) );
 }
 
 void cube::output_matching_cubie( ostream& os, const string& cubie ) const
 {
    if( !cubie.empty( ) )
    {
+      string top( face( c_face_top ) );
+      string bot( face( c_face_bot ) );
+      string lft( face( c_face_lft ) );
+      string rgt( face( c_face_rgt ) );
+      string fnt( face( c_face_fnt ) );
+      string bck( face( c_face_bck ) );
+
       int offset = 0;
 
       if( cubie.length( ) > 1 && cubie[ 1 ] >= '1' && cubie[ 1 ] <= '9' )
@@ -363,6 +454,13 @@ void cube::output_matching_cubies( ostream& os, const string& color ) const
 {
    if( !color.empty( ) )
    {
+      string top( face( c_face_top ) );
+      string bot( face( c_face_bot ) );
+      string lft( face( c_face_lft ) );
+      string rgt( face( c_face_rgt ) );
+      string fnt( face( c_face_fnt ) );
+      string bck( face( c_face_bck ) );
+
       string cubie( "U" );
 
       for( size_t i = 0; i < top.length( ); i++ )
@@ -455,7 +553,111 @@ void cube::output_matching_cubies( ostream& os, const string& color ) const
    }
 }
 
+void cube::apply_permutation( const string& perm )
+{
+   scratch.resize( facelets.size( ) );
+
+   char* p_dest = &scratch[ 0 ];
+   const char* p_src = facelets.data( );
+
+   for( size_t i = 0; i < perm.size( ); i++ )
+      p_dest[ i ] = p_src[ ( unsigned char )perm[ i ] ];
+
+   facelets.swap( scratch );
+}
+
+const string& cube::get_move_perm( const string& op )
+{
+   map< string, const string* >::iterator i = move_perms.find( op );
+
+   if( i == move_perms.end( ) )
+      i = move_perms.insert( make_pair( op, &get_move_table( type, facelets.size( ), op ) ) ).first;
+
+   return *i->second;
+}
+
 void cube::flip( )
+{
+   apply_permutation( get_move_perm( c_flip_op ) );
+}
+
+void cube::move( const string& op )
+{
+   if( !op.empty( ) )
+   {
+      if( string( "UBLFRDublfrd" ).find( op[ 0 ] ) == string::npos )
+         throw runtime_error( "unknown move op: " + op );
+
+      apply_permutation( get_move_perm( op ) );
+   }
+}
+
+void cube::move_top( const string& op )
+{
+   check_face_op( op, "move_top", 'U' );
+
+   move( op );
+}
+
+void cube::move_left( const string& op )
+{
+   check_face_op( op, "move_left", 'L' );
+
+   move( op );
+}
+
+void cube::move_back( const string& op )
+{
+   check_face_op( op, "move_back", 'B' );
+
+   move( op );
+}
+
+void cube::move_front( const string& op )
+{
+   check_face_op( op, "move_front", 'F' );
+
+   move( op );
+}
+
+void cube::move_right( const string& op )
+{
+   check_face_op( op, "move_right", 'R' );
+
+   move( op );
+}
+
+void cube::move_bottom( const string& op )
+{
+   check_face_op( op, "move_bottom", 'D' );
+
+   move( op );
+}
+
+void cube_faces::init( const string& state )
+{
+   size_t offset = 0;
+   size_t num_per_side = state.length( ) / 6;
+
+   top = state.substr( offset, num_per_side );
+
+   offset += num_per_side;
+   lft = state.substr( offset, num_per_side );
+
+   offset += num_per_side;
+   fnt = state.substr( offset, num_per_side );
+
+   offset += num_per_side;
+   rgt = state.substr( offset, num_per_side );
+
+   offset += num_per_side;
+   bck = state.substr( offset, num_per_side );
+
+   offset += num_per_side;
+   bot = state.substr( offset, num_per_side );
+}
+
+void cube_faces::flip( )
 {
    string tmp( top );
 
@@ -479,7 +681,7 @@ void cube::flip( )
    rotate_face( rgt, true );
 }
 
-void cube::move( const string& op )
+void cube_faces::move( const string& op )
 {
    if( !op.empty( ) )
    {
@@ -500,7 +702,7 @@ void cube::move( const string& op )
    }
 }
 
-void cube::move_top( const string& op )
+void cube_faces::move_top( const string& op )
 {
    string op_val( op );
 
@@ -604,7 +806,7 @@ void cube::move_top( const string& op )
    }
 }
 
-void cube::move_left( const string& op )
+void cube_faces::move_left( const string& op )
 {
    string op_val( op );
 
@@ -726,7 +928,7 @@ void cube::move_left( const string& op )
    }
 }
 
-void cube::move_back( const string& op )
+void cube_faces::move_back( const string& op )
 {
    string op_val( op );
 
@@ -849,7 +1051,7 @@ void cube::move_back( const string& op )
    }
 }
 
-void cube::move_front( const string& op )
+void cube_faces::move_front( const string& op )
 {
    string op_val( op );
 
@@ -972,7 +1174,7 @@ void cube::move_front( const string& op )
    }
 }
 
-void cube::move_right( const string& op )
+void cube_faces::move_right( const string& op )
 {
    string op_val( op );
 
@@ -1094,7 +1296,7 @@ void cube::move_right( const string& op )
    }
 }
 
-void cube::move_bottom( const string& op )
+void cube_faces::move_bottom( const string& op )
 {
    string op_val( op );
    int num_cubies_per_side = ( int )sqrt( ( float )lft.size( ) );
@@ -1199,6 +1401,12 @@ void cube::move_bottom( const string& op )
 
 void cube::perform_moves( const string& ops )
 {
+   if( ops == last_moves && !last_moves_perm.empty( ) )
+   {
+      apply_permutation( last_moves_perm );
+      return;
+   }
+
    string all_ops( ops );
    vector< string > move_ops;
 
@@ -1251,8 +1459,34 @@ void cube::perform_moves( const string& ops )
    if( !all_ops.empty( ) )
       split( all_ops, move_ops, ' ' );
 
+   // NOTE: The permutations for each move are combined into a single permutation (which is cached
+   // so that if the same moves are performed again they can simply be applied as a single gather).
+   string perm( facelets.size( ), '\0' );
+   string next_perm( facelets.size( ), '\0' );
+
+   for( size_t i = 0; i < perm.size( ); i++ )
+      perm[ i ] = ( char )i;
+
    for( size_t i = 0; i < move_ops.size( ); i++ )
-      move( move_ops[ i ] );
+   {
+      if( move_ops[ i ].empty( ) )
+         continue;
+
+      if( string( "UBLFRDublfrd" ).find( move_ops[ i ][ 0 ] ) == string::npos )
+         throw runtime_error( "unknown move op: " + move_ops[ i ] );
+
+      const string& move_perm( get_move_perm( move_ops[ i ] ) );
+
+      for( size_t j = 0; j < perm.size( ); j++ )
+         next_perm[ j ] = perm[ ( unsigned char )move_perm[ j ] ];
+
+      perm.swap( next_perm );
+   }
+
+   last_moves = ops;
+   last_moves_perm = perm;
+
+   apply_permutation( last_moves_perm );
 }
 
 string cube::random_ops( size_t num_ops ) const
@@ -1260,6 +1494,65 @@ string cube::random_ops( size_t num_ops ) const
    return scramble_moves( num_ops );
 }
 
+void cube::benchmark( ostream& os, size_t num_moves )
+{
+   if( !num_moves )
+      num_moves = 1000000;
+
+   string original( facelets );
+
+   vector< string > ops;
+
+   string faces( "UDLRFB" );
+
+   for( size_t i = 0; i < faces.size( ); i++ )
+   {
+      ops.push_back( string( 1, faces[ i ] ) );
+      ops.push_back( string( 1, faces[ i ] ) + "'" );
+      ops.push_back( string( 1, faces[ i ] ) + "2" );
+   }
+
+   mtime start( mtime::standard( ) );
+
+   for( size_t i = 0; i < num_moves; i++ )
+      move( ops[ next_random( ) % ops.size( ) ] );
+
+   milliseconds elapsed = mtime::standard( ) - start;
+
+   if( elapsed < 0 )
+      elapsed += c_milliseconds_per_day;
+
+   os << num_moves << " moves in " << elapsed << " ms";
+
+   if( elapsed > 0 )
+      os << " (" << ( uint64_t )( num_moves * 1000.0 / elapsed ) << " moves/sec)";
+
+   os << '\n';
+
+   string sequence( scramble_moves( 20 ) );
+
+   size_t num_sequences = num_moves / 20;
+
+   start = mtime::standard( );
+
+   for( size_t i = 0; i < num_sequences; i++ )
+      perform_moves( sequence );
+
+   elapsed = mtime::standard( ) - start;
+
+   if( elapsed < 0 )
+      elapsed += c_milliseconds_per_day;
+
+   os << num_sequences << " sequences of 20 moves in " << elapsed << " ms";
+
+   if( elapsed > 0 )
+      os << " (" << ( uint64_t )( num_sequences * 20 * 1000.0 / elapsed ) << " moves/sec)";
+
+   os << '\n';
+
+   facelets = original;
+}
+
 string cube::cleanup_output( const string& original ) const
 {
    string output( " " + original + " " );
@@ -1362,7 +1655,7 @@ string cube::cleanup_output( const string& original ) const
    return output;
 }
 
-void cube::swap_row( string& lhs, string& rhs, int num )
+void cube_faces::swap_row( string& lhs, string& rhs, int num )
 {
    vector< string > lhs_rows;
    vector< string > rhs_rows;
@@ -1403,7 +1696,7 @@ void cube::swap_row( string& lhs, string& rhs, int num )
       rhs += rhs_rows[ i ];
 }
 
-void cube::swap_column( string& lhs, string& rhs, int lnum, int rnum )
+void cube_faces::swap_column( string& lhs, string& rhs, int lnum, int rnum )
 {
    vector< string > lhs_columns;
    vector< string > rhs_columns;
@@ -1453,7 +1746,7 @@ void cube::swap_column( string& lhs, string& rhs, int lnum, int rnum )
    }
 }
 
-void cube::swap_row_with_column( string& lhs, string& rhs, int rnum, int cnum )
+void cube_faces::swap_row_with_column( string& lhs, string& rhs, int rnum, int cnum )
 {
    if( cnum < 0 )
       cnum = rnum;
@@ -1500,7 +1793,7 @@ void cube::swap_row_with_column( string& lhs, string& rhs, int rnum, int cnum )
    }
 }
 
-void cube::reverse_row( string& data, int num )
+void cube_faces::reverse_row( string& data, int num )
 {
    vector< string > rows;
 
@@ -1525,7 +1818,7 @@ void cube::reverse_row( string& data, int num )
       data += rows[ i ];
 }
 
-void cube::reverse_column( string& data, int num )
+void cube_faces::reverse_column( string& data, int num )
 {
    vector< string > columns;
 
@@ -1553,7 +1846,7 @@ void cube::reverse_column( string& data, int num )
    }
 }
 
-void cube::rotate_face( string& data, bool clockwise )
+void cube_faces::rotate_face( string& data, bool clockwise )
 {
    int cubies = sqrt( ( float )data.length( ) );
    int num_cubies_per_edge = ( data.length( ) / cubies );
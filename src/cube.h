@@ -7,6 +7,7 @@
 #  define CUBE_H
 
 #  ifndef HAS_PRECOMPILED_STD_HEADERS
+#     include <map>
 #     include <iosfwd>
 #     include <string>
 #  endif
@@ -95,27 +96,35 @@ class CUBE_DECL_SPEC cube : public op_algo_handler
 
    void exec_ops( const std::string& ops ) { perform_moves( ops ); }
 
+   void benchmark( std::ostream& os, size_t num_moves );
+
    std::string cleanup_output( const std::string& original ) const;
 
    private:
-   std::string top;
-   std::string bot;
-   std::string lft;
-   std::string rgt;
-   std::string fnt;
-   std::string bck;
+   // NOTE: The state is held as one byte per facelet (in the same order as "get_state" uses) with
+   // every move being applied as a permutation (and the permutation for the last sequence of moves
+   // that was performed being cached so that repeating the same sequence is a single gather).
+   std::string facelets;
+
+   size_t num_per_side;
 
    std::string type;
    std::string initial;
 
-   void swap_row( std::string& lhs, std::string& rhs, int num );
-   void swap_column( std::string& lhs, std::string& rhs, int lnum, int rnum = -1 );
-   void swap_row_with_column( std::string& lhs, std::string& rhs, int rnum, int cnum = - 1 );
+   std::string last_moves;
+   std::string last_moves_perm;
+
+   std::string scratch;
+
+   // NOTE: Each instance keeps its own pointers to the (never erased) shared move permutations so
+   // that the global lock is only needed the first time an instance performs any particular move.
+   std::map< std::string, const std::string* > move_perms;
+
+   std::string face( size_t num ) const { return facelets.substr( num * num_per_side, num_per_side ); }
 
-   void reverse_row( std::string& data, int num );
-   void reverse_column( std::string& data, int num );
+   const std::string& get_move_perm( const std::string& op );
 
-   void rotate_face( std::string& data, bool clockwise );
+   void apply_permutation( const std::string& perm );
 
    void output_side_info( std::ostream& os, const std::string& name, const std::string& data ) const;
 };
@@ -15,6 +15,7 @@
 #  endif
 #  include <cmath>
 #  include <ctime>
+#  include <cstring>
 #  include <iostream>
 #  include <algorithm>
 #  include <stdexcept>
@@ -114,6 +115,8 @@ const double c_zenith_astronomical = 108.0;
 
 const int c_epoch = 1985;
 
+const char* const c_mtime_format_error_suffix = "' but expecting 'hhmm[ss[t[h[t]]]]' or 'hh:mm[:ss[.t[h[t]]]]')";
+
 const double c_epsilon_g = 279.611371; // Solar ecliptic long at epoch.
 const double c_rho_g = 282.680403; // Solar ecliptic long of perigee at epoch.
 const double c_eccentricity = 0.01671542; // Solar orbit eccentricity.
@@ -816,6 +819,39 @@ string chinese_calendar_year_name( year yr, bool as_english_animal_name )
    return str;
 }
 
+size_t time_format_length( time_format tf, bool use_separators )
+{
+   size_t len = 0;
+
+   switch( tf )
+   {
+      case e_time_format_hhmm:
+      len = use_separators ? 5 : 4;
+      break;
+
+      case e_time_format_hhmmss:
+      len = use_separators ? 8 : 6;
+      break;
+
+      case e_time_format_hhmmsst:
+      len = use_separators ? 10 : 7;
+      break;
+
+      case e_time_format_hhmmssth:
+      len = use_separators ? 11 : 8;
+      break;
+
+      case e_time_format_hhmmsstht:
+      len = use_separators ? 12 : 9;
+      break;
+
+      default:
+      throw runtime_error( "unexpected time_format value #" + to_string( tf ) );
+   }
+
+   return len;
+}
+
 }
 
 mtime::mtime( )
@@ -835,76 +871,12 @@ mtime::mtime( const char* s )
    if( !s )
       throw runtime_error( "unexpected null ptr in mtime::mtime" );
 
-   *this = mtime( string( s ) );
+   construct_from_chars( s, strlen( s ) );
 }
 
 mtime::mtime( const std::string& s )
 {
-   if( s == "local" )
-      *this = mtime::local( );
-   else if( s == "standard" )
-      *this = mtime::standard( );
-   else
-   {
-      if( s.length( ) < 4 || s.length( ) > 12 )
-         throw runtime_error( "invalid format for mtime (given '" + s + "' but expecting 'hhmm[ss[t[h[t]]]]' or 'hh:mm[:ss[.t[h[t]]]]')" );
-
-      hour hr;
-      minute mn;
-      second sc( 0 );
-
-      size_t mn_off, sc_off;
-      if( isdigit( s[ 2 ] ) )
-         mn_off = 2, sc_off = 4;
-      else
-         mn_off = 3, sc_off = 6;
-
-      if( s.length( ) < 6 )
-         sc_off = 0;
-
-      hr = ( hour )( ( ( s[ 0 ] - '0' ) * 10 ) + ( s[ 1 ] - '0' ) );
-      mn = ( minute )( ( ( s[ mn_off ] - '0' ) * 10 ) + ( s[ mn_off + 1 ] - '0' ) );
-
-      if( sc_off == 6 && s.length( ) > 5 && s.length( ) < 8 )
-         throw runtime_error( "invalid format for mtime (given '" + s + "' but expecting 'hhmm[ss[t[h[t]]]]' or 'hh:mm[:ss[.t[h[t]]]]')" );
-
-      if( sc_off && s.length( ) > sc_off + 1 )
-         sc = ( second )( ( ( s[ sc_off ] - '0' ) * 10 ) + ( s[ sc_off + 1 ] - '0' ) );
-
-      tenth te( 0 );
-      hundredth hd( 0 );
-      thousandth th( 0 );
-
-      if( sc_off == 4 )
-      {
-         if( s.length( ) > 6 )
-            te = ( tenth )( s[ 6 ] - '0' );
-
-         if( s.length( ) > 7 )
-            hd = ( hundredth )( s[ 7 ] - '0' );
-
-         if( s.length( ) > 8 )
-            th = ( thousandth )( s[ 8 ] - '0' );
-      }
-      else if( s.length( ) >= 10 )
-      {
-         te = ( tenth )( s[ 9 ] - '0' );
-
-         if( s.length( ) >= 11 )
-         {
-            hd = ( hundredth )( s[ 10 ] - '0' );
-
-            if( s.length( ) == 12 )
-               th = ( thousandth )( s[ 11 ] - '0' );
-         }
-      }
-
-      verify_time( hr, mn, sc, te, hd, th );
-
-      ms = hr * c_milliseconds_per_hour;
-      ms += mn * c_milliseconds_per_minute;
-      ms += components_to_millisecond( sc, te, hd, th );
-   }
+   construct_from_chars( s.data( ), s.length( ) );
 }
 
 mtime::mtime( hour hr, minute mn )
@@ -1122,77 +1094,127 @@ second mtime::get_second( ) const
    return sc;
 }
 
-string mtime::as_string( time_format tf, bool use_separators ) const
+void mtime::construct_from_chars( const char* s, size_t len )
 {
-   string str( as_string( use_separators, true ) );
-
-   switch( tf )
+   if( len == 5 && memcmp( s, "local", 5 ) == 0 )
+      *this = mtime::local( );
+   else if( len == 8 && memcmp( s, "standard", 8 ) == 0 )
+      *this = mtime::standard( );
+   else
    {
-      case e_time_format_hhmm:
-      str = str.substr( 0, use_separators ? 5 : 4 );
-      break;
+      if( len < 4 || len > 12 )
+         throw runtime_error( "invalid format for mtime (given '" + string( s, len ) + c_mtime_format_error_suffix );
 
-      case e_time_format_hhmmss:
-      str = str.substr( 0, use_separators ? 8 : 6 );
-      break;
+      hour hr;
+      minute mn;
+      second sc( 0 );
 
-      case e_time_format_hhmmsst:
-      str = str.substr( 0, use_separators ? 10 : 7 );
-      break;
+      size_t mn_off, sc_off;
+      if( isdigit( s[ 2 ] ) )
+         mn_off = 2, sc_off = 4;
+      else
+         mn_off = 3, sc_off = 6;
 
-      case e_time_format_hhmmssth:
-      str = str.substr( 0, use_separators ? 11 : 8 );
-      break;
+      if( len < 6 )
+         sc_off = 0;
 
-      case e_time_format_hhmmsstht:
-      break;
+      hr = ( hour )( ( ( s[ 0 ] - '0' ) * 10 ) + ( s[ 1 ] - '0' ) );
+      mn = ( minute )( ( ( s[ mn_off ] - '0' ) * 10 ) + ( s[ mn_off + 1 ] - '0' ) );
 
-      default:
-      throw runtime_error( "unexpected time_format value #" + to_string( tf ) );
+      if( sc_off == 6 && len > 5 && len < 8 )
+         throw runtime_error( "invalid format for mtime (given '" + string( s, len ) + c_mtime_format_error_suffix );
+
+      if( sc_off && len > sc_off + 1 )
+         sc = ( second )( ( ( s[ sc_off ] - '0' ) * 10 ) + ( s[ sc_off + 1 ] - '0' ) );
+
+      tenth te( 0 );
+      hundredth hd( 0 );
+      thousandth th( 0 );
+
+      if( sc_off == 4 )
+      {
+         if( len > 6 )
+            te = ( tenth )( s[ 6 ] - '0' );
+
+         if( len > 7 )
+            hd = ( hundredth )( s[ 7 ] - '0' );
+
+         if( len > 8 )
+            th = ( thousandth )( s[ 8 ] - '0' );
+      }
+      else if( len >= 10 )
+      {
+         te = ( tenth )( s[ 9 ] - '0' );
+
+         if( len >= 11 )
+         {
+            hd = ( hundredth )( s[ 10 ] - '0' );
+
+            if( len == 12 )
+               th = ( thousandth )( s[ 11 ] - '0' );
+         }
+      }
+
+      verify_time( hr, mn, sc, te, hd, th );
+
+      ms = hr * c_milliseconds_per_hour;
+      ms += mn * c_milliseconds_per_minute;
+      ms += components_to_millisecond( sc, te, hd, th );
    }
+}
 
-   return str;
+string mtime::as_string( time_format tf, bool use_separators ) const
+{
+   char buf[ c_mtime_max_chars + 1 ];
+   as_chars( buf, use_separators, true );
+
+   return string( buf, time_format_length( tf, use_separators ) );
 }
 
 string mtime::as_string( bool use_separators, bool include_milliseconds ) const
 {
-   char hhmmssmmm[ ] = "hhmmssmmm";
+   char buf[ c_mtime_max_chars + 1 ];
+   size_t len = as_chars( buf, use_separators, include_milliseconds );
+
+   return string( buf, len );
+}
+
+size_t mtime::as_chars( char* p_buf, bool use_separators, bool include_milliseconds ) const
+{
+   char* p = p_buf;
 
    hour hr( get_hour( ) );
-   hhmmssmmm[ 0 ] = '0' + ( hr / 10 );
-   hhmmssmmm[ 1 ] = '0' + ( hr % 10 );
+   *p++ = '0' + ( hr / 10 );
+   *p++ = '0' + ( hr % 10 );
+
+   if( use_separators )
+      *p++ = ':';
 
    minute mn( get_minute( ) );
-   hhmmssmmm[ 2 ] = '0' + ( mn / 10 );
-   hhmmssmmm[ 3 ] = '0' + ( mn % 10 );
+   *p++ = '0' + ( mn / 10 );
+   *p++ = '0' + ( mn % 10 );
+
+   if( use_separators )
+      *p++ = ':';
 
    second sc( get_second( ) );
-   hhmmssmmm[ 4 ] = '0' + ( sc / 10 );
-   hhmmssmmm[ 5 ] = '0' + ( sc % 10 );
+   *p++ = '0' + ( sc / 10 );
+   *p++ = '0' + ( sc % 10 );
 
-   if( !include_milliseconds )
-      hhmmssmmm[ 6 ] = '\0';
-   else
+   if( include_milliseconds )
    {
+      if( use_separators )
+         *p++ = '.';
+
       millisecond ms( get_millisecond( ) );
-      hhmmssmmm[ 6 ] = '0' + ( ms / 100 );
-      hhmmssmmm[ 7 ] = '0' + ( ( ms % 100 ) / 10 );
-      hhmmssmmm[ 8 ] = '0' + ( ms % 10 );
+      *p++ = '0' + ( ms / 100 );
+      *p++ = '0' + ( ( ms % 100 ) / 10 );
+      *p++ = '0' + ( ms % 10 );
    }
 
-   if( !use_separators )
-      return string( hhmmssmmm );
-   else
-   {
-      string str( hhmmssmmm );
-      str.insert( 2, 1, ':' );
-      str.insert( 5, 1, ':' );
+   *p = '\0';
 
-      if( include_milliseconds )
-         str.insert( 8, 1, '.' );
-
-      return str;
-   }
+   return p - p_buf;
 }
 
 mtime mtime::local( )
@@ -1353,48 +1375,12 @@ udate::udate( const char* s )
    if( !s )
       throw runtime_error( "unexpected null ptr in udate::udate" );
 
-   *this = udate( string( s ) );
+   construct_from_chars( s, strlen( s ) );
 }
 
 udate::udate( const std::string& s )
 {
-   if( s == "local" )
-      *this = udate::local( );
-   else if( s == "standard" )
-      *this = udate::standard( );
-   else
-   {
-      if( s.length( ) != 8 && s.length( ) != 10 )
-         throw runtime_error( "invalid format for udate (given '" + s + "' but expecting 'yyyymmdd' or 'yyyy-mm-dd')" );
-
-      year yr;
-      month mo;
-      day dy;
-
-      yr = 0;
-      for( size_t i = 0; i < 4; i++ )
-      {
-         yr = yr * 10;
-         yr += s[ i ] - '0';
-      }
-
-      size_t mo_off, dy_off;
-      if( s.length( ) == 8 )
-         mo_off = 4, dy_off = 6;
-      else
-         mo_off = 5, dy_off = 8;
-
-      mo = ( month )( ( ( s[ mo_off ] - '0' ) * 10 ) + ( s[ mo_off + 1 ] - '0' ) );
-      dy = ( day )( ( ( s[ dy_off ] - '0' ) * 10 ) + ( s[ dy_off + 1 ] - '0' ) );
-
-      dn = 0;
-
-      ymd.yr = yr;
-      ymd.mo = mo;
-      ymd.dy = dy;
-
-      validate( );
-   }
+   construct_from_chars( s.data( ), s.length( ) );
 }
 
 udate::udate( year yr, month mo, day dy )
@@ -2050,34 +2036,83 @@ day udate::get_day( ) const
    return dy;
 }
 
+void udate::construct_from_chars( const char* s, size_t len )
+{
+   if( len == 5 && memcmp( s, "local", 5 ) == 0 )
+      *this = udate::local( );
+   else if( len == 8 && memcmp( s, "standard", 8 ) == 0 )
+      *this = udate::standard( );
+   else
+   {
+      if( len != 8 && len != 10 )
+         throw runtime_error( "invalid format for udate (given '"
+          + string( s, len ) + "' but expecting 'yyyymmdd' or 'yyyy-mm-dd')" );
+
+      year yr;
+      month mo;
+      day dy;
+
+      yr = 0;
+      for( size_t i = 0; i < 4; i++ )
+      {
+         yr = yr * 10;
+         yr += s[ i ] - '0';
+      }
+
+      size_t mo_off, dy_off;
+      if( len == 8 )
+         mo_off = 4, dy_off = 6;
+      else
+         mo_off = 5, dy_off = 8;
+
+      mo = ( month )( ( ( s[ mo_off ] - '0' ) * 10 ) + ( s[ mo_off + 1 ] - '0' ) );
+      dy = ( day )( ( ( s[ dy_off ] - '0' ) * 10 ) + ( s[ dy_off + 1 ] - '0' ) );
+
+      dn = 0;
+
+      ymd.yr = yr;
+      ymd.mo = mo;
+      ymd.dy = dy;
+
+      validate( );
+   }
+}
+
 string udate::as_string( bool use_separators ) const
 {
-   char yyyymmdd[ ] = "yyyymmdd";
+   char buf[ c_udate_max_chars + 1 ];
+   size_t len = as_chars( buf, use_separators );
+
+   return string( buf, len );
+}
+
+size_t udate::as_chars( char* p_buf, bool use_separators ) const
+{
+   char* p = p_buf;
 
    year yr( get_year( ) );
-   yyyymmdd[ 0 ] = '0' + ( yr / 1000 );
-   yyyymmdd[ 1 ] = '0' + ( ( yr % 1000 ) / 100 );
-   yyyymmdd[ 2 ] = '0' + ( ( yr % 100 ) / 10 );
-   yyyymmdd[ 3 ] = '0' + ( yr % 10 );
+   *p++ = '0' + ( yr / 1000 );
+   *p++ = '0' + ( ( yr % 1000 ) / 100 );
+   *p++ = '0' + ( ( yr % 100 ) / 10 );
+   *p++ = '0' + ( yr % 10 );
+
+   if( use_separators )
+      *p++ = '-';
 
    month mo( get_month( ) );
-   yyyymmdd[ 4 ] = '0' + ( mo / 10 );
-   yyyymmdd[ 5 ] = '0' + ( mo % 10 );
+   *p++ = '0' + ( mo / 10 );
+   *p++ = '0' + ( mo % 10 );
+
+   if( use_separators )
+      *p++ = '-';
 
    day dy( get_day( ) );
-   yyyymmdd[ 6 ] = '0' + ( dy / 10 );
-   yyyymmdd[ 7 ] = '0' + ( dy % 10 );
+   *p++ = '0' + ( dy / 10 );
+   *p++ = '0' + ( dy % 10 );
 
-   if( !use_separators )
-      return string( yyyymmdd );
-   else
-   {
-      string str( yyyymmdd );
-      str.insert( 4, 1, '-' );
-      str.insert( 7, 1, '-' );
+   *p = '\0';
 
-      return str;
-   }
+   return p - p_buf;
 }
 
 string udate::as_string( date_format df, bool use_separators ) const
@@ -2512,7 +2547,7 @@ date_time::date_time( const char* s )
    if( !s )
       throw runtime_error( "unexpected null ptr in date_time::date_time" );
 
-   *this = date_time( string( s ) );
+   *this = date_time( s, strlen( s ) );
 }
 
 void date_time::construct_from_julian( julian j )
@@ -2537,34 +2572,40 @@ void date_time::construct_from_julian( julian j )
 
 date_time::date_time( const string& s )
 {
-   if( s == "local" )
+   *this = date_time( s.data( ), s.length( ) );
+}
+
+date_time::date_time( const char* s, size_t len )
+{
+   if( len == 5 && memcmp( s, "local", 5 ) == 0 )
    {
       ud = udate::local( );
       mt = mtime::local( );
    }
-   else if( s == "system" )
+   else if( len == 6 && memcmp( s, "system", 6 ) == 0 )
    {
       ud = udate::standard( );
       mt = mtime::standard( );
    }
    else
    {
-      if( s.length( ) != 8 && s.length( ) != 10 && ( s.length( ) < 12 || s.length( ) > 23 ) )
-         throw runtime_error( "invalid format for date_time (given '"
-          + s + "' but expecting 'yyyymmdd[hhmm[ss[t[h[t]]]]]' or 'yyyy-mm-dd[ hh:mm[:ss[.t[h[t]]]]]')" );
+      if( len != 8 && len != 10 && ( len < 12 || len > 23 ) )
+         throw runtime_error( "invalid format for date_time (given '" + string( s, len )
+          + "' but expecting 'yyyymmdd[hhmm[ss[t[h[t]]]]]' or 'yyyy-mm-dd[ hh:mm[:ss[.t[h[t]]]]]')" );
 
       if( isdigit( s[ 4 ] ) )
       {
-         ud = udate( s.substr( 0, 8 ) );
-         if( s.length( ) > 8 )
-            mt = mtime( s.substr( 8 ) );
+         ud.construct_from_chars( s, 8 );
+
+         if( len > 8 )
+            mt.construct_from_chars( s + 8, len - 8 );
       }
       else
       {
-         ud = udate( s.substr( 0, 10 ) );
+         ud.construct_from_chars( s, len < 10 ? len : 10 );
 
-         if( s.length( ) > 11 )
-            mt = mtime( s.substr( 11 ) );
+         if( len > 11 )
+            mt.construct_from_chars( s + 11, len - 11 );
       }
    }
 }
@@ -2970,12 +3011,34 @@ date_time::operator julian( ) const
 
 string date_time::as_string( time_format tf, bool use_separators ) const
 {
-   return ud.as_string( use_separators ) + ( use_separators ? " " : "" ) + mt.as_string( tf, use_separators );
+   char buf[ c_date_time_max_chars + 1 ];
+
+   size_t len = ud.as_chars( buf, use_separators );
+
+   if( use_separators )
+      buf[ len++ ] = ' ';
+
+   mt.as_chars( buf + len, use_separators, true );
+
+   return string( buf, len + time_format_length( tf, use_separators ) );
 }
 
 string date_time::as_string( bool use_separators, bool include_milliseconds ) const
 {
-   return ud.as_string( use_separators ) + ( use_separators ? " " : "" ) + mt.as_string( use_separators, include_milliseconds );
+   char buf[ c_date_time_max_chars + 1 ];
+   size_t len = as_chars( buf, use_separators, include_milliseconds );
+
+   return string( buf, len );
+}
+
+size_t date_time::as_chars( char* p_buf, bool use_separators, bool include_milliseconds ) const
+{
+   size_t len = ud.as_chars( p_buf, use_separators );
+
+   if( use_separators )
+      p_buf[ len++ ] = ' ';
+
+   return len + mt.as_chars( p_buf + len, use_separators, include_milliseconds );
 }
 
 double date_time::moon_phase( ) const
@@ -3490,3 +3553,49 @@ string format_date_time( const date_time& dt, const string& dmask, const string&
    return format_udate( dt.get_date( ), dmask ) + format_mtime( dt.get_time( ), tmask );
 }
 
+void benchmark_date_time_conversions( ostream& os, size_t num_conversions )
+{
+   if( !num_conversions )
+      num_conversions = 1000000;
+
+   date_time dt( date_time::standard( ) );
+
+   for( int pass = 0; pass < 2; pass++ )
+   {
+      bool use_separators = ( pass == 1 );
+
+      for( int use_buffers = 0; use_buffers < 2; use_buffers++ )
+      {
+         date_time next( dt );
+         char buf[ c_date_time_max_chars + 1 ];
+
+         mtime start( mtime::standard( ) );
+
+         for( size_t i = 0; i < num_conversions; i++ )
+         {
+            if( use_buffers )
+            {
+               size_t len = next.as_chars( buf, use_separators );
+               next = date_time( buf, len );
+            }
+            else
+               next = date_time( next.as_string( use_separators ) );
+
+            next += ( milliseconds )1;
+         }
+
+         milliseconds elapsed = mtime::standard( ) - start;
+
+         if( elapsed < 0 )
+            elapsed += c_milliseconds_per_day;
+
+         os << num_conversions << ( use_separators ? " ISO" : " canonical" )
+          << ( use_buffers ? " buffer" : " string" ) << " round trips in " << elapsed << " ms";
+
+         if( elapsed > 0 )
+            os << " (" << ( uint64_t )( num_conversions * 1000.0 / elapsed ) << " round trips/sec)";
+
+         os << '\n';
+      }
+   }
+}
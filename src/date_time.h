@@ -121,6 +121,11 @@ typedef int32_t days;
 typedef fp64_t seconds;
 typedef int64_t milliseconds;
 
+// NOTE: Maximum lengths (excluding the terminating null) of the formats written by "as_chars".
+const size_t c_udate_max_chars = 10; // i.e. yyyy-mm-dd
+const size_t c_mtime_max_chars = 12; // i.e. hh:mm:ss.ttt
+const size_t c_date_time_max_chars = 23; // i.e. yyyy-mm-dd hh:mm:ss.ttt
+
 struct minutes
 {
    minutes( int32_t m ) : m( m ) { }
@@ -231,6 +236,8 @@ class DATE_TIME_DECL_SPEC mtime
    std::string as_string( time_format tf, bool use_separators = false ) const;
    std::string as_string( bool use_separators = false, bool include_milliseconds = true ) const;
 
+   size_t as_chars( char* p_buf, bool use_separators = false, bool include_milliseconds = true ) const;
+
    static mtime local( );
    static mtime standard( );
 
@@ -254,6 +261,8 @@ class DATE_TIME_DECL_SPEC mtime
    millisecond ms;
 
    mtime( millisecond ms );
+
+   void construct_from_chars( const char* s, size_t len );
 };
 
 inline bool operator !=( const mtime& lhs, const mtime& rhs )
@@ -357,6 +366,8 @@ class DATE_TIME_DECL_SPEC udate
    std::string as_string( bool use_separators = false ) const;
    std::string as_string( date_format df, bool use_separators = false ) const;
 
+   size_t as_chars( char* p_buf, bool use_separators = false ) const;
+
    days get_day_of_year( ) const;
 
    std::string month_name( bool short_name = false ) const;
@@ -410,6 +421,8 @@ class DATE_TIME_DECL_SPEC udate
    udate( daynum dn );
 
    void validate( ) const;
+
+   void construct_from_chars( const char* s, size_t len );
 };
 
 inline bool operator !=( const udate& lhs, const udate& rhs )
@@ -491,6 +504,8 @@ class DATE_TIME_DECL_SPEC date_time
    explicit date_time( const char* s );
    explicit date_time( const std::string& s );
 
+   date_time( const char* s, size_t len );
+
    date_time( const udate& ud, const mtime& mt );
 
    date_time( year yr, month mo, weekday wd, occurrence occ );
@@ -582,6 +597,8 @@ class DATE_TIME_DECL_SPEC date_time
    std::string as_string( time_format tf, bool use_separators = false ) const;
    std::string as_string( bool use_separators = false, bool include_milliseconds = true ) const;
 
+   size_t as_chars( char* p_buf, bool use_separators = false, bool include_milliseconds = true ) const;
+
    std::string month_name( bool short_name = false ) const { return ud.month_name( short_name ); }
    std::string weekday_name( bool short_name = false ) const { return ud.weekday_name( short_name ); }
 
@@ -784,5 +801,7 @@ std::string format_mtime( const mtime& mt, const std::string& mask );
 
 std::string format_date_time( const date_time& dt, const std::string& dmask, const std::string& tmask );
 
+void DATE_TIME_DECL_SPEC benchmark_date_time_conversions( std::ostream& os, size_t num_conversions = 0 );
+
 #endif
 
@@ -0,0 +1,110 @@
+// Copyright (c) 2012-2017 CIYAM Developers
+//
+// Distributed under the MIT/X11 software license, please refer to the file license.txt
+// in the root project directory or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef PRECOMPILE_H
+#  include "precompile.h"
+#endif
+#pragma hdrstop
+
+#ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <csignal>
+#  include <string>
+#  include <iostream>
+#  include <stdexcept>
+#endif
+
+#include "email_queue.h"
+
+#include "utilities.h"
+#include "ciyam_base.h"
+#include "class_base.h"
+#include "ciyam_session.h"
+
+//#define DEBUG
+
+using namespace std;
+
+extern volatile sig_atomic_t g_server_shutdown;
+
+namespace
+{
+
+const size_t c_num_email_queue_sessions = 2;
+
+// NOTE: This is the maximum number of messages that a session will send using a single
+// SMTP connection (before closing it and checking the queue again).
+const size_t c_max_messages_per_connection = 50;
+
+const size_t c_email_queue_sleep_time = 1000;
+
+}
+
+size_t start_email_queue_sessions( )
+{
+   activate_email_queue( );
+
+   for( size_t i = 0; i < c_num_email_queue_sessions; i++ )
+   {
+      email_queue_session* p_email_queue_session = new email_queue_session;
+      p_email_queue_session->start( );
+   }
+
+   return c_num_email_queue_sessions;
+}
+
+email_queue_session::email_queue_session( )
+{
+   ciyam_session::increment_session_count( );
+}
+
+email_queue_session::~email_queue_session( )
+{
+   ciyam_session::decrement_session_count( );
+}
+
+void email_queue_session::on_start( )
+{
+#ifdef DEBUG
+   cout << "started email queue session..." << endl;
+#endif
+   try
+   {
+      TRACE_LOG( TRACE_SESSIONS,
+       "started email queue session (tid = " + to_string( current_thread_id( ) ) + ")" );
+
+      while( !g_server_shutdown )
+      {
+         size_t num_sent = 0;
+
+         // NOTE: An error here (such as a bad SMTP configuration) is logged
+         // but does not stop the session from continuing to try later.
+         try
+         {
+            num_sent = send_queued_email_messages( c_max_messages_per_connection );
+         }
+         catch( exception& x )
+         {
+            TRACE_LOG( TRACE_ANYTHING, string( "email queue error: " ) + x.what( ) );
+         }
+
+         // NOTE: Only sleep if there was nothing to send (otherwise continue sending).
+         if( !num_sent )
+            msleep( c_email_queue_sleep_time );
+      }
+
+      TRACE_LOG( TRACE_SESSIONS,
+       "finished email queue session (tid = " + to_string( current_thread_id( ) ) + ")" );
+   }
+   catch( exception& x )
+   {
+      TRACE_LOG( TRACE_ANYTHING, string( "email queue error: " ) + x.what( ) );
+   }
+   catch( ... )
+   {
+      TRACE_LOG( TRACE_ANYTHING, "email queue error: unexpected unknown exception caught" );
+   }
+
+   delete this;
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2012-2017 CIYAM Developers
+//
+// Distributed under the MIT/X11 software license, please refer to the file license.txt
+// in the root project directory or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EMAIL_QUEUE_H
+#  define EMAIL_QUEUE_H
+
+#  include "threads.h"
+
+size_t start_email_queue_sessions( );
+
+class email_queue_session : public thread
+{
+   public:
+   email_queue_session( );
+   ~email_queue_session( );
+
+   void on_start( );
+};
+
+#endif
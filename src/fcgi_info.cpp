@@ -395,12 +395,11 @@ void read_storage_info( storage_info& info, vector< string > log_messages )
 {
    string filename( c_fcgi_sio );
 
-   ifstream inpf( filename.c_str( ) );
-   if( inpf )
+   if( file_exists( filename ) )
    {
       info.clear( );
 
-      sio_reader reader( inpf );
+      sio_reader reader( filename );
 
       info.reg_key = reader.read_opt_attribute( c_attribute_reg_key );
 
@@ -506,7 +505,6 @@ void read_storage_info( storage_info& info, vector< string > log_messages )
          reader.finish_section( c_section_modules );
       }
 
-      inpf.close( );
       info.sio_mod = last_modification_time( filename );
    }
 }
@@ -515,10 +513,9 @@ bool read_module_info( const string& name, module_info& info, storage_info& sinf
 {
    string filename( name + c_fcgi_sio_ext );
 
-   ifstream inpf( filename.c_str( ) );
-   if( inpf )
+   if( file_exists( filename ) )
    {
-      sio_reader reader( inpf );
+      sio_reader reader( filename );
 
       info.clear( );
 
@@ -1163,7 +1160,6 @@ bool read_module_info( const string& name, module_info& info, storage_info& sinf
 
       reader.verify_finished_sections( );
 
-      inpf.close( );
       info.sio_mod = last_modification_time( filename );
 
       return true;
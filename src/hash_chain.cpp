@@ -12,6 +12,7 @@
 #  include <memory.h>
 #  include <fstream>
 #  include <iostream>
+#  include <vector>
 #  include <stdexcept>
 #endif
 
@@ -28,6 +29,14 @@ namespace
 
 const int c_hash_buf_size = 32;
 
+struct checkpoint
+{
+   checkpoint( ) : index( 0 ) { }
+
+   uint32_t index;
+   unsigned char hash[ c_hash_buf_size ];
+};
+
 }
 
 struct hash_chain::impl
@@ -40,11 +49,15 @@ struct hash_chain::impl
 
    string get_next_hashes_to_publish( const string& password, unsigned int num_hashes );
 
+   void get_hash_at( const string& password, uint32_t index, unsigned char* p_buffer );
+
    string name;
    uint32_t rounds;
 
    unsigned char buffer[ c_hash_buf_size ];
    unsigned char seedbuf[ c_hash_buf_size ];
+
+   vector< checkpoint > checkpoints;
 };
 
 hash_chain::impl::impl( const string& name, bool is_new, unsigned int size, bool use_seed )
@@ -214,6 +227,9 @@ string hash_chain::impl::get_next_hashes_to_publish( const string& password, uns
    if( !rounds )
       throw runtime_error( "invalid 'get_next_hashes_to_publish' call for external hash chain '" + name + "'" );
 
+   if( !num_hashes )
+      return string( );
+
    if( rounds <= num_hashes )
       throw runtime_error( "hash chain '" + name + "' has been depleted" );
 
@@ -223,22 +239,17 @@ string hash_chain::impl::get_next_hashes_to_publish( const string& password, uns
    // this can make a chain more "fault resistent" it also supports *gaming* for what can be
    // considered a "better next hash" so by default is not being used (thus "check limit" is
    // defaulted to 1 in "check_and_update_if_good").
-   sha256 hash( password );
-   hash.update( seedbuf, c_hash_buf_size );
+   unsigned char next_buf[ c_hash_buf_size ];
+   get_hash_at( password, rounds - num_hashes + 1, next_buf );
 
-   string retval;
-   for( uint32_t i = 0; i < rounds; i++ )
-   {
-      hash.copy_digest_to_buffer( buffer );
-      hash.update( buffer, sizeof( buffer ) );
+   string retval( hex_encode( next_buf, c_hash_buf_size ) );
 
-      if( i >= rounds - num_hashes )
-      {
-         if( !retval.empty( ) )
-            retval += ',';
+   for( uint32_t i = 1; i < num_hashes; i++ )
+   {
+      sha256 hash( next_buf, c_hash_buf_size );
+      hash.copy_digest_to_buffer( next_buf );
 
-         retval += hash.get_digest_as_string( );
-      }
+      retval += ',' + hex_encode( next_buf, c_hash_buf_size );
    }
 
    --rounds;
@@ -259,6 +270,51 @@ string hash_chain::impl::get_next_hashes_to_publish( const string& password, uns
    return retval;
 }
 
+void hash_chain::impl::get_hash_at( const string& password, uint32_t index, unsigned char* p_buffer )
+{
+   sha256 hash( password );
+   hash.update( seedbuf, c_hash_buf_size );
+   hash.copy_digest_to_buffer( p_buffer );
+
+   // NOTE: Rather than rebuild the whole chain for each call a stack of checkpoints (in ascending
+   // index order) is retained. As hashes are published from the end of the chain towards its start
+   // any checkpoints beyond the index wanted are discarded and the walk from the nearest remaining
+   // checkpoint pushes a new checkpoint at each halfway point. This keeps O(log n) checkpoints and
+   // amortises the cost of each publish to O(log n) hashes. If the initial hash is not the one that
+   // the checkpoints were derived from (i.e. a different password is being used) they are rebuilt.
+   if( checkpoints.empty( ) || memcmp( checkpoints[ 0 ].hash, p_buffer, c_hash_buf_size ) != 0 )
+   {
+      checkpoints.clear( );
+
+      checkpoint initial;
+      memcpy( initial.hash, p_buffer, c_hash_buf_size );
+
+      checkpoints.push_back( initial );
+   }
+
+   while( checkpoints.back( ).index > index )
+      checkpoints.pop_back( );
+
+   checkpoint next( checkpoints.back( ) );
+
+   while( next.index < index )
+   {
+      uint32_t halfway = next.index + ( index - next.index + 1 ) / 2;
+
+      while( next.index < halfway )
+      {
+         hash.update( next.hash, c_hash_buf_size );
+         hash.copy_digest_to_buffer( next.hash );
+
+         ++next.index;
+      }
+
+      checkpoints.push_back( next );
+   }
+
+   memcpy( p_buffer, next.hash, c_hash_buf_size );
+}
+
 hash_chain::hash_chain( const string& name, bool is_new, unsigned int size, bool use_seed )
 {
    p_impl = new impl( name, is_new, size, use_seed );
@@ -10,12 +10,14 @@
 #pragma hdrstop
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <cstring>
 #  include <stdexcept>
 #endif
 
 #include "hashcash.h"
 
 #include "sha1.h"
+#include "threads.h"
 #include "date_time.h"
 #include "utilities.h"
 
@@ -26,34 +28,160 @@ namespace
 
 const int c_max_tries = 5000000;
 
+const int c_counter_length = 4;
+
+const int c_cancel_check_interval = 1024;
+
 const char* const c_hascash_alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+/=";
 
+const size_t c_hashcash_alphabet_size = strlen( c_hascash_alphabet );
+
 string g_alpabet( c_hascash_alphabet );
 
-void increment_counter( string& counter )
+// NOTE: The counter is kept as both alphabet positions and characters so that it can be
+// advanced in place (the leftmost position simply wraps around as the original did).
+void advance_counter( size_t* p_positions, char* p_counter, size_t amount )
+{
+   for( int i = c_counter_length - 1; i >= 0 && amount; i-- )
+   {
+      size_t next = p_positions[ i ] + amount;
+
+      p_positions[ i ] = next % c_hashcash_alphabet_size;
+      p_counter[ i ] = c_hascash_alphabet[ p_positions[ i ] ];
+
+      amount = next / c_hashcash_alphabet_size;
+   }
+}
+
+bool has_leading_zero_bits( const unsigned char* p_digest, int num_bits )
 {
-   size_t last = counter.length( ) - 1;
+   if( num_bits > c_sha1_digest_size * 8 )
+      return false;
+
+   int i = 0;
 
-   while( true )
+   for( ; num_bits >= 8; num_bits -= 8 )
    {
-      size_t pos = g_alpabet.find( counter[ last ] );
-      if( pos == string::npos )
-         throw runtime_error( "unexpected invalid counter '" + counter + "'" );
+      if( p_digest[ i++ ] )
+         return false;
+   }
 
-      if( pos < g_alpabet.size( ) - 1 )
+   return !num_bits || !( p_digest[ i ] & ( 0xff << ( 8 - num_bits ) ) );
+}
+
+class hashcash_minter
+{
+   public:
+   hashcash_minter( const string& prefix, int num_bits )
+    :
+    prefix( prefix ),
+    num_bits( num_bits ),
+    midstate( prefix ),
+    found( false )
+   {
+   }
+
+   string mint( size_t num_threads );
+
+   void try_counters( size_t first, size_t stride );
+
+   private:
+   string prefix;
+   int num_bits;
+
+   sha1 midstate;
+
+   bool found;
+   string stamp;
+
+   mutex lock;
+};
+
+class hashcash_minter_thread : public joinable_thread
+{
+   public:
+   hashcash_minter_thread( hashcash_minter& minter, size_t first, size_t stride )
+    :
+    minter( minter ),
+    first( first ),
+    stride( stride )
+   {
+   }
+
+   void on_start( )
+   {
+      minter.try_counters( first, stride );
+   }
+
+   private:
+   hashcash_minter& minter;
+
+   size_t first;
+   size_t stride;
+};
+
+string hashcash_minter::mint( size_t num_threads )
+{
+   if( num_threads <= 1 )
+      try_counters( 0, 1 );
+   else
+   {
+      worker_group workers;
+
+      for( size_t i = 0; i < num_threads; i++ )
+         workers.start( new hashcash_minter_thread( *this, i, num_threads ) );
+
+      workers.join_all( );
+   }
+
+   return stamp;
+}
+
+void hashcash_minter::try_counters( size_t first, size_t stride )
+{
+   size_t positions[ c_counter_length ];
+   char counter[ c_counter_length ];
+
+   for( int i = 0; i < c_counter_length; i++ )
+   {
+      positions[ i ] = 0;
+      counter[ i ] = c_hascash_alphabet[ 0 ];
+   }
+
+   advance_counter( positions, counter, first );
+
+   sha1 hash( midstate );
+   unsigned char digest[ c_sha1_digest_size ];
+
+   // NOTE: The SHA-1 context for the prefix is only calculated once (with each attempt just
+   // continuing on from a copy of it) and the digest's leading bits are checked directly.
+   for( size_t i = first; i < ( size_t )c_max_tries; i += stride )
+   {
+      if( ( i / stride ) % c_cancel_check_interval == 0 )
       {
-         counter[ last ] = g_alpabet[ pos + 1 ];
-         break;
+         guard g( lock );
+         if( found )
+            break;
       }
-      else
+
+      hash = midstate;
+      hash.update( ( const unsigned char* )counter, c_counter_length );
+      hash.copy_digest_to_buffer( digest );
+
+      if( has_leading_zero_bits( digest, num_bits ) )
       {
-         counter[ last ] = g_alpabet[ 0 ];
+         guard g( lock );
 
-         if( last == 0 )
-            break;
+         if( !found )
+         {
+            found = true;
+            stamp = prefix + string( counter, c_counter_length );
+         }
 
-         --last;
+         break;
       }
+
+      advance_counter( positions, counter, stride );
    }
 }
 
@@ -104,7 +232,7 @@ bool check_hashcash( const string& hashcash )
    return true;
 }
 
-string create_hashcash( const string& resource, int num_bits, const char* p_ext )
+string create_hashcash( const string& resource, int num_bits, const char* p_ext, size_t num_threads )
 {
    string retval;
 
@@ -118,32 +246,11 @@ string create_hashcash( const string& resource, int num_bits, const char* p_ext
     + ":" + dtm.as_string( false, false ).substr( 2, 6 )
     + ":" + resource + ":" + ( p_ext ? p_ext : "" ) + ":" + random + ":" );
 
-   sha1 hash;
-   string counter( "aaaa" );
-
-   for( size_t i = 0; i < c_max_tries; i++ )
-   {
-      int zeroes = 0;
-      hash.update( prefix + counter );
-      string digest = hash.get_digest_as_string( );
+   // NOTE: As the digest's bits are checked directly the work done for a "num_bits" value that
+   // is not a multiple of four is no longer rounded up (as "check_hashcash" only checks digits).
+   hashcash_minter minter( prefix, num_bits );
 
-      for( size_t j = 0; j < digest.size( ); j++ )
-      {
-         if( digest[ j ] == '0' )
-            ++zeroes;
-         else
-            break;
-      }
-
-      // KLUDGE: The work done will only be minimal here if num_bits % 4 == 0.
-      if( zeroes * 4 >= num_bits )
-      {
-         retval = prefix + counter;
-         break;
-      }
-
-      increment_counter( counter );
-   }
+   retval = minter.mint( num_threads );
 
    return retval;
 }
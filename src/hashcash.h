@@ -13,6 +13,7 @@
 
 bool check_hashcash( const std::string& hashcash );
 
-std::string create_hashcash( const std::string& resource, int num_bits = 20, const char* p_ext = 0 );
+std::string create_hashcash( const std::string& resource,
+ int num_bits = 20, const char* p_ext = 0, size_t num_threads = 4 );
 
 #endif
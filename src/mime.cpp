@@ -11,8 +11,10 @@
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
 #  include <memory>
+#  include <fstream>
 #  include <iostream>
 #  include <stdexcept>
+#  include <streambuf>
 #endif
 
 #include "mime.h"
@@ -36,6 +38,9 @@ namespace
 
 const size_t c_max_chars_per_line = 96;
 
+// NOTE: Must be a multiple of 3 (so the base64 encoding of each chunk is never padded).
+const size_t c_file_chunk_size = 3 * 16384;
+
 const string g_new_line( "\r\n" );
 
 string escape_fullstops_if_required( const string& src )
@@ -82,6 +87,42 @@ string split_input_into_lines( const string& input, size_t chars_per_line )
    return str;
 }
 
+void write_base64_file_lines( ostream& os, const string& file_name, size_t chars_per_line )
+{
+   ifstream inpf( file_name.c_str( ), ios::in | ios::binary );
+   if( !inpf )
+      throw runtime_error( "unable to open file '" + file_name + "' for input in mime_encoder" );
+
+   string line;
+   vector< char > buffer( c_file_chunk_size );
+
+   // NOTE: The output is identical to "split_input_into_lines" having been applied to the
+   // base64 encoding of the whole file (so the final line is only output after reading).
+   while( inpf )
+   {
+      inpf.read( &buffer[ 0 ], buffer.size( ) );
+
+      streamsize n = inpf.gcount( );
+      if( n <= 0 )
+         break;
+
+      line += base64::encode( ( const unsigned char* )&buffer[ 0 ], ( size_t )n );
+
+      string::size_type pos = 0;
+      while( line.length( ) - pos > chars_per_line )
+      {
+         os.write( line.data( ) + pos, chars_per_line );
+         os << g_new_line;
+
+         pos += chars_per_line;
+      }
+
+      line.erase( 0, pos );
+   }
+
+   os << line << g_new_line;
+}
+
 string clean_whitespace( const string& input )
 {
    string s;
@@ -263,18 +304,69 @@ string process_boundary( const string& input )
    return s;
 }
 
+struct mime_line_processor
+{
+   virtual ~mime_line_processor( ) { }
+
+   virtual void add_line( string& line ) = 0;
+};
+
+class mime_decoder_buffer : public streambuf
+{
+   public:
+   mime_decoder_buffer( mime_line_processor& processor )
+    :
+    processor( processor )
+   {
+   }
+
+   void finish( );
+
+   protected:
+   int_type overflow( int_type c );
+   streamsize xsputn( const char* p_s, streamsize n );
+
+   private:
+   void add_line( );
+
+   string line;
+
+   mime_line_processor& processor;
+};
+
 }
 
-struct mime_decoder::impl
+struct mime_decoder::impl : public mime_line_processor
 {
-   impl( )
+   impl( mime_part_handler* p_handler )
+    :
+    p_handler( p_handler ),
+    is_child( false ),
+    stopped( false ),
+    finished( false ),
+    has_pending( false ),
+    needs_boundary( true ),
+    processing_data( false ),
+    finished_headers( false ),
+    had_content_type( false ),
+    p_part_stream( 0 )
    {
-      is_child = false;
    }
 
-   void process_data( );
+   void add_data( const string& data );
+   void add_line( string& line );
 
-   string data;
+   void process_line( );
+
+   void finish( );
+
+   void add_part( );
+
+   void start_next_child( );
+   void start_part_stream( );
+
+   void write_part_stream( const string& line );
+   void close_part_stream( mime_part& part );
 
    string type;
    string subtype;
@@ -285,138 +377,221 @@ struct mime_decoder::impl
 
    string text_data;
 
+   mime_part_handler* p_handler;
+
    bool is_child;
 
    vector< mime_part* > parts;
 
    auto_ptr< mime_decoder > ap_child;
+
+   bool stopped;
+   bool finished;
+   bool has_pending;
+   bool needs_boundary;
+   bool processing_data;
+   bool finished_headers;
+   bool had_content_type;
+
+   string last_line;
+   string next_id;
+   string next_data;
+   string next_type;
+   string next_value;
+   string next_subtype;
+   string next_encoding;
+
+   auto_ptr< mime_decoder > ap_next_child;
+
+   mime_part stream_part;
+   ostream* p_part_stream;
+   string part_stream_base64;
+
+   auto_ptr< mime_decoder_buffer > ap_buffer;
+   auto_ptr< ostream > ap_stream;
 };
 
-void mime_decoder::impl::process_data( )
+void mime_decoder::impl::add_data( const string& data )
 {
-   vector< string > lines;
-   split( data, lines, '\n' );
-
-   string last_line, next_id, next_data;
-   string next_type, next_subtype, next_value, next_encoding, next_charset;
+   // NOTE: The lines are split in the same way as "split" (with a final empty line if the data
+   // ended with a separator or is empty) but without copying the whole input into a container.
+   string line;
+   string::size_type pos = 0;
 
-   bool needs_boundary = true;
-   bool processing_data = false;
-   bool finished_headers = false;
-   for( size_t i = 0; i < lines.size( ); i++ )
+   while( true )
    {
-      last_line = lines[ i ];
+      string::size_type npos = data.find( '\n', pos );
 
-      if( !last_line.empty( ) && !finished_headers )
+      if( npos == string::npos )
       {
-         while( i < lines.size( ) - 1 && lines[ i + 1 ].length( )
-          && ( lines[ i + 1 ][ 0 ] == 9 || lines[ i + 1 ][ 0 ] == 32 ) )
-            last_line += lines[ ++i ];
+         line = data.substr( pos );
+         add_line( line );
+         break;
       }
 
-      if( !finished_headers )
+      line = data.substr( pos, npos - pos );
+      add_line( line );
+
+      pos = npos + 1;
+   }
+}
+
+void mime_decoder::impl::add_line( string& line )
+{
+   if( stopped )
+      return;
+
+   // NOTE: Processing is delayed by one line so that "folded" header lines can be appended.
+   if( has_pending )
+   {
+      if( !finished_headers && !last_line.empty( )
+       && !line.empty( ) && ( line[ 0 ] == 9 || line[ 0 ] == 32 ) )
       {
-         if( processing_data )
-         {
-            if( !next_data.empty( ) )
-               next_data += '\n';
+         last_line += line;
+         return;
+      }
 
-            next_data += last_line;
+      process_line( );
 
-            if( !lines[ i ].length( ) )
-               next_data += '\n';
-         }
+      if( stopped )
+         return;
+   }
+
+   last_line.swap( line );
+   has_pending = true;
+}
+
+void mime_decoder::impl::process_line( )
+{
+   bool has_finished_headers = false;
+
+   if( !finished_headers )
+   {
+      if( processing_data )
+      {
+         if( !next_data.empty( ) )
+            next_data += '\n';
+
+         next_data += last_line;
 
-         if( !lines[ i ].length( ) )
+         if( last_line.empty( ) )
+            next_data += '\n';
+      }
+
+      if( last_line.empty( ) )
+      {
+         finished_headers = true;
+         has_finished_headers = true;
+
+         // NOTE: If no Content-Type was provided then the RFC 2045 default of "text/plain" applies.
+         if( !is_child && !processing_data && !had_content_type )
          {
-            finished_headers = true;
-            if( next_type != "multipart" )
-               next_data.erase( );
+            needs_boundary = false;
 
-            if( !needs_boundary )
-               processing_data = true;
+            next_type = "text";
+            next_subtype = "plain";
          }
 
-         if( !last_line.empty( ) )
-         {
-            vector< string > attributes;
-            string header( process_header( last_line, attributes ) );
+         if( next_type != "multipart" )
+            next_data.erase( );
 
-            if( lower( header ) == "content-id" )
+         if( !needs_boundary )
+            processing_data = true;
+      }
+
+      if( !last_line.empty( ) )
+      {
+         vector< string > attributes;
+         string header( process_header( last_line, attributes ) );
+
+         if( lower( header ) == "content-id" )
+         {
+            if( !attributes.empty( ) )
             {
-               if( !attributes.empty( ) )
-               {
-                  next_id = attributes[ 0 ];
-                  if( next_id.length( ) > 2 && next_id[ 0 ] == '<' )
-                     next_id = next_id.substr( 1, next_id.length( ) - 2 );
-               }
+               next_id = attributes[ 0 ];
+               if( next_id.length( ) > 2 && next_id[ 0 ] == '<' )
+                  next_id = next_id.substr( 1, next_id.length( ) - 2 );
             }
-            else if( lower( header ) == "content-type" )
+         }
+         else if( lower( header ) == "content-type" )
+         {
+            had_content_type = true;
+
+            if( boundary.empty( ) )
+               needs_boundary = is_multipart_content( attributes );
+
+            if( needs_boundary && !processing_data )
+               boundary = "--" + process_content_type( attributes, type, subtype );
+            else
             {
-               if( boundary.empty( ) )
-                  needs_boundary = is_multipart_content( attributes );
-
-               if( needs_boundary && !processing_data )
-                  boundary = "--" + process_content_type( attributes, type, subtype );
-               else
-               {
-                  next_value = process_content_type( attributes, next_type, next_subtype );
-                  if( type == "text" )
-                     attribute = next_value;
-               }
+               next_value = process_content_type( attributes, next_type, next_subtype );
+               if( type == "text" )
+                  attribute = next_value;
             }
-            else if( lower( header ) == "content-transfer-encoding" )
+         }
+         else if( lower( header ) == "content-transfer-encoding" )
+         {
+            if( !attributes.empty( ) )
             {
-               if( !attributes.empty( ) )
-               {
-                  next_encoding = attributes[ 0 ];
-                  if( type == "text" )
-                     encoding = next_encoding;
-               }
+               next_encoding = attributes[ 0 ];
+               if( type == "text" )
+                  encoding = next_encoding;
             }
          }
       }
-      else if( type == "text" )
-      {
-         if( !text_data.empty( ) )
-            text_data += "\n";
+   }
+   else if( type == "text" )
+   {
+      if( !text_data.empty( ) )
+         text_data += "\n";
 
-         text_data += last_line;
-      }
+      text_data += last_line;
+   }
 
-      if( !boundary.empty( ) && last_line.find( boundary ) == 0 )
+   if( !boundary.empty( ) && last_line.find( boundary ) == 0 )
+   {
+      if( processing_data )
       {
-         if( processing_data )
+         if( next_type == "multipart" )
          {
-            if( next_type == "multipart" )
-               ap_child.reset( new mime_decoder( true, next_data ) );
+            if( ap_next_child.get( ) )
+            {
+               ap_next_child->finish( );
+               ap_child = ap_next_child;
+            }
             else
             {
-               mime_part* p_next_part = new mime_part;
+               ap_child.reset( new mime_decoder( true, p_handler ) );
 
-               p_next_part->id = next_id;
-               p_next_part->type = next_type;
-               p_next_part->subtype = next_subtype;
-               p_next_part->encoding = next_encoding;
-               p_next_part->attribute = next_value;
-               p_next_part->data = next_data;
-
-               parts.push_back( p_next_part );
+               ap_child->p_impl->add_data( next_data );
+               ap_child->finish( );
             }
          }
+         else
+            add_part( );
+      }
 
-         if( last_line.find( boundary + "--" ) == 0 )
-            break;
+      if( last_line.find( boundary + "--" ) == 0 )
+      {
+         stopped = true;
+         return;
+      }
 
-         processing_data = true;
-         finished_headers = false;
+      processing_data = true;
+      finished_headers = false;
 
-         next_id.erase( );
-         next_data.erase( );
-         next_value.erase( );
-         next_encoding.erase( );
-      }
-      else if( processing_data )
+      next_id.erase( );
+      next_data.erase( );
+      next_value.erase( );
+      next_encoding.erase( );
+   }
+   else if( processing_data )
+   {
+      if( ap_next_child.get( ) )
+         ap_next_child->p_impl->add_line( last_line );
+      else if( p_part_stream )
+         write_part_stream( last_line );
+      else
       {
          if( !next_data.empty( ) )
             next_data += '\n';
@@ -425,42 +600,262 @@ void mime_decoder::impl::process_data( )
       }
    }
 
-   if( !needs_boundary && processing_data )
+   if( has_finished_headers && processing_data )
+   {
+      if( next_type == "multipart" )
+         start_next_child( );
+      else
+         start_part_stream( );
+   }
+}
+
+void mime_decoder::impl::finish( )
+{
+   if( !finished )
    {
-      mime_part* p_next_part = new mime_part;
+      finished = true;
 
-      p_next_part->id = next_id;
-      p_next_part->type = next_type;
-      p_next_part->subtype = next_subtype;
-      p_next_part->encoding = next_encoding;
-      p_next_part->attribute = next_value;
-      p_next_part->data = next_data;
+      if( ap_buffer.get( ) )
+         ap_buffer->finish( );
 
-      parts.push_back( p_next_part );
+      if( has_pending && !stopped )
+         process_line( );
+
+      if( !needs_boundary && processing_data )
+         add_part( );
+
+      // NOTE: If the data finished without a final boundary then an incomplete child
+      // or part stream is discarded.
+      ap_next_child.reset( );
+
+      if( p_part_stream )
+         close_part_stream( stream_part );
    }
 }
 
+void mime_decoder::impl::add_part( )
+{
+   auto_ptr< mime_part > ap_next_part( new mime_part );
+
+   ap_next_part->id = next_id;
+   ap_next_part->type = next_type;
+   ap_next_part->subtype = next_subtype;
+   ap_next_part->encoding = next_encoding;
+   ap_next_part->attribute = next_value;
+
+   if( !p_part_stream )
+      ap_next_part->data = next_data;
+   else
+      close_part_stream( *ap_next_part );
+
+   parts.push_back( ap_next_part.release( ) );
+}
+
+void mime_decoder::impl::start_next_child( )
+{
+   // NOTE: A child is given the headers (and empty lines) that had been collected for it and
+   // then every further line is passed on to it until the next boundary has been reached.
+   ap_next_child.reset( new mime_decoder( true, p_handler ) );
+
+   ap_next_child->p_impl->add_data( next_data );
+   next_data.erase( );
+}
+
+void mime_decoder::impl::start_part_stream( )
+{
+   if( p_handler && lower( next_encoding ) == "base64" )
+   {
+      stream_part.id = next_id;
+      stream_part.type = next_type;
+      stream_part.subtype = next_subtype;
+      stream_part.encoding = next_encoding;
+      stream_part.attribute = next_value;
+
+      p_part_stream = p_handler->open_part_stream( stream_part );
+
+      if( p_part_stream )
+      {
+         next_data.erase( );
+         part_stream_base64.erase( );
+      }
+   }
+}
+
+void mime_decoder::impl::write_part_stream( const string& line )
+{
+   for( size_t i = 0; i < line.size( ); i++ )
+   {
+      char c = line[ i ];
+
+      if( ( c >= 'A' && c <= 'Z' ) || ( c >= 'a' && c <= 'z' )
+       || ( c >= '0' && c <= '9' ) || c == '+' || c == '/' || c == '=' )
+         part_stream_base64 += c;
+   }
+
+   string::size_type length = part_stream_base64.size( ) - ( part_stream_base64.size( ) % 4 );
+
+   if( length )
+   {
+      *p_part_stream << base64::decode( part_stream_base64.substr( 0, length ) );
+      part_stream_base64.erase( 0, length );
+   }
+}
+
+void mime_decoder::impl::close_part_stream( mime_part& part )
+{
+   if( !part_stream_base64.empty( ) )
+      *p_part_stream << base64::decode( part_stream_base64 );
+
+   part_stream_base64.erase( );
+
+   ostream* p_os = p_part_stream;
+   p_part_stream = 0;
+
+   p_handler->close_part_stream( part, p_os );
+}
+
+void mime_decoder_buffer::finish( )
+{
+   // NOTE: Any final data (even if empty) is treated as a line in the same way as "split".
+   add_line( );
+}
+
+mime_decoder_buffer::int_type mime_decoder_buffer::overflow( int_type c )
+{
+   if( !traits_type::eq_int_type( c, traits_type::eof( ) ) )
+   {
+      char ch = traits_type::to_char_type( c );
+      xsputn( &ch, 1 );
+   }
+
+   return traits_type::not_eof( c );
+}
+
+streamsize mime_decoder_buffer::xsputn( const char* p_s, streamsize n )
+{
+   for( streamsize i = 0; i < n; i++ )
+   {
+      if( p_s[ i ] == '\n' )
+         add_line( );
+      else
+         line += p_s[ i ];
+   }
+
+   return n;
+}
+
+void mime_decoder_buffer::add_line( )
+{
+   processor.add_line( line );
+   line.erase( );
+}
+
+ostream* mime_file_handler::open_part_stream( const mime_part& part )
+{
+   if( part.type != "image" && part.type != "application" )
+      return 0;
+
+   string name( valid_file_name( part.attribute ) );
+
+   if( name.empty( ) )
+      name = "attachment" + to_string( file_names.size( ) + 1 );
+
+   string file_name( file_name_prefix + name );
+
+   auto_ptr< ofstream > ap_outf( new ofstream( file_name.c_str( ), ios::out | ios::binary ) );
+   if( !*ap_outf )
+      throw runtime_error( "unable to open file '" + file_name + "' for output" );
+
+   file_names.push_back( file_name );
+
+   return ap_outf.release( );
+}
+
+void mime_file_handler::close_part_stream( const mime_part& part, ostream* p_os )
+{
+   auto_ptr< ostream > ap_os( p_os );
+
+   ap_os->flush( );
+   if( !ap_os->good( ) )
+      throw runtime_error( "unexpected bad output stream" );
+}
+
 mime_decoder::mime_decoder( const string& mime_data )
 {
-   p_impl = new impl;
+   p_impl = new impl( 0 );
+
+   p_impl->add_data( mime_data );
+   p_impl->finish( );
+}
+
+mime_decoder::mime_decoder( istream& is, mime_part_handler* p_handler )
+{
+   auto_ptr< impl > ap_impl( new impl( p_handler ) );
 
-   p_impl->data = mime_data;
+   string line;
+   bool add_final_line = true;
+
+   while( getline( is, line ) )
+   {
+      // NOTE: If the input ended with a separator (or was empty) then a final empty line is
+      // added (in the same way as "split").
+      if( is.eof( ) )
+      {
+         add_final_line = false;
+         ap_impl->add_line( line );
+
+         break;
+      }
+
+      ap_impl->add_line( line );
+   }
 
-   p_impl->process_data( );
+   if( add_final_line )
+   {
+      line.erase( );
+      ap_impl->add_line( line );
+   }
+
+   ap_impl->finish( );
+
+   p_impl = ap_impl.release( );
 }
 
-mime_decoder::mime_decoder( bool is_child, const string& mime_data )
+mime_decoder::mime_decoder( mime_part_handler* p_handler )
 {
-   p_impl = new impl;
+   auto_ptr< impl > ap_impl( new impl( p_handler ) );
 
-   p_impl->data = mime_data;
-   p_impl->is_child = is_child;
+   ap_impl->ap_buffer.reset( new mime_decoder_buffer( *ap_impl ) );
+   ap_impl->ap_stream.reset( new ostream( ap_impl->ap_buffer.get( ) ) );
+
+   p_impl = ap_impl.release( );
+}
 
-   p_impl->process_data( );
+mime_decoder::mime_decoder( bool is_child, mime_part_handler* p_handler )
+{
+   p_impl = new impl( p_handler );
+
+   p_impl->is_child = is_child;
 }
 
 mime_decoder::~mime_decoder( )
 {
+   // NOTE: If "finish" had not been reached (such as due to an exception occurring whilst the
+   // data was being written) then the part stream is still open so is given back to its handler.
+   if( p_impl->p_part_stream )
+   {
+      ostream* p_os = p_impl->p_part_stream;
+      p_impl->p_part_stream = 0;
+
+      try
+      {
+         p_impl->p_handler->close_part_stream( p_impl->stream_part, p_os );
+      }
+      catch( ... )
+      {
+      }
+   }
+
    for( size_t i = 0; i < p_impl->parts.size( ); i++ )
       delete p_impl->parts[ i ];
 
@@ -468,6 +863,19 @@ mime_decoder::~mime_decoder( )
    p_impl = 0;
 }
 
+ostream& mime_decoder::get_stream( )
+{
+   if( !p_impl->ap_stream.get( ) || p_impl->finished )
+      throw runtime_error( "mime_decoder: output stream is not available" );
+
+   return *p_impl->ap_stream;
+}
+
+void mime_decoder::finish( )
+{
+   p_impl->finish( );
+}
+
 string mime_decoder::get_type( ) const
 {
    return p_impl->type;
@@ -527,6 +935,7 @@ struct mime_encoder::impl
 
       is_child = false;
       finished = false;
+      has_final_data = false;
 
       max_chars_per_line = c_max_chars_per_line;
 
@@ -538,19 +947,42 @@ struct mime_encoder::impl
       mime_boundary += guid.as_string( );
    }
 
+   void add_file_data( const string& file_name, const string& encoding, const char* p_func_name );
+
    string data;
+   string final_data;
    string mime_boundary;
    string multi_part_subtype;
    string multi_part_extra_subtype;
 
+   // NOTE: Base64 encoded files are not read until the data is being written so
+   // the offset (within "data") where each file's encoded lines belong is kept.
+   vector< pair< size_t, string > > files;
+
    auto_ptr< mime_encoder > ap_child;
 
    bool is_child;
    bool finished;
+   bool has_final_data;
    int num_parts;
    int max_chars_per_line;
 };
 
+void mime_encoder::impl::add_file_data( const string& file_name, const string& encoding, const char* p_func_name )
+{
+   if( encoding == "base64" )
+   {
+      if( !file_exists( file_name ) )
+         throw runtime_error( "file '" + file_name + "' not found for mime_encoder::" + string( p_func_name ) );
+
+      files.push_back( make_pair( data.length( ), file_name ) );
+   }
+   else if( encoding == "quoted-printable" )
+      data += encode_quoted_printable( buffer_file( file_name ), max_chars_per_line ) + g_new_line;
+   else
+      throw runtime_error( "unexpected encoding type '" + encoding + "' for mime_encoder::" + string( p_func_name ) );
+}
+
 mime_encoder::mime_encoder( const char* p_multi_part_subtype,
  const char* p_multi_part_extra_subtype, int max_chars_per_line )
 {
@@ -699,16 +1131,7 @@ void mime_encoder::add_file( const string& file_name, const char* p_encoding )
    p_impl->data += string( "Content-Disposition: attachment; filename=\"" ) + name + "\"" + g_new_line;
    p_impl->data += string( "Content-Transfer-Encoding: " ) + encoding + g_new_line + g_new_line;
 
-   string file_data = buffer_file( file );
-   if( encoding == "base64" )
-   {
-      file_data = base64::encode( file_data );
-      p_impl->data += split_input_into_lines( file_data, p_impl->max_chars_per_line );
-   }
-   else if( encoding == "quoted-printable" )
-      p_impl->data += encode_quoted_printable( file_data, p_impl->max_chars_per_line ) + g_new_line;
-   else
-      throw runtime_error( "unexpected encoding type '" + encoding + "' for mime_encoder::add_file" );
+   p_impl->add_file_data( file, encoding, "add_file" );
 }
 
 void mime_encoder::add_image( const string& file_name, const char* p_path_prefix, const char* p_encoding )
@@ -767,16 +1190,7 @@ void mime_encoder::add_image( const string& file_name, const char* p_path_prefix
    p_impl->data += string( "Content-Disposition: inline; filename=\"" ) + name + "\"" + g_new_line;
    p_impl->data += string( "Content-Transfer-Encoding: " ) + encoding + g_new_line + g_new_line;
 
-   string file_data = buffer_file( full_path );
-   if( encoding == "base64" )
-   {
-      file_data = base64::encode( file_data );
-      p_impl->data += split_input_into_lines( file_data, p_impl->max_chars_per_line );
-   }
-   else if( encoding == "quoted-printable" )
-      p_impl->data += encode_quoted_printable( file_data, p_impl->max_chars_per_line ) + g_new_line;
-   else
-      throw runtime_error( "unexpected encoding type '" + encoding + "' for mime_encoder::add_image" );
+   p_impl->add_file_data( full_path, encoding, "add_image" );
 }
 
 void mime_encoder::create_child( const char* p_multi_part_subtype, const char* p_multi_part_extra_subtype )
@@ -797,44 +1211,61 @@ mime_encoder& mime_encoder::get_child( )
 
 string mime_encoder::get_data( )
 {
-   if( !p_impl->finished )
+   if( !p_impl->has_final_data )
    {
-      p_impl->finished = true;
+      ostringstream osstr;
+      write_data( osstr );
+
+      p_impl->final_data = osstr.str( );
+      p_impl->has_final_data = true;
+   }
 
-      string final_data;
+   return p_impl->final_data;
+}
 
-      if( !p_impl->is_child )
-         final_data += "MIME-Version: 1.0" + g_new_line;
+void mime_encoder::write_data( ostream& os )
+{
+   p_impl->finished = true;
 
-      bool is_multi = false;
+   if( !p_impl->is_child )
+      os << "MIME-Version: 1.0" << g_new_line;
 
-      if( p_impl->num_parts > 1 || p_impl->ap_child.get( ) )
-         is_multi = true;
+   bool is_multi = false;
 
-      if( is_multi )
-      {
-         final_data += "Content-Type: multipart/" + p_impl->multi_part_subtype + ";";
-         if( !p_impl->multi_part_extra_subtype.empty( ) )
-            final_data += " type=\"multipart/" + p_impl->multi_part_extra_subtype + "\";";
-         final_data += string( " boundary=\"" ) + p_impl->mime_boundary + "\"" + g_new_line + g_new_line;
+   if( p_impl->num_parts > 1 || p_impl->ap_child.get( ) )
+      is_multi = true;
 
-         if( !p_impl->is_child )
-            final_data += string( "This is a multipart MIME message." ) + g_new_line;
+   if( is_multi )
+   {
+      os << "Content-Type: multipart/" << p_impl->multi_part_subtype << ";";
+      if( !p_impl->multi_part_extra_subtype.empty( ) )
+         os << " type=\"multipart/" << p_impl->multi_part_extra_subtype << "\";";
+      os << " boundary=\"" << p_impl->mime_boundary << "\"" << g_new_line << g_new_line;
 
-         if( p_impl->ap_child.get( ) )
-         {
-            final_data += string( "--" ) + p_impl->mime_boundary + g_new_line;
-            final_data += p_impl->ap_child->get_data( );
-         }
+      if( !p_impl->is_child )
+         os << "This is a multipart MIME message." << g_new_line;
+
+      if( p_impl->ap_child.get( ) )
+      {
+         os << "--" << p_impl->mime_boundary << g_new_line;
+         p_impl->ap_child->write_data( os );
       }
+   }
 
-      final_data += p_impl->data;
+   size_t offset = 0;
+   const string& data( p_impl->data );
 
-      final_data += string( "--" ) + p_impl->mime_boundary + string( "--" ) + g_new_line;
+   for( size_t i = 0; i < p_impl->files.size( ); i++ )
+   {
+      size_t next_offset = p_impl->files[ i ].first;
+
+      os.write( data.data( ) + offset, next_offset - offset );
+      write_base64_file_lines( os, p_impl->files[ i ].second, p_impl->max_chars_per_line );
 
-      p_impl->data = final_data;
+      offset = next_offset;
    }
 
-   return p_impl->data;
-}
+   os.write( data.data( ) + offset, data.length( ) - offset );
 
+   os << "--" << p_impl->mime_boundary << "--" << g_new_line;
+}
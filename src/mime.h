@@ -9,6 +9,8 @@
 
 #  ifndef HAS_PRECOMPILED_STD_HEADERS
 #     include <string>
+#     include <vector>
+#     include <iosfwd>
 #  endif
 
 struct mime_part
@@ -23,12 +25,55 @@ struct mime_part
    std::string data;
 };
 
+// NOTE: A part handler allows the data for base64 encoded parts to be decoded directly into
+// an output stream (rather than being held in "mime_part::data") as the MIME data is being
+// processed. If "open_part_stream" returns zero then the part data is held as per normal.
+class mime_part_handler
+{
+   public:
+   virtual ~mime_part_handler( ) { }
+
+   virtual std::ostream* open_part_stream( const mime_part& part ) = 0;
+   virtual void close_part_stream( const mime_part& part, std::ostream* p_os ) = 0;
+};
+
+// NOTE: Decodes any image or application parts directly into files (which are named as the
+// prefix followed by the part's attribute) and appends the name of each file created.
+class mime_file_handler : public mime_part_handler
+{
+   public:
+   mime_file_handler( const std::string& file_name_prefix, std::vector< std::string >& file_names )
+    :
+    file_name_prefix( file_name_prefix ),
+    file_names( file_names )
+   {
+   }
+
+   std::ostream* open_part_stream( const mime_part& part );
+   void close_part_stream( const mime_part& part, std::ostream* p_os );
+
+   private:
+   std::string file_name_prefix;
+   std::vector< std::string >& file_names;
+};
+
 class mime_decoder
 {
    public:
    mime_decoder( const std::string& mime_data );
+   mime_decoder( std::istream& is, mime_part_handler* p_handler = 0 );
+
+   // NOTE: If constructed this way then the MIME data is to be written (in chunks of any size)
+   // to the output stream returned by "get_stream" with "finish" being called after all of the
+   // data has been written.
+   mime_decoder( mime_part_handler* p_handler );
+
    ~mime_decoder( );
 
+   std::ostream& get_stream( );
+
+   void finish( );
+
    std::string get_type( ) const;
    std::string get_subtype( ) const;
    std::string get_encoding( ) const;
@@ -43,7 +88,7 @@ class mime_decoder
    mime_part& get_part( size_t num ) const;
 
    private:
-   mime_decoder( bool is_child, const std::string& mime_data );
+   mime_decoder( bool is_child, mime_part_handler* p_handler );
 
    struct impl;
    friend struct impl;
@@ -75,6 +120,10 @@ class mime_encoder
 
    std::string get_data( );
 
+   // NOTE: Unlike "get_data" the content of any attached files is encoded (in chunks) as it
+   // is being written rather than being held in memory.
+   void write_data( std::ostream& os );
+
    private:
    struct impl;
    friend struct impl;
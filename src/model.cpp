@@ -1534,11 +1534,7 @@ void model::impl::save( const string& filename )
 
 void model::impl::load( const string& filename )
 {
-   ifstream inpf( filename.c_str( ) );
-   if( !inpf )
-      throw runtime_error( "unable to open file '" + filename + "' for input" );
-
-   sio_reader reader( inpf );
+   sio_reader reader( filename );
 
    string s;
 
@@ -15,6 +15,7 @@
 #  endif
 #  include <cmath>
 #  include <cstdio>
+#  include <vector>
 #  include <iostream>
 #  include <stdexcept>
 #  include <algorithm>
@@ -22,6 +23,7 @@
 
 #include "numeric.h"
 
+#include "utilities.h"
 #include "read_write_stream.h"
 
 //#define ALLOW_ADJUST_TO_ZERO
@@ -88,6 +90,124 @@ const uint64_t c_zero = UINT64_C( 0 );
 
 const uint64_t c_max_mantissa = UINT64_C( 999999999999999999 );
 
+#ifdef __SIZEOF_INT128__
+#  define NUMERIC_USE_INT128
+#endif
+
+#ifdef NUMERIC_USE_INT128
+__extension__ typedef __int128 int128;
+__extension__ typedef unsigned __int128 uint128;
+
+const int c_max_int128_digits = 38;
+
+inline uint128 power10_128( int n )
+{
+   if( n <= 19 )
+      return power10[ n ];
+   else
+      return ( uint128 )power10[ 19 ] * power10[ n - 19 ];
+}
+
+inline int num_digits_128( uint128 m )
+{
+   if( m >= power10_128( c_max_int128_digits ) )
+      return c_max_int128_digits + 1;
+
+   int n = 1;
+
+   if( m >= power10[ 19 ] )
+   {
+      n += 19;
+      m /= power10[ 19 ];
+   }
+
+   uint64_t v = ( uint64_t )m;
+
+   for( int i = 1; i < 20 && v >= power10[ i ]; i++ )
+      ++n;
+
+   return n;
+}
+
+// NOTE: Removes as many digits (truncating) as are needed for the mantissa to fit but
+// no more digits than the number of decimals (which are reduced by the same amount).
+inline void truncate_excess_digits( uint128& m, uint8_t& d )
+{
+   int excess = num_digits_128( m ) - numeric::e_max_digits;
+
+   if( excess > 0 )
+   {
+      if( excess > d )
+         excess = d;
+
+      if( excess )
+      {
+         m /= power10_128( excess );
+         d -= excess;
+      }
+   }
+}
+
+void add_to_sum( int128& total, uint8_t& total_decimals, uint8_t decimals, uint64_t mantissa )
+{
+   const int128 c_limit = ( int128 )power10_128( c_max_int128_digits );
+
+   bool is_negative = ( decimals & c_negative_flag );
+   decimals &= c_decimals_mask;
+
+   if( decimals > total_decimals )
+   {
+      uint128 scale = power10_128( decimals - total_decimals );
+      int128 magnitude = total < 0 ? -total : total;
+
+      if( magnitude > c_limit / ( int128 )scale )
+         throw runtime_error( "overflow occurred" );
+
+      total *= ( int128 )scale;
+      total_decimals = decimals;
+   }
+
+   int128 value = ( int128 )( ( uint128 )mantissa * power10_128( total_decimals - decimals ) );
+
+   if( is_negative )
+      total -= value;
+   else
+      total += value;
+
+   if( total >= c_limit || total <= -c_limit )
+      throw runtime_error( "overflow occurred" );
+}
+
+void sum_result( int128 total, uint8_t total_decimals, uint8_t& decimals, uint64_t& mantissa )
+{
+   bool is_negative = ( total < 0 );
+   uint128 m = is_negative ? ( uint128 )-total : ( uint128 )total;
+
+   while( total_decimals > 0 && m % 10 == 0 )
+   {
+      --total_decimals;
+      m /= 10;
+   }
+
+   truncate_excess_digits( m, total_decimals );
+
+   if( m > c_max_mantissa )
+      throw runtime_error( "overflow occurred" );
+
+   mantissa = ( uint64_t )m;
+   decimals = total_decimals;
+
+   while( decimals > 0 && mantissa % 10 == 0 )
+   {
+      --decimals;
+      mantissa /= 10;
+   }
+
+   if( mantissa && is_negative )
+      decimals |= c_negative_flag;
+}
+#endif
+
 const char c_opt = '#';
 const char c_mand = '0';
 const char c_group = ',';
@@ -464,6 +584,133 @@ int64_t numeric::trunc( ) const
    return signed_whole;
 }
 
+#ifdef NUMERIC_USE_INT128
+numeric& numeric::operator *=( numeric n )
+{
+   if( mantissa != c_zero && n.mantissa != c_zero )
+   {
+      uint8_t d( decimals & c_decimals_mask );
+
+      while( d && n.mantissa % 10 == 0 )
+      {
+         --d;
+         n.mantissa /= 10;
+      }
+
+      // NOTE: As the product of two mantissas always fits within 128 bits excess
+      // digits are truncated rather than the operation failing due to overflow.
+      uint128 m( ( uint128 )mantissa * n.mantissa );
+
+      uint8_t negative_flag = ( decimals & c_negative_flag ) ^ ( n.decimals & c_negative_flag );
+
+      d += ( n.decimals & c_decimals_mask );
+
+      truncate_excess_digits( m, d );
+
+      bool adjusted = false;
+      if( d > e_max_digits )
+      {
+         m /= power10_128( d - e_max_digits );
+         d = e_max_digits;
+         adjusted = true;
+      }
+
+#ifndef ALLOW_ADJUST_TO_ZERO
+      if( adjusted && !m )
+         throw runtime_error( "underflow occurred" );
+#endif
+
+      if( m > c_max_mantissa )
+         throw runtime_error( "overflow occurred" );
+
+      mantissa = ( uint64_t )m;
+      decimals = d;
+
+      while( decimals > 0 && mantissa % 10 == 0 )
+      {
+         --decimals;
+         mantissa /= 10;
+      }
+
+      decimals |= negative_flag;
+   }
+   else
+   {
+      mantissa = 0;
+      decimals = 0;
+   }
+
+   return *this;
+}
+
+numeric& numeric::operator /=( numeric n )
+{
+   if( n.mantissa == c_zero )
+      throw runtime_error( "attempt to divide numeric by zero" );
+
+   uint8_t negative_flag = decimals & c_negative_flag;
+   uint8_t d( decimals & c_decimals_mask );
+
+   if( mantissa != c_zero )
+   {
+      // NOTE: The dividend is scaled up to the maximum number of 128 bit digits so the
+      // quotient will always have more significant digits than a mantissa can hold.
+      uint128 m( mantissa );
+
+      int scale = c_max_int128_digits - num_digits_128( m );
+
+      m *= power10_128( scale );
+      d += scale;
+
+      if( ( n.decimals & c_decimals_mask ) > d )
+         throw runtime_error( "underflow occurred" );
+
+      m /= n.mantissa;
+
+      d -= ( n.decimals & c_decimals_mask );
+
+      truncate_excess_digits( m, d );
+
+      while( d > e_max_digits && m % 10 == 0 )
+      {
+         --d;
+         m /= 10;
+      }
+
+      bool adjusted = false;
+      if( d > e_max_digits )
+      {
+         m /= power10_128( d - e_max_digits );
+         d = e_max_digits;
+         adjusted = true;
+      }
+
+#ifndef ALLOW_ADJUST_TO_ZERO
+      if( adjusted && !m )
+         throw runtime_error( "underflow occurred" );
+#endif
+
+      if( m > c_max_mantissa )
+         throw runtime_error( "overflow occurred" );
+
+      while( d > 0 && m % 10 == 0 )
+      {
+         --d;
+         m /= 10;
+      }
+
+      mantissa = ( uint64_t )m;
+   }
+
+   negative_flag = ( negative_flag == ( n.decimals & c_negative_flag ) ) ? 0 : c_negative_flag;
+
+   decimals = d;
+   if( mantissa )
+      decimals |= negative_flag;
+
+   return *this;
+}
+#else
 numeric& numeric::operator *=( numeric n )
 {
    if( mantissa != c_zero && n.mantissa != c_zero )
@@ -616,6 +863,65 @@ numeric& numeric::operator /=( numeric n )
 
    return *this;
 }
+#endif
+
+numeric sum( const numeric* p_values, size_t num_values )
+{
+   numeric total;
+
+#ifdef NUMERIC_USE_INT128
+   int128 value = 0;
+   uint8_t value_decimals = 0;
+
+   for( size_t i = 0; i < num_values; i++ )
+   {
+      if( p_values[ i ].mantissa )
+         add_to_sum( value, value_decimals, p_values[ i ].decimals, p_values[ i ].mantissa );
+   }
+
+   sum_result( value, value_decimals, total.decimals, total.mantissa );
+#else
+   for( size_t i = 0; i < num_values; i++ )
+      total += p_values[ i ];
+#endif
+
+   return total;
+}
+
+numeric sum_product( const numeric* p_lhs, const numeric* p_rhs, size_t num_values )
+{
+   numeric total;
+
+#ifdef NUMERIC_USE_INT128
+   int128 value = 0;
+   uint8_t value_decimals = 0;
+
+   for( size_t i = 0; i < num_values; i++ )
+   {
+      numeric product( p_lhs[ i ] );
+      product *= p_rhs[ i ];
+
+      if( product.mantissa )
+         add_to_sum( value, value_decimals, product.decimals, product.mantissa );
+   }
+
+   sum_result( value, value_decimals, total.decimals, total.mantissa );
+#else
+   for( size_t i = 0; i < num_values; i++ )
+      total += p_lhs[ i ] * p_rhs[ i ];
+#endif
+
+   return total;
+}
+
+void split_numerics( const string& s, vector< numeric >& values, char sep )
+{
+   vector< string > items;
+   split( s, items, sep );
+
+   for( size_t i = 0; i < items.size( ); i++ )
+      values.push_back( numeric( items[ i ].c_str( ) ) );
+}
 
 numeric numeric::max( )
 {
@@ -9,6 +9,7 @@
 
 #  ifndef HAS_PRECOMPILED_STD_HEADERS
 #     include <string>
+#     include <vector>
 #     include <iosfwd>
 #  endif
 
@@ -128,6 +129,9 @@ class NUMERIC_DECL_SPEC numeric
 
    friend void NUMERIC_DECL_SPEC perform_add_or_subtract( numeric& n1, numeric n2, bool is_add );
 
+   friend numeric NUMERIC_DECL_SPEC sum( const numeric* p_values, size_t num_values );
+   friend numeric NUMERIC_DECL_SPEC sum_product( const numeric* p_lhs, const numeric* p_rhs, size_t num_values );
+
    friend numeric NUMERIC_DECL_SPEC operator +( const numeric& lhs, const numeric& rhs );
    friend numeric NUMERIC_DECL_SPEC operator -( const numeric& lhs, const numeric& rhs );
    friend numeric NUMERIC_DECL_SPEC operator *( const numeric& lhs, const numeric& rhs );
@@ -237,6 +241,14 @@ inline bool operator !=( const numeric& lhs, const numeric& rhs ) { return !( lh
 numeric abs( const numeric& n );
 numeric sqrt( const numeric& n );
 
+// NOTE: Unlike repeated additions (which can overflow when levelling the decimals of
+// partial sums) the batch functions are accumulated exactly with any excess decimals
+// truncated from the final result.
+numeric NUMERIC_DECL_SPEC sum( const numeric* p_values, size_t num_values );
+numeric NUMERIC_DECL_SPEC sum_product( const numeric* p_lhs, const numeric* p_rhs, size_t num_values );
+
+void NUMERIC_DECL_SPEC split_numerics( const std::string& s, std::vector< numeric >& values, char sep = c_separator );
+
 std::string NUMERIC_DECL_SPEC format_numeric( const numeric& n, const std::string& mask,
  const char* p_decimal_point = 0, const char* p_plus = 0, const char* p_minus = 0,
  const char* p_group_separator = 0, const char* p_plus_left = 0, const char* p_plus_right = 0,
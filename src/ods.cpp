@@ -141,6 +141,68 @@ const int c_trans_data_items_per_region = 10000;
 
 mutex g_ods_lock;
 
+// NOTE: Any thread that releases a bulk lock, a header file lock or finishes reading or writing an
+// object will notify this (if there are any waiters) so that other threads waiting on such locks
+// can retry without delay. As locks held by other processes will not cause notifications the sleep
+// times are still used as the maximum time to wait before retrying (and max. attempts * sleep time
+// as the deadline after which no more attempts will be made).
+wait_notifier g_lock_notifier;
+
+volatile long g_lock_waiters = 0;
+
+inline void notify_lock_waiters( )
+{
+   memory_barrier( );
+
+   if( g_lock_waiters )
+      g_lock_notifier.notify( );
+}
+
+class lock_attempt_waiter
+{
+   public:
+   lock_attempt_waiter( int max_attempts, int sleep_time )
+    :
+    sleep_time( sleep_time )
+   {
+      // NOTE: The waiter is counted before the generation is read so that a lock being released
+      // after the generation has been read will always result in a notification.
+      atomic_increment( g_lock_waiters );
+
+      generation = g_lock_notifier.get_generation( );
+
+      deadline = monotonic_msecs( ) + ( unsigned long long )max_attempts * sleep_time;
+   }
+
+   ~lock_attempt_waiter( )
+   {
+      atomic_decrement( g_lock_waiters );
+   }
+
+   bool wait( )
+   {
+      unsigned long long now = monotonic_msecs( );
+
+      if( now >= deadline )
+         return false;
+
+      g_lock_notifier.wait( generation, ( int )min( ( unsigned long long )sleep_time, deadline - now ) );
+
+      return true;
+   }
+
+   private:
+   int sleep_time;
+
+   unsigned long generation;
+   unsigned long long deadline;
+};
+
+struct lock_release_notifier
+{
+   ~lock_release_notifier( ) { notify_lock_waiters( ); }
+};
+
 #ifdef ODS_DEBUG
 mutex g_debug_lock;
 
@@ -180,7 +242,7 @@ void throw_ods_error( const string& s )
 // format would no longer be compatible, however, if a "minor" version change has occurred then it
 // should still be possible to operate on previous file formats (with the same "major" version).
 const int16_t c_major_ver = 1;
-const int16_t c_minor_ver = 0;
+const int16_t c_minor_ver = 1;
 
 const int16_t c_version = ( c_major_ver << 8 ) | c_minor_ver;
 
@@ -246,7 +308,8 @@ struct log_info
    {
       is.read( ( char* )&version, sizeof( version ) );
 
-      if( version != c_version )
+      if( ( version & c_version_major_mask ) != ( c_version & c_version_major_mask )
+       || ( version & c_version_minor_mask ) > ( c_version & c_version_minor_mask ) )
          THROW_ODS_ERROR( "incompatible log_info version found" );
 
       is.read( ( char* )&sequence, sizeof( sequence ) );
@@ -838,6 +901,9 @@ struct header_info
    int64_t data_transform_id;
    int64_t index_transform_id;
 
+   int64_t compact_data_pos;
+   int64_t compact_reclaimed;
+
    header_info( )
     :
     version( 0 ),
@@ -851,11 +917,16 @@ struct header_info
     total_size_of_data( 0 ),
     transaction_id( 1 ),
     data_transform_id( 0 ),
-    index_transform_id( 0 )
+    index_transform_id( 0 ),
+    compact_data_pos( 0 ),
+    compact_reclaimed( 0 )
    {
    }
 };
 
+// NOTE: Version 1.0 headers did not include the "compact_data_pos" and "compact_reclaimed" fields.
+const int c_header_info_v1_0_size = ( sizeof( int16_t ) * 4 ) + ( sizeof( int64_t ) * 8 );
+
 class ods_index_entry
 {
    public:
@@ -1967,6 +2038,18 @@ struct transaction_buffer
    stack< transaction_level_info > levels;
 };
 
+struct ods_index_entry_pos
+{
+   int64_t id;
+   int64_t pos;
+   int64_t size;
+
+   bool operator <( const ods_index_entry_pos& lval ) const
+   {
+      return pos < lval.pos;
+   }
+};
+
 struct ods::impl
 {
    enum bulk_mode
@@ -1990,7 +2073,11 @@ struct ods::impl
     tranlog_offset( 0 ),
     read_from_trans( false ),
     total_trans_size( 0 ),
-    total_trans_op_count( 0 )
+    total_trans_op_count( 0 ),
+    compact_next_entry( 0 ),
+    compact_data_pos( 0 ),
+    compact_total_size( 0 ),
+    compact_transform_id( 0 )
    {
    }
 
@@ -2057,6 +2144,17 @@ struct ods::impl
    ref_count_ptr< mutex > rp_impl_lock;
    ref_count_ptr< mutex > rp_file_section;
 
+   // NOTE: The entries (in data position order) that were found when the current compaction pass
+   // scanned the index along with the header values that followed its last step (if any of these
+   // values have changed then data has been appended or moved so the index is scanned again).
+   vector< ods_index_entry_pos > compact_entries;
+
+   size_t compact_next_entry;
+
+   int64_t compact_data_pos;
+   int64_t compact_total_size;
+   int64_t compact_transform_id;
+
    void read_header_file_info( );
    void write_header_file_info( bool for_close = false );
 
@@ -2073,8 +2171,18 @@ void ods::impl::read_header_file_info( )
    if( _lseek( *rp_header_file, 0, SEEK_SET ) != 0 )
       THROW_ODS_ERROR( "unexpected seek at " STRINGIZE( __LINE__ ) " failed" );
 
-   if( _read( *rp_header_file,
-    ( void* )rp_header_info.get( ), sizeof( header_info ) ) != sizeof( header_info ) )
+   int len = _read( *rp_header_file, ( void* )rp_header_info.get( ), sizeof( header_info ) );
+
+   if( len == c_header_info_v1_0_size
+    && rp_header_info->version == ( c_version & c_version_major_mask ) )
+   {
+      // NOTE: An older (but compatible) header is upgraded (when next written) to the current version.
+      rp_header_info->version = c_version;
+
+      rp_header_info->compact_data_pos = 0;
+      rp_header_info->compact_reclaimed = 0;
+   }
+   else if( len != sizeof( header_info ) )
       THROW_ODS_ERROR( "unexpected read at " STRINGIZE( __LINE__ ) " failed" );
 }
 
@@ -2128,18 +2236,6 @@ bool ods::impl::found_instance_currently_writing( int64_t num )
    return false;
 }
 
-struct ods_index_entry_pos
-{
-   int64_t id;
-   int64_t pos;
-   int64_t size;
-
-   bool operator <( const ods_index_entry_pos& lval ) const
-   {
-      return pos < lval.pos;
-   }
-};
-
 ods_index_entry::ods_index_entry( )
  :
  lock_flag( e_lock_none ),
@@ -2981,9 +3077,9 @@ int64_t ods::get_size( const oid& id )
       return 0;
 
    bool found = false;
-   int attempts = c_review_max_attempts;
+   lock_attempt_waiter waiter( c_review_max_attempts, c_review_attempt_sleep_time );
 
-   while( attempts-- )
+   while( true )
    {
       { // start of file lock section...
          guard tmp_lock( *p_impl->rp_impl_lock );
@@ -3001,7 +3097,8 @@ int64_t ods::get_size( const oid& id )
          }
       } // end of file lock section...
 
-      msleep( c_review_attempt_sleep_time );
+      if( !waiter.wait( ) )
+         break;
    }
 
    if( !found )
@@ -3032,9 +3129,9 @@ void ods::destroy( const oid& id )
    ods_index_entry index_entry;
 
    bool deleted = false;
-   int attempts = c_delete_max_attempts;
+   lock_attempt_waiter waiter( c_delete_max_attempts, c_delete_attempt_sleep_time );
 
-   while( attempts-- )
+   while( true )
    {
       { // start of file lock section...
          guard tmp_lock( *p_impl->rp_impl_lock );
@@ -3135,7 +3232,8 @@ void ods::destroy( const oid& id )
             break;
       } // end of file lock section...
 
-      msleep( c_delete_attempt_sleep_time );
+      if( !waiter.wait( ) )
+         break;
    }
 
    if( !deleted )
@@ -3459,6 +3557,10 @@ void ods::move_free_data_to_end( )
    ++p_impl->rp_header_info->data_transform_id;
    ++p_impl->rp_header_info->index_transform_id;
 
+   if( p_impl->rp_header_info->total_size_of_data > actual_size )
+      p_impl->rp_header_info->compact_reclaimed += p_impl->rp_header_info->total_size_of_data - actual_size;
+
+   p_impl->rp_header_info->compact_data_pos = 0;
    p_impl->rp_header_info->total_size_of_data = actual_size;
 
    data_and_index_write( );
@@ -3466,6 +3568,288 @@ void ods::move_free_data_to_end( )
    p_impl->force_write_header_file_info( );
 }
 
+bool ods::move_some_free_data_to_end( int64_t max_entries )
+{
+   guard lock_write( write_lock );
+   guard lock_read( read_lock );
+
+   if( !okay )
+      THROW_ODS_ERROR( "database instance in bad state" );
+
+   if( max_entries <= 0 )
+      THROW_ODS_ERROR( "invalid max. entries for moving some free data to end" );
+
+   if( p_impl->is_read_only )
+      THROW_ODS_ERROR( "attempt to move free data to end when database was opened for read only access" );
+
+   if( p_impl->trans_level )
+      THROW_ODS_ERROR( "cannot move free data to end whilst in a transaction" );
+
+   if( *p_impl->rp_bulk_level && *p_impl->rp_bulk_mode != impl::e_bulk_mode_write )
+      THROW_ODS_ERROR( "cannot move free data to end when bulk locked for dumping or reading" );
+
+   // NOTE: The bulk write lock is obtained before the impl lock so that other threads are able
+   // to release any bulk locks that they hold whilst this thread is waiting to obtain its own.
+   auto_ptr< ods::bulk_write > ap_bulk_write;
+   if( !*p_impl->rp_bulk_level )
+      ap_bulk_write.reset( new ods::bulk_write( *this ) );
+
+   guard lock_impl( *p_impl->rp_impl_lock );
+
+   int64_t total_size = p_impl->rp_header_info->total_size_of_data;
+   int64_t start_pos = min( p_impl->rp_header_info->compact_data_pos, total_size );
+
+   // NOTE: All data prior to "compact_data_pos" was contiguous after the previous step. If this
+   // instance performed that step (and no data has since been appended, truncated or moved) then
+   // the remaining entries found by its scan are used, otherwise the index is scanned again. As
+   // an entry could have been destroyed (leaving a gap) the first new position is taken to be
+   // after the end of any earlier entries. Thus the index is normally only scanned once for each
+   // compaction pass rather than once for every step.
+   int64_t new_pos = start_pos;
+
+   vector< ods_index_entry_pos >& entries( p_impl->compact_entries );
+
+   ods_index_entry index_entry;
+
+   if( entries.empty( )
+    || p_impl->compact_data_pos != p_impl->rp_header_info->compact_data_pos
+    || p_impl->compact_total_size != total_size
+    || p_impl->compact_transform_id != p_impl->rp_header_info->data_transform_id )
+   {
+      entries.clear( );
+      p_impl->compact_next_entry = 0;
+
+      ods_index_entry_pos entry;
+
+      for( int64_t i = 0; i < p_impl->rp_header_info->total_entries; i++ )
+      {
+         read_index_entry( index_entry, i );
+
+         if( index_entry.trans_flag == ods_index_entry::e_trans_free_list || !index_entry.data.size )
+            continue;
+
+         if( index_entry.data.pos < start_pos )
+         {
+            new_pos = max( new_pos, index_entry.data.pos + index_entry.data.size );
+            continue;
+         }
+
+         entry.id = i;
+         entry.pos = index_entry.data.pos;
+         entry.size = index_entry.data.size;
+
+         entries.push_back( entry );
+      }
+
+      sort( entries.begin( ), entries.end( ) );
+   }
+
+   size_t first_entry = p_impl->compact_next_entry;
+   size_t end_entry = min( entries.size( ), first_entry + ( size_t )max_entries );
+
+   // NOTE: Any entry that is locked, is part of an active transaction or is currently being read
+   // or written by another instance (or process) is left in place with later entries being moved
+   // to follow it. As the header file lock is being held no other process can newly lock entries.
+   vector< pair< ods_index_entry_pos, int64_t > > moves;
+
+   for( size_t i = first_entry; i < end_entry; i++ )
+   {
+      read_index_entry( index_entry, entries[ i ].id );
+
+      // NOTE: Skip any entry that has been destroyed or whose data has been relocated since the
+      // scan (although the latter would have changed the total size and so caused a new scan).
+      if( index_entry.trans_flag == ods_index_entry::e_trans_free_list
+       || !index_entry.data.size || index_entry.data.pos != entries[ i ].pos )
+         continue;
+
+      entries[ i ].size = index_entry.data.size;
+
+      if( entries[ i ].pos < new_pos )
+         THROW_ODS_ERROR( "unexpected overlapping data found at " STRINGIZE( __LINE__ ) );
+
+      bool can_move = false;
+
+      if( entries[ i ].pos != new_pos )
+      {
+         if( index_entry.lock_flag == ods_index_entry::e_lock_none
+          && index_entry.trans_flag == ods_index_entry::e_trans_none
+          && !p_impl->found_instance_currently_reading( entries[ i ].id )
+          && !p_impl->found_instance_currently_writing( entries[ i ].id )
+          && p_impl->rp_ods_index_cache_buffer->lock_entry( entries[ i ].id, true ) )
+         {
+            can_move = true;
+            p_impl->rp_ods_index_cache_buffer->unlock_entry( entries[ i ].id, true );
+         }
+      }
+
+      if( can_move )
+      {
+         moves.push_back( make_pair( entries[ i ], new_pos ) );
+         new_pos += entries[ i ].size;
+      }
+      else
+         new_pos = entries[ i ].pos + entries[ i ].size;
+   }
+
+   int64_t log_entry_offs = 0;
+   int64_t old_append_offs = 0;
+
+   if( p_impl->using_tranlog && !moves.empty( ) )
+   {
+      log_entry_offs = append_log_entry( p_impl->rp_header_info->transaction_id++, &old_append_offs );
+
+      fstream fs;
+      fs.open( p_impl->tranlog_file_name.c_str( ), ios::in | ios::out | ios::binary );
+
+      if( !fs )
+         THROW_ODS_ERROR( "unable to open transaction log '" + p_impl->tranlog_file_name + "' in move_some_free_data_to_end" );
+
+      fs.seekg( old_append_offs, ios::beg );
+
+      for( size_t i = 0; i < moves.size( ); i++ )
+      {
+         int64_t next_size = moves[ i ].first.size;
+
+         log_entry_item tranlog_item;
+
+         tranlog_item.flags = c_log_entry_item_op_store;
+         tranlog_item.flags |= ( c_log_entry_item_type_non_transactional | c_log_entry_item_flag_has_old_pos );
+
+         tranlog_item.index_entry_id = moves[ i ].first.id;
+
+         tranlog_item.data_pos = moves[ i ].second;
+         tranlog_item.data_opos = moves[ i ].first.pos;
+         tranlog_item.data_size = next_size;
+
+         tranlog_item.write( fs );
+
+         set_read_data_pos( moves[ i ].first.pos, true );
+
+         int64_t chunk = c_buffer_chunk_size;
+         char buffer[ c_buffer_chunk_size ];
+
+         for( int64_t j = 0; j < next_size; j += chunk )
+         {
+            if( j + chunk > next_size )
+               chunk = next_size - j;
+
+            read_data_bytes( buffer, chunk );
+            fs.write( buffer, chunk );
+
+            if( !fs.good( ) )
+               THROW_ODS_ERROR( "unexpected bad tranlog data append" );
+         }
+      }
+
+      fs.flush( );
+      if( !fs.good( ) )
+         THROW_ODS_ERROR( "unexpected bad tranlog data append" );
+
+      int64_t offs = fs.tellg( );
+
+      fs.seekg( 0, ios::beg );
+
+      log_info tranlog_info;
+      tranlog_info.read( fs );
+
+      tranlog_info.append_offs = offs;
+
+      fs.seekg( 0, ios::beg );
+      tranlog_info.write( fs );
+
+      fs.close( );
+   }
+
+   // NOTE: As entries are only ever moved to lower positions (and in ascending position order)
+   // the source data of any entry cannot have been overwritten by the moving of earlier entries.
+   for( size_t i = 0; i < moves.size( ); i++ )
+   {
+      int64_t next_id = moves[ i ].first.id;
+      int64_t next_size = moves[ i ].first.size;
+
+      set_read_data_pos( moves[ i ].first.pos, true );
+      set_write_data_pos( moves[ i ].second );
+
+      int64_t chunk = c_buffer_chunk_size;
+      char buffer[ c_buffer_chunk_size ];
+
+      for( int64_t j = 0; j < next_size; j += chunk )
+      {
+         if( j + chunk > next_size )
+            chunk = next_size - j;
+
+         read_data_bytes( buffer, chunk );
+         write_data_bytes( buffer, chunk );
+      }
+
+      read_index_entry( index_entry, next_id );
+
+      index_entry.data.pos = moves[ i ].second;
+      write_index_entry( index_entry, next_id );
+   }
+
+   if( log_entry_offs )
+   {
+      fstream fs;
+      fs.open( p_impl->tranlog_file_name.c_str( ), ios::in | ios::out | ios::binary );
+
+      if( !fs )
+         THROW_ODS_ERROR( "unable to open transaction log '" + p_impl->tranlog_file_name + "' in move_some_free_data_to_end" );
+
+      log_entry tranlog_entry;
+
+      fs.seekg( log_entry_offs, ios::beg );
+      tranlog_entry.read( fs );
+
+      tranlog_entry.commit_offs = old_append_offs;
+      tranlog_entry.commit_items = moves.size( );
+
+      fs.seekg( log_entry_offs, ios::beg );
+      tranlog_entry.write( fs );
+
+      fs.close( );
+
+      p_impl->rp_header_info->tranlog_offset = log_entry_offs;
+   }
+
+   if( !moves.empty( ) )
+   {
+      ++p_impl->rp_header_info->data_transform_id;
+      ++p_impl->rp_header_info->index_transform_id;
+   }
+
+   p_impl->compact_next_entry = end_entry;
+
+   bool has_more = ( end_entry < entries.size( ) );
+
+   // NOTE: If every entry that follows "start_pos" has now been processed then the end of the
+   // data is truncated and the next step will start again from the beginning of the data file.
+   if( has_more )
+      p_impl->rp_header_info->compact_data_pos = new_pos;
+   else
+   {
+      if( total_size > new_pos )
+      {
+         p_impl->rp_header_info->compact_reclaimed += total_size - new_pos;
+         p_impl->rp_header_info->total_size_of_data = new_pos;
+      }
+
+      p_impl->rp_header_info->compact_data_pos = 0;
+
+      vector< ods_index_entry_pos >( ).swap( entries );
+   }
+
+   data_and_index_write( );
+
+   p_impl->force_write_header_file_info( );
+
+   p_impl->compact_data_pos = p_impl->rp_header_info->compact_data_pos;
+   p_impl->compact_total_size = p_impl->rp_header_info->total_size_of_data;
+   p_impl->compact_transform_id = p_impl->rp_header_info->data_transform_id;
+
+   return has_more;
+}
+
 void ods::truncate_log( const char* p_ext )
 {
    guard lock_write( write_lock );
@@ -3578,7 +3962,9 @@ void ods::dump_file_info( ostream& os )
     to_string( p_impl->rp_header_info->index_free_list - 1 ) : to_string( "n/a" ) )
     << "\nTotal Size of Data = " << p_impl->rp_header_info->total_size_of_data
     << "\nData Transformation Id = " << p_impl->rp_header_info->data_transform_id
-    << "\nIndex Transformation Id = " << p_impl->rp_header_info->index_transform_id << endl;
+    << "\nIndex Transformation Id = " << p_impl->rp_header_info->index_transform_id
+    << "\nCompact Data Position = " << p_impl->rp_header_info->compact_data_pos
+    << "\nCompact Reclaimed Bytes = " << p_impl->rp_header_info->compact_reclaimed << endl;
 
    int64_t found = p_impl->rp_ods_index_cache_buffer->get_file_size( );
    int64_t expected = ods_index_entry::get_size_of( ) * p_impl->rp_header_info->total_entries;
@@ -3810,12 +4196,11 @@ void ods::bulk_base::pause( )
 ods::bulk_dump::bulk_dump( ods& o )
  : bulk_base( o )
 {
-   int i;
-   for( i = 0; i < c_bulk_dump_max_attempts; i++ )
-   {
-      if( i > 0 )
-         msleep( c_bulk_dump_attempt_sleep_time );
+   bool obtained = false;
+   lock_attempt_waiter waiter( c_bulk_dump_max_attempts, c_bulk_dump_attempt_sleep_time );
 
+   do
+   {
       guard lock_write( o.write_lock );
       guard lock_read( o.read_lock );
       guard lock_impl( *o.p_impl->rp_impl_lock );
@@ -3829,6 +4214,8 @@ ods::bulk_dump::bulk_dump( ods& o )
       try
       {
          o.bulk_operation_start( );
+
+         obtained = true;
          break;
       }
       catch( ... )
@@ -3836,14 +4223,16 @@ ods::bulk_dump::bulk_dump( ods& o )
          *o.p_impl->rp_bulk_mode = old_bulk_mode;
          throw;
       }
-   }
+   } while( waiter.wait( ) );
 
-   if( i == c_bulk_dump_max_attempts )
+   if( !obtained )
       THROW_ODS_ERROR( "thread cannot obtain bulk dump lock (max. attempts exceeded)" );
 }
 
 ods::bulk_dump::~bulk_dump( )
 {
+   lock_release_notifier notifier;
+
    guard lock_write( o.write_lock );
    guard lock_read( o.read_lock );
    guard lock_impl( *o.p_impl->rp_impl_lock );
@@ -3860,12 +4249,11 @@ ods::bulk_dump::~bulk_dump( )
 ods::bulk_read::bulk_read( ods& o )
  : bulk_base( o )
 {
-   int i;
-   for( i = 0; i < c_bulk_read_max_attempts; i++ )
-   {
-      if( i > 0 )
-         msleep( c_bulk_read_attempt_sleep_time );
+   bool obtained = false;
+   lock_attempt_waiter waiter( c_bulk_read_max_attempts, c_bulk_read_attempt_sleep_time );
 
+   do
+   {
       guard lock_write( o.write_lock );
       guard lock_read( o.read_lock );
       guard lock_impl( *o.p_impl->rp_impl_lock );
@@ -3890,6 +4278,8 @@ ods::bulk_read::bulk_read( ods& o )
       {
          o.bulk_operation_start( );
          *o.p_impl->rp_bulk_read_thread_id = current_thread_id( );
+
+         obtained = true;
          break;
       }
       catch( ... )
@@ -3897,14 +4287,16 @@ ods::bulk_read::bulk_read( ods& o )
          *o.p_impl->rp_bulk_mode = old_bulk_mode;
          throw;
       }
-   }
+   } while( waiter.wait( ) );
 
-   if( i == c_bulk_read_max_attempts )
+   if( !obtained )
       THROW_ODS_ERROR( "thread cannot obtain bulk read lock (max. attempts exceeded)" );
 }
 
 ods::bulk_read::~bulk_read( )
 {
+   lock_release_notifier notifier;
+
    guard lock_write( o.write_lock );
    guard lock_read( o.read_lock );
    guard lock_impl( *o.p_impl->rp_impl_lock );
@@ -3927,12 +4319,11 @@ ods::bulk_write::bulk_write( ods& o )
    if( o.p_impl->is_read_only )
       THROW_ODS_ERROR( "attempt to obtain bulk write lock when database was opened for read only access" );
 
-   int i;
-   for( i = 0; i < c_bulk_write_max_attempts; i++ )
-   {
-      if( i > 0 )
-         msleep( c_bulk_write_attempt_sleep_time );
+   bool obtained = false;
+   lock_attempt_waiter waiter( c_bulk_write_max_attempts, c_bulk_write_attempt_sleep_time );
 
+   do
+   {
       guard lock_write( o.write_lock );
       guard lock_read( o.read_lock );
       guard lock_impl( *o.p_impl->rp_impl_lock );
@@ -3957,6 +4348,8 @@ ods::bulk_write::bulk_write( ods& o )
       {
          o.bulk_operation_start( );
          *o.p_impl->rp_bulk_write_thread_id = current_thread_id( );
+
+         obtained = true;
          break;
       }
       catch( ... )
@@ -3964,14 +4357,16 @@ ods::bulk_write::bulk_write( ods& o )
          *o.p_impl->rp_bulk_mode = old_bulk_mode;
          throw;
       }
-   }
+   } while( waiter.wait( ) );
 
-   if( i == c_bulk_write_max_attempts )
+   if( !obtained )
       THROW_ODS_ERROR( "thread cannot obtain bulk write lock (max. attempts exceeded)" );
 }
 
 ods::bulk_write::~bulk_write( )
 {
+   lock_release_notifier notifier;
+
    guard lock_write( o.write_lock );
    guard lock_read( o.read_lock );
    guard lock_impl( *o.p_impl->rp_impl_lock );
@@ -4179,6 +4574,8 @@ void ods::bulk_operation_pause( )
    *p_impl->rp_is_in_bulk_pause = true;
    bulk_operation_close( );
 
+   notify_lock_waiters( );
+
    msleep( c_bulk_pause_sleep_time );
 
    bulk_operation_open( );
@@ -4628,6 +5025,8 @@ void ods::lock_header_file( )
    if( *p_impl->rp_bulk_level && !*p_impl->rp_is_in_bulk_pause )
       return;
 
+   // NOTE: As the header file lock can only be held by another process (threads within the same
+   // process are serialised by the impl lock) polling is still required here.
    int attempts = c_header_lock_max_attempts;
    while( attempts )
    {
@@ -4652,6 +5051,8 @@ void ods::unlock_header_file( )
    p_impl->rp_header_file->unlock( );
 
    DEBUG_LOG( ">>>>>>>>>> released header file lock <<<<<<<<<<" );
+
+   notify_lock_waiters( );
 }
 
 void ods::data_and_index_write( bool flush )
@@ -5305,6 +5706,7 @@ ods& operator >>( ods& o, storable_base& s )
       THROW_ODS_ERROR( "cannot read when bulk locked for dumping" );
 
    temp_set_value< bool > tmp_in_read( o.is_in_read, true );
+   lock_release_notifier notifier;
    finalise_value< int64_t > finalise_reading_object( o.current_read_object_num, -1 );
 
    int64_t trans_read_pos = -1;
@@ -5320,8 +5722,9 @@ ods& operator >>( ods& o, storable_base& s )
    bool can_read = false;
    bool has_locked = false;
 
-   int attempts = c_review_max_attempts;
-   while( attempts-- )
+   lock_attempt_waiter waiter( c_review_max_attempts, c_review_attempt_sleep_time );
+
+   while( true )
    {
       { // start of file lock section...
          guard tmp_lock( *o.p_impl->rp_impl_lock );
@@ -5402,7 +5805,8 @@ ods& operator >>( ods& o, storable_base& s )
          }
       } // end of file lock section...
 
-      msleep( c_review_attempt_sleep_time );
+      if( !waiter.wait( ) )
+         break;
    }
 
    if( !can_read )
@@ -5461,6 +5865,7 @@ ods& operator <<( ods& o, storable_base& s )
       THROW_ODS_ERROR( "attempt to perform write when database was opened for read only access" );
 
    temp_set_value< bool > tmp_in_write( o.is_in_write, true );
+   lock_release_notifier notifier;
    finalise_value< int64_t > finalise_writing_object( o.current_write_object_num, -1 );
 
    int64_t old_tran_id = -1;
@@ -5480,9 +5885,9 @@ ods& operator <<( ods& o, storable_base& s )
    bool has_locked = false;
 
    unsigned char flags = 0;
-   int attempts = c_update_max_attempts;
+   lock_attempt_waiter waiter( c_update_max_attempts, c_update_attempt_sleep_time );
 
-   while( attempts-- )
+   while( true )
    {
       { // start of file lock section...
          guard tmp_lock( *o.p_impl->rp_impl_lock );
@@ -5689,7 +6094,8 @@ ods& operator <<( ods& o, storable_base& s )
          }
       } // end of file lock section...
 
-      msleep( c_update_attempt_sleep_time );
+      if( !waiter.wait( ) )
+         break;
    }
 
    if( !can_write )
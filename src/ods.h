@@ -639,6 +639,10 @@ class ODS_DECL_SPEC ods
 
    void move_free_data_to_end( );
 
+   // NOTE: Performs a bounded step of the compaction that "move_free_data_to_end" performs (but
+   // which is able to occur whilst other instances are in use) returning true if more remains.
+   bool move_some_free_data_to_end( int64_t max_entries = 1000 );
+
    void truncate_log( const char* p_ext = 0 );
 
    void dump_file_info( std::ostream& os );
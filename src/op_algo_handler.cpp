@@ -10,16 +10,19 @@
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
 #  include <cmath>
+#  include <cstdlib>
 #  include <map>
 #  include <memory>
 #  include <vector>
 #  include <fstream>
 #  include <iostream>
+#  include <algorithm>
 #  include <stdexcept>
 #endif
 
 #include "op_algo_handler.h"
 
+#include "threads.h"
 #include "utilities.h"
 
 //#define DEBUG
@@ -34,6 +37,9 @@ const size_t c_max_rounds_allowed = 100000000;
 const char* const c_act_kill = "kill";
 const char* const c_act_load = "load";
 const char* const c_act_save = "save";
+const char* const c_act_threads = "threads";
+
+const size_t c_max_threads = 64;
 
 const char* const c_goal_found = "found";
 
@@ -195,6 +201,212 @@ string g_algo_prefix;
 
 multimap< string, string > g_goal_algos;
 
+mutex g_threads_lock;
+
+size_t g_num_threads = 1;
+
+bool g_has_seed = false;
+unsigned int g_seed = 0;
+
+void get_threads_and_seed( size_t& num_threads, bool& has_seed, unsigned int& seed )
+{
+   guard g( g_threads_lock );
+
+   num_threads = g_num_threads;
+
+   has_seed = g_has_seed;
+   seed = g_seed;
+}
+
+void set_threads_and_seed( size_t num_threads, bool has_seed, unsigned int seed )
+{
+   guard g( g_threads_lock );
+
+   g_num_threads = num_threads;
+
+   g_has_seed = has_seed;
+   g_seed = seed;
+}
+
+// NOTE: If no seed was provided then one is taken from "rand( )" (by the calling thread) so each
+// task still has its own random number stream (as "rand( )" is not safe to use from the workers).
+unsigned int seed_for_tasks( bool has_seed, unsigned int seed )
+{
+   return has_seed ? seed : ( unsigned int )rand( );
+}
+
+unsigned int seed_for_task( unsigned int seed, size_t num )
+{
+   return seed ^ ( unsigned int )( ( num + 1 ) * 2654435761u );
+}
+
+class algo_task
+{
+   public:
+   virtual ~algo_task( ) { }
+
+   virtual void execute( ) = 0;
+
+   string error;
+};
+
+// NOTE: Tasks are handed out to the worker threads in order and any error is kept with the task
+// that had failed so that the caller can process the results in task order (throwing the error
+// of the first failed task when it is reached) in order to get the same outcome as if the tasks
+// had been executed serially.
+class algo_task_runner
+{
+   public:
+   algo_task_runner( vector< algo_task* >& tasks )
+    :
+    tasks( tasks ),
+    next_task( 0 )
+   {
+   }
+
+   void run( size_t num_threads );
+
+   bool run_next( );
+
+   private:
+   vector< algo_task* >& tasks;
+
+   size_t next_task;
+
+   mutex lock;
+};
+
+void algo_task_runner::run( size_t num_threads )
+{
+   if( num_threads > tasks.size( ) )
+      num_threads = tasks.size( );
+
+   run_in_threads( *this, &algo_task_runner::run_next, num_threads );
+}
+
+bool algo_task_runner::run_next( )
+{
+   algo_task* p_task = 0;
+
+   {
+      guard g( lock );
+
+      if( next_task >= tasks.size( ) )
+         return false;
+
+      p_task = tasks[ next_task++ ];
+   }
+
+   try
+   {
+      p_task->execute( );
+   }
+   catch( exception& x )
+   {
+      p_task->error = x.what( );
+   }
+   catch( ... )
+   {
+      p_task->error = "unexpected unknown exception in algo task";
+   }
+
+   return true;
+}
+
+class algo_tasks_holder
+{
+   public:
+   ~algo_tasks_holder( )
+   {
+      for( size_t i = 0; i < tasks.size( ); i++ )
+         delete tasks[ i ];
+   }
+
+   vector< algo_task* > tasks;
+};
+
+class train_task : public algo_task
+{
+   public:
+   train_task( op_algo_handler* p_handler, const vector< string >& train_args )
+    :
+    ap_handler( p_handler ),
+    train_args( train_args )
+   {
+   }
+
+   void execute( )
+   {
+      size_t rounds = 0;
+      size_t max_tries_allowed = 0;
+
+      if( train_args.size( ) > 3 )
+         rounds = from_string< size_t >( train_args[ 3 ] );
+
+      if( train_args.size( ) > 4 )
+         max_tries_allowed = from_string< size_t >( train_args[ 4 ] );
+
+      ap_handler->train_algo( train_args[ 0 ], train_args[ 1 ],
+       train_args[ 2 ], rounds, max_tries_allowed, 0, 0, &goal_algo );
+   }
+
+   pair< string, string > goal_algo;
+
+   private:
+   auto_ptr< op_algo_handler > ap_handler;
+
+   vector< string > train_args;
+};
+
+class attempt_task : public algo_task
+{
+   public:
+   attempt_task( op_algo_handler* p_handler, const string& pat,
+    const string& goal, const string& algo, size_t rounds, size_t max_op_tries )
+    :
+    algo( algo ),
+    retained( false ),
+    found_match( false ),
+    ap_handler( p_handler ),
+    pat( pat ),
+    goal( goal ),
+    rounds( rounds ),
+    max_op_tries( max_op_tries )
+   {
+   }
+
+   void execute( )
+   {
+      bool can_keep = false;
+
+      ap_handler->train_algo( pat, goal, algo, rounds, max_op_tries, &can_keep, &found_match );
+
+      if( can_keep )
+      {
+         auto_ptr< op_algo_handler > ap_tmp_handler( ap_handler->create_clone( ) );
+
+         ap_tmp_handler->exec_ops( algo );
+
+         if( is_closer_to_goal( ap_tmp_handler->current_state( ), ap_handler->current_state( ), goal ) )
+            retained = true;
+      }
+   }
+
+   string algo;
+
+   bool retained;
+   bool found_match;
+
+   private:
+   auto_ptr< op_algo_handler > ap_handler;
+
+   string pat;
+   string goal;
+
+   size_t rounds;
+   size_t max_op_tries;
+};
+
 }
 
 void op_algo_handler::suggest( ostream& os, const string& info )
@@ -692,6 +904,59 @@ void op_algo_handler::train( const string& info )
          }
       }
 
+      size_t num_threads = 1;
+
+      bool has_seed = false;
+      unsigned int seed = 0;
+
+      get_threads_and_seed( num_threads, has_seed, seed );
+
+      // NOTE: If more than one thread is to be used (or if a seed has been provided) then each line
+      // is trained by a separate task (with its own handler clone) and the results are then added
+      // in line order (stopping at the first line that failed just as the serial training does).
+      if( num_threads > 1 || has_seed )
+      {
+         algo_tasks_holder holder;
+
+         seed = seed_for_tasks( has_seed, seed );
+
+         for( size_t i = 0; i < lines.size( ); i++ )
+         {
+            string next_line( lines[ i ] );
+
+            if( next_line.empty( ) || next_line[ 0 ] == '#' )
+               continue;
+
+            vector< string > train_args;
+            split( next_line, train_args, ' ' );
+
+            if( train_args.size( ) < 3 )
+               throw runtime_error( "unexpected train args < 3" );
+
+            auto_ptr< op_algo_handler > ap_handler( create_clone( ) );
+
+            ap_handler->set_random_seed( seed_for_task( seed, i ) );
+
+            holder.tasks.push_back( new train_task( ap_handler.release( ), train_args ) );
+         }
+
+         algo_task_runner runner( holder.tasks );
+         runner.run( num_threads );
+
+         for( size_t i = 0; i < holder.tasks.size( ); i++ )
+         {
+            train_task* p_task = dynamic_cast< train_task* >( holder.tasks[ i ] );
+
+            if( !p_task->error.empty( ) )
+               throw runtime_error( p_task->error );
+
+            if( !p_task->goal_algo.first.empty( ) )
+               g_goal_algos.insert( p_task->goal_algo );
+         }
+
+         return;
+      }
+
       for( size_t i = 0; i < lines.size( ); i++ )
       {
          string next_line( lines[ i ] );
@@ -719,7 +984,7 @@ void op_algo_handler::train( const string& info )
 
 void op_algo_handler::train_algo( const string& pat,
  const string& goal, const string& algo, size_t rounds,
- size_t max_tries_allowed, bool* p_can_keep, bool* p_found_match )
+ size_t max_tries_allowed, bool* p_can_keep, bool* p_found_match, pair< string, string >* p_goal_algo )
 {
    auto_ptr< op_algo_handler > ap_tmp_handler( create_clone( ) );
 
@@ -988,7 +1253,11 @@ void op_algo_handler::train_algo( const string& pat,
          size_t tries = min( max_tries, max_tries_allowed );
 
          string prefix( g_algo_prefix + type_key( ) + c_type_separator );
-         g_goal_algos.insert( make_pair( prefix + goal, to_string( tries ) + '=' + algx ) );
+
+         if( p_goal_algo )
+            *p_goal_algo = make_pair( prefix + goal, to_string( tries ) + '=' + algx );
+         else
+            g_goal_algos.insert( make_pair( prefix + goal, to_string( tries ) + '=' + algx ) );
       }
    }
 }
@@ -1019,6 +1288,19 @@ void op_algo_handler::attempt_own_algo( ostream& os, const string& pat, const st
    if( !max_attempt_ops )
       max_attempt_ops = default_max_attempt_ops( );
 
+   size_t num_threads = 1;
+
+   bool has_seed = false;
+   unsigned int seed = 0;
+
+   get_threads_and_seed( num_threads, has_seed, seed );
+
+   if( num_threads > 1 || has_seed )
+   {
+      attempt_own_algo_tasks( os, pat, goal, max_attempt_ops, num_threads, seed_for_tasks( has_seed, seed ) );
+      return;
+   }
+
    for( size_t i = 1; i <= max_attempt_ops; i++ )
    {
       for( size_t j = 0; j < 100; j++ )
@@ -1072,6 +1354,102 @@ void op_algo_handler::attempt_own_algo( ostream& os, const string& pat, const st
       os << last_retained;
 }
 
+void op_algo_handler::attempt_own_algo_tasks( ostream& os, const string& pat,
+ const string& goal, size_t max_attempt_ops, size_t num_threads, unsigned int seed )
+{
+   string last_retained;
+
+   size_t max_op_tries = default_max_op_tries( );
+
+   // NOTE: The candidate algorithms are generated by a single seeded handler clone and are then
+   // tried in batches (one per thread) with the first candidate (in the order they were generated)
+   // being chosen so the outcome is the same as when tried serially.
+   auto_ptr< op_algo_handler > ap_ops_handler( create_clone( ) );
+
+   ap_ops_handler->set_random_seed( seed );
+
+   for( size_t i = 1; i <= max_attempt_ops; i++ )
+   {
+      bool found_match = false;
+
+      // FUTURE: Rather than being hard-coded these candidate limits
+      // should be determined by each concrete "op algo" class.
+      size_t max_candidates = 100;
+
+      if( i == 1 )
+         max_candidates = 6;
+      else if( i == 2 )
+         max_candidates = 11;
+      else if( i == 3 )
+         max_candidates = 26;
+      else if( i == 4 )
+         max_candidates = 51;
+
+      size_t rounds = default_num_train_rounds( );
+
+      // NOTE: For algorithms with more than 3 ops extend the number of rounds.
+      if( i > 3 )
+         rounds *= ( i - 2 );
+
+      for( size_t j = 0; j < max_candidates; j += num_threads )
+      {
+         algo_tasks_holder holder;
+
+         for( size_t k = j; k < min( j + num_threads, max_candidates ); k++ )
+         {
+            auto_ptr< op_algo_handler > ap_handler( create_clone( ) );
+
+            ap_handler->set_random_seed( seed_for_task( seed, ( i * 1000 ) + k ) );
+
+            holder.tasks.push_back( new attempt_task( ap_handler.release( ),
+             pat, goal, ap_ops_handler->random_ops( i ), rounds, max_op_tries ) );
+         }
+
+         algo_task_runner runner( holder.tasks );
+         runner.run( num_threads );
+
+         for( size_t k = 0; k < holder.tasks.size( ); k++ )
+         {
+            attempt_task* p_task = dynamic_cast< attempt_task* >( holder.tasks[ k ] );
+
+            if( !p_task->error.empty( ) )
+               throw runtime_error( p_task->error );
+
+            if( p_task->retained )
+            {
+               last_retained = p_task->algo;
+               break;
+            }
+
+            if( p_task->found_match )
+            {
+               found_match = true;
+               break;
+            }
+         }
+
+         if( found_match || !last_retained.empty( ) )
+            break;
+      }
+
+      if( found_match || !last_retained.empty( ) )
+         break;
+   }
+
+   if( !last_retained.empty( ) )
+      os << last_retained;
+}
+
+int op_algo_handler::next_random( ) const
+{
+   if( !has_random_seed )
+      return rand( );
+
+   random_seed = random_seed * 1103515245 + 12345;
+
+   return ( int )( ( random_seed / 65536 ) % 32768 );
+}
+
 void op_algo_handler::output_algos( ostream& os )
 {
    ::output_algos( os, type_key( ), false );
@@ -1200,6 +1578,18 @@ void exec_algos_action( const string& act, const string& info_1, const string& i
          g_goal_algos.insert( make_pair( type_key_prefix + goal, maximum_rounds_and_algo ) );
       }
    }
+   else if( act == c_act_threads )
+   {
+      // NOTE: The number of threads (and an optional seed) that will be used for training.
+      size_t num_threads = from_string< size_t >( info_1 );
+
+      if( num_threads < 1 || num_threads > c_max_threads )
+         throw runtime_error( "invalid number of threads " + info_1 );
+
+      bool has_seed = !info_2.empty( );
+
+      set_threads_and_seed( num_threads, has_seed, has_seed ? from_string< unsigned int >( info_2 ) : 0 );
+   }
    else if( act == c_act_save )
    {
       ofstream outf( info_1.c_str( ) );
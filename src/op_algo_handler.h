@@ -9,11 +9,14 @@
 #  ifndef HAS_PRECOMPILED_STD_HEADERS
 #     include <string>
 #     include <iosfwd>
+#     include <utility>
 #  endif
 
 class op_algo_handler
 {
    public:
+   op_algo_handler( ) : has_random_seed( false ), random_seed( 0 ) { }
+
    virtual ~op_algo_handler( ) { }
 
    virtual op_algo_handler* create_clone( ) const = 0;
@@ -50,7 +53,8 @@ class op_algo_handler
 
    void train_algo( const std::string& pat,
     const std::string& goal, const std::string& algo, size_t rounds = 0,
-    size_t max_tries_allowed = 0, bool* p_can_keep = 0, bool* p_found_match = 0 );
+    size_t max_tries_allowed = 0, bool* p_can_keep = 0, bool* p_found_match = 0,
+    std::pair< std::string, std::string >* p_goal_algo = 0 );
 
    void attempt( std::ostream& os, const std::string& info );
 
@@ -58,6 +62,24 @@ class op_algo_handler
     const std::string& pat, const std::string& goal, size_t max_attempt_ops = 0 );
 
    void output_algos( std::ostream& os );
+
+   void set_random_seed( unsigned int seed )
+   {
+      random_seed = seed;
+      has_random_seed = true;
+   }
+
+   protected:
+   // NOTE: Unless a seed has been provided this simply returns "rand( )" (a seed is always provided
+   // to each clone that is used by a training worker thread so that each has its own stream).
+   int next_random( ) const;
+
+   private:
+   bool has_random_seed;
+   mutable unsigned int random_seed;
+
+   void attempt_own_algo_tasks( std::ostream& os, const std::string& pat,
+    const std::string& goal, size_t max_attempt_ops, size_t num_threads, unsigned int seed );
 };
 
 struct temporary_algo_prefix
@@ -18,6 +18,7 @@
 
 #include "regex.h"
 
+#include "threads.h"
 #include "utilities.h"
 
 //#define DEBUG
@@ -28,6 +29,8 @@ using namespace std;
 namespace
 {
 
+const size_t c_max_cached_expressions = 1000;
+
 enum part_type
 {
    e_part_type_lit,
@@ -75,6 +78,14 @@ struct part
    vector< pair< char, char > > matches;
 };
 
+struct part_table
+{
+   int min_matches;
+   int max_matches;
+
+   bool chars[ 256 ];
+};
+
 bool is_special_set( char ch )
 {
    return ( ch == 'd' || ch == 's' || ch == 'w' );
@@ -228,6 +239,9 @@ struct regex::impl
 
    bool match_set( const string& text, size_t off, const part& p );
 
+   void prepare_tables( );
+   string::size_type search_tables( const string& text, string::size_type* p_length, vector< string >* p_refs );
+
    string& expand_refs( string& literal );
 
    void dump( ostream& os );
@@ -251,8 +265,16 @@ struct regex::impl
    vector< string > refs;
 
    map< int, string > node_refs;
+
+   vector< part_table > tables;
+
+   static mutex cache_lock;
+   static map< string, impl* > cache;
 };
 
+mutex regex::impl::cache_lock;
+map< string, regex::impl* > regex::impl::cache;
+
 regex::impl::impl( const string& expr )
  :
  expr( expr ),
@@ -907,6 +929,8 @@ regex::impl::impl( const string& expr )
    cout << "max_size = " << max_size << endl;
    dump( cout );
 #endif
+
+   prepare_tables( );
 }
 
 string::size_type regex::impl::search(
@@ -915,6 +939,9 @@ string::size_type regex::impl::search(
    if( parts.empty( ) || ( min_size && text.length( ) < min_size ) )
       return string::npos;
 
+   if( !tables.empty( ) && !text.empty( ) )
+      return search_tables( text, p_length, p_refs );
+
 #ifdef DEBUG
    cout << "text: " << text << endl;
    dump( cout );
@@ -1636,6 +1663,87 @@ string& regex::impl::expand_refs( string& literal )
    return literal;
 }
 
+void regex::impl::prepare_tables( )
+{
+   // NOTE: An expression that must match the whole text and consists only of non-inverted sets
+   // (without refs) where all but the last have a fixed number of matches (e.g. "^[0-9]{1,19}$")
+   // can be matched by simply checking each character against a table for its set. Set tables
+   // are filled in using "match_set" so that they will behave identically.
+   if( !match_at_start || !match_at_finish || parts.empty( ) )
+      return;
+
+   for( size_t i = 0; i < parts.size( ); i++ )
+   {
+      const part& p( parts[ i ] );
+
+      if( p.type != e_part_type_set || p.inverted || p.start_ref || p.finish_ref )
+         return;
+
+      if( i < parts.size( ) - 1 && ( !p.max_matches || p.min_matches != p.max_matches ) )
+         return;
+
+      // NOTE: An optional final set is not matched in the same manner by the search
+      // (it is permitted to match after skipping leading characters) so is excluded.
+      if( i && i == parts.size( ) - 1 && !p.min_matches )
+         return;
+   }
+
+   tables.resize( parts.size( ) );
+
+   for( size_t i = 0; i < parts.size( ); i++ )
+   {
+      part single( parts[ i ] );
+      single.min_matches = 1;
+
+      tables[ i ].min_matches = parts[ i ].min_matches;
+      tables[ i ].max_matches = parts[ i ].max_matches;
+
+      for( size_t j = 0; j < 256; j++ )
+         tables[ i ].chars[ j ] = match_set( string( 1, ( char )j ), 0, single );
+   }
+}
+
+string::size_type regex::impl::search_tables(
+ const string& text, string::size_type* p_length, vector< string >* p_refs )
+{
+   size_t length = text.length( );
+
+   size_t fixed = 0;
+   for( size_t i = 0; i < tables.size( ) - 1; i++ )
+      fixed += tables[ i ].min_matches;
+
+   const part_table& last( tables.back( ) );
+
+   if( length < fixed + last.min_matches
+    || ( last.max_matches && length > fixed + last.max_matches ) )
+      return string::npos;
+
+   const unsigned char* p_text = ( const unsigned char* )text.data( );
+
+   size_t pos = 0;
+
+   for( size_t i = 0; i < tables.size( ); i++ )
+   {
+      const bool* p_chars = tables[ i ].chars;
+
+      size_t end = ( i == tables.size( ) - 1 ) ? length : pos + tables[ i ].min_matches;
+
+      for( ; pos < end; pos++ )
+      {
+         if( !p_chars[ p_text[ pos ] ] )
+            return string::npos;
+      }
+   }
+
+   if( p_length )
+      *p_length = length;
+
+   if( p_refs )
+      p_refs->clear( );
+
+   return 0;
+}
+
 void regex::impl::dump( ostream& os )
 {
    os << "\nexpr: " << expr << '\n';
@@ -1676,19 +1784,38 @@ void regex::impl::dump( ostream& os )
 
 regex::regex( const string& expr )
 {
-#ifdef DEBUG
-   try
+   p_impl = 0;
+
+   // NOTE: Compiled expressions are cached (and copied as the search state is held in "impl").
    {
-#endif
-      p_impl = new regex::impl( expr );
-#ifdef DEBUG
+      guard g( impl::cache_lock );
+
+      map< string, impl* >::iterator i = impl::cache.find( expr );
+
+      if( i != impl::cache.end( ) )
+         p_impl = new regex::impl( *i->second );
    }
-   catch( exception& x )
+
+   if( !p_impl )
    {
-      cout << "error: " << x.what( ) << endl;
-      throw;
-   }
+#ifdef DEBUG
+      try
+      {
+#endif
+         p_impl = new regex::impl( expr );
+#ifdef DEBUG
+      }
+      catch( exception& x )
+      {
+         cout << "error: " << x.what( ) << endl;
+         throw;
+      }
 #endif
+      guard g( impl::cache_lock );
+
+      if( impl::cache.size( ) < c_max_cached_expressions && !impl::cache.count( expr ) )
+         impl::cache.insert( make_pair( expr, new regex::impl( *p_impl ) ) );
+   }
 }
 
 regex::~regex( )
@@ -197,9 +197,14 @@ void sha1_final( unsigned char digest[ 20 ], sha1_context* context )
       finalcount[ i ] = // Endian independent
        ( unsigned char )( ( context->count[ ( i >= 4 ? 0 : 1 ) ] >> ( ( 3 - ( i & 3 ) ) * 8 ) ) & 255 );
 
-   sha1_update( context, ( unsigned char* )"\200", 1 );
-   while( ( context->count[ 0 ] & 504 ) != 448 )
-      sha1_update( context, ( unsigned char* )"\0", 1 );
+   unsigned char padding[ 64 ];
+
+   memset( padding, 0, sizeof( padding ) );
+   padding[ 0 ] = 0x80;
+
+   // NOTE: Pad to 56 bytes (mod 64) with a single update (rather than one byte at a time).
+   j = ( context->count[ 0 ] >> 3 ) & 63;
+   sha1_update( context, padding, j < 56 ? 56 - j : 120 - j );
 
    sha1_update( context, finalcount, 8 ); // should cause a sha1_transform( )
    for( i = 0; i < 20; i++ )
@@ -258,6 +263,19 @@ sha1::sha1( const unsigned char* p_data, unsigned int length )
    update( p_data, length );
 }
 
+sha1::sha1( const sha1& src )
+{
+   p_impl = new impl( *src.p_impl );
+}
+
+sha1& sha1::operator =( const sha1& src )
+{
+   if( this != &src )
+      *p_impl = *src.p_impl;
+
+   return *this;
+}
+
 sha1::~sha1( )
 {
    delete p_impl;
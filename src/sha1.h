@@ -20,6 +20,11 @@ class sha1
    sha1( const std::string& str );
    sha1( const unsigned char* p_data, unsigned int length );
 
+   // NOTE: Copying will include the current (i.e. mid-state) context so a common prefix
+   // only needs to be hashed once (assignment does not perform any memory allocation).
+   sha1( const sha1& src );
+   sha1& operator =( const sha1& src );
+
    ~sha1( );
 
    void init( );
@@ -10,13 +10,23 @@
 #pragma hdrstop
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <ctime>
+#  include <cstring>
 #  include <fstream>
+#  include <iterator>
 #  include <iostream>
 #  include <stdexcept>
+#  ifndef _WIN32
+#     include <fcntl.h>
+#     include <unistd.h>
+#     include <sys/mman.h>
+#  endif
 #endif
 
 #include "sio.h"
 
+#include "sha256.h"
+#include "threads.h"
 #include "utilities.h"
 
 //#define DEBUG
@@ -54,6 +64,120 @@ const char* const c_root_section = "sio";
 const int c_min_size_for_section = 4; //i.e. <x/> or </x>
 const int c_min_size_for_section_name = 2; //i.e. x/ or /x
 
+/* Compiled "sio" file format...
+
+header: magic (4 bytes), version, byte order marker, number of lines and flags (4 bytes each)
+        followed by the source file's modification time and size (8 bytes each) and then its
+        SHA256 hash (32 bytes)
+
+lines:  line size, start and finish positions (4 bytes each), line type and end of file flag
+        (1 byte each) followed by the line's characters
+
+*/
+
+const char* const c_compiled_ext = "c";
+const char* const c_compiled_magic = "SIOC";
+
+const uint32_t c_compiled_version = 1;
+const uint32_t c_compiled_byte_order = 0x01020304;
+
+const uint32_t c_compiled_flag_verify_hash = 1;
+
+// NOTE: If the source file was last modified this recently when it was compiled then its hash
+// will always be checked (as the time resolution may not be sufficient to detect a change).
+const int c_compiled_min_age_seconds = 2;
+
+const size_t c_compiled_header_size = 24 + 8 + 8 + 32;
+const size_t c_compiled_line_header_size = 14;
+
+volatile long g_compile_number = 0;
+
+struct compiled_header
+{
+   compiled_header( ) : num_lines( 0 ), flags( 0 ), source_mod( 0 ), source_size( 0 ) { memset( hash, 0, sizeof( hash ) ); }
+
+   uint32_t num_lines;
+   uint32_t flags;
+
+   int64_t source_mod;
+   int64_t source_size;
+
+   unsigned char hash[ 32 ];
+};
+
+void get_file_hash( const string& file_name, unsigned char* p_hash )
+{
+   sha256 hash;
+   hash.update( file_name, true );
+
+   hash.copy_digest_to_buffer( p_hash );
+}
+
+void write_compiled_header( string& data, const compiled_header& header )
+{
+   data.append( c_compiled_magic, 4 );
+
+   data.append( ( const char* )&c_compiled_version, sizeof( uint32_t ) );
+   data.append( ( const char* )&c_compiled_byte_order, sizeof( uint32_t ) );
+
+   data.append( ( const char* )&header.num_lines, sizeof( uint32_t ) );
+   data.append( ( const char* )&header.flags, sizeof( uint32_t ) );
+
+   data.append( 4, '\0' );
+
+   data.append( ( const char* )&header.source_mod, sizeof( int64_t ) );
+   data.append( ( const char* )&header.source_size, sizeof( int64_t ) );
+
+   data.append( ( const char* )header.hash, sizeof( header.hash ) );
+}
+
+bool read_compiled_header( const char* p_data, size_t size, compiled_header& header )
+{
+   if( size < c_compiled_header_size || memcmp( p_data, c_compiled_magic, 4 ) != 0 )
+      return false;
+
+   uint32_t version, byte_order;
+
+   memcpy( &version, p_data + 4, sizeof( uint32_t ) );
+   memcpy( &byte_order, p_data + 8, sizeof( uint32_t ) );
+
+   if( version != c_compiled_version || byte_order != c_compiled_byte_order )
+      return false;
+
+   memcpy( &header.num_lines, p_data + 12, sizeof( uint32_t ) );
+   memcpy( &header.flags, p_data + 16, sizeof( uint32_t ) );
+
+   memcpy( &header.source_mod, p_data + 24, sizeof( int64_t ) );
+   memcpy( &header.source_size, p_data + 32, sizeof( int64_t ) );
+
+   memcpy( header.hash, p_data + 40, sizeof( header.hash ) );
+
+   return true;
+}
+
+// NOTE: The compiled file is written to a temporary file and then renamed so that it will not
+// be read by another process before it has been completely written. If it cannot be written
+// (such as when the directory is read-only) then nothing is written (with the compiled data
+// simply being used in memory). As other threads in the same process may be writing the same
+// file at the same time the temporary file name includes the thread id and a per process
+// counter as well as the pid.
+void write_compiled_file( const string& compiled_name, const string& data )
+{
+   string temp_name( compiled_name + "." + to_string( get_pid( ) )
+    + "." + to_string( current_thread_id( ) ) + "." + to_string( atomic_increment( g_compile_number ) ) );
+
+   ofstream outf( temp_name.c_str( ), ios::out | ios::binary );
+
+   if( outf )
+   {
+      outf.write( data.data( ), data.size( ) );
+      outf.close( );
+
+      if( !outf.good( ) || !file_rename( temp_name, compiled_name ) )
+         file_remove( temp_name );
+   }
+}
+
 void write_section_attributes( sio_writer& writer, const section_node& node )
 {
    for( size_t i = 0; i < node.get_num_attributes( ); i++ )
@@ -70,18 +194,327 @@ void write_section_attributes( sio_writer& writer, const section_node& node )
 
 }
 
+struct sio_reader::compiled_data
+{
+   compiled_data( )
+    :
+    p_data( 0 ),
+    size( 0 ),
+    offset( c_compiled_header_size ),
+    had_eof( false ),
+    p_mapped( 0 )
+   {
+   }
+
+   ~compiled_data( )
+   {
+#ifndef _WIN32
+      if( p_mapped )
+         munmap( p_mapped, size );
+#endif
+   }
+
+   bool load( const string& file_name, const string& compiled_name );
+
+   bool check_lines( uint32_t num_lines ) const;
+
+   void compile( const string& file_name, const string& compiled_name );
+
+   void next_line( string& line, extra_type& line_type, size_t& start_pos, size_t& finish_pos );
+
+   const char* p_data;
+   size_t size;
+   size_t offset;
+
+   bool had_eof;
+
+   void* p_mapped;
+   string buffer;
+};
+
+bool sio_reader::compiled_data::load( const string& file_name, const string& compiled_name )
+{
+   if( !file_exists( compiled_name ) )
+      return false;
+
+#ifndef _WIN32
+   int fd = open( compiled_name.c_str( ), O_RDONLY );
+   if( fd < 0 )
+      return false;
+
+   int64_t compiled_size = file_size( compiled_name );
+
+   if( compiled_size > 0 )
+   {
+      void* p = mmap( 0, compiled_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+      if( p != MAP_FAILED )
+      {
+         p_mapped = p;
+
+         p_data = ( const char* )p;
+         size = compiled_size;
+      }
+   }
+
+   close( fd );
+
+   if( !p_mapped )
+      return false;
+#else
+   ifstream inpf( compiled_name.c_str( ), ios::in | ios::binary );
+   if( !inpf )
+      return false;
+
+   buffer.assign( istreambuf_iterator< char >( inpf ), istreambuf_iterator< char >( ) );
+
+   p_data = buffer.data( );
+   size = buffer.size( );
+#endif
+
+   compiled_header header;
+
+   if( !read_compiled_header( p_data, size, header ) || !check_lines( header.num_lines ) )
+      return false;
+
+   if( header.source_size != file_size( file_name ) )
+      return false;
+
+   int64_t source_mod = ( int64_t )last_modification_time( file_name );
+
+   if( header.source_mod != source_mod || ( header.flags & c_compiled_flag_verify_hash ) )
+   {
+      unsigned char hash[ 32 ];
+      get_file_hash( file_name, hash );
+
+      if( memcmp( hash, header.hash, sizeof( hash ) ) != 0 )
+         return false;
+
+      // NOTE: As the source file is unchanged the compiled file's header is rewritten (with the
+      // current modification time and the verify flag only if still required) so that the hash
+      // will not need to be checked again whenever the compiled file is next being loaded.
+      uint32_t flags = header.flags & ~c_compiled_flag_verify_hash;
+
+      if( time( 0 ) - ( time_t )source_mod < c_compiled_min_age_seconds )
+         flags |= c_compiled_flag_verify_hash;
+
+      if( header.source_mod != source_mod || header.flags != flags )
+      {
+         header.flags = flags;
+         header.source_mod = source_mod;
+
+         string data;
+         write_compiled_header( data, header );
+
+         data.append( p_data + c_compiled_header_size, size - c_compiled_header_size );
+
+         write_compiled_file( compiled_name, data );
+      }
+   }
+
+   return true;
+}
+
+// NOTE: Checks that the line records which follow the header exactly fill the compiled data so
+// that a truncated or otherwise damaged compiled file will be ignored (and the source re-read).
+bool sio_reader::compiled_data::check_lines( uint32_t num_lines ) const
+{
+   size_t next = c_compiled_header_size;
+
+   for( uint32_t i = 0; i < num_lines; i++ )
+   {
+      if( size - next < c_compiled_line_header_size )
+         return false;
+
+      uint32_t line_size, spos, fpos;
+
+      memcpy( &line_size, p_data + next, sizeof( uint32_t ) );
+      memcpy( &spos, p_data + next + 4, sizeof( uint32_t ) );
+      memcpy( &fpos, p_data + next + 8, sizeof( uint32_t ) );
+
+      unsigned char line_type = p_data[ next + 12 ];
+      unsigned char line_eof = p_data[ next + 13 ];
+
+      if( line_type > e_extra_type_unknown
+       || line_eof != ( i == num_lines - 1 ? 1 : 0 ) || spos > fpos || fpos > line_size )
+         return false;
+
+      next += c_compiled_line_header_size;
+
+      if( size - next < line_size )
+         return false;
+
+      next += line_size;
+   }
+
+   return num_lines && next == size;
+}
+
+void sio_reader::compiled_data::compile( const string& file_name, const string& compiled_name )
+{
+   compiled_header header;
+
+   header.source_mod = last_modification_time( file_name );
+   header.source_size = file_size( file_name );
+
+   get_file_hash( file_name, header.hash );
+
+   if( time( 0 ) - ( time_t )header.source_mod < c_compiled_min_age_seconds )
+      header.flags |= c_compiled_flag_verify_hash;
+
+   ifstream inpf( file_name.c_str( ) );
+   if( !inpf )
+      throw runtime_error( "unable to open file '" + file_name + "' for input" );
+
+   string lines;
+   string line;
+
+   // NOTE: The lines are read in the same manner as "sio_reader::read_line" (but including any
+   // comment lines) so that reading the compiled lines will behave identically.
+   while( !inpf.eof( ) )
+   {
+      ++header.num_lines;
+
+      if( getline( inpf, line ) && line.empty( ) )
+         throw runtime_error( "unexpected empty line #" + to_string( header.num_lines ) );
+
+      remove_trailing_cr_from_text_file_line( line, header.num_lines == 1 );
+
+      extra_type line_type;
+      size_t start_pos, finish_pos;
+
+      classify_line( line, line_type, start_pos, finish_pos );
+
+      uint32_t line_size = line.size( );
+      uint32_t spos = start_pos;
+      uint32_t fpos = finish_pos;
+
+      lines.append( ( const char* )&line_size, sizeof( uint32_t ) );
+      lines.append( ( const char* )&spos, sizeof( uint32_t ) );
+      lines.append( ( const char* )&fpos, sizeof( uint32_t ) );
+
+      lines += ( char )line_type;
+      lines += ( char )inpf.eof( );
+
+      lines += line;
+   }
+
+   write_compiled_header( buffer, header );
+   buffer += lines;
+
+   p_data = buffer.data( );
+   size = buffer.size( );
+
+   write_compiled_file( compiled_name, buffer );
+}
+
+void sio_reader::compiled_data::next_line(
+ string& line, extra_type& line_type, size_t& start_pos, size_t& finish_pos )
+{
+   if( offset + c_compiled_line_header_size > size )
+      throw runtime_error( "unexpected end of compiled data" );
+
+   uint32_t line_size, spos, fpos;
+
+   memcpy( &line_size, p_data + offset, sizeof( uint32_t ) );
+   memcpy( &spos, p_data + offset + 4, sizeof( uint32_t ) );
+   memcpy( &fpos, p_data + offset + 8, sizeof( uint32_t ) );
+
+   line_type = ( extra_type )p_data[ offset + 12 ];
+   had_eof = ( p_data[ offset + 13 ] != 0 );
+
+   offset += c_compiled_line_header_size;
+
+   if( offset + line_size > size )
+      throw runtime_error( "unexpected end of compiled data" );
+
+   line.assign( p_data + offset, line_size );
+   offset += line_size;
+
+   start_pos = spos;
+   finish_pos = fpos;
+}
+
 sio_reader::sio_reader( istream& is, bool include_comments )
  :
- is( is ),
- line_num( 0 ),
- start_pos( 0 ),
- finish_pos( 0 ),
+ p_is( &is ),
+ p_owned_is( 0 ),
+ p_compiled( 0 ),
  include_comments( include_comments )
 {
    if( !is.good( ) )
       throw runtime_error( "input stream is bad" );
 
-   if( !is.eof( ) )
+   init( );
+}
+
+sio_reader::sio_reader( const string& file_name, bool include_comments )
+ :
+ p_is( 0 ),
+ p_owned_is( 0 ),
+ p_compiled( 0 ),
+ include_comments( include_comments )
+{
+   string compiled_name( file_name + c_compiled_ext );
+
+   try
+   {
+      p_compiled = new compiled_data;
+
+      if( !p_compiled->load( file_name, compiled_name ) )
+      {
+         delete p_compiled;
+         p_compiled = 0;
+
+         p_compiled = new compiled_data;
+         p_compiled->compile( file_name, compiled_name );
+      }
+   }
+   catch( ... )
+   {
+      // NOTE: If unable to compile the file (such as if it is malformed) then it will instead be
+      // read directly (so that any errors will be reported in the same way as with a stream).
+      delete p_compiled;
+      p_compiled = 0;
+   }
+
+   if( !p_compiled )
+   {
+      p_owned_is = p_is = new ifstream( file_name.c_str( ) );
+
+      if( !*p_is )
+      {
+         delete p_owned_is;
+         throw runtime_error( "unable to open file '" + file_name + "' for input" );
+      }
+   }
+
+   try
+   {
+      init( );
+   }
+   catch( ... )
+   {
+      delete p_compiled;
+      delete p_owned_is;
+      throw;
+   }
+}
+
+sio_reader::~sio_reader( )
+{
+   delete p_compiled;
+   delete p_owned_is;
+}
+
+void sio_reader::init( )
+{
+   line_num = 0;
+   line_type = e_extra_type_unknown;
+
+   value_pos = start_pos = finish_pos = 0;
+
+   if( p_compiled || !p_is->eof( ) )
    {
       read_line( );
       if( !has_started_section( c_root_section ) )
@@ -91,7 +524,7 @@ sio_reader::sio_reader( istream& is, bool include_comments )
 
 sio_reader::operator sio_reader::bool_type( ) const
 {
-   if( !is || is.eof( ) )
+   if( p_compiled ? p_compiled->had_eof : ( !*p_is || p_is->eof( ) ) )
       return 0;
    else
       return &sio_reader::this_type_does_not_support_comparisons;
@@ -231,20 +664,35 @@ void sio_reader::read_line( )
 {
    while( true )
    {
-      if( is.eof( ) )
+      if( p_compiled ? p_compiled->had_eof : p_is->eof( ) )
          throw runtime_error( "unexpected end of file" );
 
       ++line_num;
 #ifdef DEBUG
       cout << "==> reading line #" << line_num << endl;
 #endif
-      if( getline( is, line ) && line.empty( ) )
-         throw runtime_error( "unexpected empty line #" + to_string( line_num ) );
+      bool had_eof;
 
-      remove_trailing_cr_from_text_file_line( line, line_num == 1 );
+      if( p_compiled )
+      {
+         p_compiled->next_line( line, line_type, start_pos, finish_pos );
+         had_eof = p_compiled->had_eof;
+      }
+      else
+      {
+         if( getline( *p_is, line ) && line.empty( ) )
+            throw runtime_error( "unexpected empty line #" + to_string( line_num ) );
+
+         remove_trailing_cr_from_text_file_line( line, line_num == 1 );
+
+         classify_line( line, line_type, start_pos, finish_pos );
+         had_eof = p_is->eof( );
+      }
+
+      value_pos = finish_pos + 2;
 
       string::size_type pos = line.find_first_not_of( " \t" );
-      if( is.eof( ) || include_comments || ( pos != string::npos && line[ pos ] != '#' ) ) // i.e. continue if is a comment
+      if( had_eof || include_comments || ( pos != string::npos && line[ pos ] != '#' ) ) // i.e. continue if is a comment
          break;
    }
 }
@@ -255,7 +703,26 @@ string sio_reader::get_line( )
    return line;
 }
 
-bool sio_reader::is_sio_identifier( const string& name, extra_type xtype ) const
+void sio_reader::classify_line( const string& line,
+ extra_type& line_type, size_t& start_pos, size_t& finish_pos )
+{
+   // NOTE: A line can only be of one type so its type (and the positions of its name and value)
+   // are determined just once rather than each time the line is checked for an identifier.
+   if( is_line_of_type( line, e_extra_type_start, start_pos, finish_pos ) )
+      line_type = e_extra_type_start;
+   else if( is_line_of_type( line, e_extra_type_finish, start_pos, finish_pos ) )
+      line_type = e_extra_type_finish;
+   else if( is_line_of_type( line, e_extra_type_neither, start_pos, finish_pos ) )
+      line_type = e_extra_type_neither;
+   else
+   {
+      line_type = e_extra_type_unknown;
+      start_pos = finish_pos = 0;
+   }
+}
+
+bool sio_reader::is_line_of_type( const string& line,
+ extra_type xtype, size_t& start_pos, size_t& finish_pos )
 {
    string::size_type spos, fpos;
 
@@ -263,11 +730,11 @@ bool sio_reader::is_sio_identifier( const string& name, extra_type xtype ) const
       return false;
 
    spos = line.find( c_basic_prefix );
-   if( line.size( ) - spos < c_min_size_for_section )
+   if( spos == string::npos || line.size( ) - spos < c_min_size_for_section )
       return false;
 
    fpos = line.find( c_basic_suffix, spos + 1 );
-   if( fpos - spos < c_min_size_for_section_name )
+   if( fpos == string::npos || fpos - spos < c_min_size_for_section_name )
       return false;
 
    for( string::size_type i = 0; i < spos; i++ )
@@ -324,18 +791,24 @@ bool sio_reader::is_sio_identifier( const string& name, extra_type xtype ) const
       }
    }
 
-   value_pos = fpos + 2;
-
    start_pos = spos;
    finish_pos = fpos;
 
+   return true;
+}
+
+bool sio_reader::is_sio_identifier( const string& name, extra_type xtype ) const
+{
+   if( line_type != xtype )
+      return false;
+
    if( name.empty( ) )
       return true;
 
-   if( name.size( ) != fpos - spos + 1 )
+   if( name.size( ) != finish_pos - start_pos + 1 )
       return false;
 
-   return name == line.substr( spos, fpos - spos + 1 );
+   return line.compare( start_pos, name.size( ), name ) == 0;
 }
 
 void dump_sio( sio_reader& reader, ostream* p_ostream )
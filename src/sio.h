@@ -28,6 +28,13 @@ class sio_reader
    public:
    sio_reader( std::istream& is, bool include_comments = false );
 
+   // NOTE: Reads the file using its compiled form (i.e. "<file_name>c") which is created or
+   // re-created if not found or not up to date (if it cannot be written then the file itself
+   // will be read instead).
+   sio_reader( const std::string& file_name, bool include_comments = false );
+
+   ~sio_reader( );
+
    operator bool_type( ) const;
 
    template< typename T > bool operator ==( const T& rhs ) const
@@ -70,20 +77,36 @@ class sio_reader
    size_t get_current_section_level( ) const { return sections.size( ); }
 
    private:
+   sio_reader( const sio_reader& );
+   sio_reader& operator =( const sio_reader& );
+
    enum extra_type
    {
       e_extra_type_start,
       e_extra_type_finish,
-      e_extra_type_neither
+      e_extra_type_neither,
+      e_extra_type_unknown
    };
 
+   void init( );
+
    void read_line( );
 
    std::string get_line( );
 
+   static void classify_line( const std::string& line,
+    extra_type& line_type, size_t& start_pos, size_t& finish_pos );
+
+   static bool is_line_of_type( const std::string& line,
+    extra_type xtype, size_t& start_pos, size_t& finish_pos );
+
    bool is_sio_identifier( const std::string& name, extra_type xtype ) const;
 
-   std::istream& is;
+   std::istream* p_is;
+   std::istream* p_owned_is;
+
+   struct compiled_data;
+   compiled_data* p_compiled;
 
    bool include_comments;
 
@@ -91,7 +114,8 @@ class sio_reader
    std::string line;
    std::stack< std::string > sections;
 
-   mutable size_t value_pos, start_pos, finish_pos;
+   extra_type line_type;
+   size_t value_pos, start_pos, finish_pos;
 };
 
 void dump_sio( sio_reader& reader, std::ostream* p_ostream = 0 );
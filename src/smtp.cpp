@@ -10,6 +10,7 @@
 #pragma hdrstop
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <cctype>
 #  include <memory.h>
 #  include <memory>
 #  include <iostream>
@@ -111,6 +112,8 @@ const char* const c_smtp_prefix_data = "354";
 
 const char* c_response_multi_terminator = ".";
 
+const size_t c_data_buffer_size = 16384;
+
 const size_t c_initial_timeout = 5000;
 const size_t c_subsequent_timeout = 1500;
 const size_t c_final_response_timeout = 500;
@@ -161,8 +164,10 @@ bool get_response( string& text, tcp_socket& socket,
             if( prefix != c_smtp_prefix_info && prefix != c_smtp_prefix_okay
              && prefix != c_smtp_prefix_auth && prefix != c_smtp_prefix_user && prefix != c_smtp_prefix_data )
                okay = false;
-            // NOTE: If the prefix is followed by a "space" then no further lines are expected.
-            else if( response[ c_smtp_prefix_length ] == ' ' )
+
+            // NOTE: If the prefix is followed by a "space" then no further lines are expected
+            // (this applies to errors as well so a pipelined response will not be consumed).
+            if( response[ c_smtp_prefix_length ] == ' ' )
                break;
          }
          else
@@ -306,432 +311,746 @@ string transform_header_to_utf_8_if_required( const string& header )
       return header.substr( 0, start + 1 ) + "=?utf-8?B?" + base64::encode( header.substr( start + 1 ) ) + "?=";
 }
 
-void send_message( const string& host_and_port,
- const smtp_user_info& user_info, const vector< string >& recipients,
- const string& subject, const string* p_message = 0, const vector< string >* p_extra_headers = 0,
- const vector< string >* p_file_names = 0, const string* p_html = 0, const vector< string >* p_image_names = 0,
- const string* p_image_path_prefix = 0, progress* p_progress = 0 )
+void check_attached_files( const vector< string >& file_names, const smtp_user_info& user_info, progress* p_progress )
 {
-   int port = c_smtp_default_port;
+   int64_t num_bytes = INT64_C( 0 );
 
-   string host( host_and_port );
-
-   string::size_type pos = host.find( ':' );
-   if( pos != string::npos )
+   for( size_t i = 0; i < file_names.size( ); i++ )
    {
-      port = atoi( host.substr( pos + 1 ).c_str( ) );
-      host.erase( pos );
+      string next_file( file_names[ i ] );
+
+      string::size_type pos = next_file.find( '?' );
+      if( pos != string::npos )
+         next_file.erase( 0, pos + 1 );
+
+      if( !file_exists( next_file ) )
+         throw runtime_error( "file '" + next_file + "' not found" );
+
+      num_bytes += file_size( next_file );
    }
 
    if( p_progress )
-      p_progress->output_progress( "host = " + host + ", port = " + to_string( port ) );
+      p_progress->output_progress( "total attached file data: " + to_string( num_bytes ) );
 
-   if( p_file_names )
+   if( user_info.max_attachment_bytes && num_bytes > user_info.max_attachment_bytes )
+      throw runtime_error( "maximum allowed attached file data exceeded" );
+}
+
+bool has_extension( const string& ehlo_response, const char* p_extension )
+{
+   vector< string > lines;
+   split( ehlo_response, lines, '\n' );
+
+   // NOTE: The first line is the greeting with each following line (after the prefix and
+   // separator) being the name of an extension followed by any optional parameters.
+   for( size_t i = 1; i < lines.size( ); i++ )
+   {
+      string next( lines[ i ] );
+
+      if( next.size( ) <= c_smtp_prefix_length )
+         continue;
+
+      next.erase( 0, c_smtp_prefix_length + 1 );
+
+      string::size_type pos = next.find( ' ' );
+      if( pos != string::npos )
+         next.erase( pos );
+
+      if( upper( next ) == p_extension )
+         return true;
+   }
+
+   return false;
+}
+
+void write_message_data( ostream& os, const smtp_message& message,
+ const smtp_user_info& user_info, const string& to_header, const string& cc_header )
+{
+   string from_header( "From: " );
+   from_header += user_info.address;
+
+   string subject_header( "Subject: " );
+   subject_header += message.subject;
+
+   string str( transform_header_to_utf_8_if_required( from_header ) );
+   str += string( "\r\n" );
+
+   str += transform_header_to_utf_8_if_required( subject_header );
+   str += string( "\r\n" );
+
+   str += transform_header_to_utf_8_if_required( to_header );
+   str += string( "\r\n" );
+
+   if( !cc_header.empty( ) )
+   {
+      str += transform_header_to_utf_8_if_required( cc_header );
+      str += string( "\r\n" );
+   }
+
+   date_time dt( date_time::standard( ) );
+
+   if( user_info.p_dt )
+      dt = *user_info.p_dt;
+
+   string date_header( "Date: " );
+   date_header += dt.weekday_name( ).substr( 0, 3 );
+   date_header += ", " + to_string( ( int )dt.get_day( ) ) + " " + dt.month_name( ).substr( 0, 3 );
+   date_header += " " + to_string( dt.get_year( ) );
+   date_header += " " + dt.get_time( ).as_string( e_time_format_hhmmss, true );
+
+   if( user_info.utc_offset >= 0 )
+      date_header += " +";
+   else
+      date_header += " -";
+
+   if( abs( user_info.utc_offset ) < 10 )
+      date_header += "0";
+   date_header += to_string( ( int )user_info.utc_offset );
+
+   int minutes = ( int )( ( user_info.utc_offset - ( int )user_info.utc_offset ) * 60.0 );
+
+   if( abs( minutes ) < 10 )
+      date_header += "0";
+   date_header += to_string( minutes );
+
+   if( user_info.p_tz_abbr && !user_info.p_tz_abbr->empty( ) )
+      date_header += " (" + *user_info.p_tz_abbr + ")";
+
+   str += date_header;
+   str += string( "\r\n" );
+
+   // NOTE: It is being assumed that if extra headers were supplied
+   // then Message-ID is amongst them.
+   if( message.extra_headers.empty( ) )
    {
-      int64_t num_bytes = INT64_C( 0 );
+      string message_id_header( "Message-ID: <" );
+      message_id_header += uuid( ).as_string( ) + ">";
 
-      for( size_t i = 0; i < p_file_names->size( ); i++ )
+      str += message_id_header;
+      str += string( "\r\n" );
+   }
+   else
+   {
+      for( size_t i = 0; i < message.extra_headers.size( ); i++ )
       {
-         string next_file( ( *p_file_names )[ i ] );
+         if( !message.extra_headers[ i ].empty( ) )
+         {
+            str += transform_header_to_utf_8_if_required( message.extra_headers[ i ] );
+            str += string( "\r\n" );
+         }
+      }
+   }
+
+   auto_ptr< mime_encoder > ap_mime;
 
-         string::size_type pos = next_file.find( '?' );
-         if( pos != string::npos )
-            next_file.erase( 0, pos + 1 );
+   bool has_html = !message.html.empty( );
+   bool has_files = !message.file_names.empty( );
+   bool has_images = !message.image_names.empty( );
+   bool has_message = !message.message.empty( );
 
-         if( !file_exists( next_file ) )
-            throw runtime_error( "file '" + next_file + "' not found" );
+   const char* p_charset = 0;
+   if( user_info.p_charset )
+      p_charset = user_info.p_charset->c_str( );
 
-         num_bytes += file_size( next_file );
+   const string* p_message = &message.message;
+
+   string extracted_message;
+   if( has_html && !has_message )
+   {
+      extracted_message = extract_text_from_html( message.html );
+      p_message = &extracted_message;
+      has_message = true;
+   }
+
+   // NOTE: If there is HTML or attached files then format the message as MIME.
+   if( has_html || has_files )
+   {
+      ap_mime.reset( new mime_encoder( ) );
+
+      if( has_html )
+      {
+         if( has_images )
+         {
+            ap_mime->create_child( "related" );
+
+            if( !has_message )
+               ap_mime->get_child( ).add_html( message.html, p_charset );
+            else
+            {
+               ap_mime->get_child( ).create_child( "alternative" );
+               ap_mime->get_child( ).get_child( ).add_text( *p_message, p_charset );
+               ap_mime->get_child( ).get_child( ).add_html( message.html, p_charset );
+            }
+
+            const char* p_path_prefix = 0;
+            if( !message.image_path_prefix.empty( ) )
+               p_path_prefix = message.image_path_prefix.c_str( );
+
+            for( size_t i = 0; i < message.image_names.size( ); i++ )
+               ap_mime->get_child( ).add_image( message.image_names[ i ], p_path_prefix );
+         }
+         else
+         {
+            if( !has_message )
+               ap_mime->add_html( message.html, p_charset );
+            else
+            {
+               ap_mime->create_child( "related" );
+               ap_mime->get_child( ).create_child( "alternative" );
+               ap_mime->get_child( ).get_child( ).add_text( *p_message, p_charset );
+               ap_mime->get_child( ).get_child( ).add_html( message.html, p_charset );
+            }
+         }
       }
+      else if( has_message )
+         ap_mime->add_text( *p_message, p_charset );
 
-      if( p_progress )
-         p_progress->output_progress( "total attached file data: " + to_string( num_bytes ) );
+      if( has_files )
+      {
+         for( size_t i = 0; i < message.file_names.size( ); i++ )
+            ap_mime->add_file( message.file_names[ i ] );
+      }
+
+      os << str;
+
+      // NOTE: Any attached files are encoded as they are being written.
+      ap_mime->write_data( os );
+   }
+   else
+   {
+      // NOTE: Limit the lines to one less than the maximum as a fullstop escape character
+      // may be required at the start of one or more lines.
+      string message_text( split_input_into_lines( *p_message, c_max_chars_per_line - 1 ) );
+
+      str += string( "\r\n" );
+      str += escape_fullstops_if_required( message_text );
+      str += string( "\r\n" );
+
+      os << str;
+   }
+
+   os << ".\r\n";
+}
+
+// NOTE: Buffers message data that is being written to an SMTP socket (so that the whole
+// message does not need to be constructed in memory before being sent).
+class smtp_data_buffer : public streambuf
+{
+   public:
+   smtp_data_buffer( tcp_socket& socket )
+    :
+    socket( socket ),
+    failed( false )
+   {
+      setp( buffer, buffer + sizeof( buffer ) );
+   }
+
+   bool has_failed( ) const { return failed; }
+
+   protected:
+   int_type overflow( int_type c );
+
+   int sync( );
+
+   private:
+   bool send_buffer( );
+
+   tcp_socket& socket;
+
+   bool failed;
+   char buffer[ c_data_buffer_size ];
+};
 
-      if( user_info.max_attachment_bytes && num_bytes > user_info.max_attachment_bytes )
-         throw runtime_error( "maximum allowed attached file data exceeded" );
+smtp_data_buffer::int_type smtp_data_buffer::overflow( int_type c )
+{
+   if( !send_buffer( ) )
+      return traits_type::eof( );
+
+   if( !traits_type::eq_int_type( c, traits_type::eof( ) ) )
+   {
+      *pptr( ) = traits_type::to_char_type( c );
+      pbump( 1 );
+   }
+
+   return traits_type::not_eof( c );
+}
+
+int smtp_data_buffer::sync( )
+{
+   return send_buffer( ) ? 0 : -1;
+}
+
+bool smtp_data_buffer::send_buffer( )
+{
+   int n = pptr( ) - pbase( );
+
+   if( n && !failed && socket.send_n( ( const unsigned char* )pbase( ), n ) != n )
+      failed = true;
+
+   setp( buffer, buffer + sizeof( buffer ) );
+
+   return !failed;
+}
+
+}
+
+struct smtp_connection::impl
+{
+   impl( const smtp_user_info& user_info, progress* p_progress )
+    :
+    user_info( user_info ),
+    p_progress( p_progress ),
+    okay( false ),
+    pipelining( false ),
+    num_sent( 0 )
+   {
    }
 
+   void connect( const string& host_and_port );
+
+   void check_response( string& str, size_t timeout = c_initial_timeout );
+
+   void reset( );
+
 #ifdef SSL_SUPPORT
    ssl_socket socket;
 #else
    tcp_socket socket;
 #endif
-   bool okay = socket.open( );
-   if( okay )
+
+   smtp_user_info user_info;
+   progress* p_progress;
+
+   bool okay;
+   bool pipelining;
+
+   size_t num_sent;
+};
+
+void smtp_connection::impl::connect( const string& host_and_port )
+{
+   int port = c_smtp_default_port;
+
+   string host( host_and_port );
+
+   string::size_type pos = host.find( ':' );
+   if( pos != string::npos )
    {
-      ip_address address( host.c_str( ), port );
+      port = atoi( host.substr( pos + 1 ).c_str( ) );
+      host.erase( pos );
+   }
 
-      if( p_progress )
-         p_progress->output_progress( "connecting..." );
+   if( p_progress )
+      p_progress->output_progress( "host = " + host + ", port = " + to_string( port ) );
+
+   if( !socket.open( ) )
+      throw runtime_error( "unable to open socket" );
+
+   ip_address address( host.c_str( ), port );
+
+   if( p_progress )
+      p_progress->output_progress( "connecting..." );
+
+   if( !socket.connect( address ) )
+      throw runtime_error( "unable to connect to '" + host + "' on port #" + to_string( port ) );
 
-      if( socket.connect( address ) )
-      {
 #ifdef USE_NO_DELAY
-         socket.set_no_delay( );
+   socket.set_no_delay( );
 #endif
 #ifdef SSL_SUPPORT
-         // NOTE: For SSL all protocol is secure (unlike STARTTLS).
-         // FUTURE: After a successful SSL connection the server certificate should
-         // be checked (at the very least make sure that it is the host requested).
-         if( user_info.use_ssl )
-            socket.ssl_connect( );
+   // NOTE: For SSL all protocol is secure (unlike STARTTLS).
+   // FUTURE: After a successful SSL connection the server certificate should
+   // be checked (at the very least make sure that it is the host requested).
+   if( user_info.use_ssl )
+      socket.ssl_connect( );
 #endif
-         string str( "(connected now reading greeting)" );
+   string str( "(connected now reading greeting)" );
 
-         // NOTE: Read (and ignore) the connection message...
-         if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-            throw runtime_error( str );
+   // NOTE: Read (and ignore) the connection message...
+   check_response( str );
 
-         if( user_info.auth_type == e_smtp_auth_type_none )
-         {
-            str = string( "HELO " );
-            str += user_info.domain;
-            socket.write_line( str );
+   if( user_info.auth_type == e_smtp_auth_type_none )
+   {
+      str = string( "HELO " );
+      str += user_info.domain;
+      socket.write_line( str );
 
-            if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-               throw runtime_error( str );
-         }
-         else
-         {
-            str = string( "EHLO " );
-            str += user_info.domain;
-            socket.write_line( str );
+      check_response( str );
+   }
+   else
+   {
+      str = string( "EHLO " );
+      str += user_info.domain;
+      socket.write_line( str );
 
-            if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-               throw runtime_error( str );
+      check_response( str );
 
 #ifdef SSL_SUPPORT
-            // NOTE: For STARTTLS the initial EHLO is unsecure (enabling it to be
-            // compatible with non-secure SMTP) and therefore needs to be re-sent
-            // after the connection is secured.
-            if( !user_info.use_ssl && user_info.use_tls )
-            {
-               str = "STARTTLS";
-               socket.write_line( str );
+      // NOTE: For STARTTLS the initial EHLO is unsecure (enabling it to be
+      // compatible with non-secure SMTP) and therefore needs to be re-sent
+      // after the connection is secured.
+      if( !user_info.use_ssl && user_info.use_tls )
+      {
+         str = "STARTTLS";
+         socket.write_line( str );
 
-               if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-                  throw runtime_error( str );
+         check_response( str );
 
-               // FUTURE: After a successful SSL connection the server certificate should
-               // be checked (at the very least make sure that it is the host requested).
-               socket.ssl_connect( );
+         // FUTURE: After a successful SSL connection the server certificate should
+         // be checked (at the very least make sure that it is the host requested).
+         socket.ssl_connect( );
 
-               str = string( "EHLO " );
-               str += user_info.domain;
-               socket.write_line( str );
+         str = string( "EHLO " );
+         str += user_info.domain;
+         socket.write_line( str );
 
-               if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-                  throw runtime_error( str );
-            }
+         check_response( str );
+      }
 #endif
-            if( user_info.auth_type == e_smtp_auth_type_plain )
-            {
-               str = string( "AUTH PLAIN " );
+      pipelining = has_extension( str, "PIPELINING" );
 
-               string auth_str( user_info.username );
-               auth_str += '\0';
-               auth_str += user_info.username;
-               auth_str += '\0';
-               auth_str += user_info.password;
+      if( user_info.auth_type == e_smtp_auth_type_plain )
+      {
+         str = string( "AUTH PLAIN " );
 
-               str += base64::encode( auth_str );
-            }
-            else if( user_info.auth_type == e_smtp_auth_type_login )
-               str = string( "AUTH LOGIN" );
-            else if( user_info.auth_type == e_smtp_auth_type_cram_md5 )
-               str = string( "AUTH CRAM-MD5" );
-            else
-               throw runtime_error( "unexpected smtp_auth_type in send_message" );
+         string auth_str( user_info.username );
+         auth_str += '\0';
+         auth_str += user_info.username;
+         auth_str += '\0';
+         auth_str += user_info.password;
 
+         str += base64::encode( auth_str );
+      }
+      else if( user_info.auth_type == e_smtp_auth_type_login )
+         str = string( "AUTH LOGIN" );
+      else if( user_info.auth_type == e_smtp_auth_type_cram_md5 )
+         str = string( "AUTH CRAM-MD5" );
+      else
+         throw runtime_error( "unexpected smtp_auth_type in smtp_connection" );
+
+      socket.write_line( str );
+
+      // NOTE: Don't allow progress tracking to see the password.
+      str.erase( );
+
+      check_response( str );
+
+      if( user_info.auth_type != e_smtp_auth_type_plain )
+      {
+         if( user_info.auth_type == e_smtp_auth_type_login )
+         {
+            str = base64::encode( user_info.username );
+            socket.write_line( str );
+
+            check_response( str );
+
+            str = base64::encode( user_info.password );
             socket.write_line( str );
 
             // NOTE: Don't allow progress tracking to see the password.
             str.erase( );
 
-            if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-               throw runtime_error( str );
+            check_response( str );
+         }
+         else if( user_info.auth_type == e_smtp_auth_type_cram_md5 )
+         {
+            str = determine_challenge_response( str, user_info.username, user_info.password );
+            socket.write_line( str );
 
-            if( user_info.auth_type != e_smtp_auth_type_plain )
-            {
-               if( user_info.auth_type == e_smtp_auth_type_login )
-               {
-                  str = base64::encode( user_info.username );
-                  socket.write_line( str );
-
-                  if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-                     throw runtime_error( str );
-
-                  str = base64::encode( user_info.password );
-                  socket.write_line( str );
-
-                  // NOTE: Don't allow progress tracking to see the password.
-                  str.erase( );
-
-                  if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-                     throw runtime_error( str );
-               }
-               else if( user_info.auth_type == e_smtp_auth_type_cram_md5 )
-               {
-                  str = determine_challenge_response( str, user_info.username, user_info.password );
-                  socket.write_line( str );
-
-                  // NOTE: Don't allow progress tracking to see the password.
-                  str.erase( );
-
-                  if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-                     throw runtime_error( str );
-               }
-            }
+            // NOTE: Don't allow progress tracking to see the password.
+            str.erase( );
+
+            check_response( str );
          }
+      }
+   }
 
-         str = string( "MAIL FROM:" );
-         string from_header( "From: " );
+   okay = true;
+}
 
-         string::size_type pos = user_info.address.find( '<' );
-         if( pos == string::npos )
-            str += "<" + user_info.address + ">\r\n";
-         else
-            str += user_info.address.substr( pos ) + "\r\n";
+void smtp_connection::impl::check_response( string& str, size_t timeout )
+{
+   if( !get_response( str, socket, timeout, p_progress ) )
+      throw runtime_error( str );
+}
 
-         socket.write_line( str );
+void smtp_connection::impl::reset( )
+{
+   string str( "RSET" );
+   socket.write_line( str );
 
-         from_header += user_info.address;
+   // NOTE: If the transaction cannot be reset then the connection is no longer usable.
+   if( !get_response( str, socket, c_initial_timeout, p_progress ) )
+      okay = false;
+}
 
-         if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-            throw runtime_error( str );
+smtp_connection::smtp_connection( const string& host_and_port, const smtp_user_info& user_info, progress* p_progress )
+{
+   auto_ptr< impl > ap_impl( new impl( user_info, p_progress ) );
 
-         string to_header, cc_header;
+   ap_impl->connect( host_and_port );
 
-         bool is_to = true;
-         bool is_cc = false;
-         for( size_t i = 0; i < recipients.size( ); i++ )
-         {
-            // NOTE: A "blank" recipient is used to separate the "To" header from the "Cc" one (any
-            // further "blank" recipient will cause subsequent recipients to be considered as "Bcc").
-            if( recipients[ i ].empty( ) )
-            {
-               if( !is_cc )
-               {
-                  is_to = false;
-                  is_cc = true;
-               }
-               else
-                  is_cc = false;
-
-               continue;
-            }
+   p_impl = ap_impl.release( );
+}
 
-            str = string( "RCPT TO:" );
+smtp_connection::~smtp_connection( )
+{
+   try
+   {
+      quit( );
+   }
+   catch( ... )
+   {
+   }
 
-            pos = recipients[ i ].find( '<' );
-            if( pos == string::npos )
-               str += "<" + recipients[ i ] + ">\r\n";
-            else
-               str += recipients[ i ].substr( pos ) + "\r\n";
+   delete p_impl;
+}
 
-            socket.write_line( str );
+bool smtp_connection::is_okay( ) const
+{
+   return p_impl->okay;
+}
 
-            if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-               throw runtime_error( str );
+bool smtp_connection::has_pipelining( ) const
+{
+   return p_impl->pipelining;
+}
 
-            if( is_to )
-            {
-               if( !to_header.empty( ) )
-                  to_header += ", ";
-               else
-                  to_header = "To: ";
+size_t smtp_connection::get_num_sent( ) const
+{
+   return p_impl->num_sent;
+}
 
-               to_header += recipients[ i ];
-            }
-            else if( is_cc )
-            {
-               if( !cc_header.empty( ) )
-                  cc_header += ", ";
-               else
-                  cc_header = "Cc: ";
+void smtp_connection::send( const smtp_message& message, const smtp_user_info* p_header_info )
+{
+   if( !p_impl->okay )
+      throw runtime_error( "smtp connection is no longer usable" );
 
-               cc_header += recipients[ i ];
-            }
-         }
+   if( !p_header_info )
+      p_header_info = &p_impl->user_info;
 
-         str = string( "DATA\r\n" );
-         socket.write_line( str );
+   if( !message.file_names.empty( ) )
+      check_attached_files( message.file_names, *p_header_info, p_impl->p_progress );
 
-         if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-            throw runtime_error( str );
+   vector< string > commands;
 
-         string subject_header( "Subject: " );
-         subject_header += subject;
+   string str( "MAIL FROM:" );
 
-         str = transform_header_to_utf_8_if_required( from_header );
-         str += string( "\r\n" );
+   string::size_type pos = p_impl->user_info.address.find( '<' );
+   if( pos == string::npos )
+      str += "<" + p_impl->user_info.address + ">\r\n";
+   else
+      str += p_impl->user_info.address.substr( pos ) + "\r\n";
 
-         str += transform_header_to_utf_8_if_required( subject_header );
-         str += string( "\r\n" );
+   commands.push_back( str );
 
-         str += transform_header_to_utf_8_if_required( to_header );
-         str += string( "\r\n" );
+   string to_header, cc_header;
 
-         if( !cc_header.empty( ) )
+   bool is_to = true;
+   bool is_cc = false;
+   for( size_t i = 0; i < message.recipients.size( ); i++ )
+   {
+      const string& recipient( message.recipients[ i ] );
+
+      // NOTE: A "blank" recipient is used to separate the "To" header from the "Cc" one (any
+      // further "blank" recipient will cause subsequent recipients to be considered as "Bcc").
+      if( recipient.empty( ) )
+      {
+         if( !is_cc )
          {
-            str += transform_header_to_utf_8_if_required( cc_header );
-            str += string( "\r\n" );
+            is_to = false;
+            is_cc = true;
          }
+         else
+            is_cc = false;
 
-         date_time dt( date_time::standard( ) );
+         continue;
+      }
 
-         if( user_info.p_dt )
-            dt = *user_info.p_dt;
+      str = string( "RCPT TO:" );
+
+      pos = recipient.find( '<' );
+      if( pos == string::npos )
+         str += "<" + recipient + ">\r\n";
+      else
+         str += recipient.substr( pos ) + "\r\n";
 
-         string date_header( "Date: " );
-         date_header += dt.weekday_name( ).substr( 0, 3 );
-         date_header += ", " + to_string( ( int )dt.get_day( ) ) + " " + dt.month_name( ).substr( 0, 3 );
-         date_header += " " + to_string( dt.get_year( ) );
-         date_header += " " + dt.get_time( ).as_string( e_time_format_hhmmss, true );
+      commands.push_back( str );
 
-         if( user_info.utc_offset >= 0 )
-            date_header += " +";
+      if( is_to )
+      {
+         if( !to_header.empty( ) )
+            to_header += ", ";
          else
-            date_header += " -";
+            to_header = "To: ";
 
-         if( abs( user_info.utc_offset ) < 10 )
-            date_header += "0";
-         date_header += to_string( ( int )user_info.utc_offset );
+         to_header += recipient;
+      }
+      else if( is_cc )
+      {
+         if( !cc_header.empty( ) )
+            cc_header += ", ";
+         else
+            cc_header = "Cc: ";
 
-         int minutes = ( int )( ( user_info.utc_offset - ( int )user_info.utc_offset ) * 60.0 );
+         cc_header += recipient;
+      }
+   }
 
-         if( abs( minutes ) < 10 )
-            date_header += "0";
-         date_header += to_string( minutes );
+   commands.push_back( "DATA\r\n" );
 
-         if( user_info.p_tz_abbr && !user_info.p_tz_abbr->empty( ) )
-            date_header += " (" + *user_info.p_tz_abbr + ")";
+   tcp_socket& socket( p_impl->socket );
+   progress* p_progress = p_impl->p_progress;
 
-         str += date_header;
-         str += string( "\r\n" );
+   string error;
 
-         // NOTE: It is being assumed that if extra headers were supplied
-         // then Message-ID is amongst them.
-         if( !p_extra_headers )
-         {
-            string message_id_header( "Message-ID: <" );
-            message_id_header += uuid( ).as_string( ) + ">";
+   // NOTE: If pipelining then all of the commands up to and including DATA are written
+   // together and then each response is read (in the same order as the commands were).
+   if( p_impl->pipelining )
+   {
+      string all_commands;
+      for( size_t i = 0; i < commands.size( ); i++ )
+         all_commands += commands[ i ];
 
-            str += message_id_header;
-            str += string( "\r\n" );
-         }
-         else
-         {
-            for( size_t i = 0; i < p_extra_headers->size( ); i++ )
-            {
-               if( !( *p_extra_headers )[ i ].empty( ) )
-               {
-                  str += transform_header_to_utf_8_if_required( ( *p_extra_headers )[ i ] );
-                  str += string( "\r\n" );
-               }
-            }
-         }
+      socket.write_line( all_commands );
 
-         auto_ptr< mime_encoder > ap_mime;
+      bool data_accepted = false;
 
-         bool has_html = ( p_html && !p_html->empty( ) );
-         bool has_files = ( p_file_names && !p_file_names->empty( ) );
-         bool has_images = ( p_image_names && !p_image_names->empty( ) );
-         bool has_message = ( p_message && !p_message->empty( ) );
+      for( size_t i = 0; i < commands.size( ); i++ )
+      {
+         str = commands[ i ];
 
-         const char* p_charset = 0;
-         if( user_info.p_charset )
-            p_charset = user_info.p_charset->c_str( );
+         if( get_response( str, socket, c_initial_timeout, p_progress ) )
+            data_accepted = ( i == commands.size( ) - 1 );
+         else if( error.empty( ) )
+            error = str;
+      }
 
-         string extracted_message;
-         if( has_html && !has_message )
+      // NOTE: If DATA was accepted even though an earlier command had failed then the only
+      // way to prevent a message from being delivered to the recipients that were accepted
+      // is to abandon the connection (so it will no longer be usable).
+      if( !error.empty( ) && data_accepted )
+      {
+         p_impl->okay = false;
+         socket.close( );
+
+         throw runtime_error( error );
+      }
+   }
+   else
+   {
+      for( size_t i = 0; i < commands.size( ); i++ )
+      {
+         str = commands[ i ];
+         socket.write_line( str );
+
+         if( !get_response( str, socket, c_initial_timeout, p_progress ) )
          {
-            extracted_message = extract_text_from_html( *p_html );
-            p_message = &extracted_message;
-            has_message = true;
+            error = str;
+            break;
          }
+      }
+   }
 
-         // NOTE: If there is HTML or attached files then format the message as MIME.
-         if( has_html || has_files )
-         {
-            ap_mime.reset( new mime_encoder( ) );
+   if( error.empty( ) )
+   {
+      smtp_data_buffer buffer( socket );
+      ostream os( &buffer );
 
-            if( has_html )
-            {
-               if( has_images )
-               {
-                  ap_mime->create_child( "related" );
-
-                  if( !has_message )
-                     ap_mime->get_child( ).add_html( *p_html, p_charset );
-                  else
-                  {
-                     ap_mime->get_child( ).create_child( "alternative" );
-                     ap_mime->get_child( ).get_child( ).add_text( *p_message, p_charset );
-                     ap_mime->get_child( ).get_child( ).add_html( *p_html, p_charset );
-                  }
-
-                  const char* p_path_prefix = 0;
-                  if( p_image_path_prefix )
-                     p_path_prefix = ( *p_image_path_prefix ).c_str( );
-
-                  for( size_t i = 0; i < p_image_names->size( ); i++ )
-                     ap_mime->get_child( ).add_image( ( *p_image_names )[ i ], p_path_prefix );
-               }
-               else
-               {
-                  if( !has_message )
-                     ap_mime->add_html( *p_html, p_charset );
-                  else
-                  {
-                     ap_mime->create_child( "related" );
-                     ap_mime->get_child( ).create_child( "alternative" );
-                     ap_mime->get_child( ).get_child( ).add_text( *p_message, p_charset );
-                     ap_mime->get_child( ).get_child( ).add_html( *p_html, p_charset );
-                  }
-               }
-            }
-            else if( has_message )
-               ap_mime->add_text( *p_message, p_charset );
+      // NOTE: As the message data is being sent while it is being constructed (such as when
+      // reading an attached file) any failure leaves the connection in an unusable state.
+      try
+      {
+         write_message_data( os, message, *p_header_info, to_header, cc_header );
 
-            if( has_files )
-            {
-               for( size_t i = 0; i < p_file_names->size( ); i++ )
-                  ap_mime->add_file( ( *p_file_names )[ i ] );
-            }
+         os.flush( );
+         if( buffer.has_failed( ) )
+            throw runtime_error( "unexpected failure sending message data" );
+      }
+      catch( ... )
+      {
+         p_impl->okay = false;
+         socket.close( );
 
-            str += ap_mime->get_data( );
-         }
-         else if( p_message )
-         {
-            // NOTE: Limit the lines to one less than the maximum as a fullstop escape character
-            // may be required at the start of one or more lines.
-            string message_text( split_input_into_lines( *p_message, c_max_chars_per_line - 1 ) );
+         throw;
+      }
 
-            str += string( "\r\n" );
-            str += escape_fullstops_if_required( message_text );
-            str += string( "\r\n" );
-         }
+      str.erase( );
+      if( !get_response( str, socket, c_initial_timeout, p_progress ) )
+         error = str;
+   }
 
-         str += string( ".\r\n" );
-         socket.write_line( str );
+   if( !error.empty( ) )
+   {
+      p_impl->reset( );
+      throw runtime_error( error );
+   }
 
-         if( !get_response( str, socket, c_initial_timeout, p_progress ) )
-            throw runtime_error( str );
+   ++p_impl->num_sent;
+}
 
-         str = "QUIT\r\n";
-         socket.write_line( str );
+void smtp_connection::quit( )
+{
+   if( p_impl->okay )
+   {
+      p_impl->okay = false;
 
-         // NOTE: Read (and ignore) the disconnection message...
-         get_response( str, socket, c_final_response_timeout, p_progress );
-      }
-      else
-         throw runtime_error( "unable to connect to '" + host + "' on port #" + to_string( port ) );
+      string str( "QUIT\r\n" );
+      p_impl->socket.write_line( str );
+
+      // NOTE: Read (and ignore) the disconnection message...
+      get_response( str, p_impl->socket, c_final_response_timeout, p_impl->p_progress );
    }
-   else
-      throw runtime_error( "unable to open socket" );
 }
 
+namespace
+{
+
+void send_message( const string& host_and_port,
+ const smtp_user_info& user_info, const vector< string >& recipients,
+ const string& subject, const string* p_message = 0, const vector< string >* p_extra_headers = 0,
+ const vector< string >* p_file_names = 0, const string* p_html = 0, const vector< string >* p_image_names = 0,
+ const string* p_image_path_prefix = 0, progress* p_progress = 0 )
+{
+   smtp_message message;
+
+   message.recipients = recipients;
+   message.subject = subject;
+
+   if( p_message )
+      message.message = *p_message;
+
+   if( p_html )
+      message.html = *p_html;
+
+   if( p_extra_headers )
+      message.extra_headers = *p_extra_headers;
+
+   if( p_file_names )
+   {
+      message.file_names = *p_file_names;
+
+      // NOTE: Check the attached files before attempting to connect.
+      check_attached_files( message.file_names, user_info, p_progress );
+   }
+
+   if( p_image_names )
+      message.image_names = *p_image_names;
+
+   if( p_image_path_prefix )
+      message.image_path_prefix = *p_image_path_prefix;
+
+   smtp_connection connection( host_and_port, user_info, p_progress );
+
+   connection.send( message );
+}
+
+}
+
+bool is_permanent_smtp_failure( const string& error )
+{
+   return error.size( ) > c_smtp_prefix_length && error[ 0 ] == '5'
+    && isdigit( error[ 1 ] ) && isdigit( error[ 2 ] ) && ( error[ 3 ] == ' ' || error[ 3 ] == '-' );
 }
 
 string html_to_text( const string& html )
@@ -114,8 +114,52 @@ struct smtp_user_info
    int64_t max_attachment_bytes;
 };
 
+struct smtp_message
+{
+   std::vector< std::string > recipients;
+
+   std::string subject;
+   std::string message;
+   std::string html;
+
+   std::vector< std::string > extra_headers;
+   std::vector< std::string > file_names;
+   std::vector< std::string > image_names;
+
+   std::string image_path_prefix;
+};
+
+// NOTE: A connection is established and authenticated once and can then be used to send any number of
+// messages (with the MAIL/RCPT/DATA commands being pipelined if the server supports this). If a message
+// is rejected by the server the transaction is reset so the connection can still be used for the next.
+class smtp_connection
+{
+   public:
+   smtp_connection( const std::string& host_and_port, const smtp_user_info& user_info, progress* p_progress = 0 );
+   ~smtp_connection( );
+
+   bool is_okay( ) const;
+   bool has_pipelining( ) const;
+
+   size_t get_num_sent( ) const;
+
+   void send( const smtp_message& message, const smtp_user_info* p_header_info = 0 );
+
+   void quit( );
+
+   private:
+   smtp_connection( const smtp_connection& );
+   smtp_connection& operator =( const smtp_connection& );
+
+   struct impl;
+   impl* p_impl;
+};
+
 std::string html_to_text( const std::string& html );
 
+// NOTE: Returns true if the error (from a failed send) is a permanent (i.e. 5xx) rejection.
+bool is_permanent_smtp_failure( const std::string& error );
+
 void send_smtp_message( const std::string& host,
  const smtp_user_info& user_info, const std::vector< std::string >& recipients, const std::string& subject );
 
@@ -14,6 +14,7 @@
 #  include <memory.h>
 #  include <memory>
 #  include <fstream>
+#  include <vector>
 #  include <iostream>
 #  include <stdexcept>
 #  ifndef _WIN32
@@ -237,6 +238,17 @@ SOCKET tcp_socket::accept( ip_address& addr, size_t timeout ) const
    }
 }
 
+int tcp_socket::get_local_port( ) const
+{
+   ip_address addr;
+   socklen_t len = sizeof( sockaddr );
+
+   if( ::getsockname( socket, ( sockaddr* )&addr, &len ) == SOCKET_ERROR )
+      return 0;
+
+   return ntohs( addr.sin_port );
+}
+
 bool tcp_socket::get_delay( )
 {
    int val = 0;
@@ -535,8 +547,6 @@ void file_transfer( const string& name,
    string unexpected_data;
 
    bool use_recv_buffer = ( p_buffer && buffer_size );
-   
-   bool has_prefix_char = ( p_prefix_char && *p_prefix_char );
 
    if( d == e_ft_direction_send )
    {
@@ -547,56 +557,8 @@ void file_transfer( const string& name,
       if( !inpf )
          throw runtime_error( "file '" + name + "' could not be opened for input" );
 
-      size_t buf_size = max_line_size
-       ? base64::decode_size( max_line_size + has_prefix_char ) : c_default_buf_size;
-
-      auto_ptr< char > ap_buf( new char[ buf_size ] );
-
-      bool is_first = true;
-
-      while( true )
-      {
-         size_t count = buf_size;
-
-         if( !inpf.read( ap_buf.get( ), buf_size ) )
-            count = inpf.gcount( );
-
-         if( !count )
-            break;
-
-         string next( string( ap_buf.get( ), count ) );
-
-         if( is_first && has_prefix_char )
-            next = ( char )*p_prefix_char + next;
-
-         next = base64::encode( next );
-
-         s.write_line( next, is_first ? initial_timeout : line_timeout, p_progress );
-
-         next.erase( );
-         s.read_line( next, is_first ? initial_timeout : line_timeout, max_line_size, p_progress );
-
-         if( s.had_timeout( ) )
-            throw runtime_error( "timeout occurred reading send response for file transfer" );
-
-         if( next != string( p_ack_message ) )
-         {
-            // NOTE: If "error" is found in the message then just throw it as is.
-            if( next.find( "error" ) != string::npos )
-               throw runtime_error( next );
-            else if( next.empty( ) )
-               throw runtime_error( "unexpected empty data" );
-            else
-               throw runtime_error( "was expecting '" + string( p_ack_message ) + "' but found '" + next + "'" );
-         }
-
-         if( inpf.eof( ) )
-            break;
-
-         is_first = false;
-      }
-
-      s.write_line( p_ack_message, line_timeout, p_progress );
+      file_transfer( inpf, s, p_ack_message,
+       initial_timeout, line_timeout, max_line_size, p_prefix_char, p_progress );
    }
    else
    {
@@ -680,3 +642,63 @@ void file_transfer( const string& name,
    }
 }
 
+void file_transfer( istream& is, tcp_socket& s,
+ const char* p_ack_message, size_t initial_timeout, size_t line_timeout,
+ size_t max_line_size, unsigned char* p_prefix_char, progress* p_progress )
+{
+   bool has_prefix_char = ( p_prefix_char && *p_prefix_char );
+
+   size_t buf_size = max_line_size
+    ? base64::decode_size( max_line_size + has_prefix_char ) : c_default_buf_size;
+
+   // NOTE: One extra byte is allocated so that the prefix char (if present) can be placed
+   // in front of the first chunk without needing to copy it.
+   vector< unsigned char > buf( buf_size + 1 );
+
+   string next;
+   bool is_first = true;
+
+   while( true )
+   {
+      size_t offset = ( is_first && has_prefix_char ) ? 1 : 0;
+
+      if( offset )
+         buf[ 0 ] = *p_prefix_char;
+
+      size_t count = buf_size;
+
+      if( !is.read( ( char* )&buf[ offset ], buf_size ) )
+         count = is.gcount( );
+
+      if( !count )
+         break;
+
+      next = base64::encode( &buf[ 0 ], count + offset );
+
+      s.write_line( next, is_first ? initial_timeout : line_timeout, p_progress );
+
+      next.erase( );
+      s.read_line( next, is_first ? initial_timeout : line_timeout, max_line_size, p_progress );
+
+      if( s.had_timeout( ) )
+         throw runtime_error( "timeout occurred reading send response for file transfer" );
+
+      if( next != string( p_ack_message ) )
+      {
+         // NOTE: If "error" is found in the message then just throw it as is.
+         if( next.find( "error" ) != string::npos )
+            throw runtime_error( next );
+         else if( next.empty( ) )
+            throw runtime_error( "unexpected empty data" );
+         else
+            throw runtime_error( "was expecting '" + string( p_ack_message ) + "' but found '" + next + "'" );
+      }
+
+      if( is.eof( ) )
+         break;
+
+      is_first = false;
+   }
+
+   s.write_line( p_ack_message, line_timeout, p_progress );
+}
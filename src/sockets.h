@@ -9,6 +9,7 @@
 
 #  ifndef HAS_PRECOMPILED_STD_HEADERS
 #     include <string>
+#     include <iosfwd>
 #     ifdef _WIN32
 #        define NOMINMAX
 #        include <winsock2.h>
@@ -74,6 +75,8 @@ class tcp_socket
    bool listen( );
    SOCKET accept( ip_address& addr, size_t timeout = 0 ) const;
 
+   int get_local_port( ) const;
+
    bool get_delay( );
    bool set_delay( );
    bool set_no_delay( );
@@ -150,5 +153,10 @@ void file_transfer(
  size_t line_timeout = 0, size_t max_line_size = 0, unsigned char* p_prefix_char = 0,
  unsigned char* p_buffer = 0, unsigned int buffer_size = 0, progress* p_progress = 0 );
 
+// NOTE: Sends the content of an already opened input stream.
+void file_transfer( std::istream& is, tcp_socket& s,
+ const char* p_ack_message, size_t initial_timeout = 0, size_t line_timeout = 0,
+ size_t max_line_size = 0, unsigned char* p_prefix_char = 0, progress* p_progress = 0 );
+
 #endif
 
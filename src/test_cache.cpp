@@ -10,6 +10,7 @@
 #pragma hdrstop
 
 #ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <map>
 #  include <string>
 #  include <sstream>
 #  include <fstream>
@@ -48,7 +49,9 @@
 
 #include "cache.h"
 
+#include "threads.h"
 #include "pointers.h"
+#include "date_time.h"
 #include "utilities.h"
 #include "auto_buffer.h"
 #include "console_commands.h"
@@ -337,6 +340,151 @@ template< typename T > class test_cache : public cache_base< T >
    int handle;
 };
 
+const size_t c_bench_num_variables = 100;
+const size_t c_default_bench_threads = 4;
+const size_t c_default_bench_reads = 1000000;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
+typedef map< string, string > bench_container;
+
+struct bench_info
+{
+   bench_info( bool use_snapshot, size_t num_reads )
+    :
+    use_snapshot( use_snapshot ),
+    num_reads( num_reads ),
+    finished( false )
+   {
+      for( size_t i = 0; i < c_bench_num_variables; i++ )
+      {
+         keys.push_back( "@var" + to_string( i ) );
+         variables[ keys.back( ) ] = to_string( i );
+      }
+
+      snapshot.publish( new bench_container( variables ) );
+   }
+
+   bool use_snapshot;
+   size_t num_reads;
+
+   vector< string > keys;
+
+   mutex lock;
+
+   bool finished;
+
+   bench_container variables;
+   read_snapshot< bench_container > snapshot;
+};
+
+class bench_reader : public joinable_thread
+{
+   public:
+   bench_reader( bench_info& info ) : info( info ) { }
+
+   void on_start( );
+
+   private:
+   bench_info& info;
+};
+
+void bench_reader::on_start( )
+{
+   size_t total = 0;
+
+   for( size_t i = 0; i < info.num_reads; i++ )
+   {
+      const string& key( info.keys[ i % info.keys.size( ) ] );
+
+      if( info.use_snapshot )
+      {
+         read_snapshot< bench_container >::reader variables( info.snapshot );
+
+         bench_container::const_iterator ci = variables->find( key );
+         if( ci != variables->end( ) )
+            total += ci->second.size( );
+      }
+      else
+      {
+         guard g( info.lock );
+
+         bench_container::const_iterator ci = info.variables.find( key );
+         if( ci != info.variables.end( ) )
+            total += ci->second.size( );
+      }
+   }
+
+   if( !total )
+      cerr << "unexpected zero total in bench_reader" << endl;
+}
+
+class bench_writer : public joinable_thread
+{
+   public:
+   bench_writer( bench_info& info ) : info( info ) { }
+
+   void on_start( );
+
+   private:
+   bench_info& info;
+};
+
+void bench_writer::on_start( )
+{
+   size_t count = 0;
+
+   while( true )
+   {
+      {
+         guard g( info.lock );
+
+         if( info.finished )
+            break;
+
+         info.variables[ info.keys[ count % info.keys.size( ) ] ] = to_string( ++count );
+
+         if( info.use_snapshot )
+            info.snapshot.publish( new bench_container( info.variables ) );
+      }
+
+      msleep( 1 );
+   }
+}
+
+// NOTE: Runs reader threads (along with a single writer that changes a value every millisecond)
+// using either a mutex guarded container or a read snapshot and returns the elapsed time.
+milliseconds run_bench( bool use_snapshot, size_t num_threads, size_t num_reads )
+{
+   bench_info info( use_snapshot, num_reads );
+
+   mtime start( mtime::standard( ) );
+
+   bench_writer writer( info );
+   writer.start( );
+
+   worker_group readers;
+
+   for( size_t i = 0; i < num_threads; i++ )
+      readers.start( new bench_reader( info ) );
+
+   readers.join_all( );
+
+   {
+      guard g( info.lock );
+      info.finished = true;
+   }
+
+   writer.join( );
+
+   milliseconds elapsed = mtime::standard( ) - start;
+
+   if( elapsed < 0 )
+      elapsed += c_milliseconds_per_day;
+
+   return elapsed;
+}
+
 const char* const c_cache_file_name = "test_cache.dat";
 
 const unsigned c_default_max_items = 5;
@@ -681,6 +829,41 @@ void test_cache_command_functor::operator ( )( const string& command, const para
             handler.issue_command_reponse( "*** physical store count = "
              + to_string( total_physical_store_count - old_store_count ) + " ***" );
       }
+      else if( command == c_cmd_test_cache_bench )
+      {
+         size_t num_threads = c_default_bench_threads;
+         size_t num_reads = c_default_bench_reads;
+
+         string threads( get_parm_val( parameters, c_cmd_parm_test_cache_bench_num_threads ) );
+         string reads( get_parm_val( parameters, c_cmd_parm_test_cache_bench_num_reads ) );
+
+         if( !threads.empty( ) )
+            num_threads = atoi( threads.c_str( ) );
+
+         if( !reads.empty( ) )
+            num_reads = atoi( reads.c_str( ) );
+
+         if( !num_threads )
+            num_threads = 1;
+
+         for( size_t i = 0; i < 2; i++ )
+         {
+            bool use_snapshot = ( i == 1 );
+
+            milliseconds elapsed = run_bench( use_snapshot, num_threads, num_reads );
+
+            size_t total_reads = num_threads * num_reads;
+
+            ostringstream osstr;
+            osstr << ( use_snapshot ? "snapshot: " : "locked: " ) << total_reads
+             << " reads using " << num_threads << " threads in " << elapsed << " ms";
+
+            if( elapsed > 0 )
+               osstr << " (" << ( uint64_t )( total_reads * 1000.0 / elapsed ) << " reads/sec)";
+
+            handler.issue_command_reponse( osstr.str( ) );
+         }
+      }
       else if( command == c_cmd_test_cache_exit )
       {
    #ifdef TEST_CACHE_DEBUG
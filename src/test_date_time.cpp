@@ -0,0 +1,332 @@
+// Copyright (c) 2012-2017 CIYAM Developers
+//
+// Distributed under the MIT/X11 software license, please refer to the file license.txt
+// in the root project directory or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef PRECOMPILE_H
+#  include "precompile.h"
+#endif
+#pragma hdrstop
+
+#ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <cstring>
+#  include <string>
+#  include <iomanip>
+#  include <sstream>
+#  include <iostream>
+#  include <stdexcept>
+#endif
+
+#include "macros.h"
+#include "date_time.h"
+#include "utilities.h"
+#include "console_commands.h"
+
+using namespace std;
+
+#include "test_date_time.cmh"
+
+const char* const c_app_title = "test_date_time";
+const char* const c_app_version = "0.1";
+
+const char* const c_error_prefix = "error: ";
+
+const size_t c_default_num_verify_values = 100000;
+
+const millisecond c_milliseconds_per_day = 86400000;
+
+// NOTE: The lengths of the "hhmm", "hhmmss", "hhmmsst", "hhmmssth" and "hhmmsstht" time formats.
+const size_t c_time_format_lengths[ ] = { 4, 6, 7, 8, 9 };
+const size_t c_time_format_separator_lengths[ ] = { 5, 8, 10, 11, 12 };
+
+bool g_application_title_called = false;
+
+uint64_t next_random( uint64_t& seed )
+{
+   seed ^= seed << 13;
+   seed ^= seed >> 7;
+   seed ^= seed << 17;
+
+   return seed;
+}
+
+date_time random_date_time( uint64_t& seed )
+{
+   year yr = ( year )( date_time::minimum_year( )
+    + next_random( seed ) % ( date_time::maximum_year( ) - date_time::minimum_year( ) + 1 ) );
+
+   month mo = ( month )( 1 + next_random( seed ) % 12 );
+   day dy = ( day )( 1 + next_random( seed ) % udate( yr, mo, 1 ).days_in_month( ) );
+
+   millisecond ms = ( millisecond )( next_random( seed ) % c_milliseconds_per_day );
+
+   return date_time( udate( yr, mo, dy ), mtime( ( hour )( ms / 3600000 ),
+    ( minute )( ( ms / 60000 ) % 60 ), ( second )( ( ms / 1000 ) % 60 ), ms % 1000 ) );
+}
+
+// NOTE: The expected value is constructed from the individual date and time components rather
+// than from any of the string or buffer conversions that are being verified.
+string expected_value( const date_time& dt, bool use_separators, bool include_milliseconds )
+{
+   ostringstream osstr;
+
+   osstr << setfill( '0' ) << setw( 4 ) << ( int )dt.get_year( );
+
+   if( use_separators )
+      osstr << '-';
+
+   osstr << setw( 2 ) << ( int )dt.get_month( );
+
+   if( use_separators )
+      osstr << '-';
+
+   osstr << setw( 2 ) << ( int )dt.get_day( );
+
+   if( use_separators )
+      osstr << ' ';
+
+   osstr << setw( 2 ) << ( int )dt.get_hour( );
+
+   if( use_separators )
+      osstr << ':';
+
+   osstr << setw( 2 ) << ( int )dt.get_minute( );
+
+   if( use_separators )
+      osstr << ':';
+
+   osstr << setw( 2 ) << ( int )dt.get_second( );
+
+   if( include_milliseconds )
+   {
+      if( use_separators )
+         osstr << '.';
+
+      osstr << setw( 3 ) << ( int )dt.get_millisecond( );
+   }
+
+   return osstr.str( );
+}
+
+void check_value( const string& what, const string& value, const string& expected )
+{
+   if( value != expected )
+      throw runtime_error( "unexpected " + what + " value '" + value + "' (expected '" + expected + "')" );
+}
+
+void verify_conversions( const date_time& dt, bool use_separators, bool include_milliseconds )
+{
+   string expected( expected_value( dt, use_separators, include_milliseconds ) );
+
+   check_value( "date_time string", dt.as_string( use_separators, include_milliseconds ), expected );
+
+   // NOTE: The buffer is filled with digits beforehand so that the length returned is verified
+   // and parsing from the buffer is verified to not read any characters beyond that length.
+   char buf[ c_date_time_max_chars + 3 ];
+   memset( buf, '9', sizeof( buf ) );
+
+   size_t len = dt.as_chars( buf, use_separators, include_milliseconds );
+
+   check_value( "date_time buffer", string( buf, len ), expected );
+
+   check_value( "date_time parsed", date_time( expected ).as_string( use_separators, include_milliseconds ), expected );
+   check_value( "date_time buffer parsed", date_time( buf, len ).as_string( use_separators, include_milliseconds ), expected );
+
+   if( include_milliseconds && !( date_time( buf, len ) == dt ) )
+      throw runtime_error( "date_time parsed from buffer '" + expected + "' is not equal to its original value" );
+
+   string expected_date( expected.substr( 0, use_separators ? 10 : 8 ) );
+   string expected_time( expected.substr( use_separators ? 11 : 8 ) );
+
+   check_value( "udate string", dt.get_date( ).as_string( use_separators ), expected_date );
+   check_value( "udate parsed", udate( expected_date ).as_string( use_separators ), expected_date );
+
+   check_value( "mtime string", dt.get_time( ).as_string( use_separators, include_milliseconds ), expected_time );
+   check_value( "mtime parsed", mtime( expected_time ).as_string( use_separators, include_milliseconds ), expected_time );
+
+   if( include_milliseconds )
+   {
+      for( size_t i = 0; i < ARRAY_SIZE( c_time_format_lengths ); i++ )
+      {
+         size_t format_length = use_separators ? c_time_format_separator_lengths[ i ] : c_time_format_lengths[ i ];
+
+         check_value( "mtime format " + to_string( i ),
+          dt.get_time( ).as_string( ( time_format )i, use_separators ), expected_time.substr( 0, format_length ) );
+      }
+   }
+}
+
+string application_title( app_info_request request )
+{
+   g_application_title_called = true;
+
+   if( request == e_app_info_request_title )
+      return string( c_app_title );
+   else if( request == e_app_info_request_version )
+      return string( c_app_version );
+   else if( request == e_app_info_request_title_and_version )
+   {
+      string title( c_app_title );
+      title += " v";
+      title += string( c_app_version );
+
+      return title;
+   }
+   else
+   {
+      ostringstream osstr;
+      osstr << "unknown app_info_request: " << request;
+      throw runtime_error( osstr.str( ) );
+   }
+}
+
+class test_date_time_command_functor;
+
+class test_date_time_command_handler : public console_command_handler
+{
+   friend class test_date_time_command_functor;
+
+   public:
+   test_date_time_command_handler( )
+    :
+    dt( udate( 2000, e_month_january, 1 ), mtime( 0, 0 ) )
+   {
+   }
+
+   private:
+   date_time dt;
+};
+
+class test_date_time_command_functor : public command_functor
+{
+   public:
+   test_date_time_command_functor( test_date_time_command_handler& date_time_test_handler )
+    : command_functor( date_time_test_handler ),
+    dt( date_time_test_handler.dt )
+   {
+   }
+
+   void operator ( )( const string& command, const parameter_info& parameters );
+
+   private:
+   date_time& dt;
+};
+
+void test_date_time_command_functor::operator ( )( const string& command, const parameter_info& parameters )
+{
+   try
+   {
+      if( command == c_cmd_test_date_time_set )
+      {
+         date_time value( get_parm_val( parameters, c_cmd_parm_test_date_time_set_value ) );
+
+         dt = value;
+         handler.issue_command_reponse( dt.as_string( ) );
+      }
+      else if( command == c_cmd_test_date_time_get )
+         handler.issue_command_reponse( dt.as_string( ) );
+      else if( command == c_cmd_test_date_time_iso )
+         handler.issue_command_reponse( dt.as_string( true ) );
+      else if( command == c_cmd_test_date_time_date )
+         handler.issue_command_reponse( dt.get_date( ).as_string( ) + ' ' + dt.get_date( ).as_string( true ) );
+      else if( command == c_cmd_test_date_time_time )
+         handler.issue_command_reponse( dt.get_time( ).as_string( ) + ' ' + dt.get_time( ).as_string( true ) );
+      else if( command == c_cmd_test_date_time_times )
+      {
+         for( size_t i = 0; i < ARRAY_SIZE( c_time_format_lengths ); i++ )
+            handler.issue_command_reponse( dt.as_string( ( time_format )i )
+             + ' ' + dt.as_string( ( time_format )i, true ) );
+      }
+      else if( command == c_cmd_test_date_time_inc )
+         handler.issue_command_reponse( ( ++dt ).as_string( ) );
+      else if( command == c_cmd_test_date_time_dec )
+         handler.issue_command_reponse( ( --dt ).as_string( ) );
+      else if( command == c_cmd_test_date_time_add_days )
+      {
+         days num( from_string< days >( get_parm_val( parameters, c_cmd_parm_test_date_time_add_days_num ) ) );
+
+         dt += num;
+         handler.issue_command_reponse( dt.as_string( ) );
+      }
+      else if( command == c_cmd_test_date_time_add_msecs )
+      {
+         milliseconds num( from_string< milliseconds >( get_parm_val( parameters, c_cmd_parm_test_date_time_add_msecs_num ) ) );
+
+         dt += num;
+         handler.issue_command_reponse( dt.as_string( ) );
+      }
+      else if( command == c_cmd_test_date_time_verify )
+      {
+         string num_values( get_parm_val( parameters, c_cmd_parm_test_date_time_verify_num_values ) );
+
+         size_t num = c_default_num_verify_values;
+
+         if( !num_values.empty( ) )
+            num = from_string< size_t >( num_values );
+
+         // NOTE: A fixed seed is used so that the same values are verified every time.
+         uint64_t seed = 0x9e3779b97f4a7c15ull;
+
+         for( size_t i = 0; i < num; i++ )
+         {
+            date_time next( random_date_time( seed ) );
+
+            for( int use_separators = 0; use_separators < 2; use_separators++ )
+            {
+               for( int include_milliseconds = 0; include_milliseconds < 2; include_milliseconds++ )
+                  verify_conversions( next, use_separators, include_milliseconds );
+            }
+         }
+
+         verify_conversions( date_time::minimum( ), true, true );
+         verify_conversions( date_time::maximum( ), true, true );
+
+         handler.issue_command_reponse( "verified " + to_string( num ) + " values" );
+      }
+      else if( command == c_cmd_test_date_time_exit )
+         handler.set_finished( );
+   }
+   catch( exception& x )
+   {
+      handler.issue_command_reponse( string( c_error_prefix ) + x.what( ), true );
+   }
+}
+
+command_functor* test_date_time_command_functor_factory( const string& /*name*/, command_handler& handler )
+{
+   return new test_date_time_command_functor( dynamic_cast< test_date_time_command_handler& >( handler ) );
+}
+
+int main( int argc, char* argv[ ] )
+{
+   test_date_time_command_handler cmd_handler;
+
+   try
+   {
+      // NOTE: Use block scope for startup command processor object...
+      {
+         startup_command_processor processor( cmd_handler, application_title, 0, argc, argv );
+
+         processor.process_commands( );
+      }
+
+      if( !cmd_handler.has_option_quiet( ) )
+         cout << application_title( e_app_info_request_title_and_version ) << endl;
+
+      cmd_handler.add_commands( 0,
+       test_date_time_command_functor_factory, ARRAY_PTR_AND_SIZE( test_date_time_command_definitions ) );
+
+      console_command_processor processor( cmd_handler );
+      processor.process_commands( );
+   }
+   catch( exception& x )
+   {
+      cerr << "error: " << x.what( ) << endl;
+      return 1;
+   }
+   catch( ... )
+   {
+      cerr << "error: unexpected exception occurred" << endl;
+      return 2;
+   }
+}
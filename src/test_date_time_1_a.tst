@@ -0,0 +1,79 @@
+
+> get
+20000101000000000
+
+> iso
+2000-01-01 00:00:00.000
+
+> set 20170313080001
+20170313080001000
+
+> get
+20170313080001000
+
+> iso
+2017-03-13 08:00:01.000
+
+> date
+20170313 2017-03-13
+
+> time
+080001000 08:00:01.000
+
+> times
+201703130800 2017-03-13 08:00
+20170313080001 2017-03-13 08:00:01
+201703130800010 2017-03-13 08:00:01.0
+2017031308000100 2017-03-13 08:00:01.00
+20170313080001000 2017-03-13 08:00:01.000
+
+> set "2017-03-13 08:00:01.234"
+20170313080001234
+
+> times
+201703130800 2017-03-13 08:00
+20170313080001 2017-03-13 08:00:01
+201703130800012 2017-03-13 08:00:01.2
+2017031308000123 2017-03-13 08:00:01.23
+20170313080001234 2017-03-13 08:00:01.234
+
+> set 201703130800
+20170313080000000
+
+> set "2017-03-13 08:00"
+20170313080000000
+
+> set 20170313
+20170313000000000
+
+> set 2017-03-13
+20170313000000000
+
+> set 18000101
+18000101000000000
+
+> set 37991231235959999
+37991231235959999
+
+> set "2000-02-29 23:59:59.999"
+20000229235959999
+
+> inc
+20000301235959999
+
+> dec
+20000229235959999
+
+> add_days 365
+20010228235959999
+
+> add_days -366
+20000228235959999
+
+> add_msecs 1
+20000229000000000
+
+> add_msecs -2
+20000228235959998
+
+> 
\ No newline at end of file
@@ -0,0 +1,44 @@
+
+> set 2017031
+error: invalid format for date_time (given '2017031' but expecting 'yyyymmdd[hhmm[ss[t[h[t]]]]]' or 'yyyy-mm-dd[ hh:mm[:ss[.t[h[t]]]]]')
+
+> set 201703130
+error: invalid format for date_time (given '201703130' but expecting 'yyyymmdd[hhmm[ss[t[h[t]]]]]' or 'yyyy-mm-dd[ hh:mm[:ss[.t[h[t]]]]]')
+
+> set 20170230
+error: date is invalid
+
+> set 2017-02-29
+error: date is invalid
+
+> set 20171301
+error: date is invalid
+
+> set 201703132400
+error: invalid time
+
+> set "2017-03-13 08:60"
+error: invalid time
+
+> set 201703130800015
+20170313080001500
+
+> set "2017-03-13 08:00:01.2345"
+error: invalid format for date_time (given '2017-03-13 08:00:01.2345' but expecting 'yyyymmdd[hhmm[ss[t[h[t]]]]]' or 'yyyy-mm-dd[ hh:mm[:ss[.t[h[t]]]]]')
+
+> set 17991231
+error: date is invalid
+
+> set 38000101
+error: date is invalid
+
+> set abcdefgh
+error: date is invalid
+
+> get
+20170313080001500
+
+> verify
+verified 100000 values
+
+> 
\ No newline at end of file
@@ -16,6 +16,7 @@
 #endif
 
 #include "sha256.h"
+#include "date_time.h"
 #include "utilities.h"
 #include "hash_chain.h"
 
@@ -25,12 +26,95 @@ const int c_buffer_size = 32;
 
 const int c_test_rounds = 100;
 
+const int c_bench_rounds = 1000000;
+const int c_bench_publishes = 1000;
+const int c_bench_comparisons = 5;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
 const char* const c_test_hash_chain_internal = "~test_hash_chain_internal";
 const char* const c_test_hash_chain_external = "~test_hash_chain_external";
 
 const char* const c_test_hash_chain_password = "password";
 
-int main( )
+string calculate_hash_to_publish( const string& password, uint32_t rounds )
+{
+   unsigned char buffer[ c_buffer_size ];
+
+   sha256 seed_hash( "" );
+   seed_hash.copy_digest_to_buffer( buffer );
+
+   sha256 hash( password );
+   hash.update( buffer, c_buffer_size );
+
+   for( uint32_t i = 0; i < rounds; i++ )
+   {
+      hash.copy_digest_to_buffer( buffer );
+      hash.update( buffer, sizeof( buffer ) );
+   }
+
+   return hash.get_digest_as_string( );
+}
+
+void perform_benchmark( )
+{
+   cout << "publish " << c_bench_publishes << " hashes from a " << c_bench_rounds << " round hash chain\n";
+
+   hash_chain chain( c_test_hash_chain_internal, true, c_bench_rounds, false );
+
+   vector< string > published;
+
+   mtime start( mtime::standard( ) );
+
+   for( int i = 0; i < c_bench_publishes; i++ )
+      published.push_back( chain.get_next_hashes_to_publish( c_test_hash_chain_password ) );
+
+   milliseconds elapsed = mtime::standard( ) - start;
+
+   if( elapsed < 0 )
+      elapsed += c_milliseconds_per_day;
+
+   cout << c_bench_publishes << " publishes in " << elapsed << " ms";
+
+   if( elapsed > 0 )
+      cout << " (" << ( uint64_t )( c_bench_publishes * 1000.0 / elapsed ) << " publishes/sec)";
+
+   cout << '\n';
+
+   for( int i = 1; i < c_bench_publishes; i++ )
+   {
+      if( !check_if_valid_hash_pair( published[ i ], published[ i - 1 ] ) )
+         throw runtime_error( "published hash #" + to_string( i ) + " did not verify against its predecessor" );
+   }
+
+   cout << "\nrecalculate " << c_bench_comparisons << " of these hashes from the start of the chain\n";
+
+   start = mtime::standard( );
+
+   for( int i = 0; i < c_bench_comparisons; i++ )
+   {
+      int n = i * ( c_bench_publishes / c_bench_comparisons );
+
+      if( calculate_hash_to_publish( c_test_hash_chain_password, c_bench_rounds - n ) != published[ n ] )
+         throw runtime_error( "published hash #" + to_string( n ) + " does not match the recalculated hash" );
+   }
+
+   elapsed = mtime::standard( ) - start;
+
+   if( elapsed < 0 )
+      elapsed += c_milliseconds_per_day;
+
+   cout << c_bench_comparisons << " recalculations in " << elapsed << " ms";
+
+   if( elapsed > 0 )
+      cout << " (" << ( uint64_t )( c_bench_comparisons * 1000.0 / elapsed ) << " publishes/sec)";
+
+   cout << "\n\nall published hashes verified and matched\n";
+
+   file_remove( c_test_hash_chain_internal );
+}
+
+int main( int argc, char* argv[ ] )
 {
    unsigned char buffer[ c_buffer_size ];
 
@@ -38,6 +122,13 @@ int main( )
 
    try
    {
+      // NOTE: The benchmark is not part of the standard tests (as its output includes timings).
+      if( argc > 1 && string( argv[ 1 ] ) == "-bench" )
+      {
+         perform_benchmark( );
+         return 0;
+      }
+
       cout << "01. create seedless internal hash chain and get the last hash\n";
       hash_chain chain_internal( c_test_hash_chain_internal, true, c_test_rounds, false );
 
@@ -116,16 +207,22 @@ int main( )
       else
          cout << "fail\n";
 
+      cout << "\n09. check that asking for zero hashes to publish does not return any hash\n";
+      if( chain_internal.get_next_hashes_to_publish( c_test_hash_chain_password, 0 ).empty( ) )
+         cout << "pass\n";
+      else
+         cout << "fail\n";
+
       while( !chain_internal.has_been_depleted( ) )
       {
          new_hash_value = chain_internal.get_next_hashes_to_publish( c_test_hash_chain_password );
          chain_external.check_and_update_if_good( new_hash_value );
       }
 
-      cout << "\n09. check all remaining internal chain hashes are verified by the external chain\n";
+      cout << "\n10. check all remaining internal chain hashes are verified by the external chain\n";
       cout << new_hash_value << '\n';
 
-      cout << "\n10. check that the last hash matches what was manually calculated\n";
+      cout << "\n11. check that the last hash matches what was manually calculated\n";
       cout << new_hash_value << '\n';
 
       file_remove( c_test_hash_chain_internal );
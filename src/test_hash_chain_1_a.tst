@@ -23,8 +23,11 @@ pass
 08. check fetching two hashes at once are both verified by the external chain
 pass
 
-09. check all remaining internal chain hashes are verified by the external chain
+09. check that asking for zero hashes to publish does not return any hash
+pass
+
+10. check all remaining internal chain hashes are verified by the external chain
 5ba23633823ee900cd4ca3a9f4ce9a08f2ca1d3920c5c44fd51273b2f7cf5ca4
 
-10. check that the last hash matches what was manually calculated
+11. check that the last hash matches what was manually calculated
 5ba23633823ee900cd4ca3a9f4ce9a08f2ca1d3920c5c44fd51273b2f7cf5ca4
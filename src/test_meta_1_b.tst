@@ -29,6 +29,35 @@ Status Info has changed.
 [002 =1.0 256 100:139100] 002,test2,2000000,2000000,bad access
 [003 =1.0 256 100:139100] 003,test3,4000000,4000000,bad access
 
+> pa 100 139100 "" count:*,sum:139104,min:139104,max:139104
+3,16000000,2000000,10000000
+
+> pa 100 139100 -by=139105 "" count:*,sum:139104
+bad access,2,6000000
+okay,1,10000000
+
+> pa 100 139100 "" sum:139107
+Error: transient field 'Standard_Size_Limit' cannot be aggregated
+
+> pf 100 139100 "" 139104 -min
+10000000
+2000000
+4000000
+
+> pu admin 20011002 100 139100 002 "139104=3000000"
+
+> pf 100 139100 "" 139104 -min
+10000000
+3000000
+4000000
+
+> pu admin 20011002 100 139100 002 "139104=2000000"
+
+> pf 100 139100 "" 139104 -min
+10000000
+2000000
+4000000
+
 > ~mkdir test2
 
 > 
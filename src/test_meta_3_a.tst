@@ -3,6 +3,21 @@
 
 > session_variable @attached_file_path .
 
+> object_create Meta Package 100
+100
+
+> object_op_update 100 guest_standard
+
+> pd sys 20120102 100 105100 guest_model
+Error: instance 'guest_model' cannot be destroyed as a lock to a dependent child could not be obtained
+
+> object_op_cancel 100
+
+> object_destroy 100
+
+> pd sys 20120102 100 101100 guests
+Error: This record cannot be deleted as it is being used by one or more Enum records.
+
 > pe guest 20120102 100 105100 "-v=@async=false,@message=Removing All Packages..." guest_model =1.0 -105450
 Removing All Packages...
 
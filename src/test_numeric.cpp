@@ -14,10 +14,12 @@
 #  include <vector>
 #  include <iostream>
 #  include <stdexcept>
+#  include <algorithm>
 #endif
 
 #include "macros.h"
 #include "numeric.h"
+#include "date_time.h"
 #include "utilities.h"
 #include "console_commands.h"
 
@@ -30,8 +32,184 @@ const char* const c_app_version = "0.1";
 
 const char* const c_error_prefix = "error: ";
 
+const size_t c_default_num_bench_operations = 1000000;
+const size_t c_default_num_verify_pairs = 100000;
+
+const size_t c_max_digits = numeric::e_max_digits;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
 bool g_application_title_called = false;
 
+uint64_t next_random( uint64_t& seed )
+{
+   seed ^= seed << 13;
+   seed ^= seed >> 7;
+   seed ^= seed << 17;
+
+   return seed;
+}
+
+numeric random_numeric( uint64_t& seed )
+{
+   size_t num_digits = 1 + next_random( seed ) % c_max_digits;
+   size_t num_decimals = next_random( seed ) % ( num_digits + 1 );
+
+   string digits;
+   for( size_t i = 0; i < num_digits; i++ )
+      digits += ( char )( '0' + next_random( seed ) % 10 );
+
+   bool is_negative = ( next_random( seed ) % 2 );
+
+   // NOTE: A negative zero is not generated as it would not be equal to a plain zero.
+   string value( is_negative && digits.find_first_not_of( '0' ) != string::npos ? "-" : "" );
+
+   value += "0" + digits.substr( 0, num_digits - num_decimals );
+
+   if( num_decimals )
+      value += c_decimal + digits.substr( num_digits - num_decimals );
+
+   return numeric( value.c_str( ) );
+}
+
+// NOTE: The following functions perform exact arithmetic on strings of decimal digits
+// (without any leading zeros so that an empty string is zero) in order to verify the
+// results of numeric multiplication and division.
+void split_decimal( const string& s, bool& is_negative, string& digits, size_t& decimals )
+{
+   is_negative = ( !s.empty( ) && s[ 0 ] == '-' );
+
+   digits.erase( );
+   decimals = 0;
+
+   bool had_decimal = false;
+
+   for( size_t i = is_negative ? 1 : 0; i < s.size( ); i++ )
+   {
+      if( s[ i ] == c_decimal )
+         had_decimal = true;
+      else
+      {
+         digits += s[ i ];
+
+         if( had_decimal )
+            ++decimals;
+      }
+   }
+
+   digits.erase( 0, digits.find_first_not_of( '0' ) );
+}
+
+string multiply_digits( const string& digits, uint64_t by )
+{
+   string retval;
+   uint64_t carry = 0;
+
+   for( size_t i = digits.size( ); i > 0; i-- )
+   {
+      carry += ( digits[ i - 1 ] - '0' ) * by;
+
+      retval += ( char )( '0' + carry % 10 );
+      carry /= 10;
+   }
+
+   for( ; carry; carry /= 10 )
+      retval += ( char )( '0' + carry % 10 );
+
+   reverse( retval.begin( ), retval.end( ) );
+   retval.erase( 0, retval.find_first_not_of( '0' ) );
+
+   return retval;
+}
+
+string divide_digits( const string& digits, uint64_t by )
+{
+   string retval;
+   uint64_t remainder = 0;
+
+   for( size_t i = 0; i < digits.size( ); i++ )
+   {
+      remainder = remainder * 10 + ( digits[ i ] - '0' );
+
+      if( !retval.empty( ) || remainder >= by )
+         retval += ( char )( '0' + remainder / by );
+
+      remainder %= by;
+   }
+
+   return retval;
+}
+
+// NOTE: A product or quotient is expected to be the exact value truncated to the maximum
+// number of significant digits (with no more than the maximum number of decimals).
+string expected_result( const numeric& lhs, const numeric& rhs, bool is_divide )
+{
+   bool lhs_negative, rhs_negative;
+   string lhs_digits, rhs_digits;
+   size_t lhs_decimals, rhs_decimals;
+
+   split_decimal( to_string( lhs ), lhs_negative, lhs_digits, lhs_decimals );
+   split_decimal( to_string( rhs ), rhs_negative, rhs_digits, rhs_decimals );
+
+   uint64_t rhs_value = from_string< uint64_t >( rhs_digits.empty( ) ? "0" : rhs_digits );
+
+   // NOTE: The exact value is "digits / ( divisor * 10 ^ exponent )".
+   string digits;
+   uint64_t divisor = 1;
+   size_t exponent = 0;
+
+   if( is_divide )
+   {
+      digits = lhs_digits;
+      if( !digits.empty( ) )
+         digits += string( rhs_decimals, '0' );
+
+      divisor = rhs_value;
+      exponent = lhs_decimals;
+   }
+   else
+   {
+      digits = multiply_digits( lhs_digits, rhs_value );
+      exponent = lhs_decimals + rhs_decimals;
+   }
+
+   string truncated( digits );
+   if( !truncated.empty( ) )
+      truncated += string( c_max_digits, '0' );
+
+   truncated.erase( truncated.size( ) - min( exponent, truncated.size( ) ) );
+   truncated = divide_digits( truncated, divisor );
+
+   size_t decimals = c_max_digits;
+
+   if( truncated.size( ) > c_max_digits )
+   {
+      size_t excess = truncated.size( ) - c_max_digits;
+
+      if( excess > decimals )
+         return "overflow occurred";
+
+      truncated.erase( truncated.size( ) - excess );
+      decimals -= excess;
+   }
+
+   if( truncated.empty( ) )
+      return digits.empty( ) ? "0" : "underflow occurred";
+
+   if( decimals )
+   {
+      if( truncated.size( ) <= decimals )
+         truncated.insert( 0, decimals - truncated.size( ) + 1, '0' );
+
+      truncated.insert( truncated.size( ) - decimals, 1, c_decimal );
+   }
+
+   if( lhs_negative != rhs_negative )
+      truncated.insert( 0, 1, '-' );
+
+   return to_string( numeric( truncated.c_str( ) ) );
+}
+
 string application_title( app_info_request request )
 {
    g_application_title_called = true;
@@ -291,6 +469,141 @@ void test_numeric_command_functor::operator ( )( const string& command, const pa
 
          handler.issue_command_reponse( format_numeric( num, mask ) );
       }
+      else if( command == c_cmd_test_numeric_sum )
+      {
+         vector< numeric > values;
+         split_numerics( get_parm_val( parameters, c_cmd_parm_test_numeric_sum_values ), values );
+
+         num = values.empty( ) ? numeric( ) : sum( &values[ 0 ], values.size( ) );
+         handler.issue_command_reponse( to_string( num ) );
+      }
+      else if( command == c_cmd_test_numeric_sum_product )
+      {
+         vector< numeric > lhs_values, rhs_values;
+         split_numerics( get_parm_val( parameters, c_cmd_parm_test_numeric_sum_product_lhs_values ), lhs_values );
+         split_numerics( get_parm_val( parameters, c_cmd_parm_test_numeric_sum_product_rhs_values ), rhs_values );
+
+         if( lhs_values.size( ) != rhs_values.size( ) )
+            throw runtime_error( "lhs and rhs values must have the same number of items" );
+
+         num = lhs_values.empty( ) ? numeric( ) : sum_product( &lhs_values[ 0 ], &rhs_values[ 0 ], lhs_values.size( ) );
+         handler.issue_command_reponse( to_string( num ) );
+      }
+      else if( command == c_cmd_test_numeric_bench )
+      {
+         size_t num_operations = c_default_num_bench_operations;
+
+         string num_ops( get_parm_val( parameters, c_cmd_parm_test_numeric_bench_num_operations ) );
+         if( !num_ops.empty( ) )
+            num_operations = from_string< size_t >( num_ops );
+
+         if( !num_operations )
+            num_operations = c_default_num_bench_operations;
+
+         vector< numeric > values;
+         values.reserve( num_operations );
+
+         for( size_t i = 0; i < num_operations; i++ )
+            values.push_back( numeric( ( int )( i % 1000 ) + 1 ) / 7 );
+
+         for( int pass = 0; pass < 3; pass++ )
+         {
+            numeric result;
+            mtime start( mtime::standard( ) );
+
+            if( pass == 0 )
+            {
+               for( size_t i = 0; i < num_operations; i++ )
+                  result = values[ i ] * values[ num_operations - i - 1 ];
+            }
+            else if( pass == 1 )
+            {
+               for( size_t i = 0; i < num_operations; i++ )
+                  result = values[ i ] / values[ num_operations - i - 1 ];
+            }
+            else
+               result = sum( &values[ 0 ], num_operations );
+
+            milliseconds elapsed = mtime::standard( ) - start;
+
+            if( elapsed < 0 )
+               elapsed += c_milliseconds_per_day;
+
+            ostringstream osstr;
+            osstr << num_operations << ( pass == 0 ? " multiplies" : pass == 1 ? " divides" : " summed values" )
+             << " in " << elapsed << " ms (result = " << to_string( result ) << ')';
+
+            if( elapsed > 0 )
+               osstr << " (" << ( uint64_t )( num_operations * 1000.0 / elapsed ) << " ops/sec)";
+
+            handler.issue_command_reponse( osstr.str( ) );
+         }
+      }
+      else if( command == c_cmd_test_numeric_verify )
+      {
+         size_t num_pairs = c_default_num_verify_pairs;
+
+         string pairs( get_parm_val( parameters, c_cmd_parm_test_numeric_verify_num_pairs ) );
+         if( !pairs.empty( ) )
+            num_pairs = from_string< size_t >( pairs );
+
+         uint64_t seed = UINT64_C( 88172645463325252 );
+
+         size_t num_multiplies = 0;
+         size_t num_divides = 0;
+         size_t num_overflows = 0;
+         size_t num_underflows = 0;
+
+         for( size_t i = 0; i < num_pairs; i++ )
+         {
+            numeric lhs( random_numeric( seed ) );
+            numeric rhs( random_numeric( seed ) );
+
+            for( int is_divide = 0; is_divide < 2; is_divide++ )
+            {
+               if( is_divide && rhs == numeric( ) )
+                  continue;
+
+               string result;
+
+               try
+               {
+                  numeric n( lhs );
+
+                  if( is_divide )
+                     n /= rhs;
+                  else
+                     n *= rhs;
+
+                  result = to_string( n );
+               }
+               catch( exception& x )
+               {
+                  result = x.what( );
+               }
+
+               string expected( expected_result( lhs, rhs, is_divide ) );
+
+               if( result != expected )
+                  throw runtime_error( "unexpected result " + result + " for " + to_string( lhs )
+                   + ( is_divide ? " / " : " * " ) + to_string( rhs ) + " (expected " + expected + ")" );
+
+               if( is_divide )
+                  ++num_divides;
+               else
+                  ++num_multiplies;
+
+               if( result == "overflow occurred" )
+                  ++num_overflows;
+               else if( result == "underflow occurred" )
+                  ++num_underflows;
+            }
+         }
+
+         handler.issue_command_reponse( "verified " + to_string( num_multiplies ) + " multiplies and "
+          + to_string( num_divides ) + " divides (" + to_string( num_overflows ) + " overflows and "
+          + to_string( num_underflows ) + " underflows)" );
+      }
       else if( command == c_cmd_test_numeric_exit )
          handler.set_finished( );
    }
@@ -9,7 +9,7 @@ error: overflow occurred
 error: overflow occurred
 
 > div .0000000001
-error: underflow occurred
+error: overflow occurred
 
 > div 10
 11111111.1111111111
@@ -0,0 +1,83 @@
+
+> set 0.1
+0.1
+
+> mul 0.1
+0.01
+
+> mul 0.1
+0.001
+
+> div 3
+0.000333333333333333
+
+> mul 3
+0.000999999999999999
+
+> set 12345.6789
+12345.6789
+
+> mul 98765.4321
+1219326311.12635269
+
+> div 98765.4321
+12345.6789
+
+> set 2
+2
+
+> div 3
+0.666666666666666666
+
+> mul 3
+1.99999999999999999
+
+> set 999999999999999999
+999999999999999999
+
+> mul 1.5
+error: overflow occurred
+
+> div 0.5
+error: overflow occurred
+
+> set 1
+1
+
+> div 7
+0.142857142857142857
+
+> sum 0.1,0.2,0.3
+0.6
+
+> sum 1.5,-2.25,0.75
+0
+
+> sum 999999999999999999,0.000000000000000001
+999999999999999999
+
+> sum 999999999999999999,1
+error: overflow occurred
+
+> sum 0.333333333333333333,0.333333333333333333,0.333333333333333334
+1
+
+> sum -0.000000000000000001,0.000000000000000001
+0
+
+> sum_product 1,2,3 4,5,6
+32
+
+> sum_product 0.5,1.25,-2 2,4,0.125
+5.75
+
+> sum_product 0.1,0.2 0.3
+error: lhs and rhs values must have the same number of items
+
+> sum_product 123456789,987654321 123456789,987654321
+990702636540161562
+
+> verify 100000
+verified 100000 multiplies and 99433 divides (7810 overflows and 26 underflows)
+
+> exit
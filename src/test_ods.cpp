@@ -31,6 +31,7 @@
 
 #include "ods.h"
 #include "format.h"
+#include "date_time.h"
 #include "pointers.h"
 #include "utilities.h"
 #include "oid_pointer.h"
@@ -47,6 +48,10 @@ const char* const c_root_node_description = "root";
 const int c_max_path_size = 256;
 const int c_max_trans_depth = 100;
 
+const int c_default_contention_ops = 100;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
 const char* const c_app_title = "test_ods";
 const char* const c_app_version = "0.1";
 
@@ -319,6 +324,71 @@ class test_ods_startup_functor : public command_functor
    }
 };
 
+class contention_thread : public joinable_thread
+{
+   public:
+   contention_thread( ods* p_ods, const oid& id, int num_ops, mutex& lock, int& num_failed )
+    :
+    ap_ods( p_ods ),
+    id( id ),
+    num_ops( num_ops ),
+    lock( lock ),
+    num_failed( num_failed )
+   {
+   }
+
+   void on_start( );
+
+   private:
+   auto_ptr< ods > ap_ods;
+
+   oid id;
+   int num_ops;
+
+   mutex& lock;
+
+   int& num_failed;
+};
+
+void contention_thread::on_start( )
+{
+   bool failed = false;
+
+   try
+   {
+      outline node;
+      node.set_id( id );
+
+      // NOTE: Alternates between bulk read and bulk write locks (each of which can only be held
+      // by one thread at a time) so that every operation will contend with all other threads.
+      for( int i = 0; i < num_ops; i++ )
+      {
+         if( i % 2 )
+         {
+            ods::bulk_write bulk( *ap_ods );
+            *ap_ods >> node;
+         }
+         else
+         {
+            ods::bulk_read bulk( *ap_ods );
+            *ap_ods >> node;
+         }
+      }
+   }
+   catch( ... )
+   {
+      failed = true;
+   }
+
+   ap_ods.reset( );
+
+   if( failed )
+   {
+      guard g( lock );
+      ++num_failed;
+   }
+}
+
 class test_ods_command_functor;
 
 class test_ods_command_handler : public console_command_handler
@@ -831,6 +901,56 @@ void test_ods_command_functor::operator ( )( const string& command, const parame
          handler.issue_command_reponse( "completed" );
       }
    }
+   else if( command == c_cmd_test_ods_compact )
+   {
+      string max_entries( get_parm_val( parameters, c_cmd_parm_test_ods_compact_max_entries ) );
+
+      int64_t max = 1000;
+      if( !max_entries.empty( ) )
+         max = from_string< int64_t >( max_entries );
+
+      int steps = 1;
+      while( o.move_some_free_data_to_end( max ) )
+         ++steps;
+
+      handler.issue_command_reponse( "completed (steps = " + to_string( steps ) + ")" );
+   }
+   else if( command == c_cmd_test_ods_contention )
+   {
+      int num_threads( from_string< int >( get_parm_val( parameters, c_cmd_parm_test_ods_contention_num_threads ) ) );
+      string num_ops_val( get_parm_val( parameters, c_cmd_parm_test_ods_contention_num_ops ) );
+
+      int num_ops = c_default_contention_ops;
+      if( !num_ops_val.empty( ) )
+         num_ops = from_string< int >( num_ops_val );
+
+      if( trans_level )
+         handler.issue_command_reponse( "*** cannot perform this operation whilst in a transaction ***" );
+      else if( num_threads <= 0 || num_ops <= 0 )
+         handler.issue_command_reponse( "*** invalid number of threads or operations ***" );
+      else
+      {
+         mutex lock;
+
+         int num_failed = 0;
+
+         mtime start( mtime::standard( ) );
+
+         worker_group workers;
+
+         for( int i = 0; i < num_threads; i++ )
+            workers.start( new contention_thread( new ods( o ), node.get_id( ), num_ops, lock, num_failed ) );
+
+         workers.join_all( );
+
+         milliseconds elapsed = mtime::standard( ) - start;
+         if( elapsed < 0 )
+            elapsed += c_milliseconds_per_day;
+
+         handler.issue_command_reponse( "completed " + to_string( num_threads * num_ops )
+          + " ops in " + to_string( elapsed ) + " ms (failed threads = " + to_string( num_failed ) + ")" );
+      }
+   }
    else if( command == c_cmd_test_ods_truncate )
    {
       if( g_shared_write )
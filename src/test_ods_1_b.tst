@@ -1,5 +1,5 @@
 ** File Info
-Version: 1.0
+Version: 1.1
 Num Logs = 0
 Num Trans = 0
 Num Writers = 0
@@ -11,6 +11,8 @@ Index Free List = 12
 Total Size of Data = 428
 Data Transformation Id = 16
 Index Transformation Id = 39
+Compact Data Position = 0
+Compact Reclaimed Bytes = 342
 
 ** Freelist Info
 First freelist entry = 12
@@ -1,5 +1,5 @@
 ** File Info
-Version: 1.0
+Version: 1.1
 Num Logs = 0
 Num Trans = 0
 Num Writers = 0
@@ -11,6 +11,8 @@ Index Free List = 1
 Total Size of Data = 28
 Data Transformation Id = 10008
 Index Transformation Id = 50010
+Compact Data Position = 0
+Compact Reclaimed Bytes = 488946
 
 ** Freelist Info
 First freelist entry = 1
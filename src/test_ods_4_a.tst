@@ -0,0 +1,17 @@
+
+/> 
+/> 
+/> completed (steps = 3)
+
+/> alpha#10
+alpha#11
+alpha#12
+alpha#13
+alpha#14
+alpha#15
+alpha#16
+alpha#17
+alpha#18
+alpha#19
+
+/> 
\ No newline at end of file
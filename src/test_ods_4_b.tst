@@ -0,0 +1,21 @@
+** File Info
+Version: 1.1
+Num Logs = 0
+Num Trans = 0
+Num Writers = 0
+Init Tranlog = 0
+Total Entries = 21
+Tranlog Offset = 0
+Transaction Id = 35
+Index Free List = 10
+Total Size of Data = 428
+Data Transformation Id = 27
+Index Transformation Id = 37
+Compact Data Position = 0
+Compact Reclaimed Bytes = 418
+
+** Freelist Info
+First freelist entry = 10
+Iterating over freelist...(OK)
+Final freelist entry = 1
+Total freelist entries = 10
@@ -0,0 +1,122 @@
+** File Info
+Version: 1.1
+Num Logs = 0
+Num Trans = 0
+Num Writers = 0
+Init Tranlog = 0
+Total Entries = 21
+Tranlog Offset = 0
+Transaction Id = 35
+Index Free List = 10
+Total Size of Data = 428
+Data Transformation Id = 27
+Index Transformation Id = 37
+Compact Data Position = 0
+Compact Reclaimed Bytes = 418
+
+** Entry Info for: all
+num: 0000000000000000          pos: 0000000000000140          len: 000000000000006c
+txn: 0000000000000022          txo: 0000000000000000               flags: lk=0 tx=0
+0000000000000140  04 00 00 00 00 00 00 00 72 6f 6f 74 ff ff ff ff  ........root....
+0000000000000150  ff ff ff ff 0a 00 00 00 00 00 00 00 0b 00 00 00  ................
+0000000000000160  00 00 00 00 0c 00 00 00 00 00 00 00 0d 00 00 00  ................
+0000000000000170  00 00 00 00 0e 00 00 00 00 00 00 00 0f 00 00 00  ................
+0000000000000180  00 00 00 00 10 00 00 00 00 00 00 00 11 00 00 00  ................
+0000000000000190  00 00 00 00 12 00 00 00 00 00 00 00 13 00 00 00  ................
+00000000000001a0  00 00 00 00 14 00 00 00 00 00 00 00              ............
+
+num: 0000000000000001          pos: 0000000000000000          len: 0000000000000000
+txn: 0000000000000017          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: <at end>
+
+num: 0000000000000002          pos: 0000000000000002          len: 0000000000000000
+txn: 0000000000000018          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000001
+
+num: 0000000000000003          pos: 0000000000000003          len: 0000000000000000
+txn: 0000000000000019          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000002
+
+num: 0000000000000004          pos: 0000000000000004          len: 0000000000000000
+txn: 000000000000001a          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000003
+
+num: 0000000000000005          pos: 0000000000000005          len: 0000000000000000
+txn: 000000000000001b          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000004
+
+num: 0000000000000006          pos: 0000000000000006          len: 0000000000000000
+txn: 000000000000001c          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000005
+
+num: 0000000000000007          pos: 0000000000000007          len: 0000000000000000
+txn: 000000000000001d          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000006
+
+num: 0000000000000008          pos: 0000000000000008          len: 0000000000000000
+txn: 000000000000001e          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000007
+
+num: 0000000000000009          pos: 0000000000000009          len: 0000000000000000
+txn: 000000000000001f          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000008
+
+num: 000000000000000a          pos: 000000000000000a          len: 0000000000000000
+txn: 0000000000000020          txo: 0000000000000000               flags: lk=0 tx=3
+(freelist entry) link: 0000000000000009
+
+num: 000000000000000b          pos: 0000000000000000          len: 0000000000000020
+txn: 000000000000000c          txo: 0000000000000000               flags: lk=0 tx=0
+0000000000000000  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 30  ........alpha#10
+0000000000000010  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 000000000000000c          pos: 0000000000000020          len: 0000000000000020
+txn: 000000000000000d          txo: 0000000000000000               flags: lk=0 tx=0
+0000000000000020  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 31  ........alpha#11
+0000000000000030  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 000000000000000d          pos: 0000000000000040          len: 0000000000000020
+txn: 000000000000000e          txo: 0000000000000000               flags: lk=0 tx=0
+0000000000000040  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 32  ........alpha#12
+0000000000000050  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 000000000000000e          pos: 0000000000000060          len: 0000000000000020
+txn: 000000000000000f          txo: 0000000000000000               flags: lk=0 tx=0
+0000000000000060  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 33  ........alpha#13
+0000000000000070  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 000000000000000f          pos: 0000000000000080          len: 0000000000000020
+txn: 0000000000000010          txo: 0000000000000000               flags: lk=0 tx=0
+0000000000000080  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 34  ........alpha#14
+0000000000000090  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 0000000000000010          pos: 00000000000000a0          len: 0000000000000020
+txn: 0000000000000011          txo: 0000000000000000               flags: lk=0 tx=0
+00000000000000a0  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 35  ........alpha#15
+00000000000000b0  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 0000000000000011          pos: 00000000000000c0          len: 0000000000000020
+txn: 0000000000000012          txo: 0000000000000000               flags: lk=0 tx=0
+00000000000000c0  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 36  ........alpha#16
+00000000000000d0  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 0000000000000012          pos: 00000000000000e0          len: 0000000000000020
+txn: 0000000000000013          txo: 0000000000000000               flags: lk=0 tx=0
+00000000000000e0  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 37  ........alpha#17
+00000000000000f0  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 0000000000000013          pos: 0000000000000100          len: 0000000000000020
+txn: 0000000000000014          txo: 0000000000000000               flags: lk=0 tx=0
+0000000000000100  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 38  ........alpha#18
+0000000000000110  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+num: 0000000000000014          pos: 0000000000000120          len: 0000000000000020
+txn: 0000000000000015          txo: 0000000000000000               flags: lk=0 tx=0
+0000000000000120  08 00 00 00 00 00 00 00 61 6c 70 68 61 23 31 39  ........alpha#19
+0000000000000130  ff ff ff ff ff ff ff ff 00 00 00 00 00 00 00 00  ................
+
+** Freelist Info
+First freelist entry = 10
+Iterating over freelist...(OK)
+Final freelist entry = 1
+Total freelist entries = 10
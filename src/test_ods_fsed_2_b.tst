@@ -1,5 +1,5 @@
 ** File Info
-Version: 1.0
+Version: 1.1
 Num Logs = 0
 Num Trans = 0
 Num Writers = 0
@@ -11,6 +11,8 @@ Index Free List = n/a
 Total Size of Data = 16804
 Data Transformation Id = 4
 Index Transformation Id = 13
+Compact Data Position = 0
+Compact Reclaimed Bytes = 0
 
 ** Entry Info for: 0-4
 num: 0000000000000000          pos: 0000000000000000          len: 0000000000000100
@@ -19,8 +19,10 @@
 #include "command_parser.h"
 
 #include "config.h"
+#include "regex.h"
 #include "macros.h"
 #include "console.h"
+#include "date_time.h"
 #include "utilities.h"
 
 #ifdef __GNUG__
@@ -36,6 +38,16 @@ extern "C"
 
 using namespace std;
 
+const int c_bench_hash_checks = 200000;
+const int c_bench_commands = 100000;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
+const char* const c_bench_hash = "8f434346648f6b96df89dda901c5176b10a6d83961dd3c1ac88b59b2dc327aa4";
+
+const char* const c_bench_syntax = "<pat/^[A-Fa-f0-9]{64}$/hash>[<opt/-quiet/quiet>][<pat/^[0-9]{1,19}$/limit>]";
+const char* const c_bench_command = "8f434346648f6b96df89dda901c5176b10a6d83961dd3c1ac88b59b2dc327aa4 -quiet 1000";
+
 /*
 
 Format for node expressions:
@@ -984,6 +996,58 @@ command_tests[ ] =
    { "[<opt/a>|[<opt/b>][<opt/c>]<opt/d>|[<opt/e>][<opt/f>]<opt/g>]", "d g f e", false }
 };
 
+void output_bench_result( const string& what, int num, milliseconds elapsed )
+{
+   if( elapsed < 0 )
+      elapsed += c_milliseconds_per_day;
+
+   cout << num << ' ' << what << " in " << elapsed << " ms";
+
+   if( elapsed > 0 )
+      cout << " (" << ( uint64_t )( num * 1000.0 / elapsed ) << ' ' << what << "/sec)";
+
+   cout << '\n';
+}
+
+void perform_bench( )
+{
+   string hash( c_bench_hash );
+
+   mtime start( mtime::standard( ) );
+
+   for( int i = 0; i < c_bench_hash_checks; i++ )
+   {
+      // NOTE: Constructs the regex each time (as is done for validating hashes).
+      regex expr( c_regex_hash_256 );
+
+      if( expr.search( hash ) == string::npos )
+         throw runtime_error( "unexpected hash validation failure" );
+   }
+
+   output_bench_result( "hash checks", c_bench_hash_checks, mtime::standard( ) - start );
+
+   command_parser p;
+   p.parse_syntax( c_bench_syntax );
+
+   if( !p.okay( ) )
+      throw runtime_error( "unexpected invalid bench syntax" );
+
+   vector< string > arguments;
+   setup_arguments( c_bench_command, arguments );
+
+   start = mtime::standard( );
+
+   for( int i = 0; i < c_bench_commands; i++ )
+   {
+      map< string, string > parameters;
+
+      if( !p.parse_command( arguments, parameters ) )
+         throw runtime_error( "unexpected bench command parse failure" );
+   }
+
+   output_bench_result( "commands", c_bench_commands, mtime::standard( ) - start );
+}
+
 int main( int argc, char* argv[ ] )
 {
    bool is_quiet = false;
@@ -1063,6 +1127,8 @@ int main( int argc, char* argv[ ] )
 
          cout << "\nperformed " << num_tests << " test(s) and found " << num_errors << " error(s)\n";
       }
+      else if( argc > 1 && string( argv[ 1 ] ) == "/bench" )
+         perform_bench( );
       else if( argc == 1 )
       {
 #ifdef __GNUG__
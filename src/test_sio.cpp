@@ -0,0 +1,254 @@
+// Copyright (c) 2012-2017 CIYAM Developers
+//
+// Distributed under the MIT/X11 software license, please refer to the file license.txt
+// in the root project directory or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef PRECOMPILE_H
+#  include "precompile.h"
+#endif
+#pragma hdrstop
+
+#ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <ctime>
+#  include <cstring>
+#  include <string>
+#  include <fstream>
+#  include <sstream>
+#  include <iostream>
+#  include <stdexcept>
+#  ifndef _WIN32
+#     include <utime.h>
+#  else
+#     include <sys/utime.h>
+#  endif
+#endif
+
+#include "sio.h"
+#include "macros.h"
+#include "utilities.h"
+#include "console_commands.h"
+
+using namespace std;
+
+#include "test_sio.cmh"
+
+const char* const c_app_title = "test_sio";
+const char* const c_app_version = "0.1";
+
+const char* const c_error_prefix = "error: ";
+
+const char* const c_compiled_ext = "c";
+const char* const c_compiled_magic = "SIOC";
+
+const char* const c_default_value_prefix = "value_";
+
+// NOTE: The compiled header consists of the magic, version, byte order marker, number of lines,
+// flags and padding (4 bytes each) followed by the source file's modification time and size (8
+// bytes each) and then its SHA256 hash (32 bytes).
+const size_t c_compiled_header_size = 72;
+
+const size_t c_compiled_num_lines_offset = 12;
+const size_t c_compiled_flags_offset = 16;
+const size_t c_compiled_source_mod_offset = 24;
+
+const uint32_t c_compiled_flag_verify_hash = 1;
+
+bool g_application_title_called = false;
+
+string application_title( app_info_request request )
+{
+   g_application_title_called = true;
+
+   if( request == e_app_info_request_title )
+      return string( c_app_title );
+   else if( request == e_app_info_request_version )
+      return string( c_app_version );
+   else if( request == e_app_info_request_title_and_version )
+   {
+      string title( c_app_title );
+      title += " v";
+      title += string( c_app_version );
+
+      return title;
+   }
+   else
+   {
+      ostringstream osstr;
+      osstr << "unknown app_info_request: " << request;
+      throw runtime_error( osstr.str( ) );
+   }
+}
+
+string compiled_info( const string& file_name )
+{
+   string compiled_name( file_name + c_compiled_ext );
+
+   if( !file_exists( compiled_name ) )
+      return "compiled: none";
+
+   string data( buffer_file( compiled_name ) );
+
+   if( data.size( ) < c_compiled_header_size || data.compare( 0, strlen( c_compiled_magic ), c_compiled_magic ) != 0 )
+      return "compiled: invalid";
+
+   uint32_t num_lines, flags;
+   int64_t source_mod;
+
+   memcpy( &num_lines, data.data( ) + c_compiled_num_lines_offset, sizeof( uint32_t ) );
+   memcpy( &flags, data.data( ) + c_compiled_flags_offset, sizeof( uint32_t ) );
+   memcpy( &source_mod, data.data( ) + c_compiled_source_mod_offset, sizeof( int64_t ) );
+
+   string info( "compiled: " + to_string( num_lines ) + " lines (verify hash: " );
+
+   info += ( flags & c_compiled_flag_verify_hash ) ? "yes" : "no";
+
+   info += ", source mod: ";
+   info += ( source_mod == ( int64_t )last_modification_time( file_name ) ) ? "matches" : "differs";
+
+   info += ")";
+
+   return info;
+}
+
+class test_sio_command_functor;
+
+class test_sio_command_handler : public console_command_handler
+{
+   friend class test_sio_command_functor;
+
+   public:
+   test_sio_command_handler( )
+   {
+   }
+};
+
+class test_sio_command_functor : public command_functor
+{
+   public:
+   test_sio_command_functor( test_sio_command_handler& sio_test_handler )
+    : command_functor( sio_test_handler )
+   {
+   }
+
+   void operator ( )( const string& command, const parameter_info& parameters );
+};
+
+void test_sio_command_functor::operator ( )( const string& command, const parameter_info& parameters )
+{
+   try
+   {
+      if( command == c_cmd_test_sio_write )
+      {
+         string file_name( get_parm_val( parameters, c_cmd_parm_test_sio_write_file_name ) );
+         size_t num_items( from_string< size_t >( get_parm_val( parameters, c_cmd_parm_test_sio_write_num_items ) ) );
+         string value_prefix( get_parm_val( parameters, c_cmd_parm_test_sio_write_value_prefix ) );
+
+         if( value_prefix.empty( ) )
+            value_prefix = c_default_value_prefix;
+
+         ofstream outf( file_name.c_str( ) );
+         if( !outf )
+            throw runtime_error( "unable to open file '" + file_name + "' for output" );
+
+         sio_writer writer( outf );
+
+         for( size_t i = 0; i < num_items; i++ )
+            writer.write_attribute( "item_" + to_string( i + 1 ), value_prefix + to_string( i + 1 ) );
+
+         writer.finish_sections( );
+      }
+      else if( command == c_cmd_test_sio_read )
+      {
+         string file_name( get_parm_val( parameters, c_cmd_parm_test_sio_read_file_name ) );
+
+         sio_reader reader( file_name );
+
+         string name, value;
+         while( reader.has_read_attribute( name, value ) )
+         {
+            handler.issue_command_reponse( name + " = " + value );
+            name.erase( );
+         }
+
+         reader.verify_finished_sections( );
+      }
+      else if( command == c_cmd_test_sio_info )
+      {
+         string file_name( get_parm_val( parameters, c_cmd_parm_test_sio_info_file_name ) );
+
+         handler.issue_command_reponse( compiled_info( file_name ) );
+      }
+      else if( command == c_cmd_test_sio_backdate )
+      {
+         string file_name( get_parm_val( parameters, c_cmd_parm_test_sio_backdate_file_name ) );
+         int seconds( from_string< int >( get_parm_val( parameters, c_cmd_parm_test_sio_backdate_seconds ) ) );
+
+         struct utimbuf times;
+         times.actime = times.modtime = time( 0 ) - seconds;
+
+         if( utime( file_name.c_str( ), &times ) != 0 )
+            throw runtime_error( "unable to set the modification time of '" + file_name + "'" );
+      }
+      else if( command == c_cmd_test_sio_truncate )
+      {
+         string file_name( get_parm_val( parameters, c_cmd_parm_test_sio_truncate_file_name ) );
+         size_t size( from_string< size_t >( get_parm_val( parameters, c_cmd_parm_test_sio_truncate_size ) ) );
+
+         string data( buffer_file( file_name ) );
+
+         if( size < data.size( ) )
+            write_file( file_name, data.substr( 0, size ) );
+      }
+      else if( command == c_cmd_test_sio_remove )
+      {
+         string file_name( get_parm_val( parameters, c_cmd_parm_test_sio_remove_file_name ) );
+
+         file_remove( file_name );
+      }
+      else if( command == c_cmd_test_sio_exit )
+         handler.set_finished( );
+   }
+   catch( exception& x )
+   {
+      handler.issue_command_reponse( string( c_error_prefix ) + x.what( ), true );
+   }
+}
+
+command_functor* test_sio_command_functor_factory( const string& /*name*/, command_handler& handler )
+{
+   return new test_sio_command_functor( dynamic_cast< test_sio_command_handler& >( handler ) );
+}
+
+int main( int argc, char* argv[ ] )
+{
+   test_sio_command_handler cmd_handler;
+
+   try
+   {
+      // NOTE: Use block scope for startup command processor object...
+      {
+         startup_command_processor processor( cmd_handler, application_title, 0, argc, argv );
+
+         processor.process_commands( );
+      }
+
+      if( !cmd_handler.has_option_quiet( ) )
+         cout << application_title( e_app_info_request_title_and_version ) << endl;
+
+      cmd_handler.add_commands( 0,
+       test_sio_command_functor_factory, ARRAY_PTR_AND_SIZE( test_sio_command_definitions ) );
+
+      console_command_processor processor( cmd_handler );
+      processor.process_commands( );
+   }
+   catch( exception& x )
+   {
+      cerr << "error: " << x.what( ) << endl;
+      return 1;
+   }
+   catch( ... )
+   {
+      cerr << "error: unexpected exception occurred" << endl;
+      return 2;
+   }
+}
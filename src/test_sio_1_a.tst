@@ -0,0 +1,82 @@
+
+> write ~test_sio.sio 3
+
+> backdate ~test_sio.sio 100
+
+> info ~test_sio.sio
+compiled: none
+
+> read ~test_sio.sio
+item_1 = value_1
+item_2 = value_2
+item_3 = value_3
+
+> info ~test_sio.sio
+compiled: 6 lines (verify hash: no, source mod: matches)
+
+> backdate ~test_sio.sio 50
+
+> info ~test_sio.sio
+compiled: 6 lines (verify hash: no, source mod: differs)
+
+> read ~test_sio.sio
+item_1 = value_1
+item_2 = value_2
+item_3 = value_3
+
+> info ~test_sio.sio
+compiled: 6 lines (verify hash: no, source mod: matches)
+
+> write ~test_sio.sio 3 other_
+
+> backdate ~test_sio.sio 40
+
+> read ~test_sio.sio
+item_1 = other_1
+item_2 = other_2
+item_3 = other_3
+
+> info ~test_sio.sio
+compiled: 6 lines (verify hash: no, source mod: matches)
+
+> write ~test_sio.sio 4
+
+> backdate ~test_sio.sio 30
+
+> read ~test_sio.sio
+item_1 = value_1
+item_2 = value_2
+item_3 = value_3
+item_4 = value_4
+
+> info ~test_sio.sio
+compiled: 7 lines (verify hash: no, source mod: matches)
+
+> truncate ~test_sio.sioc 100
+
+> read ~test_sio.sio
+item_1 = value_1
+item_2 = value_2
+item_3 = value_3
+item_4 = value_4
+
+> info ~test_sio.sio
+compiled: 7 lines (verify hash: no, source mod: matches)
+
+> write ~test_sio.sio 2 first_
+
+> read ~test_sio.sio
+item_1 = first_1
+item_2 = first_2
+
+> write ~test_sio.sio 2 later_
+
+> read ~test_sio.sio
+item_1 = later_1
+item_2 = later_2
+
+> remove ~test_sio.sio
+
+> remove ~test_sio.sioc
+
+> exit
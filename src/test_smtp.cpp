@@ -0,0 +1,890 @@
+// Copyright (c) 2012-2017 CIYAM Developers
+//
+// Distributed under the MIT/X11 software license, please refer to the file license.txt
+// in the root project directory or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef PRECOMPILE_H
+#  include "precompile.h"
+#endif
+#pragma hdrstop
+
+#ifndef HAS_PRECOMPILED_STD_HEADERS
+#  include <memory>
+#  include <string>
+#  include <vector>
+#  include <iostream>
+#  include <stdexcept>
+#endif
+
+#include "mime.h"
+#include "pop3.h"
+#include "smtp.h"
+#include "macros.h"
+#include "threads.h"
+#include "sockets.h"
+#include "date_time.h"
+#include "utilities.h"
+#include "console_commands.h"
+
+using namespace std;
+
+#include "test_smtp.cmh"
+
+const char* const c_app_title = "test_smtp";
+const char* const c_app_version = "0.1";
+
+const char* const c_error_prefix = "error: ";
+
+const size_t c_accept_timeout = 250;
+const size_t c_read_line_timeout = 1000;
+const size_t c_max_line_length = 1000;
+const size_t c_read_buffer_size = 4096;
+
+const size_t c_start_stop_wait = 10;
+const size_t c_max_start_stop_waits = 500;
+
+const size_t c_decode_chunk_size = 100;
+
+const char* const c_fetch_file_prefix = "~fetched_";
+
+const size_t c_default_num_bench_messages = 1000;
+const size_t c_default_num_bench_per_connection = 50;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
+bool g_application_title_called = false;
+
+string application_title( app_info_request request )
+{
+   g_application_title_called = true;
+
+   if( request == e_app_info_request_title )
+      return string( c_app_title );
+   else if( request == e_app_info_request_version )
+      return string( c_app_version );
+   else if( request == e_app_info_request_title_and_version )
+   {
+      string title( c_app_title );
+      title += " v";
+      title += string( c_app_version );
+
+      return title;
+   }
+   else
+   {
+      ostringstream osstr;
+      osstr << "unknown app_info_request: " << request;
+      throw runtime_error( osstr.str( ) );
+   }
+}
+
+// NOTE: This is a minimal SMTP server (handling one connection at a time) which accepts
+// any AUTH PLAIN credentials and rejects any recipient whose address contains "reject".
+// If the port is zero then the server will listen on whatever port the system assigns.
+class fake_smtp_server : public joinable_thread
+{
+   public:
+   fake_smtp_server( int port, bool pipelining )
+    :
+    port( port ),
+    pipelining( pipelining ),
+    failed( false ),
+    stopping( false ),
+    listening( false ),
+    finished( false ),
+    num_received( 0 ),
+    num_connections( 0 )
+   {
+   }
+
+   void on_start( );
+
+   void stop( ) { stopping = true; }
+
+   bool has_failed( ) const { return failed; }
+   bool is_listening( ) const { return listening; }
+   bool has_finished( ) const { return finished; }
+
+   int get_port( ) const { return port; }
+
+   bool has_pipelining( ) const { return pipelining; }
+
+   size_t get_num_received( ) const { return num_received; }
+
+   const string& get_last_message( ) const { return last_message; }
+   size_t get_num_connections( ) const { return num_connections; }
+
+   private:
+   bool read_line( tcp_socket& socket, string& str );
+
+   void process_connection( tcp_socket& socket );
+
+   volatile int port;
+   bool pipelining;
+
+   volatile bool failed;
+   volatile bool stopping;
+   volatile bool listening;
+   volatile bool finished;
+
+   volatile size_t num_received;
+   volatile size_t num_connections;
+
+   string buffer;
+   char read_buffer[ c_read_buffer_size ];
+
+   string last_message;
+   string next_message;
+};
+
+void fake_smtp_server::on_start( )
+{
+   try
+   {
+      tcp_socket s;
+      ip_address address( port );
+
+      if( !s.open( ) )
+         failed = true;
+      else
+      {
+         s.set_reuse_addr( );
+
+         if( !s.bind( address ) || !s.listen( ) )
+            failed = true;
+         else
+         {
+            port = s.get_local_port( );
+            listening = true;
+
+            while( !stopping )
+            {
+               tcp_socket socket( s.accept( address, c_accept_timeout ) );
+
+               if( socket )
+               {
+                  socket.set_no_delay( );
+
+                  ++num_connections;
+                  process_connection( socket );
+               }
+            }
+         }
+
+         s.close( );
+      }
+   }
+   catch( exception& x )
+   {
+      failed = true;
+      cerr << c_error_prefix << x.what( ) << endl;
+   }
+   catch( ... )
+   {
+      failed = true;
+      cerr << c_error_prefix << "unexpected unknown exception caught" << endl;
+   }
+
+   finished = true;
+}
+
+bool fake_smtp_server::read_line( tcp_socket& socket, string& str )
+{
+   // NOTE: Reads are buffered (rather than using "tcp_socket::read_line" which reads one
+   // character at a time) so that the server itself will not limit the benchmark results.
+   while( true )
+   {
+      string::size_type pos = buffer.find( "\r\n" );
+
+      if( pos != string::npos )
+      {
+         str = buffer.substr( 0, pos );
+         buffer.erase( 0, pos + 2 );
+
+         return true;
+      }
+
+      if( buffer.size( ) > c_max_line_length )
+         return false;
+
+      int n = socket.recv( ( unsigned char* )read_buffer, sizeof( read_buffer ), c_read_line_timeout );
+
+      if( n > 0 )
+         buffer.append( read_buffer, n );
+      else if( !socket.had_timeout( ) || stopping )
+         return false;
+   }
+}
+
+void fake_smtp_server::process_connection( tcp_socket& socket )
+{
+   buffer.erase( );
+
+   string str( "220 localhost fake SMTP server ready" );
+   socket.write_line( str );
+
+   size_t num_recipients = 0;
+
+   while( read_line( socket, str ) )
+   {
+      string command( upper( str.substr( 0, 4 ) ) );
+
+      if( command == "HELO" )
+         str = "250 localhost";
+      else if( command == "EHLO" )
+      {
+         str = "250-localhost\r\n";
+
+         if( pipelining )
+            str += "250-PIPELINING\r\n";
+
+         str += "250 AUTH PLAIN";
+      }
+      else if( command == "AUTH" )
+         str = "235 authentication successful";
+      else if( command == "MAIL" )
+      {
+         num_recipients = 0;
+         str = "250 OK";
+      }
+      else if( command == "RCPT" )
+      {
+         if( lower( str ).find( "reject" ) != string::npos )
+            str = "550 mailbox unavailable";
+         else
+         {
+            ++num_recipients;
+            str = "250 OK";
+         }
+      }
+      else if( command == "DATA" )
+      {
+         if( !num_recipients )
+            str = "554 no valid recipients";
+         else
+         {
+            str = "354 end data with <CR><LF>.<CR><LF>";
+            socket.write_line( str );
+
+            bool has_terminator = false;
+
+            next_message.erase( );
+
+            while( read_line( socket, str ) )
+            {
+               if( str == "." )
+               {
+                  has_terminator = true;
+                  break;
+               }
+
+               // NOTE: Remove any fullstop that had been doubled for "transparency".
+               if( !str.empty( ) && str[ 0 ] == '.' )
+                  str.erase( 0, 1 );
+
+               next_message += str + '\n';
+            }
+
+            if( !has_terminator )
+               break;
+
+            ++num_received;
+            last_message.swap( next_message );
+            num_recipients = 0;
+
+            str = "250 OK message accepted";
+         }
+      }
+      else if( command == "RSET" )
+      {
+         num_recipients = 0;
+         str = "250 OK";
+      }
+      else if( command == "QUIT" )
+      {
+         str = "221 bye";
+         socket.write_line( str );
+
+         break;
+      }
+      else
+         str = "500 unrecognised command";
+
+      socket.write_line( str );
+   }
+
+   socket.close( );
+}
+
+// NOTE: This is a minimal POP3 server (handling just a single connection) which accepts any
+// USER/PASS credentials and provides just the one message (that is given to its constructor).
+class fake_pop3_server : public joinable_thread
+{
+   public:
+   fake_pop3_server( int port, const string& message )
+    :
+    port( port ),
+    message( message ),
+    listening( false ),
+    finished( false )
+   {
+   }
+
+   void on_start( );
+
+   int get_port( ) const { return port; }
+
+   bool is_listening( ) const { return listening; }
+   bool has_finished( ) const { return finished; }
+
+   private:
+   void process_connection( tcp_socket& socket );
+
+   volatile int port;
+   string message;
+
+   volatile bool listening;
+   volatile bool finished;
+};
+
+void fake_pop3_server::on_start( )
+{
+   try
+   {
+      tcp_socket s;
+      ip_address address( port );
+
+      if( s.open( ) )
+      {
+         s.set_reuse_addr( );
+
+         if( s.bind( address ) && s.listen( ) )
+         {
+            port = s.get_local_port( );
+            listening = true;
+
+            tcp_socket socket( s.accept( address, c_read_line_timeout ) );
+
+            if( socket )
+               process_connection( socket );
+         }
+
+         s.close( );
+      }
+   }
+   catch( exception& x )
+   {
+      cerr << c_error_prefix << x.what( ) << endl;
+   }
+   catch( ... )
+   {
+      cerr << c_error_prefix << "unexpected unknown exception caught" << endl;
+   }
+
+   finished = true;
+}
+
+void fake_pop3_server::process_connection( tcp_socket& socket )
+{
+   string str( "+OK fake POP3 server ready" );
+   socket.write_line( str );
+
+   bool deleted = false;
+
+   while( true )
+   {
+      str.erase( );
+
+      if( socket.read_line( str, c_read_line_timeout ) <= 0 )
+         break;
+
+      string command( upper( str.substr( 0, 4 ) ) );
+
+      if( command == "USER" || command == "PASS" )
+         str = "+OK";
+      else if( command == "STAT" )
+         str = "+OK " + to_string( deleted ? 0 : 1 ) + " " + to_string( deleted ? 0 : message.size( ) );
+      else if( command == "LIST" )
+      {
+         str = "+OK\r\n";
+
+         if( !deleted )
+            str += "1 " + to_string( message.size( ) ) + "\r\n";
+
+         str += ".";
+      }
+      else if( command == "RETR" )
+      {
+         if( deleted || str != "RETR 1" )
+            str = "-ERR no such message";
+         else
+         {
+            str = "+OK\r\n";
+
+            string::size_type from = 0;
+
+            while( from < message.size( ) )
+            {
+               string::size_type pos = message.find( '\n', from );
+               if( pos == string::npos )
+                  pos = message.size( );
+
+               string line( message.substr( from, pos - from ) );
+
+               // NOTE: Any line starting with a fullstop has it doubled for "transparency".
+               if( !line.empty( ) && line[ 0 ] == '.' )
+                  str += '.';
+
+               str += line + "\r\n";
+
+               from = pos + 1;
+            }
+
+            str += ".";
+         }
+      }
+      else if( command == "DELE" )
+      {
+         deleted = true;
+         str = "+OK";
+      }
+      else if( command == "QUIT" )
+      {
+         str = "+OK bye";
+         socket.write_line( str );
+
+         break;
+      }
+      else
+         str = "-ERR unrecognised command";
+
+      socket.write_line( str );
+   }
+
+   socket.close( );
+}
+
+// NOTE: Checks that each part streamed by "mime_decoder" is identical to the original file.
+class attached_file_checker : public mime_part_handler
+{
+   public:
+   ostream* open_part_stream( const mime_part& part ) { return new ostringstream; }
+
+   void close_part_stream( const mime_part& part, ostream* p_os );
+
+   vector< string > results;
+};
+
+void attached_file_checker::close_part_stream( const mime_part& part, ostream* p_os )
+{
+   auto_ptr< ostringstream > ap_osstr( dynamic_cast< ostringstream* >( p_os ) );
+
+   string result( part.type + "/" + part.subtype + " " + part.attribute );
+
+   if( !file_exists( part.attribute ) )
+      result += " (file not found)";
+   else if( buffer_file( part.attribute ) == ap_osstr->str( ) )
+      result += " (decoded " + to_string( ap_osstr->str( ).size( ) ) + " bytes okay)";
+   else
+      result += " (decoded data does not match)";
+
+   results.push_back( result );
+}
+
+void output_mime_parts( const mime_decoder& decoder, vector< string >& results )
+{
+   for( size_t i = 0; i < decoder.num_parts( ); i++ )
+   {
+      mime_part& part( decoder.get_part( i ) );
+
+      if( part.type == "text" )
+         results.push_back( part.type + "/" + part.subtype + " (" + part.encoding + ")" );
+   }
+}
+
+class test_smtp_command_functor;
+
+class test_smtp_command_handler : public console_command_handler
+{
+   friend class test_smtp_command_functor;
+
+   public:
+   test_smtp_command_handler( )
+    :
+    port( 0 ),
+    p_server( 0 )
+   {
+   }
+
+   ~test_smtp_command_handler( )
+   {
+      stop_server( );
+   }
+
+   private:
+   void start_server( bool pipelining );
+   void stop_server( );
+
+   int get_server_port( ) const;
+
+   smtp_user_info get_user_info( ) const;
+
+   int port;
+   fake_smtp_server* p_server;
+};
+
+void test_smtp_command_handler::start_server( bool pipelining )
+{
+   if( p_server )
+      throw runtime_error( "fake SMTP server has already been started" );
+
+   auto_ptr< fake_smtp_server > ap_server( new fake_smtp_server( port, pipelining ) );
+   ap_server->start( );
+
+   for( size_t i = 0; i < c_max_start_stop_waits; i++ )
+   {
+      if( ap_server->is_listening( ) || ap_server->has_finished( ) )
+         break;
+
+      msleep( c_start_stop_wait );
+   }
+
+   if( !ap_server->is_listening( ) )
+   {
+      ap_server->stop( );
+      ap_server->join( );
+
+      throw runtime_error( "unable to start fake SMTP server"
+       + ( port ? " on port #" + to_string( port ) : string( ) ) );
+   }
+
+   p_server = ap_server.release( );
+}
+
+void test_smtp_command_handler::stop_server( )
+{
+   if( p_server )
+   {
+      p_server->stop( );
+      p_server->join( );
+
+      delete p_server;
+      p_server = 0;
+   }
+}
+
+int test_smtp_command_handler::get_server_port( ) const
+{
+   if( !p_server )
+      throw runtime_error( "fake SMTP server has not been started" );
+
+   return p_server->get_port( );
+}
+
+smtp_user_info test_smtp_command_handler::get_user_info( ) const
+{
+   smtp_user_info user_info( "test@localhost", "test", "test" );
+   user_info.auth_type = e_smtp_auth_type_plain;
+
+   return user_info;
+}
+
+class test_smtp_command_functor : public command_functor
+{
+   public:
+   test_smtp_command_functor( test_smtp_command_handler& smtp_test_handler )
+    : command_functor( smtp_test_handler ),
+    smtp_handler( smtp_test_handler )
+   {
+   }
+
+   void operator ( )( const string& command, const parameter_info& parameters );
+
+   private:
+   test_smtp_command_handler& smtp_handler;
+};
+
+void test_smtp_command_functor::operator ( )( const string& command, const parameter_info& parameters )
+{
+   try
+   {
+      if( command == c_cmd_test_smtp_start )
+      {
+         bool no_pipelining( has_parm_val( parameters, c_cmd_parm_test_smtp_start_no_pipelining ) );
+         string port( get_parm_val( parameters, c_cmd_parm_test_smtp_start_port ) );
+
+         if( !port.empty( ) )
+            smtp_handler.port = atoi( port.c_str( ) );
+
+         smtp_handler.start_server( !no_pipelining );
+      }
+      else if( command == c_cmd_test_smtp_stop )
+         smtp_handler.stop_server( );
+      else if( command == c_cmd_test_smtp_send )
+      {
+         string recipients( get_parm_val( parameters, c_cmd_parm_test_smtp_send_recipients ) );
+         string num_messages( get_parm_val( parameters, c_cmd_parm_test_smtp_send_num_messages ) );
+         string file_names( get_parm_val( parameters, c_cmd_parm_test_smtp_send_file_names ) );
+
+         size_t num_to_send = 1;
+         if( !num_messages.empty( ) )
+            num_to_send = from_string< size_t >( num_messages );
+
+         smtp_message message;
+         split( recipients, message.recipients );
+
+         if( !file_names.empty( ) )
+            split( file_names, message.file_names );
+
+         smtp_connection connection( "127.0.0.1:" + to_string( smtp_handler.get_server_port( ) ), smtp_handler.get_user_info( ) );
+
+         handler.issue_command_reponse( string( "pipelining: " ) + ( connection.has_pipelining( ) ? "yes" : "no" ) );
+
+         for( size_t i = 0; i < num_to_send; i++ )
+         {
+            message.subject = "Test message #" + to_string( i + 1 );
+            message.message = "This is test message #" + to_string( i + 1 ) + ".\n.\nThe End";
+
+            try
+            {
+               connection.send( message );
+            }
+            catch( exception& x )
+            {
+               handler.issue_command_reponse( string( c_error_prefix ) + x.what( )
+                + ( is_permanent_smtp_failure( x.what( ) ) ? " (permanent)" : "" ), true );
+            }
+         }
+
+         handler.issue_command_reponse( "sent " + to_string( connection.get_num_sent( ) )
+          + " of " + to_string( num_to_send ) + " messages (connection is "
+          + ( connection.is_okay( ) ? "okay" : "not okay" ) + ")" );
+
+         connection.quit( );
+      }
+      else if( command == c_cmd_test_smtp_received )
+      {
+         if( !smtp_handler.p_server )
+            throw runtime_error( "fake SMTP server has not been started" );
+
+         handler.issue_command_reponse( to_string( smtp_handler.p_server->get_num_received( ) )
+          + " messages received using " + to_string( smtp_handler.p_server->get_num_connections( ) ) + " connections" );
+      }
+      else if( command == c_cmd_test_smtp_decode )
+      {
+         if( !smtp_handler.p_server )
+            throw runtime_error( "fake SMTP server has not been started" );
+
+         attached_file_checker checker;
+         mime_decoder decoder( &checker );
+
+         // NOTE: Write the message in small chunks to test incremental decoding.
+         const string& message( smtp_handler.p_server->get_last_message( ) );
+
+         for( size_t i = 0; i < message.size( ); i += c_decode_chunk_size )
+            decoder.get_stream( ) << message.substr( i, c_decode_chunk_size );
+
+         decoder.finish( );
+
+         vector< string > results;
+
+         output_mime_parts( decoder, results );
+
+         if( decoder.has_child( ) )
+            output_mime_parts( decoder.get_child( ), results );
+
+         results.insert( results.end( ), checker.results.begin( ), checker.results.end( ) );
+
+         for( size_t i = 0; i < results.size( ); i++ )
+            handler.issue_command_reponse( results[ i ] );
+      }
+      else if( command == c_cmd_test_smtp_fetch )
+      {
+         if( !smtp_handler.p_server )
+            throw runtime_error( "fake SMTP server has not been started" );
+
+         fake_pop3_server pop3_server( 0, smtp_handler.p_server->get_last_message( ) );
+         pop3_server.start( );
+
+         for( size_t i = 0; i < c_max_start_stop_waits; i++ )
+         {
+            if( pop3_server.is_listening( ) || pop3_server.has_finished( ) )
+               break;
+
+            msleep( c_start_stop_wait );
+         }
+
+         vector< string > results;
+         vector< string > file_names;
+
+         try
+         {
+            if( !pop3_server.is_listening( ) )
+               throw runtime_error( "unable to start fake POP3 server" );
+
+            pop3 client( "127.0.0.1", pop3_server.get_port( ) );
+            client.login( "test", "test" );
+
+            results.push_back( "fetching " + to_string( client.get_num_messages( ) ) + " message(s)" );
+
+            // NOTE: The message is decoded as it is being retrieved (with attachments being
+            // decoded directly into files rather than the whole message being held in memory).
+            mime_file_handler file_handler( c_fetch_file_prefix, file_names );
+            mime_decoder decoder( &file_handler );
+
+            client.get_message( 1, decoder.get_stream( ) );
+            decoder.finish( );
+
+            client.delete_message( 1 );
+            client.disconnect( );
+
+            output_mime_parts( decoder, results );
+
+            if( decoder.has_child( ) )
+               output_mime_parts( decoder.get_child( ), results );
+         }
+         catch( ... )
+         {
+            pop3_server.join( );
+
+            for( size_t i = 0; i < file_names.size( ); i++ )
+               file_remove( file_names[ i ] );
+
+            throw;
+         }
+
+         pop3_server.join( );
+
+         for( size_t i = 0; i < file_names.size( ); i++ )
+         {
+            string source( file_names[ i ].substr( string( c_fetch_file_prefix ).size( ) ) );
+            string result( source );
+
+            if( !file_exists( source ) )
+               result += " (file not found)";
+            else if( buffer_file( source ) == buffer_file( file_names[ i ] ) )
+               result += " (fetched " + to_string( file_size( file_names[ i ] ) ) + " bytes okay)";
+            else
+               result += " (fetched data does not match)";
+
+            file_remove( file_names[ i ] );
+
+            results.push_back( result );
+         }
+
+         for( size_t i = 0; i < results.size( ); i++ )
+            handler.issue_command_reponse( results[ i ] );
+      }
+      else if( command == c_cmd_test_smtp_bench )
+      {
+         if( !smtp_handler.p_server )
+            throw runtime_error( "fake SMTP server has not been started" );
+
+         size_t num_messages = c_default_num_bench_messages;
+         size_t per_connection = c_default_num_bench_per_connection;
+
+         string num_msgs( get_parm_val( parameters, c_cmd_parm_test_smtp_bench_num_messages ) );
+         string per_conn( get_parm_val( parameters, c_cmd_parm_test_smtp_bench_per_connection ) );
+
+         if( !num_msgs.empty( ) )
+            num_messages = from_string< size_t >( num_msgs );
+
+         if( !per_conn.empty( ) )
+            per_connection = from_string< size_t >( per_conn );
+
+         if( !per_connection )
+            per_connection = 1;
+
+         smtp_message message;
+         message.recipients.push_back( "bench@localhost" );
+
+         message.subject = "Benchmark message";
+         message.message = string( 1000, 'x' );
+
+         smtp_user_info user_info( smtp_handler.get_user_info( ) );
+         string host_and_port( "127.0.0.1:" + to_string( smtp_handler.get_server_port( ) ) );
+
+         size_t num_sent = 0;
+         size_t num_connections = 0;
+
+         mtime start( mtime::standard( ) );
+
+         while( num_sent < num_messages )
+         {
+            smtp_connection connection( host_and_port, user_info );
+            ++num_connections;
+
+            for( size_t i = 0; i < per_connection && num_sent < num_messages; i++ )
+            {
+               connection.send( message );
+               ++num_sent;
+            }
+
+            connection.quit( );
+         }
+
+         milliseconds elapsed = mtime::standard( ) - start;
+
+         if( elapsed < 0 )
+            elapsed += c_milliseconds_per_day;
+
+         ostringstream osstr;
+         osstr << num_sent << " messages using " << num_connections << " connections ("
+          << ( smtp_handler.p_server->has_pipelining( ) ? "pipelined" : "not pipelined" ) << ") in " << elapsed << " ms";
+
+         if( elapsed > 0 )
+            osstr << " (" << ( uint64_t )( num_sent * 1000.0 / elapsed ) << " messages/sec)";
+
+         handler.issue_command_reponse( osstr.str( ) );
+      }
+      else if( command == c_cmd_test_smtp_exit )
+         handler.set_finished( );
+   }
+   catch( exception& x )
+   {
+      handler.issue_command_reponse( string( c_error_prefix ) + x.what( ), true );
+   }
+}
+
+command_functor* test_smtp_command_functor_factory( const string& /*name*/, command_handler& handler )
+{
+   return new test_smtp_command_functor( dynamic_cast< test_smtp_command_handler& >( handler ) );
+}
+
+int main( int argc, char* argv[ ] )
+{
+#ifdef _WIN32
+   winsock_init wsi;
+#endif
+
+   test_smtp_command_handler cmd_handler;
+
+   try
+   {
+      // NOTE: Use block scope for startup command processor object...
+      {
+         startup_command_processor processor( cmd_handler, application_title, 0, argc, argv );
+
+         processor.process_commands( );
+      }
+
+      if( !cmd_handler.has_option_quiet( ) )
+         cout << application_title( e_app_info_request_title_and_version ) << endl;
+
+      cmd_handler.add_commands( 0,
+       test_smtp_command_functor_factory, ARRAY_PTR_AND_SIZE( test_smtp_command_definitions ) );
+
+      console_command_processor processor( cmd_handler );
+      processor.process_commands( );
+   }
+   catch( exception& x )
+   {
+      cerr << "error: " << x.what( ) << endl;
+      return 1;
+   }
+   catch( ... )
+   {
+      cerr << "error: unexpected exception occurred" << endl;
+      return 2;
+   }
+}
@@ -0,0 +1,59 @@
+
+> start
+
+> send a@x,b@x 3
+pipelining: yes
+sent 3 of 3 messages (connection is okay)
+
+> send a@x,reject@x,b@x 2
+pipelining: yes
+error: 550 mailbox unavailable (permanent)
+error: smtp connection is no longer usable
+sent 0 of 2 messages (connection is not okay)
+
+> send reject@x 1
+pipelining: yes
+error: 550 mailbox unavailable (permanent)
+sent 0 of 1 messages (connection is okay)
+
+> send a@x 2
+pipelining: yes
+sent 2 of 2 messages (connection is okay)
+
+> received
+5 messages received using 4 connections
+
+> send a@x 1 -attach=test_smtp.cms,background_texture.png
+pipelining: yes
+sent 1 of 1 messages (connection is okay)
+
+> decode
+text/plain (7bit)
+application/octet-stream test_smtp.cms (decoded 594 bytes okay)
+application/octet-stream background_texture.png (decoded 18976 bytes okay)
+
+> fetch
+fetching 1 message(s)
+text/plain (7bit)
+test_smtp.cms (fetched 594 bytes okay)
+background_texture.png (fetched 18976 bytes okay)
+
+> stop
+
+> start -no_pipelining
+
+> send a@x,reject@x 1
+pipelining: no
+error: 550 mailbox unavailable (permanent)
+sent 0 of 1 messages (connection is okay)
+
+> send a@x 2
+pipelining: no
+sent 2 of 2 messages (connection is okay)
+
+> received
+2 messages received using 2 connections
+
+> stop
+
+> exit
@@ -9,11 +9,15 @@
 
 #  ifndef HAS_PRECOMPILED_STD_HEADERS
 #     include <string>
+#     include <vector>
 #     include <iostream>
 #  endif
 
 #  ifndef _WIN32
+#     include <errno.h>
+#     include <time.h>
 #     include <pthread.h>
+#     include <sys/time.h>
 #  else
 #     define NOMINMAX
 #     define _WINSOCKAPI_
@@ -177,6 +181,294 @@ class guard
    std::string msg;
 };
 
+// NOTE: Allows threads to wait (for no longer than a given time) until notified of a change. As
+// a caller obtains the generation before checking whatever it needs to wait for a notification
+// that occurs after the check but prior to the wait being started will not be missed.
+class wait_notifier
+{
+   public:
+   wait_notifier( )
+    :
+    generation( 0 )
+   {
+#  ifndef _WIN32
+      ::pthread_mutex_init( &ptm, 0 );
+      ::pthread_cond_init( &ptc, 0 );
+#  else
+      ::InitializeCriticalSection( &cs );
+      ::InitializeConditionVariable( &cv );
+#  endif
+   }
+
+   ~wait_notifier( )
+   {
+#  ifndef _WIN32
+      ::pthread_cond_destroy( &ptc );
+      ::pthread_mutex_destroy( &ptm );
+#  else
+      ::DeleteCriticalSection( &cs );
+#  endif
+   }
+
+   unsigned long get_generation( )
+   {
+      unsigned long retval;
+#  ifndef _WIN32
+      ::pthread_mutex_lock( &ptm );
+      retval = generation;
+      ::pthread_mutex_unlock( &ptm );
+#  else
+      ::EnterCriticalSection( &cs );
+      retval = generation;
+      ::LeaveCriticalSection( &cs );
+#  endif
+      return retval;
+   }
+
+   // NOTE: Returns the number of milliseconds that were spent waiting (with "last_generation"
+   // being updated to the current generation so it can be used again for a subsequent wait).
+   int wait( unsigned long& last_generation, int max_msecs )
+   {
+      int waited = 0;
+#  ifndef _WIN32
+      timeval start;
+      ::gettimeofday( &start, 0 );
+
+      timespec until;
+      long long usecs = start.tv_usec + ( long long )max_msecs * 1000;
+
+      until.tv_sec = start.tv_sec + ( usecs / 1000000 );
+      until.tv_nsec = ( usecs % 1000000 ) * 1000;
+
+      ::pthread_mutex_lock( &ptm );
+
+      while( generation == last_generation )
+      {
+         if( ::pthread_cond_timedwait( &ptc, &ptm, &until ) == ETIMEDOUT )
+            break;
+      }
+
+      last_generation = generation;
+      ::pthread_mutex_unlock( &ptm );
+
+      timeval finish;
+      ::gettimeofday( &finish, 0 );
+
+      waited = ( int )( ( ( finish.tv_sec - start.tv_sec ) * 1000 ) + ( ( finish.tv_usec - start.tv_usec ) / 1000 ) );
+#  else
+      DWORD start = ::GetTickCount( );
+
+      ::EnterCriticalSection( &cs );
+
+      while( generation == last_generation )
+      {
+         DWORD elapsed = ::GetTickCount( ) - start;
+
+         if( elapsed >= ( DWORD )max_msecs
+          || !::SleepConditionVariableCS( &cv, &cs, max_msecs - elapsed ) )
+            break;
+      }
+
+      last_generation = generation;
+      ::LeaveCriticalSection( &cs );
+
+      waited = ( int )( ::GetTickCount( ) - start );
+#  endif
+      return waited;
+   }
+
+   void notify( )
+   {
+#  ifndef _WIN32
+      ::pthread_mutex_lock( &ptm );
+      ++generation;
+      ::pthread_cond_broadcast( &ptc );
+      ::pthread_mutex_unlock( &ptm );
+#  else
+      ::EnterCriticalSection( &cs );
+      ++generation;
+      ::WakeAllConditionVariable( &cv );
+      ::LeaveCriticalSection( &cs );
+#  endif
+   }
+
+   private:
+   unsigned long generation;
+
+#  ifndef _WIN32
+   pthread_mutex_t ptm;
+   pthread_cond_t ptc;
+#  else
+   CRITICAL_SECTION cs;
+   CONDITION_VARIABLE cv;
+#  endif
+};
+
+// NOTE: Returns a number of milliseconds that is unaffected by any changes to the system clock
+// (so is suitable for determining deadlines).
+inline unsigned long long monotonic_msecs( )
+{
+#  ifndef _WIN32
+   timespec ts;
+   ::clock_gettime( CLOCK_MONOTONIC, &ts );
+
+   return ( unsigned long long )ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#  else
+   return ::GetTickCount64( );
+#  endif
+}
+
+#  ifndef _WIN32
+inline long atomic_increment( volatile long& value ) { return __sync_add_and_fetch( &value, 1 ); }
+inline long atomic_decrement( volatile long& value ) { return __sync_sub_and_fetch( &value, 1 ); }
+
+inline void memory_barrier( ) { __sync_synchronize( ); }
+#  else
+inline long atomic_increment( volatile long& value ) { return ::InterlockedIncrement( &value ); }
+inline long atomic_decrement( volatile long& value ) { return ::InterlockedDecrement( &value ); }
+
+inline void memory_barrier( ) { ::MemoryBarrier( ); }
+#  endif
+
+// NOTE: Holds an immutable value that can be read without any locking. A writer replaces the
+// value by publishing a new one (writers must be serialised by the caller) and the value it
+// replaced is retired. Readers are counted in one of two slots (according to the parity of
+// the current epoch which is advanced by each publish so that slots will regularly drain).
+// As every reader is counted prior to fetching the value a retired value can be deleted as
+// soon as each of the slots has been found to be empty at some point after its retirement.
+template< typename T > class read_snapshot
+{
+   public:
+   read_snapshot( )
+    :
+    p_value( new T ),
+    epoch( 0 )
+   {
+      readers[ 0 ] = readers[ 1 ] = 0;
+   }
+
+   ~read_snapshot( )
+   {
+      delete p_value;
+
+      for( size_t i = 0; i < retired.size( ); i++ )
+         delete retired[ i ].p_value;
+   }
+
+   class reader
+   {
+      public:
+      reader( read_snapshot& snapshot )
+       :
+       snapshot( snapshot )
+      {
+         p_value = snapshot.enter( slot );
+      }
+
+      ~reader( )
+      {
+         snapshot.leave( slot );
+      }
+
+      const T& operator *( ) const { return *p_value; }
+      const T* operator ->( ) const { return p_value; }
+
+      private:
+      reader( const reader& );
+      reader& operator =( const reader& );
+
+      size_t slot;
+      const T* p_value;
+
+      read_snapshot& snapshot;
+   };
+
+   void publish( T* p_new_value )
+   {
+      retired.push_back( retired_value( p_value ) );
+
+      p_value = p_new_value;
+      memory_barrier( );
+
+      atomic_increment( epoch );
+
+      reclaim( );
+   }
+
+   size_t num_retired( ) const { return retired.size( ); }
+
+   private:
+   read_snapshot( const read_snapshot& );
+   read_snapshot& operator =( const read_snapshot& );
+
+   const T* enter( size_t& slot )
+   {
+      while( true )
+      {
+         long current = epoch;
+         slot = ( current & 1 );
+
+         atomic_increment( readers[ slot ] );
+
+         // NOTE: If the epoch has been advanced since it was read then the read is restarted
+         // so that readers will only be counted in the slot for the current epoch.
+         if( epoch == current )
+         {
+            memory_barrier( );
+            return p_value;
+         }
+
+         atomic_decrement( readers[ slot ] );
+      }
+   }
+
+   void leave( size_t slot )
+   {
+      atomic_decrement( readers[ slot ] );
+   }
+
+   void reclaim( )
+   {
+      memory_barrier( );
+
+      bool empty[ 2 ] = { !readers[ 0 ], !readers[ 1 ] };
+
+      for( size_t i = 0; i < retired.size( ); )
+      {
+         for( size_t j = 0; j < 2; j++ )
+         {
+            if( empty[ j ] )
+               retired[ i ].was_empty[ j ] = true;
+         }
+
+         if( !retired[ i ].was_empty[ 0 ] || !retired[ i ].was_empty[ 1 ] )
+            ++i;
+         else
+         {
+            delete retired[ i ].p_value;
+
+            retired[ i ] = retired.back( );
+            retired.pop_back( );
+         }
+      }
+   }
+
+   struct retired_value
+   {
+      retired_value( T* p_value ) : p_value( p_value ) { was_empty[ 0 ] = was_empty[ 1 ] = false; }
+
+      T* p_value;
+      bool was_empty[ 2 ];
+   };
+
+   T* volatile p_value;
+
+   volatile long epoch;
+   volatile long readers[ 2 ];
+
+   std::vector< retired_value > retired;
+};
+
 #  ifdef _WIN32
 unsigned long __stdcall threadfunc( void* pv );
 #  else
@@ -228,5 +520,145 @@ inline unsigned long __stdcall threadfunc( void* pv )
 }
 #  endif
 
+// NOTE: Unlike "thread" (which is detached and will usually delete itself) a "joinable_thread" is
+// owned by whoever started it and must be joined before being deleted. As the join only returns
+// after the thread has completely finished any state that it uses (such as objects owned by the
+// caller's stack) can then be safely destroyed. If a thread cannot be created then "on_start" is
+// instead called by "start" itself.
+class joinable_thread
+{
+   public:
+   joinable_thread( ) : is_running( false ) { }
+
+   virtual ~joinable_thread( ) { }
+
+   void start( )
+   {
+#  ifndef _WIN32
+      is_running = ( ::pthread_create( &tid, 0, joinable_threadfunc, ( void* )this ) == 0 );
+#  else
+      handle = ::CreateThread( 0, 0, joinable_threadfunc, this, 0, 0 );
+      is_running = ( handle != 0 );
+#  endif
+      if( !is_running )
+         on_start( );
+   }
+
+   void join( )
+   {
+      if( is_running )
+      {
+#  ifndef _WIN32
+         ::pthread_join( tid, 0 );
+#  else
+         ::WaitForSingleObject( handle, INFINITE );
+         ::CloseHandle( handle );
+#  endif
+         is_running = false;
+      }
+   }
+
+   virtual void on_start( ) = 0;
+
+   private:
+   joinable_thread( const joinable_thread& );
+   joinable_thread& operator =( const joinable_thread& );
+
+#  ifndef _WIN32
+   static void* joinable_threadfunc( void* p )
+   {
+      ( ( joinable_thread* )p )->on_start( );
+
+      return 0;
+   }
+#  else
+   static unsigned long __stdcall joinable_threadfunc( void* p )
+   {
+      ( ( joinable_thread* )p )->on_start( );
+
+      return 0;
+   }
+#  endif
+
+   bool is_running;
+
+#  ifndef _WIN32
+   pthread_t tid;
+#  else
+   HANDLE handle;
+#  endif
+};
+
+// NOTE: Owns a group of started joinable threads which are all joined (and then deleted) either
+// by calling "join_all" or by the destructor.
+class worker_group
+{
+   public:
+   worker_group( ) { }
+
+   ~worker_group( ) { join_all( ); }
+
+   void start( joinable_thread* p_worker )
+   {
+      workers.push_back( p_worker );
+      p_worker->start( );
+   }
+
+   void join_all( )
+   {
+      for( size_t i = 0; i < workers.size( ); i++ )
+      {
+         workers[ i ]->join( );
+         delete workers[ i ];
+      }
+
+      workers.clear( );
+   }
+
+   size_t size( ) const { return workers.size( ); }
+
+   private:
+   worker_group( const worker_group& );
+   worker_group& operator =( const worker_group& );
+
+   std::vector< joinable_thread* > workers;
+};
+
+template< typename T > class member_worker : public joinable_thread
+{
+   public:
+   member_worker( T& obj, bool ( T::*p_func )( ) ) : obj( obj ), p_func( p_func ) { }
+
+   void on_start( )
+   {
+      while( ( obj.*p_func )( ) )
+         ;
+   }
+
+   private:
+   T& obj;
+   bool ( T::*p_func )( );
+};
+
+// NOTE: Repeatedly calls the member function (until it returns false) in each of the number of
+// threads provided and only returns after all of these threads have finished.
+template< typename T > void run_in_threads( T& obj, bool ( T::*p_func )( ), size_t num_threads )
+{
+   if( num_threads <= 1 )
+   {
+      while( ( obj.*p_func )( ) )
+         ;
+   }
+   else
+   {
+      worker_group workers;
+
+      for( size_t i = 0; i < num_threads; i++ )
+         workers.start( new member_worker< T >( obj, p_func ) );
+
+      workers.join_all( );
+   }
+}
+
 #endif
 
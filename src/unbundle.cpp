@@ -18,6 +18,7 @@
 #  include <string>
 #  include <memory>
 #  include <fstream>
+#  include <iomanip>
 #  include <iostream>
 #  include <stdexcept>
 #  include <sys/stat.h>
@@ -51,6 +52,7 @@
 #include "config.h"
 #include "format.h"
 #include "console.h"
+#include "date_time.h"
 #include "utilities.h"
 
 #ifdef ZLIB_SUPPORT
@@ -75,6 +77,12 @@ const char c_type_directory = 'D';
 const int c_buffer_size = 65536;
 const int c_progress_lines = 250;
 
+const int c_zlib_read_buffer_size = 131072;
+
+const double c_bytes_per_megabyte = 1048576.0;
+
+const milliseconds c_milliseconds_per_day = 86400000;
+
 const char* const c_zlib_extension = ".gz";
 const char* const c_default_extension = ".bun";
 
@@ -112,13 +120,16 @@ string unescaped_line( const string& line )
 #ifdef ZLIB_SUPPORT
 bool read_zlib_line( gzFile& gzf, string& s )
 {
-   char c;
    s.erase( );
 
+   // NOTE: Uses "gzgetc" (which reads directly from the zlib buffer unless it needs refilling)
+   // rather than calling "gzread" for every character.
    bool is_escape = false;
    while( true )
    {
-      if( gzread( gzf, &c, sizeof( char ) ) <= 0 )
+      int ch = gzgetc( gzf );
+
+      if( ch == -1 )
       {
          if( gzeof( gzf ) )
             break;
@@ -126,6 +137,8 @@ bool read_zlib_line( gzFile& gzf, string& s )
             throw runtime_error( "reading char" );
       }
 
+      char c = ( char )ch;
+
       if( is_escape )
       {
          is_escape = false;
@@ -302,7 +315,7 @@ int main( int argc, char* argv[ ] )
    }
 
    if( !is_quiet )
-      cout << "unbundle v0.1f\n";
+      cout << "unbundle v0.1g\n";
 
    if( ( argc - first_arg < 2 )
     || string( argv[ 1 ] ) == "?" || string( argv[ 1 ] ) == "/?" || string( argv[ 1 ] ) == "-?" )
@@ -324,6 +337,8 @@ int main( int argc, char* argv[ ] )
 
    try
    {
+      mtime start( mtime::standard( ) );
+
       string filename( argv[ first_arg + 1 ] );
 
       if( !filename.empty( ) && filename[ 0 ] == '-' )
@@ -357,8 +372,13 @@ int main( int argc, char* argv[ ] )
       if( !use_zlib )
          inpf.open( filename.c_str( ) );
       else
+      {
          gzf = gzopen( filename.c_str( ), "rb" );
 
+         if( gzf )
+            gzbuffer( gzf, c_zlib_read_buffer_size );
+      }
+
       if( ( use_zlib && !gzf ) || ( !use_zlib && !inpf ) )
          throw runtime_error( "unable to open file '" + filename + "' for input" );
 #else
@@ -949,7 +969,28 @@ int main( int argc, char* argv[ ] )
          throw runtime_error( "unexpected error occurred whilst reading '" + filename + "' for input" );
 
       if( !is_quiet && !list_only )
-         cout << "==> finished unbundling '" << filename << "'" << endl;
+      {
+         cout << "==> finished unbundling '" << filename << "'";
+
+         int64_t total_bytes = 0;
+#ifdef ZLIB_SUPPORT
+         if( use_zlib )
+            total_bytes = gztell( gzf );
+         else
+            total_bytes = file_size( filename );
+#else
+         total_bytes = file_size( filename );
+#endif
+         milliseconds elapsed = mtime::standard( ) - start;
+         if( elapsed < 0 )
+            elapsed += c_milliseconds_per_day;
+
+         if( elapsed > 0 )
+            cout << " (" << fixed << setprecision( 2 )
+             << ( ( total_bytes / c_bytes_per_megabyte ) / ( elapsed / 1000.0 ) ) << " MB/s)";
+
+         cout << endl;
+      }
    }
    catch( exception& x )
    {
@@ -15,6 +15,7 @@
 #  include <string>
 #  include <fstream>
 #  include <iostream>
+#  include <vector>
 #endif
 
 #include "fcgiapp.h"
@@ -29,6 +30,7 @@
 #endif
 
 #include "config.h"
+#include "sha256.h"
 #include "threads.h"
 #include "date_time.h"
 #include "utilities.h"
@@ -41,6 +43,7 @@
 using namespace std;
 
 const int c_chunk_size = 8192;
+const int c_block_size = 65536;
 
 const int c_num_handlers = 10;
 
@@ -79,6 +82,58 @@ void pid_handler::on_start( )
    }
 }
 
+// NOTE: Locates a multipart boundary marker using a Boyer-Moore-Horspool skip table so that
+// the body can be read in large blocks and written straight to its destination (only a tail
+// of at most the marker length minus one bytes needs to be carried over between blocks).
+class boundary_scanner
+{
+   public:
+   boundary_scanner( const string& boundary );
+
+   size_t length( ) const { return marker.size( ); }
+
+   size_t find( const char* p_data, size_t size ) const;
+
+   private:
+   string marker;
+   size_t skip[ 256 ];
+};
+
+boundary_scanner::boundary_scanner( const string& boundary )
+ :
+ marker( boundary )
+{
+   size_t len = marker.size( );
+
+   for( size_t i = 0; i < 256; i++ )
+      skip[ i ] = len;
+
+   for( size_t i = 0; i + 1 < len; i++ )
+      skip[ ( unsigned char )marker[ i ] ] = len - 1 - i;
+}
+
+size_t boundary_scanner::find( const char* p_data, size_t size ) const
+{
+   size_t len = marker.size( );
+
+   if( !len )
+      return 0;
+
+   const char* p_marker = marker.data( );
+
+   for( size_t pos = 0; pos + len <= size; )
+   {
+      char last = p_data[ pos + len - 1 ];
+
+      if( last == p_marker[ len - 1 ] && memcmp( p_data + pos, p_marker, len - 1 ) == 0 )
+         return pos;
+
+      pos += skip[ ( unsigned char )last ];
+   }
+
+   return string::npos;
+}
+
 class request_handler : public thread
 {
    public:
@@ -162,8 +217,6 @@ void request_handler::process_request( )
 
    string name, file_name;
    char buf[ c_chunk_size ];
-   char buf2[ c_chunk_size ];
-   char dbuf[ c_chunk_size * 2 ];
 
    string disposition, file_source;
    if( FCGX_GetLine( buf, c_chunk_size, p_in ) )
@@ -272,8 +325,6 @@ void request_handler::process_request( )
       string line_break( buf );
       size += line_break.size( );
 
-      size_t len2( 0 );
-
       ofstream outf;
       if( !ext.empty( ) )
          outf.open( file_name.c_str( ), ios::out | ios::binary );
@@ -289,49 +340,75 @@ void request_handler::process_request( )
       }
 #endif
 
+      boundary_scanner scanner( marker );
+
+      // NOTE: The SHA-256 of the uploaded content is calculated as it is being written so that
+      // the file never needs to be read again in order to determine its hash.
+      sha256 hash;
+
+      vector< char > block( c_block_size );
+      char* p_block = &block[ 0 ];
+
+      size_t held = 0;
       size_t written = 0;
+
+      bool found = false;
       bool max_size_exceeded = false;
+
       while( true )
       {
-         int len = FCGX_GetStr( buf, c_chunk_size, p_in );
+         int len = FCGX_GetStr( p_block + held, c_block_size - held, p_in );
 
-         if( len < c_chunk_size )
+         if( len > 0 )
          {
-            if( len > 0 )
-            {
-               if( len2 )
-                  memcpy( dbuf, buf2, len2 );
-               memcpy( dbuf + len2, buf, len );
-            }
-
-            string last( dbuf, len2 + len );
-            pos = last.find( marker );
-            if( pos == string::npos )
-               FCGX_FPrintF( p_out, "<p>*** unexpected end-of-file marker not found ***</p>" );
-            else
-            {
-               outf.write( dbuf, pos );
-               written += pos;
-            }
-
             size += len;
-            break;
+            held += len;
          }
 
-         if( len2 > 0 )
+         bool is_last = ( len <= 0 || held < c_block_size );
+
+         size_t available = held;
+
+         pos = scanner.find( p_block, held );
+         if( pos != string::npos )
          {
-            outf.write( buf2, len2 );
-            written += len2;
+            found = true;
+            available = pos;
          }
+         else if( !is_last )
+            available = held - ( scanner.length( ) - 1 );
+         else
+            available = 0;
 
-         memcpy( buf2, buf, len );
-         len2 = len;
+         if( available )
+         {
+            outf.write( p_block, available );
+            hash.update( ( const unsigned char* )p_block, available );
+
+            written += available;
+         }
 
-         size += len;
-         if( max_size && written > max_size )
+         if( found || is_last || ( max_size && written > max_size ) )
             break;
+
+         held -= available;
+         memmove( p_block, p_block + available, held );
       }
 
+      if( !found && !( max_size && written > max_size ) )
+         FCGX_FPrintF( p_out, "<p>*** unexpected end-of-file marker not found ***</p>" );
+
+      // NOTE: Any remaining input (i.e. the closing boundary) is read so that the total size
+      // can still be compared with the content length.
+      if( found )
+      {
+         int len;
+         while( ( len = FCGX_GetStr( p_block, c_block_size, p_in ) ) > 0 )
+            size += len;
+      }
+
+      outf.close( );
+
       if( max_size && written > max_size )
       {
          if( !ext.empty( ) )
@@ -349,7 +426,13 @@ void request_handler::process_request( )
          if( max_size_exceeded )
             outf << ">" << max_size << endl;
          else if( !ext.empty( ) )
+         {
             outf << file_name;
+
+            // NOTE: The content hash follows the file name (which is expected to be the first line).
+            if( found )
+               outf << '\n' << hash.get_digest_as_string( );
+         }
       }
    }
 